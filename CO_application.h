@@ -125,6 +125,36 @@ void app_programAsync(CO_t* co, uint32_t timer1usDiff);
  */
 void app_programRt(CO_t* co, uint32_t timer1usDiff);
 
+/* 每次接收调用一次的函数，参数为一批接收到的帧
+ * 函数功能：CAN 驱动在一次接收中用 recvmmsg() 读取所有等待的帧，CANopen 对象处理完后，以带时间戳的
+ *         连续数组调用此函数一次，应用程序可以一起处理整批帧，而不需要为每帧注册接收缓冲区和回调
+ * 使用说明：可选，只有在同时定义 CO_USE_APPLICATION 和 CO_USE_APPLICATION_RX_BATCH 时才被调用
+ * 注意事项：与 app_programRt() 在同一线程中运行（没有实时线程时为主线程），代码必须快速执行完成。
+ *         数组只在调用期间有效
+ * 参数说明：
+ *   - co: CANopen 对象指针
+ *   - frames: 接收帧数组，包含消息、接收时间戳（系统时钟）和 CAN 接口索引，不包括错误帧
+ *   - count: 帧数量，1 .. CO_DRIVER_RX_BATCH_MAX
+ * 返回值说明：无返回值
+ */
+/**
+ * Function is called once per receive pass with the batch of received frames.
+ *
+ * CAN driver drains all frames waiting in the socket with one recvmmsg() call. After CANopen objects have processed
+ * them, this function is called once with all data frames as a contiguous array with time stamps, so application can
+ * process the whole batch together instead of registering own receive buffers with per-frame callbacks. Function is
+ * optional, it is called only if CO_USE_APPLICATION_RX_BATCH is defined besides CO_USE_APPLICATION.
+ *
+ * Runs in the same thread as app_programRt() (mainline thread without realtime thread), code must be executed fast.
+ * Array is valid only during the call.
+ *
+ * @param co CANopen object.
+ * @param frames Received frames: message, time of reception (system clock) and CAN interface index. Error frames are
+ * not included.
+ * @param count Number of frames, 1 .. @ref CO_DRIVER_RX_BATCH_MAX.
+ */
+void app_programRxBatch(CO_t* co, const CO_CANrxFrame_t frames[], uint16_t count);
+
 /** @} */ /* CO_applicationLinux */
 
 #ifdef __cplusplus
@@ -0,0 +1,213 @@
+/*
+ * ASCII numbers and tokens for Linux
+ *
+ * @file        CO_asciiLinux.c
+ * @author      CANopenLinux contributors
+ * @copyright   2026 CANopenLinux contributors
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#include <string.h>
+
+#include "CO_asciiLinux.h"
+
+/* 字符 0x80 .. 0xFF 没有分类 */
+/* characters 0x80 .. 0xFF have no class */
+const uint8_t CO_ascii_class[256] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+const uint8_t CO_ascii_hexValue[256] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+
+/* 数组正好容纳 512 个字符，没有 '\0' */
+/* array holds exactly 512 characters, without '\0' */
+const char CO_ascii_hexPairs[512] =
+    "000102030405060708090A0B0C0D0E0F101112131415161718191A1B1C1D1E1F"
+    "202122232425262728292A2B2C2D2E2F303132333435363738393A3B3C3D3E3F"
+    "404142434445464748494A4B4C4D4E4F505152535455565758595A5B5C5D5E5F"
+    "606162636465666768696A6B6C6D6E6F707172737475767778797A7B7C7D7E7F"
+    "808182838485868788898A8B8C8D8E8F909192939495969798999A9B9C9D9E9F"
+    "A0A1A2A3A4A5A6A7A8A9AAABACADAEAFB0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+    "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECFD0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+    "E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEFF0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
+/* 两位十进制数字 "00" .. "99"，格式化时每步处理两位 */
+/* two decimal digits "00" .. "99", formatting produces two digits per step */
+static const char digitPairs[200] = "0001020304050607080910111213141516171819"
+                                    "2021222324252627282930313233343536373839"
+                                    "4041424344454647484950515253545556575859"
+                                    "6061626364656667686970717273747576777879"
+                                    "8081828384858687888990919293949596979899";
+
+const char*
+CO_ascii_token(const char* str, size_t len, size_t* pos, size_t* tokLen) {
+    size_t i = *pos;
+    while (i < len && CO_ascii_isSpace(str[i])) {
+        i++;
+    }
+    size_t start = i;
+    while (i < len && !CO_ascii_isSpace(str[i])) {
+        i++;
+    }
+    *pos = i;
+    *tokLen = i - start;
+    return &str[start];
+}
+
+size_t
+CO_ascii_spanDigits(const char* str, size_t len) {
+    size_t i = 0;
+    while (i < len && CO_ascii_isDigit(str[i])) {
+        i++;
+    }
+    return i;
+}
+
+size_t
+CO_ascii_parseU32(const char* str, size_t len, uint32_t* value) {
+    uint32_t v = 0;
+    size_t i;
+
+    if (len == 0 || !CO_ascii_isDigit(str[0])) {
+        return 0;
+    }
+
+    if (str[0] != '0') {
+        /* 十进制 */
+        for (i = 0; i < len; i++) {
+            uint32_t d = (uint32_t)(uint8_t)str[i] - (uint32_t)'0';
+            if (d > 9U) {
+                break;
+            }
+            if (v > (UINT32_MAX / 10U) || (v == (UINT32_MAX / 10U) && d > (UINT32_MAX % 10U))) {
+                return 0;
+            }
+            v = v * 10U + d;
+        }
+    } else if (len > 2 && (str[1] == 'x' || str[1] == 'X') && CO_ascii_hexValue[(uint8_t)str[2]] != 0xFFU) {
+        /* 十六进制 */
+        for (i = 2; i < len; i++) {
+            uint8_t d = CO_ascii_hexValue[(uint8_t)str[i]];
+            if (d == 0xFFU) {
+                break;
+            }
+            if (v > (UINT32_MAX >> 4)) {
+                return 0;
+            }
+            v = (v << 4) | d;
+        }
+    } else {
+        /* 八进制，或者单独的 "0"（"0x" 后没有十六进制数字时与 strtoul() 相同） */
+        /* octal, or single "0" (the same as strtoul(), if "0x" is not followed by hex digit) */
+        for (i = 1; i < len; i++) {
+            uint32_t d = (uint32_t)(uint8_t)str[i] - (uint32_t)'0';
+            if (d > 7U) {
+                break;
+            }
+            if (v > (UINT32_MAX >> 3)) {
+                return 0;
+            }
+            v = (v << 3) | d;
+        }
+    }
+
+    *value = v;
+    return i;
+}
+
+size_t
+CO_ascii_formatU32(char* buf, uint32_t value) {
+    char tmp[10];
+    size_t n = sizeof(tmp);
+
+    while (value >= 100U) {
+        uint32_t r = value % 100U;
+        value /= 100U;
+        n -= 2;
+        memcpy(&tmp[n], &digitPairs[r * 2U], 2);
+    }
+    if (value >= 10U) {
+        n -= 2;
+        memcpy(&tmp[n], &digitPairs[value * 2U], 2);
+    } else {
+        tmp[--n] = (char)('0' + value);
+    }
+
+    size_t len = sizeof(tmp) - n;
+    memcpy(buf, &tmp[n], len);
+    buf[len] = '\0';
+    return len;
+}
+
+size_t
+CO_ascii_formatU64(char* buf, uint64_t value) {
+    char tmp[20];
+    size_t n = sizeof(tmp);
+
+    /* 32 位的值用更快的 32 位除法 */
+    /* 32-bit values use faster 32-bit division */
+    if (value <= UINT32_MAX) {
+        return CO_ascii_formatU32(buf, (uint32_t)value);
+    }
+    while (value >= 100U) {
+        uint64_t r = value % 100U;
+        value /= 100U;
+        n -= 2;
+        memcpy(&tmp[n], &digitPairs[r * 2U], 2);
+    }
+    if (value >= 10U) {
+        n -= 2;
+        memcpy(&tmp[n], &digitPairs[value * 2U], 2);
+    } else {
+        tmp[--n] = (char)('0' + value);
+    }
+
+    size_t len = sizeof(tmp) - n;
+    memcpy(buf, &tmp[n], len);
+    buf[len] = '\0';
+    return len;
+}
+
+size_t
+CO_ascii_formatX(char* buf, uint64_t value, size_t digits) {
+    for (size_t n = digits; n >= 2; n -= 2) {
+        memcpy(&buf[n - 2], &CO_ascii_hexPairs[(value & 0xFFU) * 2U], 2);
+        value >>= 8;
+    }
+    buf[digits] = '\0';
+    return digits;
+}
@@ -0,0 +1,182 @@
+/* Linux 平台的 ASCII 数字和标记解析
+ * 本文件提供网关使用的查表实现：字符分类、标记切分、无符号整数的解析和格式化、十六进制数字。
+ * 它们替代 isspace()/isdigit()/strtoul()/snprintf()，这些函数依赖区域设置并逐字符调用。
+ */
+/**
+ * ASCII numbers and tokens for Linux
+ *
+ * @file        CO_asciiLinux.h
+ * @ingroup     CO_asciiLinux
+ * @author      CANopenLinux contributors
+ * @copyright   2026 CANopenLinux contributors
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#ifndef CO_ASCII_LINUX_H
+#define CO_ASCII_LINUX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup CO_asciiLinux ASCII numbers and tokens with Linux
+ * Table driven character classes, tokens, unsigned and hexadecimal numbers for the command interface.
+ *
+ * @ingroup CO_socketCAN
+ * @{
+ *
+ * Functions are used by the gateway in @ref CO_epoll_processGtw() on every received command line. Character classes
+ * are looked up in one 256 entry table instead of locale dependent isspace() and isdigit(), numbers are accumulated
+ * without strtoul() and formatted two digits per step without snprintf(). The same tables are used by the
+ * conversions of OD values in @ref CO_fifoLinux.
+ */
+
+/* 字符分类位 */
+#define CO_ASCII_SPACE  0x01U /**< Character class: ' ', '\\t', '\\n', '\\v', '\\f', '\\r' */
+#define CO_ASCII_DIGIT  0x02U /**< Character class: '0' .. '9' */
+#define CO_ASCII_XDIGIT 0x04U /**< Character class: '0' .. '9', 'a' .. 'f', 'A' .. 'F' */
+
+/* 字符分类表，由 CO_ASCII_* 位组成 */
+/** Character class table, combination of CO_ASCII_* bits for each character */
+extern const uint8_t CO_ascii_class[256];
+
+/* 十六进制数字的值，其他字符为 0xFF */
+/** Value of hexadecimal digit for each character, 0xFF for other characters */
+extern const uint8_t CO_ascii_hexValue[256];
+
+/* 每个字节值的两个大写十六进制数字 "00" .. "FF"，不以 '\0' 结尾 */
+/** Two uppercase hexadecimal digits "00" .. "FF" for each byte value, not null terminated */
+extern const char CO_ascii_hexPairs[512];
+
+/** Check if character is white space, like isspace() in "C" locale */
+static inline bool
+CO_ascii_isSpace(char c) {
+    return (CO_ascii_class[(uint8_t)c] & CO_ASCII_SPACE) != 0U;
+}
+
+/** Check if character is decimal digit */
+static inline bool
+CO_ascii_isDigit(char c) {
+    return (CO_ascii_class[(uint8_t)c] & CO_ASCII_DIGIT) != 0U;
+}
+
+/* 取出下一个以空白分隔的标记
+ * 参数说明：
+ *   - str, len: 字符串和长度
+ *   - pos: 当前位置，输入输出参数
+ *   - tokLen: 标记长度，输出参数，0 表示没有更多标记
+ * 返回值说明：标记起始指针
+ */
+/**
+ * Get next token, separated by white space
+ *
+ * @param str String, not necessary null terminated
+ * @param len Length of the string
+ * @param [in,out] pos Position in the string, set after the token
+ * @param [out] tokLen Length of the token, 0 if there are no more tokens
+ *
+ * @return Pointer to the beginning of the token
+ */
+const char* CO_ascii_token(const char* str, size_t len, size_t* pos, size_t* tokLen);
+
+/* 返回开头十进制数字的个数 */
+/**
+ * Get number of leading decimal digits
+ *
+ * @param str String
+ * @param len Length of the string
+ *
+ * @return Number of digits
+ */
+size_t CO_ascii_spanDigits(const char* str, size_t len);
+
+/* 解析无符号 32 位整数
+ * 函数功能：与 strtoul(str, &end, 0) 相同的语法：十进制、"0x" 开头的十六进制、"0" 开头的八进制，
+ *         但不跳过开头的空白，不接受符号，溢出时返回 0
+ * 返回值说明：使用的字符数，没有数字或溢出时返回 0
+ */
+/**
+ * Parse unsigned 32-bit integer
+ *
+ * Syntax is the same as with strtoul(str, &end, 0): decimal, hexadecimal with "0x" prefix or octal with leading "0".
+ * Leading white space and sign are not accepted.
+ *
+ * @param str String, not necessary null terminated
+ * @param len Length of the string
+ * @param [out] value Parsed value
+ *
+ * @return Number of used characters, 0 if there are no digits or on overflow
+ */
+size_t CO_ascii_parseU32(const char* str, size_t len, uint32_t* value);
+
+/* 把无符号 32 位整数格式化为十进制
+ * 参数说明：
+ *   - buf: 输出缓冲区，至少 11 字节，结果以 '\0' 结尾
+ * 返回值说明：字符数，不包括 '\0'
+ */
+/**
+ * Format unsigned 32-bit integer as decimal number
+ *
+ * @param [out] buf Buffer of at least 11 bytes, result is null terminated
+ * @param value Value
+ *
+ * @return Number of characters, without null terminator
+ */
+size_t CO_ascii_formatU32(char* buf, uint32_t value);
+
+/* 把无符号 64 位整数格式化为十进制
+ * 参数说明：
+ *   - buf: 输出缓冲区，至少 21 字节，结果以 '\0' 结尾
+ * 返回值说明：字符数，不包括 '\0'
+ */
+/**
+ * Format unsigned 64-bit integer as decimal number
+ *
+ * @param [out] buf Buffer of at least 21 bytes, result is null terminated
+ * @param value Value
+ *
+ * @return Number of characters, without null terminator
+ */
+size_t CO_ascii_formatU64(char* buf, uint64_t value);
+
+/* 把无符号整数格式化为固定位数的大写十六进制，与 "%0*llX" 相同，没有 "0x" 前缀
+ * 参数说明：
+ *   - buf: 输出缓冲区，至少 digits + 1 字节，结果以 '\0' 结尾
+ *   - digits: 位数，偶数，2 .. 16，高位被截断
+ * 返回值说明：字符数，不包括 '\0'
+ */
+/**
+ * Format unsigned integer as uppercase hexadecimal number with fixed number of digits
+ *
+ * Result is the same as with "%0*llX", without "0x" prefix.
+ *
+ * @param [out] buf Buffer of at least digits + 1 bytes, result is null terminated
+ * @param value Value, higher digits are truncated
+ * @param digits Number of digits, even, 2 to 16
+ *
+ * @return Number of characters, without null terminator
+ */
+size_t CO_ascii_formatX(char* buf, uint64_t value, size_t digits);
+
+/** @} */ /* CO_asciiLinux */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CO_ASCII_LINUX_H */
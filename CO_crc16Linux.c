@@ -0,0 +1,325 @@
+/*
+ * CRC16-CCITT calculation for Linux
+ *
+ * @file        CO_crc16Linux.c
+ * @author      CANopenLinux contributors
+ * @copyright   2026 CANopenLinux contributors
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#include "CO_crc16Linux.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CRC16_CLMUL_X86
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#define CRC16_CLMUL_ARM
+#endif
+
+#if (CO_CONFIG_CRC16) & CO_CONFIG_CRC16_EXTERNAL
+
+/* 生成多项式 x^16 + x^12 + x^5 + 1，不反射，无最终异或 */
+/* Generator polynomial x^16 + x^12 + x^5 + 1, not reflected, no final xor */
+#define CRC16_POLY 0x1021U
+
+/* 无进位乘法实现的最小长度，更短的数据用 slice-by-8 计算 */
+/* Minimum length for carry-less multiply implementation, shorter data are calculated with slice-by-8 */
+#define CRC16_CLMUL_MIN 64U
+
+/* crc16Table[k][b]：字节 b 后面跟 k 个零字节的 CRC。crc16Table[0] 与 CANopenNode 的表相同 */
+/* crc16Table[k][b]: CRC of byte b followed by k zero bytes. crc16Table[0] is the same as table in CANopenNode */
+static uint16_t crc16Table[8][256];
+
+/* 折叠常数 x^n mod P：[0] x^192，[1] x^128（16 字节），[2] x^576，[3] x^512（64 字节） */
+/* Folding constants x^n mod P: [0] x^192, [1] x^128 (16 bytes), [2] x^576, [3] x^512 (64 bytes) */
+static uint64_t crc16Fold[4];
+
+typedef uint16_t (*crc16Fn_t)(const uint8_t* block, size_t len, uint16_t crc);
+
+static uint16_t crc16Table1(const uint8_t* block, size_t len, uint16_t crc);
+static crc16Fn_t crc16Fn = crc16Table1;
+static const char* crc16Name = "table";
+
+uint16_t
+CO_crc16Linux_reference(const uint8_t block[], size_t blockLength, uint16_t crc) {
+    for (size_t i = 0; i < blockLength; i++) {
+        crc ^= (uint16_t)block[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000U) != 0 ? (uint16_t)((crc << 1) ^ CRC16_POLY) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/* x^n mod P */
+static uint64_t
+crc16XpowMod(unsigned n) {
+    uint32_t r = 1;
+    while (n-- > 0) {
+        r <<= 1;
+        if ((r & 0x10000U) != 0) {
+            r ^= 0x10000U | CRC16_POLY;
+        }
+    }
+    return r;
+}
+
+/* 每次一个字节 */
+/* One byte per step */
+static uint16_t
+crc16Table1(const uint8_t* block, size_t len, uint16_t crc) {
+    for (size_t i = 0; i < len; i++) {
+        crc = (uint16_t)(crc << 8) ^ crc16Table[0][(uint8_t)(crc >> 8) ^ block[i]];
+    }
+    return crc;
+}
+
+/* 每次八个字节：CRC 与前两个字节异或，八个字节的贡献从各自的表中查出并异或 */
+/* Eight bytes per step: CRC is xored into the first two bytes, contributions of eight bytes are looked up in own
+ * tables and xored */
+static uint16_t
+crc16Slice8(const uint8_t* block, size_t len, uint16_t crc) {
+    while (len >= 8) {
+        crc = crc16Table[7][block[0] ^ (uint8_t)(crc >> 8)] ^ crc16Table[6][block[1] ^ (uint8_t)crc]
+              ^ crc16Table[5][block[2]] ^ crc16Table[4][block[3]] ^ crc16Table[3][block[4]]
+              ^ crc16Table[2][block[5]] ^ crc16Table[1][block[6]] ^ crc16Table[0][block[7]];
+        block += 8;
+        len -= 8;
+    }
+    return crc16Table1(block, len, crc);
+}
+
+/* 无进位乘法实现：数据按 16 字节块看作多项式，第一个字节在最高位。累加器 X 与下一个块的合并用
+ * X * x^128 = hi * x^192 + lo * x^128 (mod P) 折叠，四个累加器并行处理 64 字节。最后的 128 位余数
+ * 和剩余字节用 slice-by-8 计算，余数的 CRC 是 X * x^16 mod P，与原数据前缀的 CRC 相同 */
+/* Carry-less multiply implementation: data in 16 byte blocks are polynomials, with the first byte at the top.
+ * Accumulator X is merged with the next block by folding X * x^128 = hi * x^192 + lo * x^128 (mod P), four
+ * accumulators process 64 bytes in parallel. The final 128 bit remainder and the remaining bytes are calculated with
+ * slice-by-8; CRC of the remainder is X * x^16 mod P, the same as CRC of the data prefix. */
+#ifdef CRC16_CLMUL_X86
+#define CRC16_TARGET __attribute__((target("pclmul,ssse3")))
+
+CRC16_TARGET static inline __m128i
+crc16Load(const uint8_t* p) {
+    const __m128i swap = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    return _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)p), swap);
+}
+
+CRC16_TARGET static inline __m128i
+crc16FoldX(__m128i x, __m128i k) {
+    return _mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x11), _mm_clmulepi64_si128(x, k, 0x00));
+}
+
+CRC16_TARGET static uint16_t
+crc16Clmul(const uint8_t* block, size_t len, uint16_t crc) {
+    if (len < CRC16_CLMUL_MIN) {
+        return crc16Slice8(block, len, crc);
+    }
+    const __m128i k16 = _mm_set_epi64x((long long)crc16Fold[0], (long long)crc16Fold[1]);
+    const __m128i k64 = _mm_set_epi64x((long long)crc16Fold[2], (long long)crc16Fold[3]);
+    __m128i x0 = _mm_xor_si128(crc16Load(block), _mm_set_epi64x((long long)((uint64_t)crc << 48), 0));
+    __m128i x1 = crc16Load(block + 16);
+    __m128i x2 = crc16Load(block + 32);
+    __m128i x3 = crc16Load(block + 48);
+    block += 64;
+    len -= 64;
+
+    while (len >= 64) {
+        x0 = _mm_xor_si128(crc16FoldX(x0, k64), crc16Load(block));
+        x1 = _mm_xor_si128(crc16FoldX(x1, k64), crc16Load(block + 16));
+        x2 = _mm_xor_si128(crc16FoldX(x2, k64), crc16Load(block + 32));
+        x3 = _mm_xor_si128(crc16FoldX(x3, k64), crc16Load(block + 48));
+        block += 64;
+        len -= 64;
+    }
+    x0 = _mm_xor_si128(crc16FoldX(x0, k16), x1);
+    x0 = _mm_xor_si128(crc16FoldX(x0, k16), x2);
+    x0 = _mm_xor_si128(crc16FoldX(x0, k16), x3);
+    while (len >= 16) {
+        x0 = _mm_xor_si128(crc16FoldX(x0, k16), crc16Load(block));
+        block += 16;
+        len -= 16;
+    }
+
+    uint8_t rem[16];
+    const __m128i swap = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    _mm_storeu_si128((__m128i*)rem, _mm_shuffle_epi8(x0, swap));
+    return crc16Slice8(block, len, crc16Slice8(rem, sizeof(rem), 0));
+}
+
+static bool_t
+crc16ClmulSupported(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3");
+}
+
+#define CRC16_CLMUL_NAME "clmul-pclmulqdq"
+#endif /* CRC16_CLMUL_X86 */
+
+#ifdef CRC16_CLMUL_ARM
+#define CRC16_TARGET __attribute__((target("arch=armv8-a+crypto")))
+
+/* 字节顺序反转后，第一个字节在第 1 通道的最高位 */
+/* After byte reversal the first byte is at the top of lane 1 */
+CRC16_TARGET static inline uint64x2_t
+crc16Load(const uint8_t* p) {
+    uint8x16_t b = vrev64q_u8(vld1q_u8(p));
+    return vreinterpretq_u64_u8(vextq_u8(b, b, 8));
+}
+
+CRC16_TARGET static inline uint64x2_t
+crc16FoldX(uint64x2_t x, poly64_t kHi, poly64_t kLo) {
+    poly128_t hi = vmull_p64((poly64_t)vgetq_lane_u64(x, 1), kHi);
+    poly128_t lo = vmull_p64((poly64_t)vgetq_lane_u64(x, 0), kLo);
+    return veorq_u64(vreinterpretq_u64_p128(hi), vreinterpretq_u64_p128(lo));
+}
+
+CRC16_TARGET static uint16_t
+crc16Clmul(const uint8_t* block, size_t len, uint16_t crc) {
+    if (len < CRC16_CLMUL_MIN) {
+        return crc16Slice8(block, len, crc);
+    }
+    const poly64_t k16Hi = (poly64_t)crc16Fold[0], k16Lo = (poly64_t)crc16Fold[1];
+    const poly64_t k64Hi = (poly64_t)crc16Fold[2], k64Lo = (poly64_t)crc16Fold[3];
+    uint64x2_t x0 = veorq_u64(crc16Load(block), vcombine_u64(vcreate_u64(0), vcreate_u64((uint64_t)crc << 48)));
+    uint64x2_t x1 = crc16Load(block + 16);
+    uint64x2_t x2 = crc16Load(block + 32);
+    uint64x2_t x3 = crc16Load(block + 48);
+    block += 64;
+    len -= 64;
+
+    while (len >= 64) {
+        x0 = veorq_u64(crc16FoldX(x0, k64Hi, k64Lo), crc16Load(block));
+        x1 = veorq_u64(crc16FoldX(x1, k64Hi, k64Lo), crc16Load(block + 16));
+        x2 = veorq_u64(crc16FoldX(x2, k64Hi, k64Lo), crc16Load(block + 32));
+        x3 = veorq_u64(crc16FoldX(x3, k64Hi, k64Lo), crc16Load(block + 48));
+        block += 64;
+        len -= 64;
+    }
+    x0 = veorq_u64(crc16FoldX(x0, k16Hi, k16Lo), x1);
+    x0 = veorq_u64(crc16FoldX(x0, k16Hi, k16Lo), x2);
+    x0 = veorq_u64(crc16FoldX(x0, k16Hi, k16Lo), x3);
+    while (len >= 16) {
+        x0 = veorq_u64(crc16FoldX(x0, k16Hi, k16Lo), crc16Load(block));
+        block += 16;
+        len -= 16;
+    }
+
+    uint8_t rem[16];
+    uint8x16_t b = vrev64q_u8(vreinterpretq_u8_u64(x0));
+    vst1q_u8(rem, vextq_u8(b, b, 8));
+    return crc16Slice8(block, len, crc16Slice8(rem, sizeof(rem), 0));
+}
+
+static bool_t
+crc16ClmulSupported(void) {
+    return (getauxval(AT_HWCAP) & HWCAP_PMULL) != 0;
+}
+
+#define CRC16_CLMUL_NAME "clmul-pmull"
+#endif /* CRC16_CLMUL_ARM */
+
+#ifdef CRC16_CLMUL_NAME
+/* 比较实现与参考实现：不同长度、对齐和初始值 */
+/* Compare implementation with the reference: different lengths, alignments and initial values */
+static bool_t
+crc16Verify(crc16Fn_t fn) {
+    uint8_t data[1024 + 16];
+    uint32_t seed = 0x12345678U;
+
+    for (size_t i = 0; i < sizeof(data); i++) {
+        seed = seed * 1103515245U + 12345U;
+        data[i] = (uint8_t)(seed >> 16);
+    }
+    for (size_t len = 0; len <= 1024; len += (len < 300) ? 1 : 37) {
+        size_t offset = len % 16;
+        uint16_t init = (uint16_t)(len * 0x9E37U);
+        if (fn(&data[offset], len, init) != CO_crc16Linux_reference(&data[offset], len, init)) {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+bool_t
+CO_crc16Linux_select(CO_crc16Linux_impl_t impl) {
+    switch (impl) {
+        case CO_CRC16_IMPL_TABLE:
+            crc16Fn = crc16Table1;
+            crc16Name = "table";
+            return true;
+        case CO_CRC16_IMPL_SLICE8:
+            crc16Fn = crc16Slice8;
+            crc16Name = "slice8";
+            return true;
+        case CO_CRC16_IMPL_CLMUL:
+#ifdef CRC16_CLMUL_NAME
+            if (crc16ClmulSupported() && crc16Verify(crc16Clmul)) {
+                crc16Fn = crc16Clmul;
+                crc16Name = CRC16_CLMUL_NAME;
+                return true;
+            }
+#endif
+            return false;
+        case CO_CRC16_IMPL_AUTO:
+            if (!CO_crc16Linux_select(CO_CRC16_IMPL_CLMUL)) {
+                CO_crc16Linux_select(CO_CRC16_IMPL_SLICE8);
+            }
+            return true;
+        default: return false;
+    }
+}
+
+const char*
+CO_crc16Linux_name(void) {
+    return crc16Name;
+}
+
+/* 程序启动时生成表和折叠常数，并选择实现，在任何线程计算 CRC 之前 */
+/* Generate tables and folding constants and select implementation at program startup, before any thread calculates
+ * CRC */
+__attribute__((constructor)) static void
+crc16Init(void) {
+    for (unsigned b = 0; b < 256; b++) {
+        uint8_t byte = (uint8_t)b;
+        crc16Table[0][b] = CO_crc16Linux_reference(&byte, 1, 0);
+    }
+    for (unsigned k = 1; k < 8; k++) {
+        for (unsigned b = 0; b < 256; b++) {
+            uint16_t prev = crc16Table[k - 1][b];
+            crc16Table[k][b] = (uint16_t)(prev << 8) ^ crc16Table[0][prev >> 8];
+        }
+    }
+    crc16Fold[0] = crc16XpowMod(192);
+    crc16Fold[1] = crc16XpowMod(128);
+    crc16Fold[2] = crc16XpowMod(576);
+    crc16Fold[3] = crc16XpowMod(512);
+
+    CO_crc16Linux_select(CO_CRC16_IMPL_AUTO);
+}
+
+void
+crc16_ccitt_single(uint16_t* crc, const uint8_t chr) {
+    *crc = (uint16_t)(*crc << 8) ^ crc16Table[0][(uint8_t)(*crc >> 8) ^ chr];
+}
+
+uint16_t
+crc16_ccitt(const uint8_t block[], size_t blockLength, uint16_t crc) {
+    return crc16Fn(block, blockLength, crc);
+}
+
+#endif /* (CO_CONFIG_CRC16) & CO_CONFIG_CRC16_EXTERNAL */
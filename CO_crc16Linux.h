@@ -0,0 +1,106 @@
+/* Linux 平台的 CRC16-CCITT 计算
+ * 本文件提供 CANopenNode crc16_ccitt() 的加速实现，用于存储、SDO 块传输和 FIFO。运行时根据 CPU
+ * 选择实现：无进位乘法（x86 的 PCLMULQDQ，ARMv8 的 PMULL）或 slice-by-8 查表。
+ */
+/**
+ * CRC16-CCITT calculation for Linux
+ *
+ * @file        CO_crc16Linux.h
+ * @ingroup     CO_crc16Linux
+ * @author      CANopenLinux contributors
+ * @copyright   2026 CANopenLinux contributors
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#ifndef CO_CRC16_LINUX_H
+#define CO_CRC16_LINUX_H
+
+#include "301/crc16-ccitt.h"
+
+#if ((CO_CONFIG_CRC16)&CO_CONFIG_CRC16_EXTERNAL) || defined CO_DOXYGEN
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup CO_crc16Linux CRC16-CCITT with Linux
+ * Accelerated crc16_ccitt() and crc16_ccitt_single(), used with CO_CONFIG_CRC16_EXTERNAL.
+ *
+ * @ingroup CO_socketCAN
+ * @{
+ * See also @ref CO_crc16_ccitt.
+ */
+
+/* CRC16-CCITT 实现 */
+/** Implementation of CRC16-CCITT */
+typedef enum {
+    CO_CRC16_IMPL_AUTO,   /**< Fastest implementation supported by the CPU */
+    CO_CRC16_IMPL_TABLE,  /**< One byte per step with 256 entry table, as in CANopenNode */
+    CO_CRC16_IMPL_SLICE8, /**< Eight bytes per step with 8 x 256 entry tables */
+    CO_CRC16_IMPL_CLMUL   /**< Folding of 16 byte blocks with carry-less multiply, PCLMULQDQ or PMULL */
+} CO_crc16Linux_impl_t;
+
+/* 选择 crc16_ccitt() 的实现
+ * 函数功能：选择实现。启动时自动选择 CO_CRC16_IMPL_AUTO，无进位乘法实现在选择前与参考实现比较，
+ *         结果不同时不被使用
+ * 使用说明：只在没有其他线程计算 CRC 时调用，例如基准测试
+ * 参数说明：
+ *   - impl: 实现
+ * 返回值说明：成功返回 true，CPU 不支持该实现时返回 false，原来的实现保持不变
+ */
+/**
+ * Select implementation of crc16_ccitt()
+ *
+ * CO_CRC16_IMPL_AUTO is selected automatically at program startup. Carry-less multiply implementation is compared
+ * with the reference before it is selected and it is not used, if results differ. Call this function only when no
+ * other thread calculates CRC, for example in benchmarks.
+ *
+ * @param impl Implementation
+ *
+ * @return true on success, false if implementation is not supported by the CPU, previous implementation is kept then.
+ */
+bool_t CO_crc16Linux_select(CO_crc16Linux_impl_t impl);
+
+/* 返回当前实现的名称，例如 "clmul-pclmulqdq" */
+/**
+ * Get name of the selected implementation, for example "clmul-pclmulqdq"
+ *
+ * @return Name
+ */
+const char* CO_crc16Linux_name(void);
+
+/* 逐位计算的参考实现，用于验证
+ * 参数说明：与 crc16_ccitt() 相同
+ * 返回值说明：CRC
+ */
+/**
+ * Bitwise reference implementation, for verification
+ *
+ * @param block Pointer to data
+ * @param blockLength Length of data in bytes
+ * @param crc Initial value (zero for xmodem compatibility)
+ *
+ * @return CRC
+ */
+uint16_t CO_crc16Linux_reference(const uint8_t block[], size_t blockLength, uint16_t crc);
+
+/** @} */ /* CO_crc16Linux */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* (CO_CONFIG_CRC16) & CO_CONFIG_CRC16_EXTERNAL */
+
+#endif /* CO_CRC16_LINUX_H */
@@ -20,6 +20,10 @@
  * See the License for the specific language governing permissions and limitations under the License.
  */
 
+/* 启用 GNU 扩展以支持 sendmmsg() 套接字函数 */
+/* following macro is necessary for sendmmsg() function call (sockets) */
+#define _GNU_SOURCE
+
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -110,6 +114,206 @@ CO_CANgetIndexFromIdent(uint32_t* lookup, uint32_t ident) {
 
 #endif /* CO_DRIVER_MULTI_INTERFACE */
 
+/* 函数功能：估算 CAN 帧在总线上占用的位数
+ * 执行步骤：
+ *   步骤1: 根据帧格式（标准/扩展）计算名义位数，包括帧间隔
+ *   步骤2: 远程帧不传输数据字节
+ *   步骤3: 加上最坏情况下的位填充位数
+ * 参数说明：
+ *   ident - CAN 标识符，包括 CAN_EFF_FLAG 和 CAN_RTR_FLAG
+ *   DLC - 数据长度
+ * 返回值说明：返回帧的估算位数
+ * 注意：使用最坏情况下的位填充，因此总线负载被略微高估，适合用于限速
+ */
+static uint32_t
+CO_CANframeBits(uint32_t ident, uint8_t DLC) {
+    uint32_t dataBits = ((ident & CAN_RTR_FLAG) != 0U) ? 0U : (uint32_t)(DLC > 8U ? 8U : DLC) * 8U;
+    /* 名义位数和可被填充的位数（SOF 到 CRC）*/
+    /* nominal bits including interframe space and bits, which are subject of bit stuffing (SOF to CRC) */
+    uint32_t bits = ((ident & CAN_EFF_FLAG) != 0U) ? 67U : 47U;
+    uint32_t stuffable = ((ident & CAN_EFF_FLAG) != 0U) ? 54U : 34U;
+
+    return bits + dataBits + (stuffable + dataBits - 1U) / 4U;
+}
+
+/* 函数功能：统计总线负载，必要时结束当前测量窗口
+ * 执行步骤：
+ *   步骤1: 取帧的时间（接收帧的内核时间戳），没有时读取系统时钟
+ *   步骤2: 如果测量窗口已结束，计算总线负载并开始新窗口。时钟跳变时只开始新窗口
+ *   步骤3: 否则将位数累加到当前窗口
+ * 参数说明：
+ *   CANmodule - CAN 模块对象指针
+ *   bits - 接收或发送帧的位数，0 表示仅更新窗口
+ *   timestamp - 帧的时间（系统时钟），NULL 或零表示读取时钟
+ * 返回值说明：无返回值
+ * 注意：可以从实时线程（接收）和主线程（发送）同时调用，因此使用原子操作。窗口使用系统时钟，
+ *       与接收帧的内核时间戳相同，这样接收路径不需要为每帧调用 clock_gettime()
+ */
+static void
+CO_CANbusLoadAccount(CO_CANmodule_t* CANmodule, uint32_t bits, const struct timespec* timestamp) {
+    struct timespec ts;
+    uint64_t now_us;
+    uint64_t start_us;
+
+    if (timestamp == NULL || (timestamp->tv_sec == 0 && timestamp->tv_nsec == 0)) {
+        (void)clock_gettime(CLOCK_REALTIME, &ts);
+        timestamp = &ts;
+    }
+    now_us = (uint64_t)timestamp->tv_sec * 1000000 + (uint64_t)timestamp->tv_nsec / 1000;
+    start_us = __atomic_load_n(&CANmodule->busLoadWindow_us, __ATOMIC_RELAXED);
+
+    /* 接收时间戳可能略早于已开始的窗口，这些帧计入当前窗口 */
+    /* rx time stamp may be slightly before the started window, these frames are added to the current window */
+    if (now_us >= start_us + CO_DRIVER_BUSLOAD_WINDOW_US || now_us + CO_DRIVER_BUSLOAD_WINDOW_US < start_us) {
+        if (__atomic_compare_exchange_n(&CANmodule->busLoadWindow_us, &start_us, now_us, false, __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED)) {
+            uint32_t windowBits = __atomic_exchange_n(&CANmodule->busLoadBits, bits, __ATOMIC_RELAXED);
+
+            /* 窗口结束：capacity = kbit/s * us / 1000。时钟跳变（或第一个窗口）时不计算 */
+            /* window finished: capacity = kbit/s * us / 1000. Not calculated on clock jump (or first window) */
+            if (now_us > start_us && now_us - start_us < 10U * CO_DRIVER_BUSLOAD_WINDOW_US) {
+                uint64_t capacity = (uint64_t)CANmodule->CANbitRate * (now_us - start_us) / 1000;
+                uint64_t load = capacity > 0 ? (uint64_t)windowBits * 100 / capacity : 0;
+                __atomic_store_n(&CANmodule->busLoad, load > 100 ? 100 : (uint8_t)load, __ATOMIC_RELAXED);
+            }
+            __atomic_store_n(&CANmodule->busLoadBulkSent, false, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+    if (bits > 0) {
+        (void)__atomic_fetch_add(&CANmodule->busLoadBits, bits, __ATOMIC_RELAXED);
+    }
+}
+
+#if CO_DRIVER_MULTI_INTERFACE == 0
+
+/* 函数功能：判断发送帧是否属于批量流量（启用限速时）*/
+static bool_t
+CO_CANtxIsBulk(CO_CANmodule_t* CANmodule, const CO_CANtx_t* buffer) {
+    uint32_t ident = buffer->ident;
+
+    return CANmodule->busLoadLimit > 0 && (ident & (CAN_EFF_FLAG | CAN_RTR_FLAG)) == 0
+           && ident >= CO_DRIVER_BULK_IDENT_MIN && ident <= CO_DRIVER_BULK_IDENT_MAX;
+}
+
+/* 函数功能：判断批量帧是否需要被延迟发送
+ * 执行步骤：
+ *   步骤1: 非批量帧从不延迟
+ *   步骤2: 更新测量窗口
+ *   步骤3: 如果有其他实时帧等待发送，延迟批量帧
+ *   步骤4: 每个窗口的第一个批量帧总是允许发送，保证传输进度
+ *   步骤5: 如果当前窗口的位数加上此帧超过限值，延迟批量帧
+ * 参数说明：
+ *   CANmodule - CAN 模块对象指针
+ *   buffer - 要发送的缓冲区
+ * 返回值说明：
+ *   true - 帧必须被延迟
+ *   false - 帧可以立即发送
+ */
+static bool_t
+CO_CANtxBulkHold(CO_CANmodule_t* CANmodule, const CO_CANtx_t* buffer) {
+    if (!CO_CANtxIsBulk(CANmodule, buffer)) {
+        return false;
+    }
+
+    CO_CANbusLoadAccount(CANmodule, 0, NULL);
+
+    /* 实时帧优先 */
+    /* real-time frames first */
+    if (CANmodule->CANtxCount > 0) {
+        for (uint16_t i = 0; i < CANmodule->txSize; i++) {
+            CO_CANtx_t* other = &CANmodule->txArray[i];
+            if (other != buffer && other->bufferFull && !CO_CANtxIsBulk(CANmodule, other)) {
+                return true;
+            }
+        }
+    }
+
+    if (!__atomic_load_n(&CANmodule->busLoadBulkSent, __ATOMIC_RELAXED) || CANmodule->CANbitRate == 0) {
+        return false;
+    }
+
+    uint64_t limitBits = (uint64_t)CANmodule->CANbitRate * CO_DRIVER_BUSLOAD_WINDOW_US / 1000
+                         * CANmodule->busLoadLimit / 100;
+    uint32_t bits = __atomic_load_n(&CANmodule->busLoadBits, __ATOMIC_RELAXED)
+                    + CO_CANframeBits(buffer->ident, buffer->DLC);
+
+    return bits > limitBits;
+}
+
+/* 函数功能：设置批量发送流量的总线负载限值
+ * 参数说明：
+ *   CANmodule - CAN 模块对象指针
+ *   busLoadLimit - 总线负载限值（百分比），0 表示禁用限速
+ * 返回值说明：无返回值
+ */
+void
+CO_CANmodule_setBusLoadLimit(CO_CANmodule_t* CANmodule, uint8_t busLoadLimit) {
+    if (CANmodule != NULL) {
+        CANmodule->busLoadLimit = busLoadLimit > 100 ? 100 : busLoadLimit;
+    }
+}
+
+/* 函数功能：计算到下一次有意义的发送重试的时间
+ * 执行步骤：
+ *   步骤1: 没有等待的帧时返回 0
+ *   步骤2: 有不被限速的等待帧（套接字忙或实时帧）时返回 0，应尽快重试
+ *   步骤3: 只有被限速的批量帧时，返回到当前测量窗口结束的时间，新窗口中第一个批量帧总是允许发送
+ * 参数说明：
+ *   CANmodule - CAN 模块对象指针
+ * 返回值说明：到下一次重试的微秒数，最多 CO_DRIVER_BUSLOAD_WINDOW_US
+ */
+uint32_t
+CO_CANmodule_txRetryTime_us(CO_CANmodule_t* CANmodule) {
+    bool_t held = false;
+
+    if (CANmodule == NULL || CANmodule->CANtxCount == 0) {
+        return 0;
+    }
+    for (uint16_t i = 0; i < CANmodule->txSize; i++) {
+        CO_CANtx_t* buffer = &CANmodule->txArray[i];
+        if (buffer->bufferFull) {
+            if (!CO_CANtxBulkHold(CANmodule, buffer)) {
+                return 0;
+            }
+            held = true;
+        }
+    }
+    if (!held) {
+        return 0;
+    }
+
+    /* 限速的批量帧在当前窗口结束后发送，窗口使用系统时钟 */
+    /* throttled bulk frames are sent after the end of the current window, window uses system clock */
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t now_us = (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+    uint64_t end_us = __atomic_load_n(&CANmodule->busLoadWindow_us, __ATOMIC_RELAXED) + CO_DRIVER_BUSLOAD_WINDOW_US;
+
+    if (end_us <= now_us) {
+        return 0;
+    }
+    return end_us - now_us > CO_DRIVER_BUSLOAD_WINDOW_US ? CO_DRIVER_BUSLOAD_WINDOW_US : (uint32_t)(end_us - now_us);
+}
+
+#endif /* CO_DRIVER_MULTI_INTERFACE == 0 */
+
+/* 函数功能：设置接收批次回调
+ * 参数说明：
+ *   CANmodule - CAN 模块对象指针
+ *   object - 传给回调的对象
+ *   callback - 回调函数，NULL 表示禁用
+ * 返回值说明：无返回值
+ */
+void
+CO_CANmodule_setRxBatchCallback(CO_CANmodule_t* CANmodule, void* object,
+                                void (*callback)(void* object, const CO_CANrxFrame_t frames[], uint16_t count)) {
+    if (CANmodule != NULL) {
+        CANmodule->rxBatchCallback = callback;
+        CANmodule->rxBatchObject = object;
+    }
+}
+
 /* 函数功能：禁用 socketCAN 接收功能，停止接收所有 CAN 消息
  * 执行步骤：
  *   步骤1: 初始化返回值为无错误
@@ -255,7 +459,7 @@ CO_CANsetNormalMode(CO_CANmodule_t* CANmodule) {
  *   rxSize - 接收缓冲区数量
  *   txArray - 发送缓冲区数组
  *   txSize - 发送缓冲区数量
- *   CANbitRate - CAN 波特率（socketCAN 中未使用，由系统配置）
+ *   CANbitRate - CAN 波特率（kbit/s），socketCAN 中由系统配置，此处仅用于总线负载估算，0 表示未知
  * 返回值说明：
  *   CO_ERROR_NO - 初始化成功
  *   CO_ERROR_ILLEGAL_ARGUMENT - 参数无效
@@ -266,7 +470,6 @@ CO_CANmodule_init(CO_CANmodule_t* CANmodule, void* CANptr, CO_CANrx_t rxArray[],
                   uint16_t txSize, uint16_t CANbitRate) {
     int32_t ret;
     uint16_t i;
-    (void)CANbitRate; /* socketCAN 中波特率由系统配置，此参数未使用 */
 
     /* 步骤1: 验证参数有效性 */
     /* verify arguments */
@@ -289,6 +492,15 @@ CO_CANmodule_init(CO_CANmodule_t* CANmodule, void* CANptr, CO_CANrx_t rxArray[],
     CANmodule->CANerrorStatus = 0;
     CANmodule->CANnormal = false; /* 初始状态为非正常模式 */
     CANmodule->CANtxCount = 0;
+    CANmodule->CANbitRate = CANbitRate; /* 仅用于总线负载估算 */
+    CANmodule->busLoadLimit = 0;
+    CANmodule->busLoad = 0;
+    CANmodule->busLoadBits = 0;
+    CANmodule->busLoadWindow_us = 0;
+    CANmodule->busLoadBulkSent = false;
+    CANmodule->txBulkDeferred = 0;
+    CANmodule->rxBatchCallback = NULL;
+    CANmodule->rxBatchObject = NULL;
 
 #if CO_DRIVER_MULTI_INTERFACE > 0
     /* 步骤4: 初始化多接口模式下的 COB-ID 到索引的查找表 */
@@ -836,6 +1048,8 @@ CO_CANCheckSendInterface(CO_CANmodule_t* CANmodule, CO_CANtx_t* buffer, CO_CANin
         log_printf(LOG_ERR, DBG_CAN_TX_FAILED, buffer->ident, interface->ifName);
         log_printf(LOG_DEBUG, DBG_ERRNO, "send()");
         err = CO_ERROR_TX_OVERFLOW;
+    } else {
+        CO_CANbusLoadAccount(CANmodule, CO_CANframeBits(buffer->ident, buffer->DLC), NULL);
     }
 
     return err;
@@ -952,8 +1166,9 @@ CO_CANCheckSend(CO_CANmodule_t* CANmodule, CO_CANtx_t* buffer) {
  *   步骤1: 验证参数有效性
  *   步骤2: 获取第一个 CAN 接口
  *   步骤3: 检查发送缓冲区是否已满（溢出检测）
- *   步骤4: 调用 send() 尝试发送消息
- *   步骤5: 根据返回值处理不同情况：
+ *   步骤4: 总线负载限速：需要延迟的批量帧设置 bufferFull 标志并返回忙碌
+ *   步骤5: 调用 send() 尝试发送消息
+ *   步骤6: 根据返回值处理不同情况：
  *         - 成功：清除 bufferFull 标志
  *         - 忙碌：设置 bufferFull 标志，由 CO_CANmodule_process() 重发
  *         - 错误：记录错误状态
@@ -996,10 +1211,21 @@ CO_CANsend(CO_CANmodule_t* CANmodule, CO_CANtx_t* buffer) {
         err = CO_ERROR_TX_OVERFLOW;
     }
 
-    /* 步骤4: 尝试发送消息（非阻塞模式）*/
+    /* 步骤4: 总线负载限速，批量帧由 CO_CANmodule_process() 稍后发送 */
+    /* Bus load throttling, bulk frame will be sent later by CO_CANmodule_process() */
+    if (CO_CANtxBulkHold(CANmodule, buffer)) {
+        if (!buffer->bufferFull) {
+            buffer->bufferFull = true;
+            CANmodule->CANtxCount++;
+            CANmodule->txBulkDeferred++;
+        }
+        return err != CO_ERROR_NO ? err : CO_ERROR_TX_BUSY;
+    }
+
+    /* 步骤5: 尝试发送消息（非阻塞模式）*/
     errno = 0;
     ssize_t n = send(interface->fd, buffer, CAN_MTU, MSG_DONTWAIT);
-    /* 步骤5: 处理发送结果 */
+    /* 步骤6: 处理发送结果 */
     if (errno == 0 && n == CAN_MTU) {
         /* 发送成功 */
         /* success */
@@ -1007,6 +1233,10 @@ CO_CANsend(CO_CANmodule_t* CANmodule, CO_CANtx_t* buffer) {
             buffer->bufferFull = false;
             CANmodule->CANtxCount--;
         }
+        CO_CANbusLoadAccount(CANmodule, CO_CANframeBits(buffer->ident, buffer->DLC), NULL);
+        if (CO_CANtxIsBulk(CANmodule, buffer)) {
+            __atomic_store_n(&CANmodule->busLoadBulkSent, true, __ATOMIC_RELAXED);
+        }
     } else if (errno == EINTR || errno == EAGAIN || errno == ENOBUFS) {
         /* 发送失败，消息将由 CO_CANmodule_process() 重新发送 */
         /* Send failed, message will be re-sent by CO_CANmodule_process() */
@@ -1030,6 +1260,99 @@ CO_CANsend(CO_CANmodule_t* CANmodule, CO_CANtx_t* buffer) {
 
 #endif /* CO_DRIVER_MULTI_INTERFACE == 0 */
 
+/* 函数功能：在一个接口上用 sendmmsg() 批量发送 CAN 帧
+ * 执行步骤：
+ *   步骤1: 为每个帧准备 iovec 和消息头（CO_CANtx_t 的前 16 字节与 can_frame 兼容）
+ *   步骤2: 循环调用 sendmmsg()，直到所有帧发送完毕或 socket 队列满
+ *   步骤3: 统计已发送帧的总线负载
+ * 参数说明：
+ *   CANmodule - CAN 模块对象指针
+ *   interface - CAN 接口指针
+ *   frames - 要发送的帧数组
+ *   count - 帧数量
+ * 返回值说明：返回已发送的帧数量
+ */
+static uint16_t
+CO_CANsendBatchInterface(CO_CANmodule_t* CANmodule, CO_CANinterface_t* interface, CO_CANtx_t frames[],
+                         uint16_t count) {
+    struct mmsghdr msgs[CO_DRIVER_TX_BATCH_MAX];
+    struct iovec iovs[CO_DRIVER_TX_BATCH_MAX];
+    uint16_t sent = 0;
+
+    while (sent < count) {
+        unsigned int n = (count - sent) < CO_DRIVER_TX_BATCH_MAX ? (count - sent) : CO_DRIVER_TX_BATCH_MAX;
+
+        memset(msgs, 0, sizeof(msgs[0]) * n);
+        for (unsigned int i = 0; i < n; i++) {
+            iovs[i].iov_base = &frames[sent + i];
+            iovs[i].iov_len = CAN_MTU;
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int ret = sendmmsg(interface->fd, msgs, n, MSG_DONTWAIT);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        } else if (ret <= 0) {
+            /* socket 队列满（EAGAIN/ENOBUFS）或其他错误，剩余帧未发送 */
+            /* socket queue full (EAGAIN/ENOBUFS) or other error, remaining frames are not sent */
+            if (errno != EAGAIN && errno != ENOBUFS) {
+                log_printf(LOG_DEBUG, DBG_ERRNO, "sendmmsg()");
+            }
+#if CO_DRIVER_ERROR_REPORTING > 0
+            interface->errorhandler.CANerrorStatus |= CO_CAN_ERRTX_OVERFLOW;
+#endif
+            break;
+        }
+        struct timespec now;
+        (void)clock_gettime(CLOCK_REALTIME, &now);
+        for (int i = 0; i < ret; i++) {
+            CO_CANbusLoadAccount(CANmodule, CO_CANframeBits(frames[sent + i].ident, frames[sent + i].DLC), &now);
+        }
+        sent += (uint16_t)ret;
+    }
+
+    return sent;
+}
+
+/* 函数功能：批量发送 CAN 帧（一次系统调用发送多个帧）
+ * 执行步骤：
+ *   步骤1: 验证参数有效性
+ *   步骤2: 单接口模式下在第一个接口上发送，多接口模式下在每个接口上发送
+ * 参数说明：
+ *   CANmodule - CAN 模块对象指针
+ *   frames - 要发送的帧数组
+ *   count - 帧数量
+ * 返回值说明：
+ *   返回已发送的帧数量（多接口模式下为各接口中最少的数量），参数无效时返回 -1
+ */
+int
+CO_CANsendBatch(CO_CANmodule_t* CANmodule, CO_CANtx_t frames[], uint16_t count) {
+    if (CANmodule == NULL || frames == NULL || CANmodule->CANinterfaceCount == 0) {
+        return -1;
+    }
+
+#if CO_DRIVER_MULTI_INTERFACE == 0
+    CO_CANinterface_t* interface = &CANmodule->CANinterfaces[0];
+    if (interface->fd < 0) {
+        return -1;
+    }
+    return CO_CANsendBatchInterface(CANmodule, interface, frames, count);
+#else
+    uint16_t sentMin = count;
+    for (uint32_t i = 0; i < CANmodule->CANinterfaceCount; i++) {
+        CO_CANinterface_t* interface = &CANmodule->CANinterfaces[i];
+        if (interface->fd >= 0) {
+            uint16_t sent = CO_CANsendBatchInterface(CANmodule, interface, frames, count);
+            if (sent < sentMin) {
+                sentMin = sent;
+            }
+        }
+    }
+    return sentMin;
+#endif
+}
+
 /* 函数功能：清除待处理的同步 PDO 消息（socketCAN 中为空实现）
  * 说明：在 socketCAN 中，消息要么被写入 socket 队列，要么被丢弃，无需手动清除
  * 参数说明：
@@ -1048,7 +1371,7 @@ CO_CANclearPendingSyncPDOs(CO_CANmodule_t* CANmodule) {
  *   步骤1: 验证模块有效性
  *   步骤2: 更新 CAN 错误状态（如果启用错误报告）
  *   步骤3: 在单接口模式下，重发之前未成功发送的消息
- *   步骤4: 查找标记为 bufferFull 的发送缓冲区
+ *   步骤4: 查找标记为 bufferFull 的发送缓冲区，跳过仍被限速的批量帧
  *   步骤5: 尝试重新发送该消息
  * 参数说明：
  *   CANmodule - CAN 模块对象指针
@@ -1087,11 +1410,16 @@ CO_CANmodule_process(CO_CANmodule_t* CANmodule) {
             CO_CANtx_t* buffer = &CANmodule->txArray[i];
 
             if (buffer->bufferFull) {
+                found = true;
+                /* 被限速的批量帧让位于后面的实时帧 */
+                /* throttled bulk frame gives way to the following real-time frames */
+                if (CO_CANtxBulkHold(CANmodule, buffer)) {
+                    continue;
+                }
                 /* 步骤5: 清除标志并尝试重新发送 */
                 buffer->bufferFull = false;
                 CANmodule->CANtxCount--;
                 CO_CANsend(CANmodule, buffer);
-                found = true;
                 break; /* 每次处理一条消息 */
             }
         }
@@ -1104,87 +1432,109 @@ CO_CANmodule_process(CO_CANmodule_t* CANmodule) {
 #endif /* CO_DRIVER_MULTI_INTERFACE == 0 */
 }
 
-/* 函数功能：从 socket 读取 CAN 消息并验证错误
+/* 函数功能：用一次 recvmmsg() 从 socket 读取最多 maxCount 条 CAN 消息并验证错误
  * 执行步骤：
- *   步骤1: 准备 recvmsg() 所需的数据结构
- *   步骤2: 设置 IO 向量指向消息缓冲区
- *   步骤3: 设置消息头以接收控制信息（时间戳和溢出计数）
- *   步骤4: 调用 recvmsg() 从 socket 读取消息
- *   步骤5: 验证接收的数据大小是否正确
- *   步骤6: 遍历控制消息，提取时间戳和队列溢出信息
- *   步骤7: 处理接收队列溢出情况
+ *   步骤1: 为每条消息准备 IO 向量和消息头，数据直接读入 frames 数组
+ *   步骤2: 设置消息头以接收控制信息（时间戳和溢出计数）
+ *   步骤3: 调用 recvmmsg() 读取 socket 中等待的消息，不阻塞
+ *   步骤4: 验证每条消息的数据大小是否正确
+ *   步骤5: 遍历控制消息，提取时间戳和队列溢出信息
+ *   步骤6: 处理接收队列溢出情况
  * 参数说明：
  *   CANmodule - CAN 模块对象指针
  *   interface - CAN 接口指针
- *   msg - CAN 消息结构指针（输出参数）
- *   timestamp - 消息时间戳指针（输出参数）
+ *   frames - 接收帧数组（输出参数），时间戳和接口索引也被设置
+ *   maxCount - 最多读取的消息数量，1 .. CO_DRIVER_RX_BATCH_MAX
  * 返回值说明：
- *   CO_ERROR_NO - 读取成功
- *   CO_ERROR_SYSCALL - 系统调用失败
- * 注意：使用 recvmsg() 而非 read()，以获取 socket 的统计信息
+ *   读取的消息数量，没有等待的消息时返回 0，系统调用失败时返回 -1
+ * 注意：使用 recvmmsg() 而非 read()，以获取 socket 的统计信息
  */
-/* Read CAN message from socket and verify some errors */
-static CO_ReturnError_t
-CO_CANread(CO_CANmodule_t* CANmodule, CO_CANinterface_t* interface,
-           struct can_frame* msg,      /* CAN 消息，返回值 - CAN message, return value */
-           struct timespec* timestamp) /* CAN 消息的时间戳，返回值 - timestamp of CAN message, return value */
-{
-    int32_t n;
+/* Read up to maxCount CAN messages from socket with one recvmmsg() call and verify some errors */
+static int32_t
+CO_CANread(CO_CANmodule_t* CANmodule, CO_CANinterface_t* interface, CO_CANrxFrame_t frames[], uint16_t maxCount) {
     uint32_t dropped;
-    /* 步骤1: recvmsg - 类似 read，但可以生成 socket 的统计信息（参考 berlios candump.c）*/
-    /* recvmsg - like read, but generates statistics about the socket example in berlios candump.c */
-    struct iovec iov;
-    struct msghdr msghdr;
-    char ctrlmsg[CMSG_SPACE(sizeof(struct timeval)) + CMSG_SPACE(sizeof(dropped))];
+    /* recvmmsg - 类似 read，但可以生成 socket 的统计信息（参考 berlios candump.c）*/
+    /* recvmmsg - like read, but generates statistics about the socket example in berlios candump.c */
+    struct mmsghdr msgs[CO_DRIVER_RX_BATCH_MAX];
+    struct iovec iovs[CO_DRIVER_RX_BATCH_MAX];
+    char ctrlmsgs[CO_DRIVER_RX_BATCH_MAX][CMSG_SPACE(3 * sizeof(struct timespec)) + CMSG_SPACE(sizeof(dropped))];
     struct cmsghdr* cmsg;
+    int32_t count = 0;
 
-    /* 步骤2: 设置 IO 向量指向消息缓冲区 */
-    iov.iov_base = msg;
-    iov.iov_len = sizeof(*msg);
-
-    /* 步骤3: 配置消息头结构以接收辅助数据 */
-    msghdr.msg_name = NULL;
-    msghdr.msg_namelen = 0;
-    msghdr.msg_iov = &iov;
-    msghdr.msg_iovlen = 1;
-    msghdr.msg_control = &ctrlmsg; /* 用于接收控制消息（时间戳等）*/
-    msghdr.msg_controllen = sizeof(ctrlmsg);
-    msghdr.msg_flags = 0;
-
-    /* 步骤4: 从 socket 接收消息 */
-    n = recvmsg(interface->fd, &msghdr, 0);
-    /* 步骤5: 检查接收的数据大小 */
-    if (n != CAN_MTU) {
+    if (maxCount > CO_DRIVER_RX_BATCH_MAX) {
+        maxCount = CO_DRIVER_RX_BATCH_MAX;
+    }
+
+    /* 步骤1, 2: CANopenNode CAN 消息与 socketCAN 消息二进制兼容，直接读入帧数组 */
+    /* CANopenNode can message is binary compatible to the socketCAN one, read directly into frames */
+    memset(msgs, 0, sizeof(msgs[0]) * maxCount);
+    for (uint16_t i = 0; i < maxCount; i++) {
+        iovs[i].iov_base = &frames[i].msg;
+        iovs[i].iov_len = CAN_MTU;
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_control = ctrlmsgs[i]; /* 用于接收控制消息（时间戳等）*/
+        msgs[i].msg_hdr.msg_controllen = sizeof(ctrlmsgs[i]);
+    }
+
+    /* 步骤3: 读取等待的消息，epoll 已报告至少一条 */
+    /* read waiting messages, epoll reported at least one */
+    int n = recvmmsg(interface->fd, msgs, maxCount, MSG_DONTWAIT, NULL);
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return 0;
+        }
 #if CO_DRIVER_ERROR_REPORTING > 0
         interface->errorhandler.CANerrorStatus |= CO_CAN_ERRRX_OVERFLOW;
 #endif
         log_printf(LOG_DEBUG, DBG_CAN_RX_FAILED, interface->ifName);
-        log_printf(LOG_DEBUG, DBG_ERRNO, "recvmsg()");
-        return CO_ERROR_SYSCALL;
+        log_printf(LOG_DEBUG, DBG_ERRNO, "recvmmsg()");
+        return -1;
     }
 
-    /* 步骤6: 检查接收队列溢出，获取接收时间 */
-    /* check for rx queue overflow, get rx time */
-    for (cmsg = CMSG_FIRSTHDR(&msghdr); cmsg && (cmsg->cmsg_level == SOL_SOCKET); cmsg = CMSG_NXTHDR(&msghdr, cmsg)) {
-        if (cmsg->cmsg_type == SO_TIMESTAMPING) {
-            /* 这是系统时间，不是单调时间！*/
-            /* this is system time, not monotonic time! */
-            *timestamp = ((struct timespec*)CMSG_DATA(cmsg))[0];
-        } else if (cmsg->cmsg_type == SO_RXQ_OVFL) {
-            /* 步骤7: 处理接收队列溢出 */
-            dropped = *(uint32_t*)CMSG_DATA(cmsg);
-            if (dropped > CANmodule->rxDropCount) {
+    for (int i = 0; i < n; i++) {
+        struct msghdr* msghdr = &msgs[i].msg_hdr;
+        CO_CANrxFrame_t* frame = &frames[count];
+
+        /* 步骤4: 检查接收的数据大小 */
+        if (msgs[i].msg_len != CAN_MTU) {
 #if CO_DRIVER_ERROR_REPORTING > 0
-                interface->errorhandler.CANerrorStatus |= CO_CAN_ERRRX_OVERFLOW;
+            interface->errorhandler.CANerrorStatus |= CO_CAN_ERRRX_OVERFLOW;
 #endif
-                log_printf(LOG_ERR, CAN_RX_SOCKET_QUEUE_OVERFLOW, interface->ifName, dropped);
+            log_printf(LOG_DEBUG, DBG_CAN_RX_FAILED, interface->ifName);
+            continue;
+        }
+        if (count != i) {
+            frame->msg = frames[i].msg;
+        }
+        frame->timestamp.tv_sec = 0;
+        frame->timestamp.tv_nsec = 0;
+        frame->can_ifindex = interface->can_ifindex;
+
+        /* 步骤5: 检查接收队列溢出，获取接收时间 */
+        /* check for rx queue overflow, get rx time */
+        for (cmsg = CMSG_FIRSTHDR(msghdr); cmsg && (cmsg->cmsg_level == SOL_SOCKET); cmsg = CMSG_NXTHDR(msghdr, cmsg)) {
+            if (cmsg->cmsg_type == SO_TIMESTAMPING) {
+                /* 这是系统时间，不是单调时间！*/
+                /* this is system time, not monotonic time! */
+                frame->timestamp = ((struct timespec*)CMSG_DATA(cmsg))[0];
+            } else if (cmsg->cmsg_type == SO_RXQ_OVFL) {
+                /* 步骤6: 处理接收队列溢出 */
+                dropped = *(uint32_t*)CMSG_DATA(cmsg);
+                if (dropped > CANmodule->rxDropCount) {
+#if CO_DRIVER_ERROR_REPORTING > 0
+                    interface->errorhandler.CANerrorStatus |= CO_CAN_ERRRX_OVERFLOW;
+#endif
+                    log_printf(LOG_ERR, CAN_RX_SOCKET_QUEUE_OVERFLOW, interface->ifName, dropped);
+                }
+                CANmodule->rxDropCount = dropped;
+                // todo 使用此信息！- use this info!
             }
-            CANmodule->rxDropCount = dropped;
-            // todo 使用此信息！- use this info!
         }
+        count++;
     }
 
-    return CO_ERROR_NO;
+    return count;
 }
 
 /* 函数功能：在接收数组中查找匹配的消息并调用相应的回调函数
@@ -1259,11 +1609,12 @@ CO_CANrxMsg(                                                  /* 返回接收消
  *   步骤3: 处理不同类型的 epoll 事件：
  *         - EPOLLERR/EPOLLHUP: socket 错误或关闭
  *         - EPOLLIN: 有数据可读
- *   步骤4: 读取 CAN 消息和时间戳
+ *   步骤4: 用一次 recvmmsg() 读取 CAN 消息和时间戳（手动模式下一条，否则所有等待的消息）
  *   步骤5: 区分错误帧和数据帧：
  *         - 错误帧：调用错误处理函数
  *         - 数据帧：调用消息处理函数
  *   步骤6: 存储接收到的消息信息（时间戳和接口索引）
+ *   步骤7: 把一次读取的所有数据帧交给接收批次回调
  * 参数说明：
  *   CANmodule - CAN 模块对象指针
  *   ev - epoll 事件结构指针
@@ -1296,22 +1647,25 @@ CO_CANrxFromEpoll(CO_CANmodule_t* CANmodule, struct epoll_event* ev, CO_CANrxMsg
                 recv(ev->data.fd, &msg, sizeof(msg), MSG_DONTWAIT);
                 log_printf(LOG_DEBUG, DBG_CAN_RX_EPOLL, ev->events, strerror(errno));
             } else if ((ev->events & EPOLLIN) != 0) {
-                /* 可读事件 - 有新消息到达 */
-                struct can_frame msg;
-                struct timespec timestamp;
+                /* 可读事件 - 有新消息到达。手动模式下每次读取一条，否则读取所有等待的消息 */
+                /* new messages arrived. One message in manual mode, otherwise all waiting messages */
+                CO_CANrxFrame_t frames[CO_DRIVER_RX_BATCH_MAX];
+                uint16_t maxCount = (buffer != NULL || msgIndex != NULL) ? 1 : CO_DRIVER_RX_BATCH_MAX;
+                uint16_t batchCount = 0;
 
                 /* 步骤4: 获取消息 */
-                /* get message */
-                CO_ReturnError_t err = CO_CANread(CANmodule, interface, &msg, &timestamp);
+                /* get messages */
+                int32_t count = CO_CANread(CANmodule, interface, frames, maxCount);
 
-                if (err == CO_ERROR_NO && CANmodule->CANnormal) {
+                for (int32_t j = 0; j < count && CANmodule->CANnormal; j++) {
+                    struct can_frame* msg = (struct can_frame*)&frames[j].msg;
 
                     /* 步骤5: 区分错误帧和数据帧 */
-                    if (msg.can_id & CAN_ERR_FLAG) {
+                    if (msg->can_id & CAN_ERR_FLAG) {
                         /* 错误消息 */
                         /* error msg */
 #if CO_DRIVER_ERROR_REPORTING > 0
-                        CO_CANerror_rxMsgError(&interface->errorhandler, &msg);
+                        CO_CANerror_rxMsgError(&interface->errorhandler, msg);
 #endif
                     } else {
                         /* 数据消息 */
@@ -1321,19 +1675,35 @@ CO_CANrxFromEpoll(CO_CANmodule_t* CANmodule, struct epoll_event* ev, CO_CANrxMsg
                         /* clear listenOnly and noackCounter if necessary */
                         CO_CANerror_rxMsg(&interface->errorhandler);
 #endif
+                        /* 使用帧的内核时间戳，接收路径不读取时钟 */
+                        /* use kernel time stamp of the frame, rx path does not read the clock */
+                        CO_CANbusLoadAccount(CANmodule, CO_CANframeBits(msg->can_id, msg->can_dlc),
+                                             &frames[j].timestamp);
                         /* 处理接收到的数据消息 */
-                        int32_t idx = CO_CANrxMsg(CANmodule, &msg, buffer);
+                        int32_t idx = CO_CANrxMsg(CANmodule, msg, buffer);
                         if (idx > -1) {
                             /* 步骤6: 存储消息信息 */
                             /* Store message info */
-                            CANmodule->rxArray[idx].timestamp = timestamp;
+                            CANmodule->rxArray[idx].timestamp = frames[j].timestamp;
                             CANmodule->rxArray[idx].can_ifindex = interface->can_ifindex;
                         }
                         if (msgIndex != NULL) {
                             *msgIndex = idx;
                         }
+                        /* 数据帧连续地留在数组中，用于接收批次回调 */
+                        /* data frames stay contiguous in the array for receive batch callback */
+                        if (batchCount != j) {
+                            frames[batchCount] = frames[j];
+                        }
+                        batchCount++;
                     }
                 }
+
+                /* 步骤7: 所有帧处理完后，把整批数据帧交给应用程序 */
+                /* pass the whole batch of data frames to the application after all frames are processed */
+                if (batchCount > 0 && CANmodule->rxBatchCallback != NULL) {
+                    CANmodule->rxBatchCallback(CANmodule->rxBatchObject, frames, batchCount);
+                }
             } else {
                 /* 未知的 epoll 事件 */
                 log_printf(LOG_DEBUG, DBG_EPOLL_UNKNOWN, ev->events, ev->data.fd);
@@ -128,7 +128,7 @@ extern "C" {
 #endif
 
 #ifndef CO_CONFIG_CRC16
-#define CO_CONFIG_CRC16 (CO_CONFIG_CRC16_ENABLE)
+#define CO_CONFIG_CRC16 (CO_CONFIG_CRC16_ENABLE | CO_CONFIG_CRC16_EXTERNAL)
 #endif
 
 #ifndef CO_CONFIG_FIFO
@@ -209,6 +209,72 @@ ip link set canX type can berr-reporting on
 #define CO_DRIVER_ERROR_REPORTING 1
 #endif
 
+/* 总线负载测量窗口（微秒）
+ * 功能说明：驱动统计所有接收和发送 CAN 帧的位数，并在此时间窗口内计算总线负载。
+ *         总线负载用于批量发送流量的限速，参见 CO_CANmodule_setBusLoadLimit()
+ * 默认值：20000（20 毫秒），可以被覆盖
+ */
+/**
+ * Bus load measurement window in microseconds
+ *
+ * Driver counts bits of all received and transmitted CAN frames and calculates bus load over this window. Bus load is
+ * used for throttling of bulk transmit traffic, see @ref CO_CANmodule_setBusLoadLimit().
+ *
+ * Macro is set to 20000 by default. It can be overridden.
+ */
+#ifndef CO_DRIVER_BUSLOAD_WINDOW_US
+#define CO_DRIVER_BUSLOAD_WINDOW_US 20000
+#endif
+
+/* 批量发送流量的 CAN 标识符范围
+ * 功能说明：此范围内的发送帧被视为批量流量，当总线负载超过限值或有实时帧等待发送时被延迟。
+ *         默认为 SDO 客户端请求（0x600 + 服务器节点 ID），即网关产生的 SDO 传输
+ * 默认值：0x601 .. 0x67F，可以被覆盖
+ */
+/**
+ * Range of CAN identifiers, which are treated as bulk transmit traffic
+ *
+ * Transmit frames in this range are held back, if bus load is over the limit or if real-time frames are waiting for
+ * transmission. Default are SDO client requests (0x600 + server node-ID), which are produced by SDO transfers from the
+ * gateway.
+ *
+ * Macros are set to 0x601 .. 0x67F by default. They can be overridden.
+ */
+#ifndef CO_DRIVER_BULK_IDENT_MIN
+#define CO_DRIVER_BULK_IDENT_MIN 0x601
+#endif
+#ifndef CO_DRIVER_BULK_IDENT_MAX
+#define CO_DRIVER_BULK_IDENT_MAX 0x67F
+#endif
+
+/* 批量发送时每次 sendmmsg() 调用的最大帧数
+ * 默认值：32，可以被覆盖
+ */
+/**
+ * Maximum number of frames per sendmmsg() call in @ref CO_CANsendBatch()
+ *
+ * Macro is set to 32 by default. It can be overridden.
+ */
+#ifndef CO_DRIVER_TX_BATCH_MAX
+#define CO_DRIVER_TX_BATCH_MAX 32
+#endif
+
+/* 接收时每次 recvmmsg() 调用的最大帧数
+ * 功能说明：CO_CANrxFromEpoll() 在一次接收中最多读取这么多帧，并作为一批交给接收批次回调，
+ *         参见 CO_CANmodule_setRxBatchCallback()
+ * 默认值：32，可以被覆盖
+ */
+/**
+ * Maximum number of frames received with one recvmmsg() call in @ref CO_CANrxFromEpoll()
+ *
+ * Frames read in one receive pass are passed as one batch to the callback, see @ref CO_CANmodule_setRxBatchCallback().
+ *
+ * Macro is set to 32 by default. It can be overridden.
+ */
+#ifndef CO_DRIVER_RX_BATCH_MAX
+#define CO_DRIVER_RX_BATCH_MAX 32
+#endif
+
 /* skip this section for Doxygen, because it is documented in CO_driver.h */
 #ifndef CO_DOXYGEN
 
@@ -269,6 +335,20 @@ CO_CANrxMsg_readData(void* rxMsg) {
     return (uint8_t*)(rxMsgCasted->data);
 }
 
+/* 带时间戳的接收帧，接收批次的元素
+ * 结构说明：一次接收中读取的帧以此类型的连续数组交给接收批次回调
+ * 成员说明：
+ *   - msg: CAN 消息，与 socketCAN 的 can_frame 二进制兼容
+ *   - timestamp: 接收时间戳（系统时钟，内核软件时间戳）
+ *   - can_ifindex: 接收帧的 CAN 接口索引
+ */
+/* Received frame with time stamp, element of receive batch */
+typedef struct {
+    CO_CANrxMsg_t msg;         /* CAN message, binary compatible with socketCAN can_frame */
+    struct timespec timestamp; /* time of reception, system clock */
+    int can_ifindex;           /* CAN Interface index */
+} CO_CANrxFrame_t;
+
 /* 接收消息对象结构体
  * 结构说明：定义 CAN 接收消息的完整对象，包含标识符、掩码、回调函数和时间戳等信息
  * 成员说明：
@@ -362,6 +442,14 @@ typedef struct {
  *   - CANnormal: CAN 正常运行标志（易失性）
  *   - CANtxCount: CAN 发送计数（易失性）
  *   - epoll_fd: epoll 文件描述符，用于等待 CAN 接收事件
+ *   - CANbitRate: CAN 波特率（kbit/s），来自 CO_CANmodule_init()，0 表示未知
+ *   - busLoadLimit: 批量发送流量的总线负载限值（百分比），0 表示禁用限速
+ *   - busLoad: 上一个完整测量窗口内的总线负载（百分比）
+ *   - busLoadBits: 当前测量窗口内接收和发送的位数
+ *   - busLoadWindow_us: 当前测量窗口的起始时间（微秒，系统时钟，与接收时间戳相同）
+ *   - busLoadBulkSent: 当前测量窗口内是否已发送批量帧（原子访问）
+ *   - txBulkDeferred: 因限速而被延迟的批量帧数量（统计信息）
+ *   - rxBatchCallback, rxBatchObject: 接收批次回调和它的对象，每次接收调用一次
  *   - rxIdentToIndex: COB ID 到接收数组索引的查找表（仅用于标准帧消息，多接口模式）
  *   - txIdentToIndex: COB ID 到发送数组索引的查找表（仅用于标准帧消息，多接口模式）
  */
@@ -380,6 +468,16 @@ typedef struct {
     volatile bool_t CANnormal;
     volatile uint16_t CANtxCount;
     int epoll_fd; /* File descriptor for epoll, which waits for CAN receive event */
+    uint16_t CANbitRate;       /* CAN bit rate in kbit/s from CO_CANmodule_init(), 0 if unknown */
+    uint8_t busLoadLimit;      /* bus load limit for bulk transmit traffic in percent, 0 = throttling disabled */
+    uint8_t busLoad;           /* bus load in percent, measured in the last complete window */
+    uint32_t busLoadBits;      /* bits received and transmitted in the current measurement window */
+    uint64_t busLoadWindow_us; /* start time of the current measurement window, system clock as rx time stamps */
+    bool_t busLoadBulkSent;    /* bulk frame was already transmitted in the current window, atomic access */
+    uint32_t txBulkDeferred;   /* number of bulk frames held back by throttling, statistics */
+    /* called once per receive pass with all data frames read, see CO_CANmodule_setRxBatchCallback() */
+    void (*rxBatchCallback)(void* object, const CO_CANrxFrame_t frames[], uint16_t count);
+    void* rxBatchObject;
 #if CO_DRIVER_MULTI_INTERFACE > 0 || defined CO_DOXYGEN
     /* Lookup tables Cob ID to rx/tx array index.  Only feasible for SFF Messages. */
     uint32_t rxIdentToIndex[CO_CAN_MSG_SFF_MAX_COB_ID];
@@ -395,6 +493,14 @@ typedef struct {
 #define CO_STORAGE_PATH_MAX 255
 #endif
 
+/* OD 写钩子，见 CO_storageLinux.h */
+/* OD write hook, see CO_storageLinux.h */
+struct CO_storageLinux_hook;
+
+/* 存储对象的 Linux 状态，见 CO_storageLinux.c */
+/* Linux state of the storage object, see CO_storageLinux.c */
+struct CO_storageLinux;
+
 /* 单个数据存储条目对象
  * 结构说明：表示一个数据存储条目，包含数据地址、长度和文件信息
  * 成员说明：
@@ -404,7 +510,18 @@ typedef struct {
  *   - attr: 属性标志
  *   - filename: 存储数据块的文件名（包括路径）
  *   - crc: 之前存储的数据的 CRC 校验和，用于自动存储
- *   - fp: 已打开文件的指针，用于自动存储
+ *   - dirty: 自上次自动存储后数据已改变，由 OD 写钩子或 CO_storageLinux_markDirty() 设置
+ *   - dirtyFirst_us, dirtyLast_us: 第一次和最后一次未保存改变的时间（单调时钟）
+ *   - autoSaveError: 上次自动存储失败
+ *   - hooks, hooksCount: 安装在映射到本条目的 OD 对象上的写钩子
+ *   - snapshot: 自动存储的快照缓冲区（数据和 CRC），在 OD 锁内复制，由写线程写入
+ *   - writeState: 快照的写状态（空闲、排队、正在写）
+ *   - snapshotTime_us: 快照时间，用于存储延时统计
+ *   - journal: 日志模式，只把改变的字节范围追加到日志文件 <filename>.jrn，由应用程序设置
+ *   - stored: 存储中数据的副本，日志模式下用于查找改变的字节范围
+ *   - journalFd, journalSize: 已打开的日志文件和它的大小
+ *   - defaults: "恢复默认参数"之后存储默认值，自动存储暂停到下一次"存储参数"命令
+ *   - owner: 条目所属存储对象的 Linux 状态，由 CO_storageLinux_init() 设置
  */
 /* Data storage object for one entry */
 typedef struct {
@@ -414,7 +531,21 @@ typedef struct {
     uint8_t attr;
     char filename[CO_STORAGE_PATH_MAX]; /* Name of the file, where data block is stored */
     uint16_t crc;                       /* CRC checksum of the data stored previously, for auto storage */
-    FILE* fp;                           /* Pointer to opened file, for auto storage */
+    volatile uint8_t dirty;             /* Data changed since last auto storage */
+    uint64_t dirtyFirst_us;             /* Time of the first unsaved change, monotonic clock */
+    uint64_t dirtyLast_us;              /* Time of the last change, monotonic clock */
+    bool_t autoSaveError;               /* Last auto storage failed, retried after CO_STORAGE_AUTO_INTERVAL */
+    struct CO_storageLinux_hook* hooks; /* OD write hooks on objects inside this entry, for auto storage */
+    uint16_t hooksCount;
+    uint8_t* snapshot;                  /* Snapshot of data and CRC for auto storage, written by writer thread */
+    volatile uint8_t writeState;        /* Write state of the snapshot: idle, queued or being written */
+    uint64_t snapshotTime_us;           /* Time of the snapshot, for storage latency statistics */
+    bool_t journal;                     /* Append only changed byte ranges to journal file <filename>.jrn */
+    uint8_t* stored;                    /* Copy of the data in storage, for changed ranges in journal mode */
+    int journalFd;                      /* Opened journal file or -1 */
+    size_t journalSize;                 /* Size of the journal file */
+    bool_t defaults;                    /* Default values are stored after 0x1011, auto storage waits for 0x1010 */
+    struct CO_storageLinux* owner;      /* Linux state of the storage object, set by CO_storageLinux_init() */
 } CO_storage_entry_t;
 
 #ifdef CO_SINGLE_THREAD
@@ -573,6 +704,7 @@ CO_ReturnError_t CO_CANtxBuffer_setInterface(CO_CANmodule_t* CANmodule, uint16_t
  * 使用说明：此函数可以两种方式结合使用：
  *         1. 自动模式：如果为匹配的 _rxArray_ 指定了 CANrx_callback，则自动调用其回调函数
  *         2. 手动模式：评估消息过滤器，返回接收到的消息
+ *         不使用 buffer 和 msgIndex 时，一次读取所有等待的消息并交给接收批次回调，手动模式下每次读取一条
  * 参数说明：
  *   - CANmodule: CAN 模块对象
  *   - ev: 要验证匹配的 epoll 事件
@@ -596,6 +728,10 @@ CO_ReturnError_t CO_CANtxBuffer_setInterface(CO_CANmodule_t* CANmodule, uint16_t
  * - automatic mode: If CANrx_callback is specified for matched _rxArray_, then   calls its callback.
  * - manual mode: evaluate message filters, return received message
  *
+ * Without _buffer_ and _msgIndex_ all waiting messages (up to @ref CO_DRIVER_RX_BATCH_MAX) are read in one pass and
+ * passed to the receive batch callback, see @ref CO_CANmodule_setRxBatchCallback(). In manual mode one message is
+ * read per call.
+ *
  * @param CANmodule This object.
  * @param ev Epoll event, which vill be verified for matches.
  * @param [out] buffer Storage for received message or _NULL_ if not used.
@@ -606,6 +742,113 @@ CO_ReturnError_t CO_CANtxBuffer_setInterface(CO_CANmodule_t* CANmodule, uint16_t
  */
 bool_t CO_CANrxFromEpoll(CO_CANmodule_t* CANmodule, struct epoll_event* ev, CO_CANrxMsg_t* buffer, int32_t* msgIndex);
 
+#if CO_DRIVER_MULTI_INTERFACE == 0 || defined CO_DOXYGEN
+/* 设置批量发送流量的总线负载限值
+ * 函数功能：启用批量发送帧（CO_DRIVER_BULK_IDENT_MIN .. CO_DRIVER_BULK_IDENT_MAX）的自适应限速。
+ *         批量帧在以下情况下被延迟，并由 CO_CANmodule_process() 稍后发送：
+ *         1. 有其他（实时）帧在 CANtxCount 中等待发送
+ *         2. 当前测量窗口的位数加上此帧将超过限值（需要已知 CANbitRate）
+ *         每个测量窗口至少允许发送一个批量帧，因此 SDO 传输不会超时
+ * 使用说明：必须在每次 CO_CANmodule_init() 之后调用。仅在 CO_DRIVER_MULTI_INTERFACE == 0 时可用，多接口模式的
+ *         发送没有重试，被延迟的帧会丢失
+ * 参数说明：
+ *   - CANmodule: CAN 模块对象
+ *   - busLoadLimit: 总线负载限值（1 .. 100 百分比），0 表示禁用限速
+ * 返回值说明：无返回值
+ */
+/**
+ * Set bus load limit for bulk transmit traffic
+ *
+ * Enables adaptive throttling of bulk transmit frames (@ref CO_DRIVER_BULK_IDENT_MIN .. @ref CO_DRIVER_BULK_IDENT_MAX).
+ * Bulk frame is held back and later transmitted from @ref CO_CANmodule_process(), if:
+ * - other (real-time) frames are waiting for transmission in CANtxCount, or
+ * - bits of the current measurement window plus this frame would exceed the limit (CANbitRate must be known).
+ *
+ * At least one bulk frame per measurement window is always transmitted, so SDO transfers do not time out. Held back
+ * frame keeps CO_CANtx_t->bufferFull set, so SDO client pauses block sub-blocks automatically.
+ *
+ * Function must be called after each CO_CANmodule_init(). It is available for CO_DRIVER_MULTI_INTERFACE == 0 only,
+ * transmission in multi interface mode has no retry, so held back frames would be lost.
+ *
+ * @param CANmodule This object.
+ * @param busLoadLimit Bus load limit in percent (1 .. 100). 0 disables throttling.
+ */
+void CO_CANmodule_setBusLoadLimit(CO_CANmodule_t* CANmodule, uint8_t busLoadLimit);
+
+/* 到下一次发送重试的时间
+ * 函数功能：等待的帧中有不被限速的帧时返回 0。只有被限速的批量帧时，返回到当前测量窗口结束的时间，
+ *         这样主线程的定时器可以直接设置到下一次允许发送的时刻，而不是周期性轮询
+ * 参数说明：
+ *   - CANmodule: CAN 模块对象
+ * 返回值说明：微秒数，0 表示尽快重试
+ */
+/**
+ * Get time until the next useful retry of unsent frames
+ *
+ * If only throttled bulk frames are waiting, they may be sent at the end of the current bus load measurement window,
+ * so mainline timer is set to that deadline instead of polling. Used by @ref CO_epoll_processMain().
+ *
+ * @param CANmodule This object.
+ *
+ * @return Time in microseconds (up to @ref CO_DRIVER_BUSLOAD_WINDOW_US), 0 if there are no frames waiting or some of
+ * them are not throttled and should be retried as soon as possible.
+ */
+uint32_t CO_CANmodule_txRetryTime_us(CO_CANmodule_t* CANmodule);
+#endif /* CO_DRIVER_MULTI_INTERFACE == 0 */
+
+/* 设置接收批次回调
+ * 函数功能：CO_CANrxFromEpoll() 在一次接收中用 recvmmsg() 读取套接字中所有等待的帧（最多
+ *         CO_DRIVER_RX_BATCH_MAX 个），先由 CANopen 对象逐帧处理，然后以带时间戳的连续数组调用一次回调。
+ *         错误帧和 CAN 非正常模式下接收的帧不包括在内。回调在调用 CO_CANrxFromEpoll() 的线程中运行，
+ *         必须快速执行完成
+ * 使用说明：必须在每次 CO_CANmodule_init() 之后调用
+ * 参数说明：
+ *   - CANmodule: CAN 模块对象
+ *   - object: 传给回调的对象
+ *   - callback: 回调函数，NULL 表示禁用
+ * 返回值说明：无返回值
+ */
+/**
+ * Set receive batch callback
+ *
+ * @ref CO_CANrxFromEpoll() drains all frames waiting in the socket (up to @ref CO_DRIVER_RX_BATCH_MAX) with one
+ * recvmmsg() call. Frames are first processed by CANopen objects one by one, then callback is called once with all
+ * data frames as a contiguous array with time stamps, so application can process them together. Error frames and
+ * frames received outside CAN normal mode are not included. Callback runs in the thread, which calls
+ * CO_CANrxFromEpoll() (realtime thread, if used), and must be fast.
+ *
+ * Function must be called after each CO_CANmodule_init().
+ *
+ * @param CANmodule This object.
+ * @param object Object passed to callback.
+ * @param callback Callback function or NULL to disable it.
+ */
+void CO_CANmodule_setRxBatchCallback(CO_CANmodule_t* CANmodule, void* object,
+                                     void (*callback)(void* object, const CO_CANrxFrame_t frames[], uint16_t count));
+
+/* 批量发送 CAN 帧
+ * 函数功能：用 sendmmsg() 一次发送多个帧，例如网关发往多个节点的 NMT 命令。
+ *         帧不使用 bufferFull 机制：队列满时剩余帧不发送，由调用者处理
+ * 参数说明：
+ *   - CANmodule: CAN 模块对象
+ *   - frames: 帧数组，ident、DLC 和 data 必须已设置
+ *   - count: 帧数量
+ * 返回值说明：已发送的帧数量（多接口模式下为各接口中最少的数量），参数无效时返回 -1
+ */
+/**
+ * Send CAN frames in a batch
+ *
+ * Frames are sent back-to-back with sendmmsg(), for example NMT commands from the gateway to a set of nodes. Frames
+ * do not use bufferFull mechanism: if socket queue is full, remaining frames are not sent and caller must handle them.
+ *
+ * @param CANmodule This object.
+ * @param frames Array of frames with ident, DLC and data set.
+ * @param count Number of frames.
+ *
+ * @return Number of frames sent (smallest number of all interfaces in multi interface mode) or -1 on wrong arguments.
+ */
+int CO_CANsendBatch(CO_CANmodule_t* CANmodule, CO_CANtx_t frames[], uint16_t count);
+
 /** @} */
 
 #ifdef __cplusplus
@@ -42,9 +42,24 @@
 #include <netinet/in.h>
 #include <signal.h>
 
+#include "CO_asciiLinux.h"
+
 #ifndef LISTEN_BACKLOG
 #define LISTEN_BACKLOG 50
 #endif
+
+/* 节点集合命令行的解析状态 */
+/* parser states of command line with node-set */
+#define GTW_LINE_HEAD    0 /* 命令行开始，收集到节点字段为止 */
+#define GTW_LINE_PASS    1 /* 普通命令，直接传递给网关直到行尾 */
+#define GTW_LINE_BATCH   2 /* 节点集合命令，收集整行 */
+#define GTW_LINE_DISCARD 3 /* 命令行过长，丢弃直到行尾 */
+
+/* 每次主线程处理中，网关最多连续执行的已缓冲命令数量 */
+/* maximum number of buffered gateway commands executed in one mainline pass */
+#ifndef CO_GTWA_PROCESS_BURST
+#define CO_GTWA_PROCESS_BURST 32
+#endif
 #endif /* (CO_CONFIG_GTW) & CO_CONFIG_GTW_ASCII */
 
 /* 当 CAN TX 缓冲区满时，重新调用 CANsend() 的延迟时间（微秒） */
@@ -434,8 +449,10 @@ CO_epoll_initCANopenMain(CO_epoll_t* ep, CO_t* co) {
  * 执行步骤：
  *   步骤1：参数有效性检查
  *   步骤2：调用 CO_process() 处理 CANopen 对象并获取复位命令
- *   步骤3：检查 CAN 发送缓冲区是否有未发送的消息
- *   步骤4：如果有未发送消息且定时器间隔较长，则缩短定时器间隔以尽快发送
+ *   步骤3：网关空闲且命令缓冲区中还有完整命令时，连续执行这些命令（最多 CO_GTWA_PROCESS_BURST 条），
+ *          剩余的命令在下一次循环中立即处理，而不是等待下一个事件或定时器
+ *   步骤4：检查 CAN 发送缓冲区是否有未发送的消息
+ *   步骤5：如果有未发送消息且定时器间隔较长，则缩短定时器间隔以尽快发送
  * 
  * 参数说明：
  *   ep - epoll 对象指针
@@ -456,11 +473,39 @@ CO_epoll_processMain(CO_epoll_t* ep, CO_t* co, bool_t enableGateway, CO_NMT_rese
     /* process CANopen objects */
     *reset = CO_process(co, enableGateway, ep->timeDifference_us, &ep->timerNext_us);
 
-    /* 如果有未发送的 CAN 消息，提前调用 CO_CANmodule_process() */
-    /* If there are unsent CAN messages, call CO_CANmodule_process() earlier */
-    if (co->CANmodule->CANtxCount > 0 && ep->timerNext_us > CANSEND_DELAY_US) {
-        ep->timerNext_us = CANSEND_DELAY_US;
+#if (CO_CONFIG_GTW) & CO_CONFIG_GTW_ASCII
+    /* 网关每次调用只解析一条命令。对于已完成的（本地）命令，继续执行缓冲区中的下一条命令 */
+    /* Gateway parses one command per call. If command has finished (local commands), execute the next buffered one */
+    if (enableGateway && co->gtwa != NULL) {
+        CO_GTWA_t* gtwa = co->gtwa;
+        uint16_t burst = 0;
+
+        while (gtwa->state == CO_GTWA_ST_IDLE && !gtwa->respHold && CO_fifo_CommSearch(&gtwa->commFifo, false)) {
+            if (++burst > CO_GTWA_PROCESS_BURST) {
+                /* 让出处理器给其他事件，下次循环立即继续 */
+                /* yield to other events, continue immediately in the next loop */
+                ep->timerNext_us = 0;
+                break;
+            }
+            CO_GTWA_process(gtwa, true, 0, &ep->timerNext_us);
+        }
+    }
+#endif
+
+#if CO_DRIVER_MULTI_INTERFACE == 0
+    /* 如果有未发送的 CAN 消息，提前调用 CO_CANmodule_process()。只有被限速的批量帧时，定时器设置到允许发送的时刻 */
+    /* If there are unsent CAN messages, call CO_CANmodule_process() earlier. If only throttled bulk frames are waiting,
+     * timer is set to the time, when they are allowed to be sent */
+    if (co->CANmodule->CANtxCount > 0) {
+        uint32_t retry_us = CO_CANmodule_txRetryTime_us(co->CANmodule);
+        if (retry_us < CANSEND_DELAY_US) {
+            retry_us = CANSEND_DELAY_US;
+        }
+        if (ep->timerNext_us > retry_us) {
+            ep->timerNext_us = retry_us;
+        }
     }
+#endif
 }
 
 /* CAN 接收和实时处理 ********************************************************/
@@ -539,18 +584,18 @@ CO_epoll_processRT(CO_epoll_t* ep, CO_t* co, bool_t realtime) {
 /*
  * 函数功能：从网关 ASCII 对象写入响应字符串
  * 
- * 本函数作为回调函数被 CANopen 网关模块调用，用于将响应数据写入到客户端连接。
+ * 本函数作为回调函数被 CANopen 网关模块调用，用于将响应数据写入到当前拥有网关的客户端连接。
  * 
  * 执行步骤：
- *   步骤1：将 object 指针转换为文件描述符指针
+ *   步骤1：将 object 指针转换为网关对象指针
  *   步骤2：初始化 nWritten 为 count（错误时清空数据）
- *   步骤3：检查文件描述符有效性
- *   步骤4：调用 write() 写入数据到套接字
+ *   步骤3：节点集合 SDO 写命令执行时，捕获子命令的响应；否则检查文件描述符有效性
+ *   步骤4：调用 write() 写入数据到套接字，并统计发送字节数
  *   步骤5：处理写入错误（EAGAIN 表示资源暂时不可用，需重试）
  *   步骤6：如果连接无效，设置 connectionOK 为 0
  * 
  * 参数说明：
- *   object - 文件描述符指针（void* 类型）
+ *   object - 网关对象指针（void* 类型）
  *   buf - 要写入的数据缓冲区
  *   count - 要写入的字节数
  *   connectionOK - 连接状态指针，用于返回连接是否正常
@@ -561,21 +606,45 @@ CO_epoll_processRT(CO_epoll_t* ep, CO_t* co, bool_t realtime) {
 /* write response string from gateway-ascii object */
 static size_t
 gtwa_write_response(void* object, const char* buf, size_t count, uint8_t* connectionOK) {
-    int* fd = (int*)object;
+    CO_epoll_gtw_t* epGtw = (CO_epoll_gtw_t*)object;
     /* nWritten = count -> 出错时（文件描述符不存在）数据被清空 */
     /* nWritten = count -> in case of error (non-existing fd) data are purged */
     size_t nWritten = count;
 
-    if (fd != NULL && *fd >= 0) {
-        ssize_t n = write(*fd, (const void*)buf, count);
+    if (epGtw != NULL && epGtw->batch.active && !epGtw->batch.waiting) {
+        /* 捕获节点集合 SDO 写命令的子命令响应，并尽快继续处理 */
+        /* capture response of the node-set sub-command and continue as soon as possible */
+        CO_epoll_gtwBatch_t* batch = &epGtw->batch;
+        size_t copy = sizeof(batch->resp) - 1 - batch->respLen;
+        if (copy > count) {
+            copy = count;
+        }
+        memcpy(&batch->resp[batch->respLen], buf, copy);
+        batch->respLen += copy;
+        batch->resp[batch->respLen] = '\0';
+        if (memchr(buf, '\n', count) != NULL) {
+            batch->respDone = true;
+            if (epGtw->ep != NULL) {
+                epGtw->ep->timerNext_us = 0;
+            }
+        }
+    } else if (epGtw != NULL && epGtw->gtwa_fd >= 0) {
+        ssize_t n = write(epGtw->gtwa_fd, (const void*)buf, count);
         if (n >= 0) {
             nWritten = (size_t)n;
+            if (epGtw->owner != NULL) {
+                epGtw->owner->statTxBytes += nWritten;
+            }
         } else {
             /* 可能是 EAGAIN - "资源暂时不可用"。需要重试。 */
             /* probably EAGAIN - "Resource temporarily unavailable". Retry. */
             log_printf(LOG_DEBUG, DBG_ERRNO, "write(gtwa_response)");
             nWritten = 0;
         }
+        if (epGtw->batch.waiting && epGtw->ep != NULL && memchr(buf, '\n', count) != NULL) {
+            /* 之前的命令完成，尽快执行等待的节点集合命令 */
+            epGtw->ep->timerNext_us = 0;
+        }
     } else {
         *connectionOK = 0;
     }
@@ -583,9 +652,9 @@ gtwa_write_response(void* object, const char* buf, size_t count, uint8_t* connec
 }
 
 /*
- * 函数功能：为 epoll 启用套接字接受功能
+ * 函数功能：为 epoll 启用监听器的套接字接受功能
  * 
- * 本函数修改 epoll 监听的套接字事件，使用 EPOLLONESHOT 标志确保每次只处理一个连接。
+ * 本函数修改 epoll 监听的套接字事件，使用 EPOLLONESHOT 标志确保每个监听器每次只处理一个连接。
  * 
  * 执行步骤：
  *   步骤1：初始化 epoll_event 结构
@@ -594,36 +663,691 @@ gtwa_write_response(void* object, const char* buf, size_t count, uint8_t* connec
  * 
  * 参数说明：
  *   epGtw - 网关 epoll 对象指针
+ *   l - 监听器指针
  * 
  * 返回值说明：
  *   无返回值
  */
 static inline void
-socketAcceptEnableForEpoll(CO_epoll_gtw_t* epGtw) {
+socketAcceptEnableForEpoll(CO_epoll_gtw_t* epGtw, CO_epoll_gtwListener_t* l) {
     struct epoll_event ev = {0};
     int ret;
 
     ev.events = EPOLLIN | EPOLLONESHOT;
-    ev.data.fd = epGtw->gtwa_fdSocket;
+    ev.data.fd = l->fdSocket;
     ret = epoll_ctl(epGtw->epoll_fd, EPOLL_CTL_MOD, ev.data.fd, &ev);
     if (ret < 0) {
         log_printf(LOG_CRIT, DBG_ERRNO, "epoll_ctl(gtwa_fdSocket)");
     }
 }
 
+/*
+ * 函数功能：暂停或恢复监听器 I/O 流上的 epoll 读事件
+ * 说明：当其他监听器拥有网关时，暂停的连接数据保留在套接字中，避免电平触发的 epoll 空转
+ * 参数说明：
+ *   epGtw - 网关 epoll 对象指针
+ *   l - 监听器指针
+ *   park - true 暂停，false 恢复
+ * 返回值说明：无返回值
+ */
+static void
+gtwListenerPark(CO_epoll_gtw_t* epGtw, CO_epoll_gtwListener_t* l, bool_t park) {
+    struct epoll_event ev = {0};
+
+    if (l->fd < 0 || l->parked == park) {
+        return;
+    }
+    ev.events = park ? 0 : EPOLLIN;
+    ev.data.fd = l->fd;
+    if (epoll_ctl(epGtw->epoll_fd, EPOLL_CTL_MOD, ev.data.fd, &ev) < 0) {
+        log_printf(LOG_CRIT, DBG_ERRNO, "epoll_ctl(mod, gtwa_fd)");
+    }
+    l->parked = park;
+}
+
+/*
+ * 函数功能：获取监听器的描述文字，用于日志
+ * 参数说明：
+ *   l - 监听器指针
+ *   buf - 输出缓冲区
+ *   size - 缓冲区大小
+ * 返回值说明：返回 buf
+ */
+static const char*
+gtwListenerName(const CO_epoll_gtwListener_t* l, char* buf, size_t size) {
+    if (l->commandInterface == CO_COMMAND_IF_STDIO) {
+        snprintf(buf, size, "standard IO");
+    } else if (l->commandInterface == CO_COMMAND_IF_LOCAL_SOCKET) {
+        snprintf(buf, size, "local socket \"%s\"", l->localSocketPath);
+    } else {
+        snprintf(buf, size, "tcp port %d", (int)l->commandInterface);
+    }
+    return buf;
+}
+
+/*
+ * 函数功能：关闭监听器上已建立的连接，并重新启用套接字接受
+ * 执行步骤：
+ *   步骤1：从 epoll 中删除并关闭 I/O 流
+ *   步骤2：如果该监听器拥有网关，释放网关
+ *   步骤3：套接字模式下重新启用接受下一个连接
+ * 参数说明：
+ *   epGtw - 网关 epoll 对象指针
+ *   l - 监听器指针
+ * 返回值说明：无返回值
+ */
+static void
+gtwListenerCloseConnection(CO_epoll_gtw_t* epGtw, CO_epoll_gtwListener_t* l) {
+    if (l->fd < 0) {
+        return;
+    }
+    if (epoll_ctl(epGtw->epoll_fd, EPOLL_CTL_DEL, l->fd, NULL) < 0) {
+        log_printf(LOG_CRIT, DBG_ERRNO, "epoll_ctl(del, gtwa_fd)");
+    }
+    if (close(l->fd) < 0) {
+        log_printf(LOG_CRIT, DBG_ERRNO, "close(gtwa_fd)");
+    }
+    if (epGtw->owner == l) {
+        /* 丢弃未完成的命令行 */
+        epGtw->owner = NULL;
+        epGtw->gtwa_fd = -1;
+        epGtw->lineState = GTW_LINE_HEAD;
+        epGtw->lineLen = 0;
+        epGtw->pendingLen = 0;
+        if (epGtw->batch.waiting) {
+            epGtw->batch.waiting = false;
+            epGtw->batch.active = false;
+        }
+    }
+    l->fd = -1;
+    l->parked = false;
+    l->freshCommand = true;
+    if (l->fdSocket >= 0) {
+        socketAcceptEnableForEpoll(epGtw, l);
+    }
+}
+
+/*
+ * 函数功能：向当前连接写入网关响应（节点集合命令的汇总响应）
+ * 参数说明：
+ *   epGtw - 网关 epoll 对象指针
+ *   resp - 以 NULL 结尾的响应字符串
+ * 返回值说明：无返回值
+ */
+static void
+gtwRespond(CO_epoll_gtw_t* epGtw, const char* resp) {
+    uint8_t connectionOK = 1;
+    bool_t active = epGtw->batch.active;
+
+    /* 不捕获自己的响应 */
+    epGtw->batch.active = false;
+    (void)gtwa_write_response(epGtw, resp, strlen(resp), &connectionOK);
+    epGtw->batch.active = active;
+}
+
+/*
+ * 函数功能：判断标记是否为节点集合（列表、范围或 "all"）
+ * 参数说明：
+ *   tok - 标记
+ *   len - 标记长度
+ * 返回值说明：true 表示节点集合
+ */
+static bool_t
+gtwIsNodeSet(const char* tok, size_t len) {
+    if (len >= 3 && strncmp(tok, "all", 3) == 0 && (len == 3 || tok[3] == ':')) {
+        return true;
+    }
+    if (len == 0 || !CO_ascii_isDigit(tok[0])) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (tok[i] == ',' || tok[i] == '-') {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * 函数功能：根据命令行开始部分判断是否为节点集合命令
+ * 执行步骤：
+ *   步骤1：注释行和没有序列号的行直接传递
+ *   步骤2：取出节点字段（序列号之后的第一个标记，或网络号之后的第二个标记）
+ *   步骤3：标记尚未结束时需要更多数据
+ * 参数说明：
+ *   line - 命令行开始部分
+ *   len - 长度
+ *   complete - 命令行是否已完整（包含换行符）
+ * 返回值说明：GTW_LINE_HEAD（需要更多数据）、GTW_LINE_PASS 或 GTW_LINE_BATCH
+ */
+static uint8_t
+gtwLineClassify(const char* line, size_t len, bool_t complete) {
+    size_t pos = 0, tokLen;
+    const char* tok = CO_ascii_token(line, len, &pos, &tokLen);
+
+    if (tokLen == 0) {
+        return complete ? GTW_LINE_PASS : GTW_LINE_HEAD;
+    }
+    if (tok[0] != '[') {
+        return GTW_LINE_PASS;
+    }
+    const char* seqEnd = memchr(tok, ']', len - (size_t)(tok - line));
+    if (seqEnd == NULL) {
+        return complete ? GTW_LINE_PASS : GTW_LINE_HEAD;
+    }
+
+    pos = (size_t)(seqEnd - line) + 1;
+    for (uint8_t field = 0; field < 2; field++) {
+        tok = CO_ascii_token(line, len, &pos, &tokLen);
+        if (!complete && pos == len) {
+            return GTW_LINE_HEAD; /* 标记可能尚未结束 */
+        }
+        if (gtwIsNodeSet(tok, tokLen)) {
+            return GTW_LINE_BATCH;
+        }
+        if (tokLen == 0 || CO_ascii_spanDigits(tok, tokLen) != tokLen) {
+            break; /* 不是网络号 */
+        }
+    }
+    return GTW_LINE_PASS;
+}
+
+/*
+ * 函数功能：把节点集合展开为节点 ID 列表
+ * 执行步骤：
+ *   步骤1："all" 或 "all:<state>"：心跳消费者监视的节点，可按 NMT 状态筛选
+ *   步骤2：否则解析逗号分隔的节点 ID 和范围（1 .. 127）
+ * 参数说明：
+ *   co - CANopen 对象指针
+ *   tok - 节点集合标记
+ *   len - 标记长度
+ *   nodes - 输出节点 ID 数组（127 个元素）
+ * 返回值说明：返回节点数量，语法错误时返回 -1
+ */
+static int
+gtwNodeSetExpand(CO_t* co, const char* tok, size_t len, uint8_t nodes[]) {
+    bool_t selected[128] = {false};
+    int count = 0;
+
+    if (strncmp(tok, "all", 3) == 0) {
+#if (CO_CONFIG_HB_CONS) & CO_CONFIG_HB_CONS_ENABLE
+        const char* state = len > 4 ? &tok[4] : NULL;
+        size_t stateLen = len > 4 ? len - 4 : 0;
+        CO_HBconsumer_t* HBcons = co->HBcons;
+
+        if (len == 4) {
+            return -1;
+        }
+        for (uint8_t i = 0; HBcons != NULL && i < HBcons->numberOfMonitoredNodes; i++) {
+            CO_HBconsNode_t* monitoredNode = &HBcons->monitoredNodes[i];
+            uint8_t nodeId = monitoredNode->nodeId;
+            bool_t known = monitoredNode->HBstate == CO_HBconsumer_ACTIVE;
+            bool_t match;
+
+            if (nodeId < 1 || nodeId > 127) {
+                continue;
+            }
+            if (state == NULL) {
+                match = true;
+            } else if ((stateLen == 11 && strncmp(state, "operational", 11) == 0)
+                       || (stateLen == 2 && strncmp(state, "op", 2) == 0)) {
+                match = known && monitoredNode->NMTstate == CO_NMT_OPERATIONAL;
+            } else if ((stateLen == 5 && strncmp(state, "preop", 5) == 0)
+                       || (stateLen == 15 && strncmp(state, "pre-operational", 15) == 0)) {
+                match = known && monitoredNode->NMTstate == CO_NMT_PRE_OPERATIONAL;
+            } else if ((stateLen == 7 && strncmp(state, "stopped", 7) == 0)
+                       || (stateLen == 4 && strncmp(state, "stop", 4) == 0)) {
+                match = known && monitoredNode->NMTstate == CO_NMT_STOPPED;
+            } else if (stateLen == 7 && strncmp(state, "unknown", 7) == 0) {
+                match = !known;
+            } else {
+                return -1;
+            }
+            selected[nodeId] = selected[nodeId] || match;
+        }
+#else
+        return -1;
+#endif
+    } else {
+        size_t i = 0;
+        while (i < len) {
+            uint32_t first, last;
+            size_t used = CO_ascii_parseU32(&tok[i], len - i, &first);
+            if (used == 0) {
+                return -1;
+            }
+            i += used;
+            last = first;
+            if (i < len && tok[i] == '-') {
+                i++;
+                used = CO_ascii_parseU32(&tok[i], len - i, &last);
+                if (used == 0) {
+                    return -1;
+                }
+                i += used;
+            }
+            if (first < 1 || last > 127 || first > last || (i < len && tok[i] != ',')) {
+                return -1;
+            }
+            for (uint32_t n = first; n <= last; n++) {
+                selected[n] = true;
+            }
+            i++; /* 跳过 ',' */
+        }
+    }
+
+    for (uint8_t n = 1; n <= 127; n++) {
+        if (selected[n]) {
+            nodes[count++] = n;
+        }
+    }
+    return count;
+}
+
+/*
+ * 函数功能：把节点集合 SDO 写命令的下一个子命令写入网关
+ * 参数说明：
+ *   epGtw - 网关 epoll 对象指针
+ *   co - CANopen 对象指针
+ * 返回值说明：无返回值
+ */
+static void
+gtwBatchFeedNext(CO_epoll_gtw_t* epGtw, CO_t* co) {
+    CO_epoll_gtwBatch_t* batch = &epGtw->batch;
+    char sub[sizeof(batch->prefix) + sizeof(batch->command) + 8];
+    size_t prefixLen = strlen(batch->prefix);
+    size_t commandLen = strlen(batch->command);
+    size_t n = prefixLen;
+
+    /* 子命令 "<prefix><node> <command>\n" */
+    memcpy(sub, batch->prefix, prefixLen);
+    n += CO_ascii_formatU32(&sub[n], batch->nodes[batch->nodeIdx]);
+    sub[n++] = ' ';
+    memcpy(&sub[n], batch->command, commandLen);
+    n += commandLen;
+    sub[n++] = '\n';
+
+    batch->respLen = 0;
+    batch->respDone = false;
+    if (CO_GTWA_write(co->gtwa, sub, n) != n) {
+        /* 网关缓冲区没有空间，作为失败节点处理 */
+        batch->respLen = (size_t)snprintf(batch->resp, sizeof(batch->resp), "[0] ERROR:102\r\n");
+        batch->respDone = true;
+    }
+}
+
+/*
+ * 函数功能：执行节点集合命令（完整的命令行）
+ * 执行步骤：
+ *   步骤1：解析序列号、可选的网络号、节点集合和命令
+ *   步骤2：展开节点集合
+ *   步骤3：NMT 命令：构造所有 NMT 帧并用 CO_CANsendBatch() 一次发送，本节点使用内部命令
+ *   步骤4：SDO 写命令：保存子命令并开始逐个节点执行
+ *   步骤5：其他命令返回 "不支持的请求" 错误
+ * 参数说明：
+ *   epGtw - 网关 epoll 对象指针
+ *   co - CANopen 对象指针
+ * 返回值说明：无返回值
+ */
+static void
+gtwBatchExecute(CO_epoll_gtw_t* epGtw, CO_t* co) {
+    const char* line = epGtw->line;
+    size_t len = epGtw->lineLen;
+    size_t pos = 0, tokLen, netLen = 0;
+    const char* seq;
+    const char* net = NULL;
+    const char* tok;
+    uint8_t nodes[127];
+    char resp[sizeof(epGtw->batch.failed) + 64];
+
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+        len--;
+    }
+
+    /* 序列号 */
+    seq = CO_ascii_token(line, len, &pos, &tokLen);
+    pos = (size_t)((const char*)memchr(seq, ']', len - (size_t)(seq - line)) - line) + 1;
+    int seqLen = (int)(&line[pos] - seq);
+
+    /* 可选的网络号和节点集合 */
+    tok = CO_ascii_token(line, len, &pos, &tokLen);
+    if (!gtwIsNodeSet(tok, tokLen)) {
+        net = tok;
+        netLen = tokLen;
+        tok = CO_ascii_token(line, len, &pos, &tokLen);
+    }
+    int count = gtwNodeSetExpand(co, tok, tokLen, nodes);
+    if (count < 0) {
+        snprintf(resp, sizeof(resp), "%.*s ERROR:101 #Syntax error in command.\r\n", seqLen, seq);
+        gtwRespond(epGtw, resp);
+        return;
+    }
+
+    /* 命令 */
+    const char* cmd = CO_ascii_token(line, len, &pos, &tokLen);
+    size_t cmdLen = tokLen;
+    const char* cmdRest = cmd;
+    uint8_t nmtCommand = 0;
+
+    if (cmdLen == 5 && strncmp(cmd, "start", 5) == 0) {
+        nmtCommand = CO_NMT_ENTER_OPERATIONAL;
+    } else if (cmdLen == 4 && strncmp(cmd, "stop", 4) == 0) {
+        nmtCommand = CO_NMT_ENTER_STOPPED;
+    } else if ((cmdLen == 5 && strncmp(cmd, "preop", 5) == 0)
+               || (cmdLen == 14 && strncmp(cmd, "preoperational", 14) == 0)) {
+        nmtCommand = CO_NMT_ENTER_PRE_OPERATIONAL;
+    } else if (cmdLen == 5 && strncmp(cmd, "reset", 5) == 0) {
+        const char* what = CO_ascii_token(line, len, &pos, &tokLen);
+        if (tokLen == 4 && strncmp(what, "node", 4) == 0) {
+            nmtCommand = CO_NMT_RESET_NODE;
+        } else if ((tokLen == 4 && strncmp(what, "comm", 4) == 0)
+                   || (tokLen == 13 && strncmp(what, "communication", 13) == 0)) {
+            nmtCommand = CO_NMT_RESET_COMMUNICATION;
+        }
+    }
+
+#if (CO_CONFIG_GTW) & CO_CONFIG_GTW_ASCII_NMT
+    if (nmtCommand != 0) {
+        CO_CANtx_t frames[127];
+        int sent;
+        bool_t local = false;
+
+        memset(frames, 0, sizeof(frames[0]) * (size_t)count);
+        for (int i = 0; i < count; i++) {
+            frames[i].ident = 0x000; /* NMT service */
+            frames[i].DLC = 2;
+            frames[i].data[0] = nmtCommand;
+            frames[i].data[1] = nodes[i];
+            if (nodes[i] == co->NMT->nodeId) {
+                local = true;
+            }
+        }
+        sent = count > 0 ? CO_CANsendBatch(co->CANmodule, frames, (uint16_t)count) : 0;
+        if (local) {
+            /* 本节点也执行命令，与 CO_NMT_sendCommand() 相同 */
+            /* apply command also to this node, the same as CO_NMT_sendCommand() does */
+            CO_NMT_sendInternalCommand(co->NMT, (CO_NMT_command_t)nmtCommand);
+        }
+
+        if (sent == count) {
+            snprintf(resp, sizeof(resp), "%.*s OK\r\n", seqLen, seq);
+        } else {
+            int first = sent < 0 ? 0 : sent;
+            int used = snprintf(resp, sizeof(resp), "%.*s ERROR:102 #failed nodes: ", seqLen, seq);
+            for (int i = first; i < count && used < (int)sizeof(resp) - 8; i++) {
+                if (i > first) {
+                    resp[used++] = ',';
+                }
+                used += (int)CO_ascii_formatU32(&resp[used], nodes[i]);
+            }
+            snprintf(&resp[used], sizeof(resp) - (size_t)used, "\r\n");
+        }
+        gtwRespond(epGtw, resp);
+        return;
+    }
+#endif
+
+#if (CO_CONFIG_GTW) & CO_CONFIG_GTW_ASCII_SDO
+    if ((cmdLen == 1 && cmd[0] == 'w') || (cmdLen == 5 && strncmp(cmd, "write", 5) == 0)) {
+        CO_epoll_gtwBatch_t* batch = &epGtw->batch;
+
+        if (count == 0) {
+            snprintf(resp, sizeof(resp), "%.*s OK\r\n", seqLen, seq);
+            gtwRespond(epGtw, resp);
+            return;
+        }
+        snprintf(batch->prefix, sizeof(batch->prefix), "%.*s %.*s%s", seqLen, seq, (int)netLen,
+                 net != NULL ? net : "", net != NULL ? " " : "");
+        snprintf(batch->command, sizeof(batch->command), "%.*s", (int)(len - (size_t)(cmdRest - line)), cmdRest);
+        memcpy(batch->nodes, nodes, (size_t)count);
+        batch->nodeCount = (uint8_t)count;
+        batch->nodeIdx = 0;
+        batch->failed[0] = '\0';
+        batch->firstError[0] = '\0';
+        batch->active = true;
+        gtwBatchFeedNext(epGtw, co);
+        return;
+    }
+#endif
+
+    (void)nmtCommand;
+    (void)net;
+    (void)netLen;
+    snprintf(resp, sizeof(resp), "%.*s ERROR:100 #Request not supported.\r\n", seqLen, seq);
+    gtwRespond(epGtw, resp);
+}
+
+/*
+ * 函数功能：处理节点集合 SDO 写命令的进度
+ * 执行步骤：
+ *   步骤1：等待当前子命令的响应
+ *   步骤2：记录失败的节点和第一个错误
+ *   步骤3：继续下一个节点，或在所有节点完成后发送汇总响应
+ * 参数说明：
+ *   epGtw - 网关 epoll 对象指针
+ *   co - CANopen 对象指针
+ * 返回值说明：无返回值
+ */
+static void
+gtwBatchProcess(CO_epoll_gtw_t* epGtw, CO_t* co) {
+    CO_epoll_gtwBatch_t* batch = &epGtw->batch;
+
+    if (batch->waiting) {
+        /* 先执行同一连接之前的命令，保持响应顺序 */
+        /* execute preceding commands first, keep order of responses */
+        if (co->gtwa->state != CO_GTWA_ST_IDLE || co->gtwa->respHold
+            || CO_fifo_getOccupied(&co->gtwa->commFifo) != 0) {
+            return;
+        }
+        batch->waiting = false;
+        batch->active = false;
+        gtwBatchExecute(epGtw, co);
+        epGtw->lineState = GTW_LINE_HEAD;
+        epGtw->lineLen = 0;
+    }
+
+    while (batch->active && batch->respDone) {
+        const char* result = memchr(batch->resp, ']', batch->respLen);
+        result = result != NULL ? result + 1 : batch->resp;
+        while (*result == ' ') {
+            result++;
+        }
+
+        if (strncmp(result, "OK", 2) != 0) {
+            size_t used = strlen(batch->failed);
+            if (used == 0) {
+                size_t errLen = strcspn(result, " \r\n");
+                if (errLen >= sizeof(batch->firstError)) {
+                    errLen = sizeof(batch->firstError) - 1;
+                }
+                memcpy(batch->firstError, result, errLen);
+                batch->firstError[errLen] = '\0';
+            }
+            if (used + 5 <= sizeof(batch->failed)) { /* ',', 3 digits, '\0' */
+                if (used > 0) {
+                    batch->failed[used++] = ',';
+                }
+                CO_ascii_formatU32(&batch->failed[used], batch->nodes[batch->nodeIdx]);
+            }
+        }
+
+        if (++batch->nodeIdx < batch->nodeCount) {
+            gtwBatchFeedNext(epGtw, co);
+            continue;
+        }
+
+        /* 所有节点完成，发送汇总响应 */
+        /* all nodes finished, send aggregated response */
+        char resp[sizeof(batch->prefix) + sizeof(batch->failed) + sizeof(batch->firstError) + 32];
+        size_t seqLen = strcspn(batch->prefix, "]") + 1;
+        if (batch->failed[0] == '\0') {
+            snprintf(resp, sizeof(resp), "%.*s OK\r\n", (int)seqLen, batch->prefix);
+        } else {
+            snprintf(resp, sizeof(resp), "%.*s %s #failed nodes: %s\r\n", (int)seqLen, batch->prefix,
+                     batch->firstError, batch->failed);
+        }
+        batch->active = false;
+        gtwRespond(epGtw, resp);
+        if (epGtw->owner != NULL) {
+            gtwListenerPark(epGtw, epGtw->owner, false);
+        }
+    }
+}
+
+/*
+ * 函数功能：把从连接读取的数据写入网关，识别节点集合命令
+ * 
+ * 普通命令在节点字段确定后直接传递给网关（包括长的流式 SDO 写命令）。
+ * 节点集合命令被收集为整行，由 gtwBatchExecute() 执行。节点集合 SDO 写命令开始执行后，
+ * 或者网关缓冲区已满时，函数返回，剩余的数据由调用者保存，之后继续处理。
+ * 
+ * 参数说明：
+ *   epGtw - 网关 epoll 对象指针
+ *   co - CANopen 对象指针
+ *   buf - 数据
+ *   count - 数据长度
+ * 返回值说明：返回已处理的数据长度
+ */
+static size_t
+gtwFeed(CO_epoll_gtw_t* epGtw, CO_t* co, const char* buf, size_t count) {
+    size_t consumed = 0;
+
+    while (consumed < count && !epGtw->batch.active) {
+        const char* data = &buf[consumed];
+        const char* nl = memchr(data, '\n', count - consumed);
+        size_t n = nl != NULL ? (size_t)(nl - data) + 1 : count - consumed;
+
+        if (epGtw->lineState == GTW_LINE_PASS) {
+            /* 网关缓冲区满时剩余的数据由调用者保存 */
+            /* if gateway buffer is full, caller keeps the rest of data */
+            size_t written = CO_GTWA_write(co->gtwa, data, n);
+            if (written < n) {
+                return consumed + written;
+            }
+        } else if (epGtw->lineState != GTW_LINE_DISCARD) {
+            /* 收集命令行开始部分或整个节点集合命令行 */
+            size_t space = sizeof(epGtw->line) - epGtw->lineLen;
+            size_t copy = n < space ? n : space;
+            memcpy(&epGtw->line[epGtw->lineLen], data, copy);
+            epGtw->lineLen += copy;
+
+            if (epGtw->lineState == GTW_LINE_HEAD) {
+                uint8_t state = gtwLineClassify(epGtw->line, epGtw->lineLen, nl != NULL && copy == n);
+                if (state == GTW_LINE_HEAD && epGtw->lineLen >= sizeof(epGtw->line)) {
+                    state = GTW_LINE_PASS;
+                }
+                if (state == GTW_LINE_PASS) {
+                    /* 收集的开始部分必须整个写入，否则撤销本次复制，数据由调用者保存 */
+                    /* collected beginning must be written as a whole, otherwise undo this copy, caller keeps data */
+                    if (CO_GTWA_write_getSpace(co->gtwa) < epGtw->lineLen) {
+                        epGtw->lineLen -= copy;
+                        return consumed;
+                    }
+                    CO_GTWA_write(co->gtwa, epGtw->line, epGtw->lineLen);
+                    epGtw->lineLen = 0;
+                    epGtw->lineState = state;
+                    if (copy < n) {
+                        size_t written = CO_GTWA_write(co->gtwa, &data[copy], n - copy);
+                        if (written < n - copy) {
+                            return consumed + copy + written;
+                        }
+                    }
+                }
+                epGtw->lineState = state;
+            }
+            if (epGtw->lineState == GTW_LINE_BATCH) {
+                if (copy < n) {
+                    /* 节点集合命令行过长 */
+                    char resp[48];
+                    size_t seqLen = strcspn(epGtw->line, "]") + 1;
+                    snprintf(resp, sizeof(resp), "%.*s ERROR:101\r\n", (int)(seqLen < 20 ? seqLen : 20), epGtw->line);
+                    gtwRespond(epGtw, resp);
+                    epGtw->lineState = GTW_LINE_DISCARD;
+                } else if (nl != NULL) {
+                    /* 命令行完整，在网关空闲后执行 */
+                    /* command line is complete, execute it when gateway is idle */
+                    epGtw->batch.waiting = true;
+                    epGtw->batch.active = true;
+                    consumed += n;
+                    break;
+                }
+            }
+        }
+
+        if (nl != NULL) {
+            epGtw->lineState = GTW_LINE_HEAD;
+            epGtw->lineLen = 0;
+        }
+        consumed += n;
+    }
+    return consumed;
+}
+
+/* 函数功能：处理从连接读取的数据，节点集合 SDO 写命令开始后剩余的数据被保存 */
+static void
+gtwFeedRead(CO_epoll_gtw_t* epGtw, CO_t* co, const char* buf, size_t count) {
+    size_t used = gtwFeed(epGtw, co, buf, count);
+
+    if (used < count) {
+        memcpy(epGtw->pending, &buf[used], count - used);
+        epGtw->pendingLen = count - used;
+    }
+}
+
 /*
  * 函数功能：创建网关套接字（核心网关初始化函数）
  * 
- * 本函数创建并配置 CANopen 网关的通信接口，支持三种模式：标准输入输出、
- * 本地 Unix 套接字和 TCP 套接字。网关允许外部应用通过命令行界面访问 CANopen 网络。
+ * 本函数初始化网关对象，并为 commandInterface 创建第一个监听器。其他监听器可以通过
+ * CO_epoll_addGtwListener() 添加。网关允许外部应用通过命令行界面访问 CANopen 网络。
  * 
  * 执行步骤：
  *   步骤1：参数有效性检查
  *   步骤2：初始化 epGtw 结构体的基本字段
+ *   步骤3：如果命令接口未禁用，添加第一个监听器
+ * 
+ * 参数说明：
+ *   epGtw - 网关 epoll 对象指针
+ *   epoll_fd - epoll 文件描述符
+ *   commandInterface - 命令接口类型（stdio/本地套接字/TCP套接字端口号）
+ *   socketTimeout_ms - 套接字超时时间（毫秒）
+ *   localSocketPath - 本地套接字路径（仅用于本地套接字模式）
+ * 
+ * 返回值说明：
+ *   CO_ERROR_NO - 成功创建
+ *   CO_ERROR_ILLEGAL_ARGUMENT - 参数无效
+ *   CO_ERROR_SYSCALL - 系统调用失败
+ */
+CO_ReturnError_t
+CO_epoll_createGtw(CO_epoll_gtw_t* epGtw, int epoll_fd, int32_t commandInterface, uint32_t socketTimeout_ms,
+                   char* localSocketPath) {
+    if (epGtw == NULL || epoll_fd < 0) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    memset(epGtw, 0, sizeof(CO_epoll_gtw_t));
+    epGtw->epoll_fd = epoll_fd;
+    epGtw->owner = NULL;
+    epGtw->gtwa_fd = -1;
+
+    if (commandInterface == CO_COMMAND_IF_DISABLED) {
+        return CO_ERROR_NO;
+    }
+    return CO_epoll_addGtwListener(epGtw, commandInterface, socketTimeout_ms, localSocketPath);
+}
+
+/*
+ * 函数功能：为网关添加一个命令接口监听器
+ * 
+ * 本函数支持三种模式：标准输入输出、本地 Unix 套接字和 TCP 套接字。所有监听器
+ * 共用同一个网关对象，每个监听器有自己的超时时间和统计信息。
+ * 
+ * 执行步骤：
+ *   步骤1：参数有效性检查（监听器数量、禁用的接口、重复的标准输入输出）
+ *   步骤2：初始化监听器的基本字段
  *   步骤3：根据 commandInterface 类型进行不同的配置：
  *     
  *     A. 标准输入输出模式 (CO_COMMAND_IF_STDIO)：
- *        步骤3.1：设置 gtwa_fd 为标准输入
+ *        步骤3.1：设置 fd 为标准输入
  *        步骤3.2：记录日志
  *     
  *     B. 本地套接字模式 (CO_COMMAND_IF_LOCAL_SOCKET)：
@@ -639,52 +1363,64 @@ socketAcceptEnableForEpoll(CO_epoll_gtw_t* epGtw) {
  *        步骤3.4：开始监听连接
  *        步骤3.5：忽略 SIGPIPE 信号
  *   
- *   步骤4：如果 gtwa_fd 有效，将其添加到 epoll 监听
- *   步骤5：如果 gtwa_fdSocket 有效，将其添加到 epoll 监听（EPOLLONESHOT 模式）
+ *   步骤4：如果 fd 有效，将其添加到 epoll 监听
+ *   步骤5：如果 fdSocket 有效，将其添加到 epoll 监听（EPOLLONESHOT 模式）
  * 
  * 参数说明：
  *   epGtw - 网关 epoll 对象指针
- *   epoll_fd - epoll 文件描述符
  *   commandInterface - 命令接口类型（stdio/本地套接字/TCP套接字端口号）
  *   socketTimeout_ms - 套接字超时时间（毫秒）
  *   localSocketPath - 本地套接字路径（仅用于本地套接字模式）
  * 
  * 返回值说明：
- *   CO_ERROR_NO - 成功创建
- *   CO_ERROR_ILLEGAL_ARGUMENT - 参数无效
+ *   CO_ERROR_NO - 成功添加
+ *   CO_ERROR_ILLEGAL_ARGUMENT - 参数无效或监听器过多
  *   CO_ERROR_SYSCALL - 系统调用失败
  */
 CO_ReturnError_t
-CO_epoll_createGtw(CO_epoll_gtw_t* epGtw, int epoll_fd, int32_t commandInterface, uint32_t socketTimeout_ms,
-                   char* localSocketPath) {
+CO_epoll_addGtwListener(CO_epoll_gtw_t* epGtw, int32_t commandInterface, uint32_t socketTimeout_ms,
+                        char* localSocketPath) {
     int ret;
     struct epoll_event ev = {0};
 
-    if (epGtw == NULL || epoll_fd < 0) {
+    if (epGtw == NULL || epGtw->listenerCount >= CO_EPOLL_GTW_LISTENERS_MAX
+        || (commandInterface != CO_COMMAND_IF_STDIO && commandInterface != CO_COMMAND_IF_LOCAL_SOCKET
+            && (commandInterface < CO_COMMAND_IF_TCP_SOCKET_MIN || commandInterface > CO_COMMAND_IF_TCP_SOCKET_MAX))
+        || (commandInterface == CO_COMMAND_IF_LOCAL_SOCKET && localSocketPath == NULL)) {
         return CO_ERROR_ILLEGAL_ARGUMENT;
     }
+    for (uint8_t i = 0; i < epGtw->listenerCount; i++) {
+        if (commandInterface == CO_COMMAND_IF_STDIO && epGtw->listeners[i].commandInterface == CO_COMMAND_IF_STDIO) {
+            return CO_ERROR_ILLEGAL_ARGUMENT;
+        }
+    }
 
-    epGtw->epoll_fd = epoll_fd;
-    epGtw->commandInterface = commandInterface;
+    CO_epoll_gtwListener_t* l = &epGtw->listeners[epGtw->listenerCount];
+    memset(l, 0, sizeof(CO_epoll_gtwListener_t));
+    l->commandInterface = commandInterface;
+    l->socketTimeout_us = (socketTimeout_ms < (UINT_MAX / 1000 - 1000000)) ? socketTimeout_ms * 1000
+                                                                           : (UINT_MAX - 1000000);
+    l->fdSocket = -1;
+    l->fd = -1;
+    l->freshCommand = true;
 
-    epGtw->socketTimeout_us = (socketTimeout_ms < (UINT_MAX / 1000 - 1000000)) ? socketTimeout_ms * 1000
-                                                                               : (UINT_MAX - 1000000);
-    epGtw->gtwa_fdSocket = -1;
-    epGtw->gtwa_fd = -1;
+    /* 监听器注册后再计数，失败时 CO_epoll_closeGtw() 只关闭已打开的描述符 */
+    /* count the listener first, so CO_epoll_closeGtw() can clean it up on error */
+    epGtw->listenerCount++;
 
     /* 模式 A：标准输入输出接口 */
     if (commandInterface == CO_COMMAND_IF_STDIO) {
-        epGtw->gtwa_fd = STDIN_FILENO;
+        l->fd = STDIN_FILENO;
         log_printf(LOG_INFO, DBG_COMMAND_STDIO_INFO);
     } else if (commandInterface == CO_COMMAND_IF_LOCAL_SOCKET) {
         /* 模式 B：本地 Unix 套接字接口 */
         struct sockaddr_un addr;
-        epGtw->localSocketPath = localSocketPath;
+        l->localSocketPath = localSocketPath;
 
         /* 创建、绑定并监听本地套接字 */
         /* Create, bind and listen local socket */
-        epGtw->gtwa_fdSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
-        if (epGtw->gtwa_fdSocket < 0) {
+        l->fdSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (l->fdSocket < 0) {
             log_printf(LOG_CRIT, DBG_ERRNO, "socket(local)");
             return CO_ERROR_SYSCALL;
         }
@@ -692,13 +1428,13 @@ CO_epoll_createGtw(CO_epoll_gtw_t* epGtw, int epoll_fd, int32_t commandInterface
         memset(&addr, 0, sizeof(struct sockaddr_un));
         addr.sun_family = AF_UNIX;
         strncpy(addr.sun_path, localSocketPath, sizeof(addr.sun_path) - 1);
-        ret = bind(epGtw->gtwa_fdSocket, (struct sockaddr*)&addr, sizeof(struct sockaddr_un));
+        ret = bind(l->fdSocket, (struct sockaddr*)&addr, sizeof(struct sockaddr_un));
         if (ret < 0) {
             log_printf(LOG_CRIT, DBG_COMMAND_LOCAL_BIND, localSocketPath);
             return CO_ERROR_SYSCALL;
         }
 
-        ret = listen(epGtw->gtwa_fdSocket, LISTEN_BACKLOG);
+        ret = listen(l->fdSocket, LISTEN_BACKLOG);
         if (ret < 0) {
             log_printf(LOG_CRIT, DBG_ERRNO, "listen(local)");
             return CO_ERROR_SYSCALL;
@@ -715,33 +1451,33 @@ CO_epoll_createGtw(CO_epoll_gtw_t* epGtw, int epoll_fd, int32_t commandInterface
         }
 
         log_printf(LOG_INFO, DBG_COMMAND_LOCAL_INFO, localSocketPath);
-    } else if (commandInterface >= CO_COMMAND_IF_TCP_SOCKET_MIN && commandInterface <= CO_COMMAND_IF_TCP_SOCKET_MAX) {
+    } else {
         /* 模式 C：TCP 套接字接口 */
         struct sockaddr_in addr;
         const int yes = 1;
 
         /* 创建、绑定并监听 TCP 套接字 */
         /* Create, bind and listen socket */
-        epGtw->gtwa_fdSocket = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
-        if (epGtw->gtwa_fdSocket < 0) {
+        l->fdSocket = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (l->fdSocket < 0) {
             log_printf(LOG_CRIT, DBG_ERRNO, "socket(tcp)");
             return CO_ERROR_SYSCALL;
         }
 
-        setsockopt(epGtw->gtwa_fdSocket, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(int));
+        setsockopt(l->fdSocket, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(int));
 
         memset(&addr, 0, sizeof(struct sockaddr_in));
         addr.sin_family = AF_INET;
         addr.sin_port = htons(commandInterface);
         addr.sin_addr.s_addr = INADDR_ANY;
 
-        ret = bind(epGtw->gtwa_fdSocket, (struct sockaddr*)&addr, sizeof(struct sockaddr_in));
+        ret = bind(l->fdSocket, (struct sockaddr*)&addr, sizeof(struct sockaddr_in));
         if (ret < 0) {
             log_printf(LOG_CRIT, DBG_COMMAND_TCP_BIND, commandInterface);
             return CO_ERROR_SYSCALL;
         }
 
-        ret = listen(epGtw->gtwa_fdSocket, LISTEN_BACKLOG);
+        ret = listen(l->fdSocket, LISTEN_BACKLOG);
         if (ret < 0) {
             log_printf(LOG_CRIT, DBG_ERRNO, "listen(tcp)");
             return CO_ERROR_SYSCALL;
@@ -758,26 +1494,25 @@ CO_epoll_createGtw(CO_epoll_gtw_t* epGtw, int epoll_fd, int32_t commandInterface
         }
 
         log_printf(LOG_INFO, DBG_COMMAND_TCP_INFO, commandInterface);
-    } else {
-        epGtw->commandInterface = CO_COMMAND_IF_DISABLED;
     }
 
-    /* 将通信文件描述符添加到 epoll 监听 */
-    if (epGtw->gtwa_fd >= 0) {
+    /* 将 fd 或 fdSocket 添加到 epoll */
+    /* Add fd or fdSocket to epoll */
+    if (l->fd >= 0) {
         ev.events = EPOLLIN;
-        ev.data.fd = epGtw->gtwa_fd;
+        ev.data.fd = l->fd;
         ret = epoll_ctl(epGtw->epoll_fd, EPOLL_CTL_ADD, ev.data.fd, &ev);
         if (ret < 0) {
             log_printf(LOG_CRIT, DBG_ERRNO, "epoll_ctl(gtwa_fd)");
             return CO_ERROR_SYSCALL;
         }
     }
-    if (epGtw->gtwa_fdSocket >= 0) {
+    if (l->fdSocket >= 0) {
         /* 准备 epoll 监听新的套接字连接。连接被接受后，将定义用于 I/O 操作的 fd */
         /* prepare epoll for listening for new socket connection. After
          * connection will be accepted, fd for io operation will be defined. */
         ev.events = EPOLLIN | EPOLLONESHOT;
-        ev.data.fd = epGtw->gtwa_fdSocket;
+        ev.data.fd = l->fdSocket;
         ret = epoll_ctl(epGtw->epoll_fd, EPOLL_CTL_ADD, ev.data.fd, &ev);
         if (ret < 0) {
             log_printf(LOG_CRIT, DBG_ERRNO, "epoll_ctl(gtwa_fdSocket)");
@@ -793,9 +1528,10 @@ CO_epoll_createGtw(CO_epoll_gtw_t* epGtw, int epoll_fd, int32_t commandInterface
  * 
  * 执行步骤：
  *   步骤1：参数有效性检查
- *   步骤2：根据接口类型关闭相应的文件描述符
- *   步骤3：对于本地套接字，从文件系统删除套接字文件
- *   步骤4：重置文件描述符为 -1
+ *   步骤2：对每个监听器记录统计信息
+ *   步骤3：根据接口类型关闭相应的文件描述符
+ *   步骤4：对于本地套接字，从文件系统删除套接字文件
+ *   步骤5：重置文件描述符为 -1
  * 
  * 参数说明：
  *   epGtw - 网关 epoll 对象指针
@@ -809,24 +1545,33 @@ CO_epoll_closeGtw(CO_epoll_gtw_t* epGtw) {
         return;
     }
 
-    if (epGtw->commandInterface == CO_COMMAND_IF_LOCAL_SOCKET) {
-        if (epGtw->gtwa_fd > 0) {
-            close(epGtw->gtwa_fd);
-        }
-        close(epGtw->gtwa_fdSocket);
-        /* 从文件系统中删除本地套接字文件 */
-        /* Remove local socket file from filesystem. */
-        if (remove(epGtw->localSocketPath) < 0) {
-            log_printf(LOG_CRIT, DBG_ERRNO, "remove(local)");
-        }
-    } else if (epGtw->commandInterface >= CO_COMMAND_IF_TCP_SOCKET_MIN) {
-        if (epGtw->gtwa_fd > 0) {
-            close(epGtw->gtwa_fd);
+    for (uint8_t i = 0; i < epGtw->listenerCount; i++) {
+        CO_epoll_gtwListener_t* l = &epGtw->listeners[i];
+        char name[64];
+
+        log_printf(LOG_INFO, DBG_COMMAND_STATS, gtwListenerName(l, name, sizeof(name)), l->statConnections,
+                   l->statCommands, (unsigned long long)l->statRxBytes, (unsigned long long)l->statTxBytes,
+                   l->statTimeouts);
+
+        if (l->commandInterface != CO_COMMAND_IF_STDIO) {
+            if (l->fd > 0) {
+                close(l->fd);
+            }
+            if (l->fdSocket >= 0) {
+                close(l->fdSocket);
+                /* 从文件系统中删除本地套接字文件 */
+                /* Remove local socket file from filesystem. */
+                if (l->commandInterface == CO_COMMAND_IF_LOCAL_SOCKET && remove(l->localSocketPath) < 0) {
+                    log_printf(LOG_CRIT, DBG_ERRNO, "remove(local)");
+                }
+            }
         }
-        close(epGtw->gtwa_fdSocket);
+        l->fd = -1;
+        l->fdSocket = -1;
     }
+    epGtw->listenerCount = 0;
+    epGtw->owner = NULL;
     epGtw->gtwa_fd = -1;
-    epGtw->gtwa_fdSocket = -1;
 }
 
 /*
@@ -835,7 +1580,7 @@ CO_epoll_closeGtw(CO_epoll_gtw_t* epGtw) {
  * 执行步骤：
  *   步骤1：参数有效性检查
  *   步骤2：初始化网关读取功能，设置响应写入回调函数
- *   步骤3：设置 freshCommand 标志为 true（用于标准输入模式）
+ *   步骤3：设置所有监听器的 freshCommand 标志为 true（用于标准输入模式）
  * 
  * 参数说明：
  *   epGtw - 网关 epoll 对象指针
@@ -850,49 +1595,57 @@ CO_epoll_initCANopenGtw(CO_epoll_gtw_t* epGtw, CO_t* co) {
         return;
     }
 
-    CO_GTWA_initRead(co->gtwa, gtwa_write_response, (void*)&epGtw->gtwa_fd);
-    epGtw->freshCommand = true;
+    CO_GTWA_initRead(co->gtwa, gtwa_write_response, (void*)epGtw);
+    for (uint8_t i = 0; i < epGtw->listenerCount; i++) {
+        epGtw->listeners[i].freshCommand = true;
+    }
 }
 
 /*
  * 函数功能：处理网关事件（核心网关处理函数）
  * 
- * 本函数在主循环中被调用，负责处理网关相关的 epoll 事件，包括新连接接受、
+ * 本函数在主循环中被调用，负责处理所有监听器的 epoll 事件，包括新连接接受、
  * 命令数据读取、连接超时管理等。这是网关功能的核心事件处理函数。
  * 
+ * 网关只有一个命令缓冲区和一个响应目标，因此同一时刻只有一个监听器的连接（owner）
+ * 向网关写入命令。其他连接的数据保留在套接字中（epoll 暂停），直到网关空闲且
+ * 命令缓冲区为空时，所有权被释放。
+ * 
  * 执行步骤：
  *   步骤1：参数有效性检查
- *   步骤2：检查是否有网关相关的 epoll 事件
+ *   步骤2：如果网关空闲且命令缓冲区为空，释放所有权并恢复暂停的连接
+ *   步骤3：查找与 epoll 事件对应的监听器
  *   
- *   步骤3：处理套接字接受事件（EPOLLIN on gtwa_fdSocket）：
- *     步骤3.1：调用 accept4() 接受新连接（非阻塞模式）
- *     步骤3.2：如果接受成功，将新连接的 fd 添加到 epoll 监听
- *     步骤3.3：重置套接字超时计时器
- *     步骤3.4：如果失败，重新启用套接字接受
+ *   步骤4：处理套接字接受事件（EPOLLIN on fdSocket）：
+ *     步骤4.1：调用 accept4() 接受新连接（非阻塞模式）
+ *     步骤4.2：如果接受成功，将新连接的 fd 添加到 epoll 监听
+ *     步骤4.3：重置套接字超时计时器
+ *     步骤4.4：如果失败，重新启用套接字接受
  *   
- *   步骤4：处理数据读取事件（EPOLLIN on gtwa_fd）：
- *     步骤4.1：从套接字读取数据到缓冲区
- *     步骤4.2：根据接口类型处理数据：
+ *   步骤5：处理数据读取事件（EPOLLIN on fd）：
+ *     步骤5.1：如果其他监听器拥有网关，暂停此连接
+ *     步骤5.2：获取网关所有权，从套接字读取数据到缓冲区
+ *     步骤5.3：根据接口类型处理数据：
  *       
  *       A. 标准输入模式：
- *          步骤4.2.1：简化命令格式，自动添加 "[0] " 前缀（如果缺失）
- *          步骤4.2.2：将数据写入网关对象
+ *          步骤5.3.1：简化命令格式，自动添加 "[0] " 前缀（如果缺失）
+ *          步骤5.3.2：将数据写入网关对象
  *       
  *       B. 套接字模式（本地或 TCP）：
- *          步骤4.2.1：检查是否收到 EOF（s == 0）
- *          步骤4.2.2：如果收到 EOF，关闭连接并重新启用套接字接受
- *          步骤4.2.3：否则，将数据写入网关对象
+ *          步骤5.3.1：检查是否收到 EOF（s == 0）
+ *          步骤5.3.2：如果收到 EOF，关闭连接并重新启用套接字接受
+ *          步骤5.3.3：否则，将数据写入网关对象
  *     
- *     步骤4.3：重置套接字超时计时器
+ *     步骤5.4：更新统计信息，重置套接字超时计时器
  *   
- *   步骤5：处理错误或挂断事件（EPOLLERR | EPOLLHUP）：
- *     步骤5.1：记录错误日志
- *     步骤5.2：关闭连接
+ *   步骤6：处理错误或挂断事件（EPOLLERR | EPOLLHUP）：
+ *     步骤6.1：记录错误日志
+ *     步骤6.2：关闭连接
  *   
- *   步骤6：验证套接字超时（针对套接字模式）：
- *     步骤6.1：检查超时计时器是否超过配置的超时时间
- *     步骤6.2：如果超时，关闭当前连接并接受下一个连接
- *     步骤6.3：否则，累加时间差
+ *   步骤7：验证每个监听器的套接字超时（针对套接字模式）：
+ *     步骤7.1：检查超时计时器是否超过配置的超时时间
+ *     步骤7.2：如果超时，关闭当前连接并接受下一个连接
+ *     步骤7.3：否则，累加时间差（暂停的连接不计时）
  * 
  * 参数说明：
  *   epGtw - 网关 epoll 对象指针
@@ -908,16 +1661,46 @@ CO_epoll_processGtw(CO_epoll_gtw_t* epGtw, CO_t* co, CO_epoll_t* ep) {
         return;
     }
 
-    /* 验证是否有 epoll 事件需要处理 */
-    /* Verify for epoll events */
-    if (ep->epoll_new && (ep->ev.data.fd == epGtw->gtwa_fdSocket || ep->ev.data.fd == epGtw->gtwa_fd)) {
+    epGtw->ep = ep;
+
+    /* 节点集合 SDO 写命令的进度，完成后继续处理保存的数据 */
+    /* progress of node-set SDO write, then continue with pending data */
+    if (!co->nodeIdUnconfigured) {
+        gtwBatchProcess(epGtw, co);
+        if (!epGtw->batch.active && epGtw->pendingLen > 0) {
+            size_t used = gtwFeed(epGtw, co, epGtw->pending, epGtw->pendingLen);
+            epGtw->pendingLen -= used;
+            memmove(epGtw->pending, &epGtw->pending[used], epGtw->pendingLen);
+        }
+    }
+
+    /* 网关空闲时释放所有权，其他连接可以继续 */
+    /* Release gateway ownership, when gateway is idle, so other connections can continue */
+    if (epGtw->owner != NULL
+        && (co->nodeIdUnconfigured
+            || (!epGtw->batch.active && epGtw->pendingLen == 0 && epGtw->lineState == GTW_LINE_HEAD
+                && epGtw->lineLen == 0 && co->gtwa->state == CO_GTWA_ST_IDLE && !co->gtwa->respHold
+                && CO_fifo_getOccupied(&co->gtwa->commFifo) == 0))) {
+        epGtw->owner = NULL;
+        for (uint8_t i = 0; i < epGtw->listenerCount; i++) {
+            gtwListenerPark(epGtw, &epGtw->listeners[i], false);
+        }
+    }
+
+    for (uint8_t i = 0; ep->epoll_new && i < epGtw->listenerCount; i++) {
+        CO_epoll_gtwListener_t* l = &epGtw->listeners[i];
+
+        if (ep->ev.data.fd != l->fdSocket && ep->ev.data.fd != l->fd) {
+            continue;
+        }
+
         /* 事件类型 A：套接字接受事件 - 有新客户端连接 */
-        if ((ep->ev.events & EPOLLIN) != 0 && ep->ev.data.fd == epGtw->gtwa_fdSocket) {
+        if ((ep->ev.events & EPOLLIN) != 0 && ep->ev.data.fd == l->fdSocket) {
             bool_t fail = false;
 
             /* 接受新连接（非阻塞模式） */
-            epGtw->gtwa_fd = accept4(epGtw->gtwa_fdSocket, NULL, NULL, SOCK_NONBLOCK);
-            if (epGtw->gtwa_fd < 0) {
+            l->fd = accept4(l->fdSocket, NULL, NULL, SOCK_NONBLOCK);
+            if (l->fd < 0) {
                 fail = true;
                 if (errno != EAGAIN && errno != EWOULDBLOCK) {
                     log_printf(LOG_CRIT, DBG_ERRNO, "accept(gtwa_fdSocket)");
@@ -927,34 +1710,55 @@ CO_epoll_processGtw(CO_epoll_gtw_t* epGtw, CO_t* co, CO_epoll_t* ep) {
                 /* add fd to epoll */
                 struct epoll_event ev2 = {0};
                 ev2.events = EPOLLIN;
-                ev2.data.fd = epGtw->gtwa_fd;
+                ev2.data.fd = l->fd;
                 int ret = epoll_ctl(ep->epoll_fd, EPOLL_CTL_ADD, ev2.data.fd, &ev2);
                 if (ret < 0) {
                     fail = true;
                     log_printf(LOG_CRIT, DBG_ERRNO, "epoll_ctl(add, gtwa_fd)");
                 }
+                l->parked = false;
+                l->freshCommand = true;
+                l->statConnections++;
                 /* 重置超时计时器 */
-                epGtw->socketTimeoutTmr_us = 0;
+                l->socketTimeoutTmr_us = 0;
             }
 
             if (fail) {
-                socketAcceptEnableForEpoll(epGtw);
+                socketAcceptEnableForEpoll(epGtw, l);
             }
             ep->epoll_new = false;
-        } else if ((ep->ev.events & EPOLLIN) != 0 && ep->ev.data.fd == epGtw->gtwa_fd) {
+        } else if ((ep->ev.events & EPOLLIN) != 0 && ep->ev.data.fd == l->fd) {
             /* 事件类型 B：数据读取事件 - 客户端发送了命令数据 */
+            if ((epGtw->owner != NULL && epGtw->owner != l) || epGtw->batch.active || epGtw->pendingLen > 0) {
+                /* 网关正在执行其他连接的命令或节点集合命令，数据保留在套接字中 */
+                /* Gateway is busy with commands from other connection or with node-set command, keep data in the
+                 * socket */
+                gtwListenerPark(epGtw, l, true);
+                ep->epoll_new = false;
+                break;
+            }
+            epGtw->owner = l;
+            epGtw->gtwa_fd = l->fd;
+
             char buf[CO_CONFIG_GTWA_COMM_BUF_SIZE];
             size_t space = co->nodeIdUnconfigured ? CO_CONFIG_GTWA_COMM_BUF_SIZE : CO_GTWA_write_getSpace(co->gtwa);
+            /* 为已收集的命令行开始部分保留空间 */
+            space = space > epGtw->lineLen ? space - epGtw->lineLen : 0;
 
-            ssize_t s = read(epGtw->gtwa_fd, buf, space);
+            ssize_t s = read(l->fd, buf, space);
 
             if (space == 0 || co->nodeIdUnconfigured) {
                 /* 继续或清空数据 */
                 /* continue or purge data */
             } else if (s < 0 && errno != EAGAIN) {
                 log_printf(LOG_DEBUG, DBG_ERRNO, "read(gtwa_fd)");
-            } else if (s >= 0) {
-                if (epGtw->commandInterface == CO_COMMAND_IF_STDIO) {
+            } else if (s > 0 || (s == 0 && l->commandInterface != CO_COMMAND_IF_STDIO)) {
+                l->statRxBytes += (uint64_t)s;
+                for (const char* c = buf; (c = memchr(c, '\n', (size_t)(&buf[s] - c))) != NULL; c++) {
+                    l->statCommands++;
+                }
+
+                if (l->commandInterface == CO_COMMAND_IF_STDIO) {
                     /* 简化标准输入的命令接口，使难以输入的序列变为可选 */
                     /* 如果缺失，则在字符串前添加 "[0] " */
                     /* simplify command interface on stdio, make hard to type
@@ -963,61 +1767,50 @@ CO_epoll_processGtw(CO_epoll_gtw_t* epGtw, CO_t* co, CO_epoll_t* ep) {
                     bool_t closed = (buf[s - 1] == '\n'); /* 命令是否结束？ */
 
                     if (buf[0] != '[' && (space - s) >= strlen(sequence) && isgraph(buf[0]) && buf[0] != '#' && closed
-                        && epGtw->freshCommand) {
-                        CO_GTWA_write(co->gtwa, sequence, strlen(sequence));
+                        && l->freshCommand) {
+                        gtwFeed(epGtw, co, sequence, strlen(sequence));
                     }
-                    epGtw->freshCommand = closed;
-                    CO_GTWA_write(co->gtwa, buf, s);
+                    l->freshCommand = closed;
+                    gtwFeedRead(epGtw, co, buf, (size_t)s);
                 } else { /* 套接字模式：本地或 TCP */
                     if (s == 0) {
                         /* 收到 EOF，关闭连接并启用套接字接受 */
                         /* EOF received, close connection and enable socket
                          * accepting */
-                        int ret = epoll_ctl(ep->epoll_fd, EPOLL_CTL_DEL, epGtw->gtwa_fd, NULL);
-                        if (ret < 0) {
-                            log_printf(LOG_CRIT, DBG_ERRNO, "epoll_ctl(del, gtwa_fd)");
-                        }
-                        if (close(epGtw->gtwa_fd) < 0) {
-                            log_printf(LOG_CRIT, DBG_ERRNO, "close(gtwa_fd)");
-                        }
-                        epGtw->gtwa_fd = -1;
-                        socketAcceptEnableForEpoll(epGtw);
+                        gtwListenerCloseConnection(epGtw, l);
                     } else {
-                        CO_GTWA_write(co->gtwa, buf, s);
+                        gtwFeedRead(epGtw, co, buf, (size_t)s);
                     }
                 }
             }
             /* 重置超时计时器 */
-            epGtw->socketTimeoutTmr_us = 0;
+            l->socketTimeoutTmr_us = 0;
 
             ep->epoll_new = false;
         } else if ((ep->ev.events & (EPOLLERR | EPOLLHUP)) != 0) {
             /* 事件类型 C：套接字错误或挂断事件 */
             log_printf(LOG_DEBUG, DBG_GENERAL, "socket error or hangup, event=", ep->ev.events);
-            if (close(epGtw->gtwa_fd) < 0) {
-                log_printf(LOG_CRIT, DBG_ERRNO, "close(gtwa_fd, hangup)");
-            }
+            gtwListenerCloseConnection(epGtw, l);
+            ep->epoll_new = false;
         }
-    } /* if (ep->epoll_new) */
+        break;
+    } /* for (listeners) */
 
     /* 如果建立了套接字连接，验证超时 */
     /* if socket connection is established, verify timeout */
-    if (epGtw->socketTimeout_us > 0 && epGtw->gtwa_fdSocket > 0 && epGtw->gtwa_fd > 0) {
-        if (epGtw->socketTimeoutTmr_us > epGtw->socketTimeout_us) {
-            /* 超时过期，关闭当前连接并接受下一个连接 */
-            /* timout expired, close current connection and accept next */
-            int ret = epoll_ctl(ep->epoll_fd, EPOLL_CTL_DEL, epGtw->gtwa_fd, NULL);
-            if (ret < 0) {
-                log_printf(LOG_CRIT, DBG_ERRNO, "epoll_ctl(del, gtwa_fd), tmo");
-            }
-            if (close(epGtw->gtwa_fd) < 0) {
-                log_printf(LOG_CRIT, DBG_ERRNO, "close(gtwa_fd), tmo");
+    for (uint8_t i = 0; i < epGtw->listenerCount; i++) {
+        CO_epoll_gtwListener_t* l = &epGtw->listeners[i];
+
+        if (l->socketTimeout_us > 0 && l->fdSocket >= 0 && l->fd >= 0 && !l->parked) {
+            if (l->socketTimeoutTmr_us > l->socketTimeout_us) {
+                /* 超时过期，关闭当前连接并接受下一个连接 */
+                /* timout expired, close current connection and accept next */
+                l->statTimeouts++;
+                gtwListenerCloseConnection(epGtw, l);
+            } else {
+                /* 累加经过的时间 */
+                l->socketTimeoutTmr_us += ep->timeDifference_us;
             }
-            epGtw->gtwa_fd = -1;
-            socketAcceptEnableForEpoll(epGtw);
-        } else {
-            /* 累加经过的时间 */
-            epGtw->socketTimeoutTmr_us += ep->timeDifference_us;
         }
     }
 }
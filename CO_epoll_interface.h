@@ -275,34 +275,131 @@ typedef enum {
     CO_COMMAND_IF_TCP_SOCKET_MAX = 0xFFFF
 } CO_commandInterface_t;
 
-/* 网关对象结构体
- * 结构说明：封装网关功能所需的所有状态和配置
+/* 网关命令接口监听器的最大数量
+ * 默认值：4，可以被覆盖
+ */
+/**
+ * Maximum number of command interface listeners for one gateway
+ */
+#ifndef CO_EPOLL_GTW_LISTENERS_MAX
+#define CO_EPOLL_GTW_LISTENERS_MAX 4
+#endif
+
+/* 网关命令接口监听器结构体
+ * 结构说明：一个命令接口（标准输入输出、本地套接字或 TCP 端口），每次接受一个连接
  * 成员说明：
- *   - epoll_fd: epoll 文件描述符，来自 CO_epoll_createGtw()
  *   - commandInterface: 命令接口类型或 TCP 端口号，参见 CO_commandInterface_t
- *   - socketTimeout_us: 套接字超时时间（微秒）
+ *   - socketTimeout_us: 套接字超时时间（微秒），0 表示无超时
  *   - socketTimeoutTmr_us: 套接字超时定时器（微秒）
  *   - localSocketPath: 本地套接字的路径（如果使用本地套接字）
- *   - gtwa_fdSocket: 网关套接字文件描述符
- *   - gtwa_fd: 网关 I/O 流文件描述符
+ *   - fdSocket: 监听套接字文件描述符，标准输入输出为 -1
+ *   - fd: I/O 流文件描述符（标准输入或已接受的连接），-1 表示无连接
+ *   - parked: 其他监听器拥有网关时，I/O 流暂停 epoll 读事件
  *   - freshCommand: 新命令指示标志
+ *   - statConnections .. statTimeouts: 统计信息（连接数、命令行数、接收/发送字节数、超时次数）
  */
 /**
- * Object for gateway
+ * Command interface listener for gateway
+ *
+ * Listener is standard IO, local socket or tcp port. Socket listener accepts one connection at a time.
  */
 typedef struct {
-    int epoll_fd;                 /**< Epoll file descriptor, from @ref CO_epoll_createGtw() */
     int32_t commandInterface;     /**< Command interface type or tcp port number, see @ref CO_commandInterface_t */
-    uint32_t socketTimeout_us;    /**< Socket timeout in microseconds */
+    uint32_t socketTimeout_us;    /**< Socket timeout in microseconds, 0 = no timeout */
     uint32_t socketTimeoutTmr_us; /**< Socket timeout timer in microseconds */
     char* localSocketPath;        /**< Path in case of local socket */
-    int gtwa_fdSocket;            /**< Gateway socket file descriptor */
-    int gtwa_fd;                  /**< Gateway io stream file descriptor */
+    int fdSocket;                 /**< Listening socket file descriptor, -1 for stdio */
+    int fd;                       /**< Io stream file descriptor (stdin or accepted connection), -1 if none */
+    bool_t parked;                /**< Io stream is paused in epoll, while other listener owns the gateway */
     bool_t freshCommand;          /**< Indication of fresh command */
+    uint32_t statConnections;     /**< Statistics: number of accepted connections */
+    uint32_t statCommands;        /**< Statistics: number of received command lines */
+    uint64_t statRxBytes;         /**< Statistics: bytes received from io stream */
+    uint64_t statTxBytes;         /**< Statistics: bytes of responses written to io stream */
+    uint32_t statTimeouts;        /**< Statistics: number of connections closed by timeout */
+} CO_epoll_gtwListener_t;
+
+/* 网关节点集合命令行的最大长度
+ * 默认值：256，可以被覆盖
+ */
+/**
+ * Maximum length of gateway command line with node-set
+ */
+#ifndef CO_EPOLL_GTW_BATCH_LINE_MAX
+#define CO_EPOLL_GTW_BATCH_LINE_MAX 256
+#endif
+
+/* 网关节点集合 SDO 写命令的执行状态
+ * 成员说明：
+ *   - active: 节点集合 SDO 写命令正在执行
+ *   - prefix: 每个子命令的前缀（"[<sequence>] [<net>] "）
+ *   - command: 节点之后的命令部分，例如 "w 0x1017 0 u16 1000"
+ *   - nodes, nodeCount, nodeIdx: 展开后的节点 ID 列表和当前索引
+ *   - resp, respLen, respDone: 捕获的网关子命令响应
+ *   - failed, firstError: 失败节点列表和第一个错误
+ */
+/**
+ * State of SDO write command to a node-set, executed by gateway one node after another
+ */
+typedef struct {
+    bool_t active;                               /**< SDO write to node-set is in progress */
+    bool_t waiting;                              /**< Node-set command line waits for idle gateway */
+    char prefix[32];                             /**< Prefix of each sub-command: "[<sequence>] [<net>] " */
+    char command[CO_EPOLL_GTW_BATCH_LINE_MAX];   /**< Command after node, for example "w 0x1017 0 u16 1000" */
+    uint8_t nodes[127];                          /**< Expanded node-IDs */
+    uint8_t nodeCount;                           /**< Number of nodes */
+    uint8_t nodeIdx;                             /**< Index of node, which sub-command is executing */
+    char resp[128];                              /**< Captured gateway response of the sub-command */
+    size_t respLen;                              /**< Length of captured response */
+    bool_t respDone;                             /**< Response line is complete */
+    char failed[128];                            /**< Comma separated list of failed nodes */
+    char firstError[24];                         /**< Error of the first failed node, for example "ERROR:0x06020000" */
+} CO_epoll_gtwBatch_t;
+
+/* 网关对象结构体
+ * 结构说明：封装网关功能所需的所有状态和配置。所有监听器共用同一个网关对象，
+ *         同一时刻只有一个连接（owner）向网关写入命令并接收响应
+ * 成员说明：
+ *   - epoll_fd: epoll 文件描述符，来自 CO_epoll_createGtw()
+ *   - listeners: 命令接口监听器数组
+ *   - listenerCount: 已配置的监听器数量
+ *   - owner: 当前拥有网关的监听器，NULL 表示网关空闲
+ *   - gtwa_fd: 网关响应写入的 I/O 流文件描述符（owner 的 fd）
+ *   - ep: 上一次 CO_epoll_processGtw() 调用的 epoll 对象
+ *   - lineState, line, lineLen: 节点集合语法的命令行解析状态
+ *   - pending, pendingLen: 节点集合 SDO 写命令之后收到的数据，命令完成后处理
+ *   - batch: 节点集合 SDO 写命令的执行状态
+ */
+/**
+ * Object for gateway
+ *
+ * All listeners feed the same gateway. Gateway has one command buffer and one response target, so only one connection
+ * (owner) writes commands at a time. Data from other connections stay in their sockets, until the gateway is idle and
+ * its command buffer is empty.
+ *
+ * Node field of NMT and SDO write commands may be a node-set: list and ranges ("2,5,10-20"), all nodes monitored by
+ * heartbeat consumer ("all") or monitored nodes in NMT state ("all:operational", "all:preop", "all:stopped",
+ * "all:unknown"). Node-set commands are expanded here: NMT frames are sent back-to-back with @ref CO_CANsendBatch() and
+ * SDO writes are executed by the gateway one node after another. Single aggregated response is returned.
+ */
+typedef struct {
+    int epoll_fd; /**< Epoll file descriptor, from @ref CO_epoll_createGtw() */
+    CO_epoll_gtwListener_t listeners[CO_EPOLL_GTW_LISTENERS_MAX]; /**< Command interface listeners */
+    uint8_t listenerCount;           /**< Number of configured listeners */
+    CO_epoll_gtwListener_t* owner;   /**< Listener, which currently owns the gateway, NULL if idle */
+    int gtwa_fd;                     /**< Gateway io stream file descriptor for responses (fd of the owner) */
+    CO_epoll_t* ep;                  /**< Epoll object from the last @ref CO_epoll_processGtw() call */
+    uint8_t lineState;               /**< Parser state of the current command line (node-set syntax) */
+    char line[CO_EPOLL_GTW_BATCH_LINE_MAX]; /**< Beginning of command line or whole command line with node-set */
+    size_t lineLen;                  /**< Length of data in line */
+    char pending[CO_CONFIG_GTWA_COMM_BUF_SIZE]; /**< Data received after node-set SDO write, processed after it */
+    size_t pendingLen;               /**< Length of pending data */
+    CO_epoll_gtwBatch_t batch;       /**< Node-set SDO write in progress */
 } CO_epoll_gtw_t;
 
 /* 为网关 ASCII 命令接口创建套接字并添加到 epoll
- * 函数功能：根据参数配置标准输入输出接口、本地套接字或 IP 套接字
+ * 函数功能：初始化网关对象，并根据参数配置第一个监听器：标准输入输出接口、本地套接字或 IP 套接字。
+ *         commandInterface 为 CO_COMMAND_IF_DISABLED 时不创建监听器
  * 参数说明：
  *   - epGtw: 要初始化的网关对象
  *   - epoll_fd: 已配置的 epoll 文件描述符
@@ -317,7 +414,9 @@ typedef struct {
 /**
  * Create socket for gateway-ascii command interface and add it to epoll
  *
- * Depending on arguments function configures stdio interface or local socket or IP socket.
+ * Function initializes the object and, depending on arguments, configures the first listener: stdio interface or local
+ * socket or IP socket. If commandInterface is CO_COMMAND_IF_DISABLED, no listener is created. More listeners can be
+ * added with @ref CO_epoll_addGtwListener().
  *
  * @param epGtw This object
  * @param epoll_fd Already configured epoll file descriptor
@@ -330,6 +429,35 @@ typedef struct {
 CO_ReturnError_t CO_epoll_createGtw(CO_epoll_gtw_t* epGtw, int epoll_fd, int32_t commandInterface,
                                     uint32_t socketTimeout_ms, char* localSocketPath);
 
+/* 为网关添加命令接口监听器
+ * 函数功能：配置额外的标准输入输出接口、本地套接字或 IP 套接字，所有监听器共用同一个网关
+ * 参数说明：
+ *   - epGtw: 网关对象，已由 CO_epoll_createGtw() 初始化
+ *   - commandInterface: CO_commandInterface_t 中的命令接口类型
+ *   - socketTimeout_ms: 此监听器已建立套接字连接的超时时间（毫秒）
+ *   - localSocketPath: 文件路径（如果 commandInterface 是本地套接字）
+ * 返回值说明：
+ *   - CO_ERROR_NO: 成功
+ *   - CO_ERROR_ILLEGAL_ARGUMENT: 参数非法，监听器过多或重复的标准输入输出
+ *   - CO_ERROR_SYSCALL: 系统调用失败
+ */
+/**
+ * Add command interface listener to the gateway
+ *
+ * Configures additional stdio interface or local socket or IP socket. All listeners feed the same gateway, each with
+ * own timeout and statistics.
+ *
+ * @param epGtw This object, initialized by @ref CO_epoll_createGtw()
+ * @param commandInterface Command interface type from CO_commandInterface_t
+ * @param socketTimeout_ms Timeout for established socket connection of this listener in [ms]
+ * @param localSocketPath File path, if commandInterface is local socket
+ *
+ * @return @ref CO_ReturnError_t CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT (also if there are too many listeners or stdio
+ * is already used) or CO_ERROR_SYSCALL.
+ */
+CO_ReturnError_t CO_epoll_addGtwListener(CO_epoll_gtw_t* epGtw, int32_t commandInterface, uint32_t socketTimeout_ms,
+                                         char* localSocketPath);
+
 /* 关闭网关 ASCII 套接字
  * 函数功能：关闭并释放网关使用的套接字资源
  * 参数说明：
@@ -120,16 +120,38 @@ extern "C" {
 #define DBG_WRONG_NODE_ID      "(%s) Wrong node ID \"%d\"", __func__
 /* 错误的实时优先级 */
 #define DBG_WRONG_PRIORITY     "(%s) Wrong RT priority \"%d\"", __func__
+/* 错误的总线负载限值 */
+#define DBG_WRONG_BUSLOAD      "(%s) Wrong bus load limit \"%s\"", __func__
 /* 找不到 CAN 设备 */
 #define DBG_NO_CAN_DEVICE      "(%s) Can't find CAN device \"%s\"", __func__
 /* 存储错误 */
 #define DBG_STORAGE            "(%s) Error with storage \"%s\"", __func__
+/* 自动存储统计信息 */
+#define DBG_STORAGE_STATS                                                                                              \
+    "CANopen auto storage: snapshots=%u, OD lock max=%uus avg=%uus, writes=%u, errors=%u, %llu bytes, "                \
+    "write max=%uus, latency max=%uus avg=%uus, journal compactions=%u"
 /* 对象字典条目错误 */
 #define DBG_OD_ENTRY           "(%s) Error in Object Dictionary entry: 0x%X", __func__
 /* CANopen 错误 */
 #define DBG_CAN_OPEN           "(%s) CANopen error in %s, err=%d", __func__
 /* CANopen 设备信息 */
 #define DBG_CAN_OPEN_INFO      "CANopen device, Node ID = 0x%02X, %s"
+/* 热备份信息 */
+#define DBG_STANDBY_INFO       "CANopen hot standby on \"%s\": %s"
+/* 热备份套接字绑定失败 */
+#define DBG_STANDBY_BIND       "(%s) Can't bind hot standby socket to path \"%s\"", __func__
+/* 热备份复制流错误 */
+#define DBG_STANDBY_PROTOCOL                                                                                           \
+    "(%s) Hot standby on \"%s\": wrong replication stream, different data blocks or Object Dictionary", __func__
+/* 热备份：其他实例已接管，本实例被隔离 */
+#define DBG_STANDBY_FENCED     "CANopen hot standby on \"%s\": other instance took over, this one is fenced and ends"
+/* 热备份接管 */
+#define DBG_STANDBY_TAKEOVER                                                                                           \
+    "CANopen hot standby takes over: %s, %uus after the last message, %u updates received, %s data"
+/* 运行时快照信息 */
+#define DBG_SNAPSHOT_INFO      "CANopen runtime snapshot \"%s\": %s"
+/* 运行时快照已恢复 */
+#define DBG_SNAPSHOT_RESTORED  "CANopen runtime snapshot \"%s\" restored, node-ID %d, written %ums ago"
 
 /* CO_epoll_interface 相关的消息定义
  * 说明：以下宏定义了 epoll 接口和命令接口相关的消息格式
@@ -147,6 +169,13 @@ extern "C" {
 #define DBG_COMMAND_LOCAL_INFO "CANopen command interface on local socket \"%s\" started"
 /* TCP 套接字命令接口启动信息 */
 #define DBG_COMMAND_TCP_INFO   "CANopen command interface on tcp port \"%d\" started"
+/* 命令接口统计信息 */
+#define DBG_COMMAND_STATS                                                                                              \
+    "CANopen command interface on %s: connections=%u, commands=%u, rx=%llu bytes, tx=%llu bytes, timeouts=%u"
+/* 命令接口过多 */
+#define DBG_COMMAND_TOO_MANY   "(%s) Too many command interfaces, maximum is %d", __func__
+/* 总线负载限速启动信息 */
+#define DBG_BUSLOAD_INFO       "CANopen bulk transmit traffic limited to %d%% bus load at %d kbit/s"
 
 #ifdef __cplusplus
 }
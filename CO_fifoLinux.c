@@ -0,0 +1,288 @@
+/*
+ * FIFO ASCII data type conversions for Linux
+ *
+ * @file        CO_fifoLinux.c
+ * @author      CANopenLinux contributors
+ * @copyright   2026 CANopenLinux contributors
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#include <string.h>
+
+#include "CO_fifoLinux.h"
+#include "CO_asciiLinux.h"
+
+#if (CO_CONFIG_FIFO) & CO_CONFIG_FIFO_ASCII_DATATYPES
+
+/* 命令分隔符和注释开始，与 CO_fifo.c 相同 */
+/* command delimiter and comment start, the same as in CO_fifo.c */
+#define DELIM_COMMAND '\n'
+#define DELIM_COMMENT '#'
+
+/* CO_fifo_cpyTok2Hex() 在 dest->aux 中的状态：低字节为步骤，第二个字节为未完成字节的第一位数字 */
+/* State of CO_fifo_cpyTok2Hex() in dest->aux: step in low byte, first digit of incomplete byte in second byte */
+#define HEX_STEP_IDLE    0U /* no digit of the current byte */
+#define HEX_STEP_DIGIT   1U /* first digit received */
+#define HEX_STEP_COMMENT 2U /* inside comment, waiting for command delimiter */
+
+/* 如果 fifo 中正好有 size 字节，读取小端数值 */
+/* Read little endian value, if fifo contains exactly size bytes */
+static bool_t
+fifoReadValue(CO_fifo_t* fifo, size_t size, uint64_t* value) {
+    uint64_t v = 0;
+
+    if (CO_fifo_getOccupied(fifo) != size) {
+        return false;
+    }
+    for (size_t i = 0; i < size; i++) {
+        uint8_t c = 0;
+        CO_fifo_getc(fifo, &c);
+        v |= (uint64_t)c << (i * 8U);
+    }
+    *value = v;
+    return true;
+}
+
+/* 参数说明：
+ *   - size: 数值的字节数
+ *   - maxLen: 最长的文本，不包括 '\0'
+ */
+static size_t
+fifoReadUnsigned(CO_fifo_t* fifo, char* buf, size_t count, bool_t end, size_t size, size_t maxLen) {
+    uint64_t v;
+
+    if (fifo != NULL && count > maxLen && fifoReadValue(fifo, size, &v)) {
+        return CO_ascii_formatU64(buf, v);
+    }
+    return __wrap_CO_fifo_readHex2a(fifo, buf, count, end);
+}
+
+static size_t
+fifoReadSigned(CO_fifo_t* fifo, char* buf, size_t count, bool_t end, size_t size, size_t maxLen) {
+    uint64_t v;
+
+    if (fifo != NULL && count > maxLen && fifoReadValue(fifo, size, &v)) {
+        uint64_t sign = (uint64_t)1U << (size * 8U - 1U);
+        if ((v & sign) == 0U) {
+            return CO_ascii_formatU64(buf, v);
+        }
+        /* 绝对值，对最小的负数也正确 */
+        /* absolute value, correct also for the most negative number */
+        buf[0] = '-';
+        return 1U + CO_ascii_formatU64(&buf[1], (sign << 1) - v);
+    }
+    return __wrap_CO_fifo_readHex2a(fifo, buf, count, end);
+}
+
+static size_t
+fifoReadX(CO_fifo_t* fifo, char* buf, size_t count, bool_t end, size_t size) {
+    uint64_t v;
+
+    if (fifo != NULL && count > (size * 2U + 2U) && fifoReadValue(fifo, size, &v)) {
+        buf[0] = '0';
+        buf[1] = 'x';
+        return 2U + CO_ascii_formatX(&buf[2], v, size * 2U);
+    }
+    return __wrap_CO_fifo_readHex2a(fifo, buf, count, end);
+}
+
+size_t
+__wrap_CO_fifo_readU82a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end) {
+    return fifoReadUnsigned(fifo, buf, count, end, 1, 3);
+}
+
+size_t
+__wrap_CO_fifo_readU162a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end) {
+    return fifoReadUnsigned(fifo, buf, count, end, 2, 5);
+}
+
+size_t
+__wrap_CO_fifo_readU322a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end) {
+    return fifoReadUnsigned(fifo, buf, count, end, 4, 10);
+}
+
+size_t
+__wrap_CO_fifo_readU642a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end) {
+    return fifoReadUnsigned(fifo, buf, count, end, 8, 20);
+}
+
+size_t
+__wrap_CO_fifo_readX82a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end) {
+    return fifoReadX(fifo, buf, count, end, 1);
+}
+
+size_t
+__wrap_CO_fifo_readX162a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end) {
+    return fifoReadX(fifo, buf, count, end, 2);
+}
+
+size_t
+__wrap_CO_fifo_readX322a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end) {
+    return fifoReadX(fifo, buf, count, end, 4);
+}
+
+size_t
+__wrap_CO_fifo_readX642a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end) {
+    return fifoReadX(fifo, buf, count, end, 8);
+}
+
+size_t
+__wrap_CO_fifo_readI82a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end) {
+    return fifoReadSigned(fifo, buf, count, end, 1, 4);
+}
+
+size_t
+__wrap_CO_fifo_readI162a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end) {
+    return fifoReadSigned(fifo, buf, count, end, 2, 6);
+}
+
+size_t
+__wrap_CO_fifo_readI322a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end) {
+    return fifoReadSigned(fifo, buf, count, end, 4, 11);
+}
+
+size_t
+__wrap_CO_fifo_readI642a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end) {
+    return fifoReadSigned(fifo, buf, count, end, 8, 20);
+}
+
+size_t
+__wrap_CO_fifo_readHex2a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end) {
+    (void)end; /* unused */
+    size_t len = 0;
+    uint8_t c;
+
+    if (fifo == NULL || count <= 3U) {
+        return 0;
+    }
+
+    /* 第一个字节前面没有空格 */
+    /* very first byte is without leading space */
+    if (!fifo->started && CO_fifo_getc(fifo, &c)) {
+        memcpy(&buf[0], &CO_ascii_hexPairs[c * 2U], 2);
+        len = 2;
+        fifo->started = true;
+    }
+    while ((len + 3U) < count && CO_fifo_getc(fifo, &c)) {
+        buf[len] = ' ';
+        memcpy(&buf[len + 1U], &CO_ascii_hexPairs[c * 2U], 2);
+        len += 3U;
+    }
+
+    /* 与 sprintf() 相同，文本以 '\0' 结尾 */
+    /* text is null terminated, the same as with sprintf() */
+    if (len > 0U) {
+        buf[len] = '\0';
+    }
+    return len;
+}
+
+size_t
+__wrap_CO_fifo_cpyTok2Hex(CO_fifo_t* dest, CO_fifo_t* src, CO_fifo_st* status) {
+    size_t destSpace, destSpaceStart;
+    bool_t finished = false;
+    CO_fifo_st st = 0;
+
+    if (dest == NULL || src == NULL) {
+        return 0;
+    }
+
+    destSpaceStart = destSpace = CO_fifo_getSpace(dest);
+
+    /* dest 的第一次写入，跳过前导空白 */
+    /* first write into dest, skip leading white space */
+    if (!dest->started) {
+        bool_t insideComment = false;
+        if (CO_fifo_trimSpaces(src, &insideComment) || insideComment) {
+            /* 没有数据就遇到命令分隔符或注释 */
+            /* command delimiter or comment found without data */
+            st |= CO_fifo_st_errTok;
+        }
+        dest->started = true;
+        dest->aux = 0;
+    }
+
+    uint8_t step = (uint8_t)(dest->aux & 0xFFU);
+    uint8_t firstDigit = (uint8_t)((dest->aux >> 8) & 0xFFU);
+
+    while (destSpace > 0U && (st & CO_fifo_st_errMask) == 0U && !finished) {
+        uint8_t c;
+        if (!CO_fifo_getc(src, &c)) {
+            break;
+        }
+
+        if (step == HEX_STEP_COMMENT) {
+            bool_t insideComment = true;
+            if (c == (uint8_t)DELIM_COMMAND || CO_fifo_trimSpaces(src, &insideComment)) {
+                st |= CO_fifo_st_closed;
+                finished = true;
+            }
+            continue;
+        }
+
+        uint8_t digit = CO_ascii_hexValue[c];
+        if (digit != 0xFFU) {
+            if (step == HEX_STEP_IDLE) {
+                firstDigit = digit;
+                step = HEX_STEP_DIGIT;
+            } else {
+                CO_fifo_putc(dest, (uint8_t)((firstDigit << 4) | digit));
+                destSpace--;
+                step = HEX_STEP_IDLE;
+            }
+        } else if (c > (uint8_t)' ' && c < 0x7FU) {
+            /* 可打印字符，不是十六进制数字 */
+            /* printable character, not hex digit */
+            if (c == (uint8_t)DELIM_COMMENT) {
+                step = HEX_STEP_COMMENT;
+            } else {
+                st |= CO_fifo_st_errVal;
+            }
+        } else {
+            /* 空白或分隔符，单个数字是一个字节 */
+            /* white space or delimiter, single digit is one byte */
+            if (step == HEX_STEP_DIGIT) {
+                CO_fifo_putc(dest, firstDigit);
+                destSpace--;
+                step = HEX_STEP_IDLE;
+            }
+            /* 下一个字符是十六进制数字时不需要 CO_fifo_trimSpaces()，常见的 "01 02" 格式 */
+            /* CO_fifo_trimSpaces() is not needed, if the next character is hex digit, common "01 02" format */
+            if (c != (uint8_t)DELIM_COMMAND && src->readPtr != src->writePtr
+                && CO_ascii_hexValue[src->buf[src->readPtr]] != 0xFFU) {
+                continue;
+            }
+            bool_t insideComment = false;
+            if (c == (uint8_t)DELIM_COMMAND || CO_fifo_trimSpaces(src, &insideComment)) {
+                st |= CO_fifo_st_closed;
+                finished = true;
+            } else if (insideComment) {
+                step = HEX_STEP_COMMENT;
+            }
+        }
+    }
+
+    if (!finished) {
+        st |= CO_fifo_st_partial;
+        /* 为下一次调用保存状态 */
+        /* store state for the next call */
+        dest->aux = (uint32_t)step | ((uint32_t)firstDigit << 8);
+    }
+
+    if (status != NULL) {
+        *status = st;
+    }
+    return destSpaceStart - destSpace;
+}
+
+#endif /* (CO_CONFIG_FIFO) & CO_CONFIG_FIFO_ASCII_DATATYPES */
@@ -0,0 +1,108 @@
+/* Linux 平台的 FIFO ASCII 数据类型转换
+ * 本文件在链接时替换 CANopenNode 301/CO_fifo.c 中网关最常用的转换函数：整数和十六进制数值的格式化，
+ * 八位字节串的十六进制编码和解码。它们用 CO_asciiLinux 的查表代替每个字节一次的 sprintf() 和 strtol()。
+ */
+/**
+ * FIFO ASCII data type conversions for Linux
+ *
+ * @file        CO_fifoLinux.h
+ * @ingroup     CO_fifoLinux
+ * @author      CANopenLinux contributors
+ * @copyright   2026 CANopenLinux contributors
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#ifndef CO_FIFO_LINUX_H
+#define CO_FIFO_LINUX_H
+
+#include "301/CO_fifo.h"
+
+#if ((CO_CONFIG_FIFO)&CO_CONFIG_FIFO_ASCII_DATATYPES) || defined CO_DOXYGEN
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup CO_fifoLinux FIFO ASCII data types with Linux
+ * Table driven replacements of hot ASCII conversion functions of CO_fifo.c, used by the gateway.
+ *
+ * @ingroup CO_socketCAN
+ * @{
+ *
+ * CANopenNode formats each integer with sprintf() and each byte of an octet string with sprintf(" %02X"), and
+ * converts each written hex byte with strtol(). Functions here produce the same text and the same data with the
+ * tables of @ref CO_asciiLinux.
+ *
+ * Functions replace the originals at link time with `-Wl,--wrap=<function>` (see FIFO_WRAP in Makefile): all
+ * references from other objects, also function pointers in the data type table of CO_gateway_ascii.c, are resolved
+ * to __wrap_<function>. Original is still available as __real_<function>, benchmark/gtwparse compares both.
+ * Other functions of CO_fifo.c (tokenizer, visible string, base64, floating point) are used unchanged.
+ *
+ * Arguments and return values are the same as in CO_fifo.h. Numeric functions read the value, if the fifo contains
+ * exactly the value and the buffer is large enough for its text, otherwise they return its bytes as hex, as the
+ * originals do.
+ */
+
+/* 读取函数：fifo 中的数值 -> ASCII */
+/** Read unsigned 8-bit value from fifo and write it as decimal text, replaces CO_fifo_readU82a() */
+size_t __wrap_CO_fifo_readU82a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+/** Read unsigned 16-bit value, replaces CO_fifo_readU162a() */
+size_t __wrap_CO_fifo_readU162a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+/** Read unsigned 32-bit value, replaces CO_fifo_readU322a() */
+size_t __wrap_CO_fifo_readU322a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+/** Read unsigned 64-bit value, replaces CO_fifo_readU642a() */
+size_t __wrap_CO_fifo_readU642a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+/** Read 8-bit value and write it as "0x" and two hex digits, replaces CO_fifo_readX82a() */
+size_t __wrap_CO_fifo_readX82a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+/** Read 16-bit value as hex, replaces CO_fifo_readX162a() */
+size_t __wrap_CO_fifo_readX162a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+/** Read 32-bit value as hex, replaces CO_fifo_readX322a() */
+size_t __wrap_CO_fifo_readX322a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+/** Read 64-bit value as hex, replaces CO_fifo_readX642a() */
+size_t __wrap_CO_fifo_readX642a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+/** Read signed 8-bit value, replaces CO_fifo_readI82a() */
+size_t __wrap_CO_fifo_readI82a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+/** Read signed 16-bit value, replaces CO_fifo_readI162a() */
+size_t __wrap_CO_fifo_readI162a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+/** Read signed 32-bit value, replaces CO_fifo_readI322a() */
+size_t __wrap_CO_fifo_readI322a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+/** Read signed 64-bit value, replaces CO_fifo_readI642a() */
+size_t __wrap_CO_fifo_readI642a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+
+/* 八位字节串 -> "01 02 AB"，可以分多次调用 */
+/**
+ * Read bytes from fifo and write them as hex text "01 02 AB", replaces CO_fifo_readHex2a()
+ *
+ * May be called several times for one value, fifo->started is set after the first byte.
+ */
+size_t __wrap_CO_fifo_readHex2a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+
+/* 写入函数：ASCII 十六进制标记 -> dest 中的字节，可以分多次调用 */
+/**
+ * Copy hex text token from src to bytes in dest, replaces CO_fifo_cpyTok2Hex()
+ *
+ * Digits are paired, white space separates bytes, single digit is one byte. May be called several times for one
+ * value, state of the incomplete byte is kept in dest->aux.
+ */
+size_t __wrap_CO_fifo_cpyTok2Hex(CO_fifo_t* dest, CO_fifo_t* src, CO_fifo_st* status);
+
+/** @} */ /* CO_fifoLinux */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* (CO_CONFIG_FIFO) & CO_CONFIG_FIFO_ASCII_DATATYPES */
+
+#endif /* CO_FIFO_LINUX_H */
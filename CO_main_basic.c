@@ -56,6 +56,10 @@
 #include "CO_error.h"
 #include "CO_epoll_interface.h"
 #include "CO_storageLinux.h"
+#include "CO_standbyLinux.h"
+/* 构建时从 OD.c 生成的对象字典布局标识 */
+/* Identity of the Object Dictionary layout, generated from OD.c at build time */
+#include "CO_odLayout.h"
 
 /* 包含可选的外部应用程序函数 */
 /* Include optional external application functions */
@@ -112,15 +116,27 @@
 #define TIME_STAMP_INTERVAL_MS 10000    /* 时间戳间隔: 10秒 */
 #endif
 
+/* 数据存储日志模式：只把改变的字节范围追加到日志文件，见 CO_storageLinux_init() */
+/* Journal mode of data storage: append only changed byte ranges to journal file, see CO_storageLinux_init() */
+#ifndef CO_STORAGE_JOURNAL
+#define CO_STORAGE_JOURNAL false
+#endif
+
+/* 数据存储容器文件名，例如 "storage.persist"：定义时所有条目存储在一个文件中，见 CO_storageLinux_initContainer() */
+/* Data storage container file name, for example "storage.persist": if defined, all entries are stored in one file,
+ * see CO_storageLinux_initContainer() */
+/* #define CO_STORAGE_CONTAINER "storage.persist" */
+
 /* 应用程序特定数据存储对象定义 */
 /* Definitions for application specific data storage objects */
 #ifndef CO_STORAGE_APPLICATION
 #define CO_STORAGE_APPLICATION
 #endif
-/* 自动数据存储间隔(微秒) */
-/* Interval for automatic data storage in microseconds */
-#ifndef CO_STORAGE_AUTO_INTERVAL
-#define CO_STORAGE_AUTO_INTERVAL 60000000  /* 自动存储间隔: 60秒 */
+
+/* 应用程序特定的热备份复制和运行时快照数据块定义 */
+/* Definitions for application specific data blocks, replicated to hot standby and written to runtime snapshot */
+#ifndef CO_STANDBY_APPLICATION
+#define CO_STANDBY_APPLICATION
 #endif
 
 /* 全局CANopen对象指针 */
@@ -163,6 +179,9 @@ static void* rt_thread(void* arg);
 /* 程序结束标志 - 由信号处理器设置，用于优雅退出程序 */
 /* Signal handler */
 volatile sig_atomic_t CO_endProgram = 0;
+/* 收到SIGUSR1，程序结束时写入运行时快照 */
+/* SIGUSR1 received, write runtime snapshot at program end */
+static volatile sig_atomic_t CO_snapshotRequest = 0;
 
 /*
  * 函数功能: 信号处理函数，用于处理SIGINT(Ctrl+C)和SIGTERM信号
@@ -175,7 +194,9 @@ volatile sig_atomic_t CO_endProgram = 0;
  */
 static void
 sigHandler(int sig) {
-    (void)sig;
+    if (sig == SIGUSR1) {
+        CO_snapshotRequest = 1;
+    }
     CO_endProgram = 1;
 }
 
@@ -249,6 +270,22 @@ EmergencyRxCallback(const uint16_t ident, const uint16_t errorCode, const uint8_
 }
 #endif
 
+#if defined CO_USE_APPLICATION && defined CO_USE_APPLICATION_RX_BATCH
+/*
+ * 函数功能: 接收批次回调，把一次接收中读取的所有帧交给应用程序
+ * 参数说明:
+ *   object - CANopen对象
+ *   frames - 接收帧数组
+ *   count - 帧数量
+ * 返回值说明: 无返回值
+ */
+/* callback for batch of received frames, passed to the application */
+static void
+RxBatchCallback(void* object, const CO_CANrxFrame_t frames[], uint16_t count) {
+    app_programRxBatch((CO_t*)object, frames, count);
+}
+#endif
+
 #if ((CO_CONFIG_NMT)&CO_CONFIG_NMT_CALLBACK_CHANGE) || ((CO_CONFIG_HB_CONS)&CO_CONFIG_HB_CONS_CALLBACK_CHANGE)
 /*
  * 函数功能: 将NMT状态枚举值转换为可读字符串
@@ -307,12 +344,12 @@ HeartbeatNmtChangedCallback(uint8_t nodeId, uint8_t idx, CO_NMT_internalState_t
 /*
  * 函数功能: LSS配置存储回调函数，保存LSS从站配置的节点ID和波特率
  * 执行步骤:
- *   步骤1: 将传入的object指针转换为mainlineStorage_t类型
- *   步骤2: 保存新配置的节点ID到存储结构
- *   步骤3: 保存新配置的CAN波特率到存储结构
+ *   步骤1: 保存新配置的节点ID到主线数据
+ *   步骤2: 保存新配置的CAN波特率到主线数据
+ *   步骤3: 标记主线数据已改变，由自动存储保存
  *   步骤4: 返回true表示存储成功
  * 参数说明:
- *   object - 指向mainlineStorage_t结构的指针
+ *   object - 指向CO_storage_t存储对象的指针(未启用存储时为NULL)
  *   id - LSS配置的新节点ID
  *   bitRate - LSS配置的新CAN波特率
  * 返回值说明: true表示存储成功
@@ -320,16 +357,41 @@ HeartbeatNmtChangedCallback(uint8_t nodeId, uint8_t idx, CO_NMT_internalState_t
 /* callback for storing node id and bitrate */
 static bool_t
 LSScfgStoreCallback(void* object, uint8_t id, uint16_t bitRate) {
-    /* 步骤1: 获取主线数据存储指针 */
-    mainlineStorage_t* mainlineStorage = object;
-    /* 步骤2: 保存待处理的节点ID */
-    mainlineStorage->pendingNodeId = id;
-    /* 步骤3: 保存待处理的波特率 */
-    mainlineStorage->pendingBitRate = bitRate;
+    /* 步骤1: 保存待处理的节点ID */
+    mlStorage.pendingNodeId = id;
+    /* 步骤2: 保存待处理的波特率 */
+    mlStorage.pendingBitRate = bitRate;
+#if (CO_CONFIG_STORAGE) & CO_CONFIG_STORAGE_ENABLE
+    /* 步骤3: 标记主线数据已改变，由自动存储保存 */
+    CO_storageLinux_markDirty(object, &mlStorage, sizeof(mlStorage));
+#else
+    (void)object;
+#endif
     /* 步骤4: 返回存储成功 */
     return true;
 }
 
+#if (CO_CONFIG_STORAGE) & CO_CONFIG_STORAGE_ENABLE
+/*
+ * 函数功能: 在存储文件名前添加路径前缀，总长度超过 CO_STORAGE_PATH_MAX 时不改变
+ * 参数说明:
+ *   file - 文件名缓冲区，大小为 CO_STORAGE_PATH_MAX
+ *   prefix - 路径前缀
+ * 返回值说明: 无返回值
+ */
+/* add path prefix to storage filename */
+static void
+storageAddPrefix(char* file, const char* prefix) {
+    size_t prefixLen = strlen(prefix);
+    size_t fileLen = strlen(file);
+    if (fileLen + prefixLen < CO_STORAGE_PATH_MAX) {
+        /* 在文件名前添加路径前缀 */
+        memmove(&file[prefixLen], &file[0], fileLen + 1);
+        memcpy(&file[0], &prefix[0], prefixLen);
+    }
+}
+#endif
+
 /*
  * 函数功能: 打印程序使用说明和命令行参数帮助信息
  * 参数说明:
@@ -351,6 +413,25 @@ printUsage(char* progName) {
 #endif
     /* 打印重启选项 */
     printf("  -r                  Enable reboot on CANopen NMT reset_node command. \n");
+    /* 打印热备份选项 */
+    printf("  -H <socket path>    Hot standby. The first instance with the same local\n"
+           "                      socket path is active, the second one waits as standby,\n"
+           "                      receives OD data and runtime state and takes over the\n"
+           "                      node without boot-up, when the active instance ends.\n");
+    /* 打印运行时快照选项 */
+    printf("  -R <snapshot file>  Runtime snapshot for fast restart. On SIGUSR1 program\n"
+           "                      writes OD data, NMT state and heartbeat consumer states\n"
+           "                      to the file and ends. On start it restores the snapshot,\n"
+           "                      if it exists and is not older than %d s, and continues\n"
+           "                      without boot-up. The file is removed then.\n",
+           CO_STANDBY_SNAPSHOT_MAX_AGE_S);
+#if CO_DRIVER_MULTI_INTERFACE == 0
+    /* 打印总线负载限速选项 */
+    printf("  -L <limit>[,<kbps>] Limit bulk transmit traffic (SDO client requests from\n"
+           "                      gateway) to <limit> percent of bus load. <kbps> is CAN\n"
+           "                      bit rate in kbit/s, used for bus load estimation. If\n"
+           "                      not set, bulk frames only give way to other frames.\n");
+#endif
 #if (CO_CONFIG_STORAGE) & CO_CONFIG_STORAGE_ENABLE
     /* 启用存储功能: 显示存储路径选项 */
     printf("  -s <storage path>   Path and filename prefix for data storage files.\n"
@@ -359,7 +440,8 @@ printUsage(char* progName) {
 #if (CO_CONFIG_GTW) & CO_CONFIG_GTW_ASCII
     /* 启用网关功能: 显示命令接口选项 */
     printf("  -c <interface>      Enable command interface for master functionality.\n"
-           "                      One of three types of interfaces can be specified as:\n"
+           "                      Option may be repeated for up to %d interfaces, which\n"
+           "                      all feed the same gateway. Each can be specified as:\n"
            "                   1. \"stdio\" - Standard IO of a program (terminal).\n"
            "                   2. \"local-<file path>\" - Local socket interface on file\n"
            "                      path, for example \"local-/tmp/CO_command_socket\".\n"
@@ -367,8 +449,11 @@ printUsage(char* progName) {
            "                      port, for example \"tcp-60000\".\n"
            "                      Note that this option may affect security of the CAN.\n"
            "  -T <timeout_time>   If -c is specified as local or tcp socket, then this\n"
-           "                      parameter specifies socket timeout time in milliseconds.\n"
-           "                      Default is 0 - no timeout on established connection.\n");
+           "                      parameter specifies socket timeout time in milliseconds\n"
+           "                      for the preceding -c. If specified before the first -c,\n"
+           "                      it is the default for all. Default is 0 - no timeout on\n"
+           "                      established connection.\n",
+           CO_EPOLL_GTW_LISTENERS_MAX);
 #endif
     /* 打印项目链接 */
     printf("\n"
@@ -401,6 +486,7 @@ main(int argc, char* argv[]) {
     CO_epoll_t epMain;              /* 主线程epoll接口对象 */
 #ifndef CO_SINGLE_THREAD
     pthread_t rt_thread_id;         /* 实时线程ID */
+    bool_t rtThreadStarted = false; /* 实时线程已创建，只有这时才等待它结束 */
     int rtPriority = -1;            /* 实时线程优先级(-1表示使用普通调度器) */
 #endif
     CO_NMT_reset_cmd_t reset = CO_RESET_NOT; /* NMT复位命令 */
@@ -408,11 +494,29 @@ main(int argc, char* argv[]) {
     CO_CANptrSocketCan_t CANptr = {0};       /* SocketCAN指针结构 */
     int opt;                                  /* getopt返回的选项字符 */
     bool_t firstRun = true;                  /* 首次运行标志 */
+    bool_t CANopenStarted = false;           /* CANopen曾进入正常模式 */
 
     /* 可通过命令行参数配置的变量 */
     char* CANdevice = NULL;      /* CAN device, configurable by arguments. */
     int16_t nodeIdFromArgs = -1; /* May be set by arguments */
     bool_t rebootEnable = false; /* Configurable by arguments */
+#if CO_DRIVER_MULTI_INTERFACE == 0
+    uint8_t busLoadLimit = 0;    /* 总线负载限值(百分比)，0表示禁用限速 */
+#endif
+    uint16_t CANbitRate = 0;     /* CAN波特率(kbit/s)，仅用于总线负载估算 */
+
+    /* 热备份和运行时快照相关变量 */
+    char* standbyPath = NULL;                               /* 热备份本地套接字路径，NULL表示禁用 */
+    CO_standbyLinux_t standby;                              /* 热备份对象 */
+    char* snapshotPath = NULL;                              /* 运行时快照文件路径，NULL表示禁用 */
+    CO_standbyLinux_runtime_t snapshotRuntime;              /* 从快照恢复的运行时状态 */
+    const CO_standbyLinux_runtime_t* runtimeRestore = NULL; /* 接管或快照恢复后，通信复位时应用的运行时状态 */
+    CO_standbyLinux_block_t standbyBlocks[] = {/* 复制到被动实例和写入快照的数据块 */
+                                               {.addr = &OD_PERSIST_COMM, .len = sizeof(OD_PERSIST_COMM)},
+                                               {.addr = &OD_RAM, .len = sizeof(OD_RAM)},
+                                               {.addr = &mlStorage, .len = sizeof(mlStorage)},
+                                               CO_STANDBY_APPLICATION};
+    uint8_t standbyBlocksCount = sizeof(standbyBlocks) / sizeof(standbyBlocks[0]); /* 数据块数量 */
 
 #if (CO_CONFIG_STORAGE) & CO_CONFIG_STORAGE_ENABLE
     /* 数据存储相关变量 */
@@ -423,27 +527,33 @@ main(int argc, char* argv[]) {
          .len = sizeof(OD_PERSIST_COMM),
          .subIndexOD = 2,
          .attr = CO_storage_cmd | CO_storage_restore,
+         .journal = CO_STORAGE_JOURNAL,
          .filename = {'o', 'd', '_', 'c', 'o', 'm', 'm', '.', 'p', 'e', 'r', 's', 'i', 's', 't', '\0'}},
         /* 条目2: 主线数据(节点ID和波特率)持久化存储 */
         {.addr = &mlStorage,
          .len = sizeof(mlStorage),
          .subIndexOD = 4,
          .attr = CO_storage_cmd | CO_storage_auto | CO_storage_restore,
+         .journal = CO_STORAGE_JOURNAL,
          .filename = {'m', 'a', 'i', 'n', 'l', 'i', 'n', 'e', '.', 'p', 'e', 'r', 's', 'i', 's', 't', '\0'}},
         /* 应用自定义存储条目(如果有) */
         CO_STORAGE_APPLICATION};
     uint8_t storageEntriesCount = sizeof(storageEntries) / sizeof(storageEntries[0]); /* 存储条目数量 */
     uint32_t storageInitError = 0;          /* 存储初始化错误 */
     uint32_t storageErrorPrev = 0;          /* 前一次存储错误 */
-    uint32_t storageIntervalTimer = 0;      /* 自动存储间隔计时器 */
+#ifdef CO_STORAGE_CONTAINER
+    char storageContainer[CO_STORAGE_PATH_MAX] = CO_STORAGE_CONTAINER; /* 容器文件名 */
+#endif
 #endif
 
 #if (CO_CONFIG_GTW) & CO_CONFIG_GTW_ASCII
     /* CANopen网关相关变量 */
-    CO_epoll_gtw_t epGtw;                              /* 网关epoll接口对象 */
-    int32_t commandInterface = CO_COMMAND_IF_DISABLED; /* 命令接口类型(CO_commandInterface_t枚举值) */
-    char* localSocketPath = NULL;                      /* 本地socket路径(当commandInterface为LOCAL_SOCKET时使用) */
-    uint32_t socketTimeout_ms = 0;                     /* socket超时时间(毫秒) */
+    CO_epoll_gtw_t epGtw;                                       /* 网关epoll接口对象 */
+    int32_t commandInterface[CO_EPOLL_GTW_LISTENERS_MAX];       /* 命令接口类型(CO_commandInterface_t枚举值) */
+    char* localSocketPath[CO_EPOLL_GTW_LISTENERS_MAX] = {NULL}; /* 本地socket路径(LOCAL_SOCKET时使用) */
+    uint32_t socketTimeout_ms[CO_EPOLL_GTW_LISTENERS_MAX];      /* 每个命令接口的socket超时时间(毫秒) */
+    uint8_t commandInterfaceCount = 0;                          /* 已配置的命令接口数量(-c选项可重复) */
+    uint32_t socketTimeoutDefault_ms = 0;                       /* 在第一个-c之前指定的-T，作为默认值 */
 #else
 #define commandInterface 0
 #define localSocketPath  NULL
@@ -463,7 +573,7 @@ main(int argc, char* argv[]) {
         exit(EXIT_SUCCESS);
     }
     /* 循环解析所有命令行选项 */
-    while ((opt = getopt(argc, argv, "i:p:rc:T:s:")) != -1) {
+    while ((opt = getopt(argc, argv, "i:p:rH:R:L:c:T:s:")) != -1) {
         switch (opt) {
             case 'i': {
                 /* 选项i: 设置CANopen节点ID (1-127或0xFF表示未配置) */
@@ -481,19 +591,52 @@ main(int argc, char* argv[]) {
                 /* 选项r: 启用NMT复位节点命令时重启系统 */
                 rebootEnable = true; 
                 break;
+            case 'H': 
+                /* 选项H: 热备份本地套接字路径 */
+                standbyPath = optarg; 
+                break;
+            case 'R': 
+                /* 选项R: 运行时快照文件路径 */
+                snapshotPath = optarg; 
+                break;
+#if CO_DRIVER_MULTI_INTERFACE == 0
+            case 'L': {
+                /* 选项L: 批量发送流量的总线负载限值和CAN波特率 */
+                char* end;
+                unsigned long limit = strtoul(optarg, &end, 0);
+                unsigned long bitRate = 0;
+                if (*end == ',') {
+                    bitRate = strtoul(end + 1, &end, 0);
+                }
+                if (limit < 1 || limit > 100 || bitRate > 1000 || *end != '\0') {
+                    log_printf(LOG_CRIT, DBG_WRONG_BUSLOAD, optarg);
+                    printUsage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                busLoadLimit = (uint8_t)limit;
+                CANbitRate = (uint16_t)bitRate;
+                break;
+            }
+#endif
 #if (CO_CONFIG_GTW) & CO_CONFIG_GTW_ASCII
             case 'c': {
-                /* 选项c: 配置命令接口类型(stdio/local socket/tcp socket) */
+                /* 选项c: 配置命令接口类型(stdio/local socket/tcp socket)，可重复指定多个命令接口 */
                 const char* comm_stdio = "stdio";
                 const char* comm_local = "local-";
                 const char* comm_tcp = "tcp-";
+                if (commandInterfaceCount >= CO_EPOLL_GTW_LISTENERS_MAX) {
+                    log_printf(LOG_CRIT, DBG_COMMAND_TOO_MANY, CO_EPOLL_GTW_LISTENERS_MAX);
+                    exit(EXIT_FAILURE);
+                }
+                uint8_t n = commandInterfaceCount;
+                socketTimeout_ms[n] = socketTimeoutDefault_ms;
                 if (strcmp(optarg, comm_stdio) == 0) {
                     /* 使用标准输入输出作为命令接口 */
-                    commandInterface = CO_COMMAND_IF_STDIO;
+                    commandInterface[n] = CO_COMMAND_IF_STDIO;
                 } else if (strncmp(optarg, comm_local, strlen(comm_local)) == 0) {
                     /* 使用本地socket作为命令接口 */
-                    commandInterface = CO_COMMAND_IF_LOCAL_SOCKET;
-                    localSocketPath = &optarg[6];
+                    commandInterface[n] = CO_COMMAND_IF_LOCAL_SOCKET;
+                    localSocketPath[n] = &optarg[6];
                 } else if (strncmp(optarg, comm_tcp, strlen(comm_tcp)) == 0) {
                     /* 使用TCP socket作为命令接口 */
                     const char* portStr = &optarg[4];
@@ -503,17 +646,22 @@ main(int argc, char* argv[]) {
                         log_printf(LOG_CRIT, DBG_NOT_TCP_PORT, portStr);
                         exit(EXIT_FAILURE);
                     }
-                    commandInterface = port;
+                    commandInterface[n] = port;
                 } else {
                     /* 未知的命令接口类型 */
                     log_printf(LOG_CRIT, DBG_ARGUMENT_UNKNOWN, "-c", optarg);
                     exit(EXIT_FAILURE);
                 }
+                commandInterfaceCount++;
                 break;
             }
             case 'T': 
-                /* 选项T: 设置socket超时时间(毫秒) */
-                socketTimeout_ms = strtoul(optarg, NULL, 0); 
+                /* 选项T: 设置前一个-c命令接口的socket超时时间(毫秒)，在第一个-c之前指定时作为默认值 */
+                if (commandInterfaceCount > 0) {
+                    socketTimeout_ms[commandInterfaceCount - 1] = strtoul(optarg, NULL, 0);
+                } else {
+                    socketTimeoutDefault_ms = strtoul(optarg, NULL, 0);
+                }
                 break;
 #endif
 #if (CO_CONFIG_STORAGE) & CO_CONFIG_STORAGE_ENABLE
@@ -521,16 +669,11 @@ main(int argc, char* argv[]) {
                 /* 选项s: 为存储文件添加路径前缀 */
                 /* add prefix to each storageEntries[i].filename */
                 for (uint8_t i = 0; i < storageEntriesCount; i++) {
-                    char* filePrefix = optarg;
-                    size_t filePrefixLen = strlen(filePrefix);
-                    char* file = storageEntries[i].filename;
-                    size_t fileLen = strlen(file);
-                    if (fileLen + filePrefixLen < CO_STORAGE_PATH_MAX) {
-                        /* 在文件名前添加路径前缀 */
-                        memmove(&file[filePrefixLen], &file[0], fileLen + 1);
-                        memcpy(&file[0], &filePrefix[0], filePrefixLen);
-                    }
+                    storageAddPrefix(storageEntries[i].filename, optarg);
                 }
+#ifdef CO_STORAGE_CONTAINER
+                storageAddPrefix(storageContainer, optarg);
+#endif
                 break;
             }
 #endif
@@ -610,11 +753,58 @@ main(int argc, char* argv[]) {
         exit(EXIT_FAILURE);
     }
 
+    /* 步骤9: 捕获SIGINT(Ctrl+C)和SIGTERM信号以实现优雅退出 */
+    /* Catch signals SIGINT and SIGTERM */
+    if (signal(SIGINT, sigHandler) == SIG_ERR) {
+        log_printf(LOG_CRIT, DBG_ERRNO, "signal(SIGINT, sigHandler)");
+        exit(EXIT_FAILURE);
+    }
+    if (signal(SIGTERM, sigHandler) == SIG_ERR) {
+        log_printf(LOG_CRIT, DBG_ERRNO, "signal(SIGTERM, sigHandler)");
+        exit(EXIT_FAILURE);
+    }
+    if (snapshotPath != NULL && signal(SIGUSR1, sigHandler) == SIG_ERR) {
+        log_printf(LOG_CRIT, DBG_ERRNO, "signal(SIGUSR1, sigHandler)");
+        exit(EXIT_FAILURE);
+    }
+
+    /* 热备份: 已有主动实例时作为被动实例等待，接收数据直到主动实例结束，然后接管。这在存储初始化之前:
+     * 被动实例不能打开、回放或压缩主动实例正在使用的存储文件 */
+    /* Hot standby: if active instance exists, wait as standby and receive data until it ends, then take over. This is
+     * before storage initialization: standby must not open, replay or compact storage files used by the active
+     * instance */
+    if (standbyPath != NULL) {
+        err = CO_standbyLinux_init(&standby, standbyPath, (int)CANptr.can_ifindex, CO_OD_LAYOUT_ID, standbyBlocks,
+                                   standbyBlocksCount);
+        if (err == CO_ERROR_NO && standby.standby) {
+            err = CO_standbyLinux_follow(&standby, &CO_endProgram);
+        }
+        if (err != CO_ERROR_NO) {
+            log_printf(LOG_CRIT, DBG_GENERAL, "CO_standbyLinux_init(), err=", err);
+            exit(EXIT_FAILURE);
+        }
+        if (CO_endProgram != 0) {
+            /* 接管之前结束: CANopen、实时线程和存储都没有启动，不能写主动实例的存储文件 */
+            /* end before take over: CANopen, realtime thread and storage were not started, files of the active
+             * instance must not be written */
+            CO_standbyLinux_close(&standby);
+            CO_delete(CO);
+            log_printf(LOG_INFO, DBG_STANDBY_INFO, standbyPath, "ended before take over");
+            exit(EXIT_SUCCESS);
+        }
+    }
+
 #if (CO_CONFIG_STORAGE) & CO_CONFIG_STORAGE_ENABLE
-    /* 步骤9: 初始化数据存储功能 */
+    /* 步骤10: 初始化数据存储功能 */
+#ifdef CO_STORAGE_CONTAINER
+    err = CO_storageLinux_initContainer(&storage, CO->CANmodule, OD_ENTRY_H1010_storeParameters,
+                                        OD_ENTRY_H1011_restoreDefaultParameters, storageEntries,
+                                        storageEntriesCount, storageContainer, &storageInitError);
+#else
     err = CO_storageLinux_init(&storage, CO->CANmodule, OD_ENTRY_H1010_storeParameters,
                                OD_ENTRY_H1011_restoreDefaultParameters, storageEntries, storageEntriesCount,
                                &storageInitError);
+#endif
 
     if (err != CO_ERROR_NO && err != CO_ERROR_DATA_CORRUPT) {
         /* 存储初始化失败(数据损坏可以容忍) */
@@ -624,7 +814,7 @@ main(int argc, char* argv[]) {
     }
 #endif
 #ifdef CO_USE_APPLICATION
-    /* 步骤10: 执行可选的外部应用程序启动代码 */
+    /* 步骤11: 执行可选的外部应用程序启动代码 */
     /* Execute optional external application code */
     uint32_t errInfo_app_programStart = 0;
     err = app_programStart(&mlStorage.pendingBitRate, &mlStorage.pendingNodeId, &errInfo_app_programStart);
@@ -638,26 +828,36 @@ main(int argc, char* argv[]) {
     }
 #endif
 
-    /* 步骤11: 如果命令行指定了节点ID，覆盖存储的节点ID */
+    /* 步骤12: 如果命令行指定了节点ID，覆盖存储的节点ID */
     /* Overwrite node-id, if specified by program arguments */
     if (nodeIdFromArgs > 0) {
         mlStorage.pendingNodeId = (uint8_t)nodeIdFromArgs;
     }
-    /* 步骤12: 验证并修正存储的节点ID */
+    /* 步骤13: 验证并修正存储的节点ID */
     /* verify stored values */
     if (mlStorage.pendingNodeId < 1 || mlStorage.pendingNodeId > 127) {
         mlStorage.pendingNodeId = CO_LSS_NODE_ID_ASSIGNMENT;
     }
 
-    /* 步骤13: 捕获SIGINT(Ctrl+C)和SIGTERM信号以实现优雅退出 */
-    /* Catch signals SIGINT and SIGTERM */
-    if (signal(SIGINT, sigHandler) == SIG_ERR) {
-        log_printf(LOG_CRIT, DBG_ERRNO, "signal(SIGINT, sigHandler)");
-        exit(EXIT_FAILURE);
+    /* 运行时快照: 计划重启前写入的快照代替存储数据，以它的节点ID和状态继续 */
+    /* Runtime snapshot: snapshot written before planned restart replaces stored data, continue with its node-id and
+     * state */
+    if (snapshotPath != NULL
+        && CO_standbyLinux_snapshotLoad(snapshotPath, CO_OD_LAYOUT_ID, standbyBlocks, standbyBlocksCount,
+                                        &snapshotRuntime)
+               == CO_ERROR_NO
+        && snapshotRuntime.nodeId >= 1 && snapshotRuntime.nodeId <= 127) {
+        mlStorage.pendingNodeId = snapshotRuntime.nodeId;
+        runtimeRestore = &snapshotRuntime;
     }
-    if (signal(SIGTERM, sigHandler) == SIG_ERR) {
-        log_printf(LOG_CRIT, DBG_ERRNO, "signal(SIGTERM, sigHandler)");
-        exit(EXIT_FAILURE);
+
+    /* 接管: 复制的数据代替存储初始化从文件读取的较旧数据，以主动实例的节点ID和状态继续 */
+    /* take over: replicated data replace older data, read from files by storage initialization, continue with node-id
+     * and state of the active instance */
+    if (standbyPath != NULL && CO_standbyLinux_applyReplicated(&standby) && standby.runtime.nodeId >= 1
+        && standby.runtime.nodeId <= 127) {
+        mlStorage.pendingNodeId = standby.runtime.nodeId;
+        runtimeRestore = &standby.runtime;
     }
 
     /* 步骤14: 获取当前时间用于CANopen TIME对象 */
@@ -696,7 +896,20 @@ main(int argc, char* argv[]) {
 #endif
 #if (CO_CONFIG_GTW) & CO_CONFIG_GTW_ASCII
     /* 步骤16: 创建网关epoll接口 */
-    err = CO_epoll_createGtw(&epGtw, epMain.epoll_fd, commandInterface, socketTimeout_ms, localSocketPath);
+    if (runtimeRestore != NULL) {
+        /* 崩溃的主动实例或上一个进程留下的本地命令套接字文件 */
+        /* local command socket files left by crashed active instance or by previous process */
+        for (uint8_t i = 0; i < commandInterfaceCount; i++) {
+            if (commandInterface[i] == CO_COMMAND_IF_LOCAL_SOCKET) {
+                unlink(localSocketPath[i]);
+            }
+        }
+    }
+    err = CO_epoll_createGtw(&epGtw, epMain.epoll_fd, CO_COMMAND_IF_DISABLED, 0, NULL);
+    for (uint8_t i = 0; i < commandInterfaceCount && err == CO_ERROR_NO; i++) {
+        /* 所有命令接口共用同一个网关 */
+        err = CO_epoll_addGtwListener(&epGtw, commandInterface[i], socketTimeout_ms[i], localSocketPath[i]);
+    }
     if (err != CO_ERROR_NO) {
         log_printf(LOG_CRIT, DBG_GENERAL, "CO_epoll_createGtw(), err=", err);
         exit(EXIT_FAILURE);
@@ -725,13 +938,27 @@ main(int argc, char* argv[]) {
 
         /* 步骤19: 初始化CAN接口 */
         /* initialize CANopen */
-        err = CO_CANinit(CO, (void*)&CANptr, 0 /* bit rate not used */);
+        err = CO_CANinit(CO, (void*)&CANptr, CANbitRate /* used for bus load estimation only */);
         if (err != CO_ERROR_NO) {
             log_printf(LOG_CRIT, DBG_CAN_OPEN, "CO_CANinit()", err);
             programExit = EXIT_FAILURE;
             CO_endProgram = 1;
             continue;
         }
+#if CO_DRIVER_MULTI_INTERFACE == 0
+        if (busLoadLimit > 0) {
+            /* 启用批量发送流量(网关SDO传输)的总线负载限速 */
+            CO_CANmodule_setBusLoadLimit(CO->CANmodule, busLoadLimit);
+            if (firstRun) {
+                log_printf(LOG_INFO, DBG_BUSLOAD_INFO, busLoadLimit, CANbitRate);
+            }
+        }
+#endif
+#if defined CO_USE_APPLICATION && defined CO_USE_APPLICATION_RX_BATCH
+        /* 每次接收把整批帧交给应用程序 */
+        /* pass the whole batch of frames of each receive pass to the application */
+        CO_CANmodule_setRxBatchCallback(CO->CANmodule, CO, RxBatchCallback);
+#endif
 
         /* 步骤20: 初始化LSS(层设置服务)功能 */
         /* 从对象字典中读取LSS地址信息(厂商ID、产品代码、版本号、序列号) */
@@ -783,7 +1010,11 @@ main(int argc, char* argv[]) {
         CO_epoll_initCANopenGtw(&epGtw, CO);
 #endif
         /* 初始化LSS配置存储回调 */
-        CO_LSSslave_initCfgStoreCall(CO->LSSslave, &mlStorage, LSScfgStoreCallback);
+#if (CO_CONFIG_STORAGE) & CO_CONFIG_STORAGE_ENABLE
+        CO_LSSslave_initCfgStoreCall(CO->LSSslave, &storage, LSScfgStoreCallback);
+#else
+        CO_LSSslave_initCfgStoreCall(CO->LSSslave, NULL, LSScfgStoreCallback);
+#endif
         
         if (!CO->nodeIdUnconfigured) {
             /* 节点ID已配置的情况下初始化各种回调和错误报告 */
@@ -842,6 +1073,7 @@ main(int argc, char* argv[]) {
                 CO_endProgram = 1;
                 continue;
             }
+            rtThreadStarted = true;
             if (rtPriority > 0) {
                 /* 设置实时线程为FIFO调度策略 */
                 struct sched_param param;
@@ -863,6 +1095,19 @@ main(int argc, char* argv[]) {
         app_communicationReset(CO);
 #endif
 
+#if (CO_CONFIG_STORAGE) & CO_CONFIG_STORAGE_ENABLE
+        /* 在PDO初始化之前安装OD写钩子，RPDO在初始化时取得映射对象的OD接口，这样RPDO写入也标记自动存储条目 */
+        /* install OD write hooks before PDO init, RPDOs take OD interface of mapped objects there, so RPDO writes also
+         * mark auto storage entries */
+        err = CO_storageLinux_initHooks(&storage, OD);
+        if (err != CO_ERROR_NO) {
+            log_printf(LOG_CRIT, DBG_CAN_OPEN, "CO_storageLinux_initHooks()", err);
+            programExit = EXIT_FAILURE;
+            CO_endProgram = 1;
+            continue;
+        }
+#endif
+
         /* 步骤26: 初始化PDO(过程数据对象) */
         errInfo = 0;
         err = CO_CANopenInitPDO(CO,     /* CANopen object - CANopen对象 */
@@ -881,9 +1126,34 @@ main(int argc, char* argv[]) {
             continue;
         }
 
+#if (CO_CONFIG_STORAGE) & CO_CONFIG_STORAGE_ENABLE
+        /* 再次安装OD写钩子，PDO初始化可能重新初始化了扩展，已安装的钩子保持不变 */
+        /* install OD write hooks again, PDO init may have re-initialized extensions, installed hooks are kept */
+        err = CO_storageLinux_initHooks(&storage, OD);
+        if (err != CO_ERROR_NO) {
+            log_printf(LOG_CRIT, DBG_CAN_OPEN, "CO_storageLinux_initHooks()", err);
+            programExit = EXIT_FAILURE;
+            CO_endProgram = 1;
+            continue;
+        }
+#endif
+
+        if (runtimeRestore != NULL && !CO->nodeIdUnconfigured) {
+            /* 接管或快照: 恢复NMT状态(不发送启动报文)、心跳消费者状态和网关默认值 */
+            /* take over or snapshot: restore NMT state (no boot-up message), heartbeat consumer states and gateway
+             * defaults */
+            CO_LOCK_OD(CO->CANmodule);
+            CO_standbyLinux_setRuntime(CO, runtimeRestore);
+            CO_UNLOCK_OD(CO->CANmodule);
+            log_printf(LOG_INFO, DBG_CAN_OPEN_INFO, CO_activeNodeId,
+                       runtimeRestore == &snapshotRuntime ? "restored from runtime snapshot" : "hot standby took over");
+        }
+        runtimeRestore = NULL;
+
         /* 步骤27: 启动CAN通信，进入正常模式 */
         /* start CAN */
         CO_CANsetNormalMode(CO->CANmodule);
+        CANopenStarted = true;
 
         reset = CO_RESET_NOT;
 
@@ -905,6 +1175,12 @@ main(int argc, char* argv[]) {
             /* 处理网关通信(命令接口) */
             CO_epoll_processGtw(&epGtw, CO, &epMain);
 #endif
+            /* 向被动实例发送改变的数据和运行时状态。其他实例已接管时立即结束，不再发送CAN报文，也不写存储 */
+            /* send changed data and runtime state to standby. If other instance took over, end immediately, without
+             * CAN messages and without writing to storage */
+            if (standbyPath != NULL && !CO_standbyLinux_process(&standby, CO, &epMain)) {
+                exit(EXIT_FAILURE);
+            }
             /* 处理主线程CANopen任务(SDO、心跳等) */
             CO_epoll_processMain(&epMain, CO, GATEWAY_ENABLE, &reset);
             /* 处理最后的清理任务 */
@@ -917,26 +1193,19 @@ main(int argc, char* argv[]) {
 #endif
 
 #if (CO_CONFIG_STORAGE) & CO_CONFIG_STORAGE_ENABLE
-            /* 步骤29: 处理自动数据存储(按设定间隔) */
-            /* don't save more often than interval */
-            if (storageIntervalTimer < CO_STORAGE_AUTO_INTERVAL) {
-                /* 累加时间，未到存储间隔 */
-                storageIntervalTimer += epMain.timeDifference_us;
-            } else {
-                /* 到达存储间隔，执行自动存储 */
-                uint32_t mask = CO_storageLinux_auto_process(&storage, false);
-                if (mask != storageErrorPrev && !CO->nodeIdUnconfigured) {
-                    if (mask != 0) {
-                        /* 报告存储错误 */
-                        CO_errorReport(CO->em, CO_EM_NON_VOLATILE_AUTO_SAVE, CO_EMC_HARDWARE, mask);
-                    } else {
-                        /* 清除之前的存储错误 */
-                        CO_errorReset(CO->em, CO_EM_NON_VOLATILE_AUTO_SAVE, 0);
-                    }
+            /* 步骤29: 处理自动数据存储(只保存已改变的条目，带去抖) */
+            /* save changed data, debounced, see CO_STORAGE_AUTO_DEBOUNCE_US */
+            uint32_t mask = CO_storageLinux_auto_process(&storage, false);
+            if (mask != storageErrorPrev && !CO->nodeIdUnconfigured) {
+                if (mask != 0) {
+                    /* 报告存储错误 */
+                    CO_errorReport(CO->em, CO_EM_NON_VOLATILE_AUTO_SAVE, CO_EMC_HARDWARE, mask);
+                } else {
+                    /* 清除之前的存储错误 */
+                    CO_errorReset(CO->em, CO_EM_NON_VOLATILE_AUTO_SAVE, 0);
                 }
-                storageErrorPrev = mask;
-                storageIntervalTimer = 0; /* 重置计时器 */
             }
+            storageErrorPrev = mask;
 #endif
         }
     } /* while(reset != CO_RESET_APP */ /* 通信复位循环结束 */
@@ -948,12 +1217,19 @@ main(int argc, char* argv[]) {
     /* join threads */
     CO_endProgram = 1;
 #ifndef CO_SINGLE_THREAD
-    /* 等待实时线程退出 */
-    if (pthread_join(rt_thread_id, NULL) != 0) {
+    /* 等待实时线程退出，初始化失败时它可能没有创建 */
+    /* rt_thread may not be created, if initialization failed */
+    if (rtThreadStarted && pthread_join(rt_thread_id, NULL) != 0) {
         log_printf(LOG_CRIT, DBG_ERRNO, "pthread_join()");
         exit(EXIT_FAILURE);
     }
 #endif
+    if (snapshotPath != NULL && CO_snapshotRequest != 0 && CANopenStarted && reset == CO_RESET_NOT
+        && !CO->nodeIdUnconfigured) {
+        /* 计划重启: CANopen已停止处理，写入运行时快照，新进程从它继续 */
+        /* planned restart: CANopen processing is stopped, write runtime snapshot, new process continues from it */
+        CO_standbyLinux_snapshotSave(snapshotPath, CO, CO_OD_LAYOUT_ID, standbyBlocks, standbyBlocksCount);
+    }
 #ifdef CO_USE_APPLICATION
     /* 步骤31: 执行应用程序退出代码 */
     /* Execute optional external application code */
@@ -961,8 +1237,18 @@ main(int argc, char* argv[]) {
 #endif
 
 #if (CO_CONFIG_STORAGE) & CO_CONFIG_STORAGE_ENABLE
-    /* 步骤32: 强制保存所有待存储数据 */
+    /* 步骤32: 强制保存所有待存储数据，输出存储统计 */
     CO_storageLinux_auto_process(&storage, true);
+    CO_storageLinux_stats_t storageStats;
+    CO_storageLinux_getStats(&storage, &storageStats);
+    if (storageStats.snapshots > 0) {
+        uint32_t done = storageStats.writes + storageStats.writeErrors;
+        log_printf(LOG_INFO, DBG_STORAGE_STATS, storageStats.snapshots, storageStats.lockMax_us,
+                   (uint32_t)(storageStats.lockTotal_us / storageStats.snapshots), storageStats.writes,
+                   storageStats.writeErrors, (unsigned long long)storageStats.writeBytes, storageStats.writeMax_us,
+                   storageStats.latencyMax_us, done > 0 ? (uint32_t)(storageStats.latencyTotal_us / done) : 0,
+                   storageStats.compactions);
+    }
 #endif
 
     /* 步骤33: 清理并释放所有对象 */
@@ -980,6 +1266,11 @@ main(int argc, char* argv[]) {
     /* 进入CAN配置模式并删除CANopen对象 */
     CO_CANsetConfigurationMode((void*)&CANptr);
     CO_delete(CO);
+    if (standbyPath != NULL) {
+        /* 关闭热备份套接字。在CAN关闭之后，这样被动实例接管时本实例已不在总线上 */
+        /* close hot standby socket after CAN, so this instance is off the bus, when standby takes over */
+        CO_standbyLinux_close(&standby);
+    }
 
     /* 步骤34: 记录程序结束日志 */
     log_printf(LOG_INFO, DBG_CAN_OPEN_INFO, CO_activeNodeId, "finished");
@@ -0,0 +1,81 @@
+/*
+ * Generator of the Object Dictionary layout identity
+ *
+ * @file        CO_odLayoutGen.c
+ * @author      CANopenLinux contributors
+ * @copyright   2026 CANopenLinux contributors
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+/* 构建时运行的程序，与 OD.c 链接，输出 CO_odLayout.h。
+ * 标识是所有 OD 条目的索引、子索引和数据长度的 FNV-1a 哈希。运行时快照和热备份用它拒绝来自不同对象字典
+ * 的数据，即使数据块长度相同。
+ */
+/* Program is run at build time, linked with OD.c, and prints CO_odLayout.h.
+ * Identity is FNV-1a hash of index, subindex and data length of all OD entries. Runtime snapshot and hot standby use
+ * it to reject data from a different Object Dictionary, even if data block lengths are equal.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "301/CO_ODinterface.h"
+#include "OD.h"
+
+#define FNV_OFFSET 2166136261U
+#define FNV_PRIME  16777619U
+
+static uint32_t
+fnv1a(uint32_t hash, uint32_t value, uint8_t bytes) {
+    /* 小端字节序，与主机无关 */
+    /* little endian byte order, independent of the host */
+    for (uint8_t i = 0; i < bytes; i++) {
+        hash = (hash ^ ((value >> (i * 8U)) & 0xFFU)) * FNV_PRIME;
+    }
+    return hash;
+}
+
+int
+main(void) {
+    uint32_t hash = FNV_OFFSET;
+    uint32_t subEntries = 0;
+
+    for (uint16_t i = 0; i < OD->size; i++) {
+        const OD_entry_t* entry = &OD->list[i];
+
+        /* 记录的子索引可以不连续，所以尝试所有子索引 */
+        /* subindexes of a record may have gaps, so try all of them */
+        for (uint16_t sub = 0; sub <= 0xFFU; sub++) {
+            OD_IO_t io;
+            if (OD_getSub(entry, (uint8_t)sub, &io, true) != ODR_OK) {
+                continue;
+            }
+            hash = fnv1a(hash, entry->index, 2);
+            hash = fnv1a(hash, sub, 1);
+            hash = fnv1a(hash, (uint32_t)io.stream.dataLength, 4);
+            subEntries++;
+        }
+    }
+
+    printf("/* 由 CO_odLayoutGen 从对象字典生成，不要编辑 */\n"
+           "/* Generated by CO_odLayoutGen from the Object Dictionary, do not edit */\n"
+           "#ifndef CO_OD_LAYOUT_H\n"
+           "#define CO_OD_LAYOUT_H\n"
+           "\n"
+           "/** Identity of the Object Dictionary layout, %u entries, %u subentries */\n"
+           "#define CO_OD_LAYOUT_ID 0x%08XU\n"
+           "\n"
+           "#endif /* CO_OD_LAYOUT_H */\n",
+           (unsigned)OD->size, (unsigned)subEntries, (unsigned)hash);
+    return EXIT_SUCCESS;
+}
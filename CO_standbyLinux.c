@@ -0,0 +1,848 @@
+/*
+ * Hot standby replication for Linux
+ *
+ * @file        CO_standbyLinux.c
+ * @author      CANopenLinux contributors
+ * @copyright   2026 CANopenLinux contributors
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#include "CO_standbyLinux.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <syslog.h>
+#include <time.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+
+#include "301/crc16-ccitt.h"
+
+/* 复制流的记录头，后面是 length 字节的数据。一个消息包含一个或多个记录 */
+/* Record header of the replication stream, followed by length bytes of data. One message contains one or more
+ * records. */
+typedef struct {
+    uint16_t type;   /* REC_xxx */
+    uint16_t block;  /* REC_DATA: index of data block; REC_HELLO: number of blocks */
+    uint32_t offset; /* REC_DATA: offset inside block; REC_HELLO: OD layout identity; REC_COMMIT: sequence number */
+    uint32_t length; /* Length of data */
+} standbyRecord_t;
+
+/* 连接后的第一个记录，数据是各数据块的长度（uint32_t） */
+/* The first record after connection, data are lengths of data blocks (uint32_t) */
+#define REC_HELLO   1
+/* 数据块中一个字节范围的新数据 */
+/* New data of byte range inside data block */
+#define REC_DATA    2
+/* 新的运行时状态，CO_standbyLinux_runtime_t */
+/* New runtime state, CO_standbyLinux_runtime_t */
+#define REC_RUNTIME 3
+/* 更新结束，被动实例应用暂存的数据。没有改变时作为保活发送 */
+/* End of update, standby applies staged data. Sent as keep-alive, if nothing changed */
+#define REC_COMMIT  4
+
+/* 运行时快照文件头，后面是块长度（uint32_t）、运行时状态和数据块 */
+/* Header of runtime snapshot file, followed by block lengths (uint32_t), runtime state and data blocks */
+typedef struct {
+    char magic[4];        /* SNAPSHOT_MAGIC */
+    uint16_t version;     /* SNAPSHOT_VERSION */
+    uint16_t blocksCount; /* Number of data blocks */
+    uint32_t dataSize;    /* Sum of block lengths */
+    uint32_t runtimeSize; /* sizeof(CO_standbyLinux_runtime_t) */
+    int64_t time_s;       /* Time of writing, CLOCK_REALTIME */
+    uint32_t time_ns;     /* Time of writing, nanoseconds */
+    uint32_t odLayoutId;  /* Identity of the Object Dictionary layout, CO_OD_LAYOUT_ID */
+    uint16_t crc;         /* CRC16-CCITT of everything after the header */
+    uint16_t reserved;    /* Reserved, zero */
+} snapshotHeader_t;
+
+#define SNAPSHOT_MAGIC   "COrs"
+#define SNAPSHOT_VERSION 2
+
+static uint64_t
+standbyTime_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+/* 删除过期的套接字文件，绑定并监听，成为主动实例 */
+/* Remove stale socket file, bind and listen, become active */
+static CO_ReturnError_t
+standbyListen(CO_standbyLinux_t* sb) {
+    struct sockaddr_un addr;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, sb->path, sizeof(addr.sun_path) - 1);
+    sb->fdListen = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (sb->fdListen < 0) {
+        log_printf(LOG_CRIT, DBG_ERRNO, "socket(standby)");
+        return CO_ERROR_SYSCALL;
+    }
+    unlink(sb->path);
+    if (bind(sb->fdListen, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(sb->fdListen, 1) < 0) {
+        log_printf(LOG_CRIT, DBG_STANDBY_BIND, sb->path);
+        close(sb->fdListen);
+        sb->fdListen = -1;
+        return CO_ERROR_SYSCALL;
+    }
+    struct stat st;
+    sb->pathIno = stat(sb->path, &st) == 0 ? (uint64_t)st.st_ino : 0;
+    sb->standby = false;
+    return CO_ERROR_NO;
+}
+
+CO_ReturnError_t
+CO_standbyLinux_init(CO_standbyLinux_t* sb, const char* path, int canIfindex, uint32_t odLayoutId,
+                     CO_standbyLinux_block_t* blocks, uint8_t blocksCount) {
+    struct sockaddr_un addr;
+
+    if (sb == NULL || path == NULL || blocks == NULL || strlen(path) >= sizeof(addr.sun_path)) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    memset(sb, 0, sizeof(*sb));
+    sb->blocks = blocks;
+    sb->blocksCount = blocksCount;
+    sb->fdListen = -1;
+    sb->fd = -1;
+    strcpy(sb->path, path);
+    sb->canIfindex = canIfindex;
+    sb->odLayoutId = odLayoutId;
+    for (uint8_t i = 0; i < blocksCount; i++) {
+        sb->dataSize += blocks[i].len;
+    }
+    sb->shadow = malloc(sb->dataSize + 1);
+    sb->current = malloc(sb->dataSize + 1);
+    sb->msg = malloc(CO_STANDBY_MSG_MAX);
+    if (sb->shadow == NULL || sb->current == NULL || sb->msg == NULL) {
+        CO_standbyLinux_close(sb);
+        return CO_ERROR_OUT_OF_MEMORY;
+    }
+
+    /* 已有主动实例时成为被动实例 */
+    /* become standby, if active instance exists */
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    sb->fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (sb->fd < 0) {
+        log_printf(LOG_CRIT, DBG_ERRNO, "socket(standby)");
+        CO_standbyLinux_close(sb);
+        return CO_ERROR_SYSCALL;
+    }
+    if (connect(sb->fd, (struct sockaddr*)&addr, sizeof(addr)) == 0) {
+        sb->standby = true;
+        log_printf(LOG_INFO, DBG_STANDBY_INFO, path, "standby, receiving state");
+        return CO_ERROR_NO;
+    }
+    close(sb->fd);
+    sb->fd = -1;
+
+    CO_ReturnError_t err = standbyListen(sb);
+    if (err != CO_ERROR_NO) {
+        CO_standbyLinux_close(sb);
+        return err;
+    }
+    log_printf(LOG_INFO, DBG_STANDBY_INFO, path, "active");
+    return CO_ERROR_NO;
+}
+
+/* 暂存的数据和运行时状态应用到数据块 */
+/* Apply staged data and runtime state to data blocks */
+static void
+standbyCommit(CO_standbyLinux_t* sb) {
+    size_t offset = 0;
+    for (uint8_t i = 0; i < sb->blocksCount; i++) {
+        memcpy(sb->blocks[i].addr, &sb->shadow[offset], sb->blocks[i].len);
+        offset += sb->blocks[i].len;
+    }
+    sb->runtime = sb->runtimeNew;
+    sb->synced = true;
+    sb->statUpdates++;
+}
+
+/* 解析一个消息的记录，数据暂存到 shadow。协议错误或数据块大小不一致时返回 false */
+/* Parse records of one message, data are staged in shadow. Return false on protocol error or if block sizes differ */
+static bool_t
+standbyReceive(CO_standbyLinux_t* sb, size_t len) {
+    size_t pos = 0;
+
+    while (pos + sizeof(standbyRecord_t) <= len) {
+        standbyRecord_t rec;
+        memcpy(&rec, &sb->msg[pos], sizeof(rec));
+        pos += sizeof(rec);
+        const uint8_t* data = &sb->msg[pos];
+        if (rec.length > len - pos) {
+            return false;
+        }
+        pos += rec.length;
+
+        switch (rec.type) {
+            case REC_HELLO: {
+                if (rec.block != sb->blocksCount || rec.offset != sb->odLayoutId
+                    || rec.length != sb->blocksCount * sizeof(uint32_t)) {
+                    return false;
+                }
+                for (uint8_t i = 0; i < sb->blocksCount; i++) {
+                    uint32_t blockLen;
+                    memcpy(&blockLen, &data[i * sizeof(uint32_t)], sizeof(blockLen));
+                    if (blockLen != sb->blocks[i].len) {
+                        return false;
+                    }
+                }
+                break;
+            }
+            case REC_DATA: {
+                if (rec.block >= sb->blocksCount || rec.offset > sb->blocks[rec.block].len
+                    || rec.length > sb->blocks[rec.block].len - rec.offset) {
+                    return false;
+                }
+                size_t blockOffset = 0;
+                for (uint16_t i = 0; i < rec.block; i++) {
+                    blockOffset += sb->blocks[i].len;
+                }
+                memcpy(&sb->shadow[blockOffset + rec.offset], data, rec.length);
+                break;
+            }
+            case REC_RUNTIME:
+                if (rec.length != sizeof(sb->runtimeNew)) {
+                    return false;
+                }
+                memcpy(&sb->runtimeNew, data, sizeof(sb->runtimeNew));
+                break;
+            case REC_COMMIT:
+                sb->sequence = rec.offset;
+                standbyCommit(sb);
+                break;
+            default: return false;
+        }
+    }
+    return pos == len;
+}
+
+/* 打开只接收的原始 CAN 套接字，接收所有节点的心跳。失败或没有 CAN 接口时返回 -1 */
+/* Open receive-only raw CAN socket for heartbeats of all nodes. Return -1 on failure or if there is no CAN interface */
+static int
+standbyCanOpen(CO_standbyLinux_t* sb) {
+    struct sockaddr_can addr = {.can_family = AF_CAN, .can_ifindex = sb->canIfindex};
+    struct can_filter filter = {.can_id = CO_CAN_ID_HEARTBEAT, .can_mask = 0x780U | CAN_EFF_FLAG | CAN_RTR_FLAG};
+
+    if (sb->canIfindex == 0) {
+        return -1;
+    }
+    int fd = socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, CAN_RAW);
+    if (fd < 0) {
+        log_printf(LOG_CRIT, DBG_ERRNO, "socket(standby CAN)");
+        return -1;
+    }
+    if (setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FILTER, &filter, sizeof(filter)) < 0
+        || bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        log_printf(LOG_CRIT, DBG_ERRNO, "bind(standby CAN)");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* 心跳超时（微秒），心跳不能监视时为 0：没有 CAN 套接字、没有复制的节点 ID 或生产者时间为 0 */
+/* Heartbeat timeout in microseconds, 0 if heartbeat can not be watched: no CAN socket, no replicated node-ID or
+ * producer time is zero */
+static uint64_t
+standbyHbTimeout(const CO_standbyLinux_t* sb, int fdCan) {
+    if (fdCan < 0 || !sb->synced || sb->runtime.nodeId < 1 || sb->runtime.nodeId > 127) {
+        return 0;
+    }
+    return (uint64_t)sb->runtime.hbProducerTime_us * CO_STANDBY_HB_TIMEOUT_PCT / 100;
+}
+
+CO_ReturnError_t
+CO_standbyLinux_follow(CO_standbyLinux_t* sb, volatile sig_atomic_t* endProgram) {
+    uint64_t lastMessage_us = standbyTime_us();
+    uint64_t lastHeartbeat_us = lastMessage_us;
+    bool_t hbAlive = false;
+    const char* reason = NULL;
+    CO_ReturnError_t ret = CO_ERROR_NO;
+
+    if (sb == NULL || !sb->standby) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    /* 暂存区从本地数据开始，没有完整副本时也一致 */
+    /* staging area starts from local data, so it is consistent also without full copy */
+    size_t offset = 0;
+    for (uint8_t i = 0; i < sb->blocksCount; i++) {
+        memcpy(&sb->shadow[offset], sb->blocks[i].addr, sb->blocks[i].len);
+        offset += sb->blocks[i].len;
+    }
+    int fdCan = standbyCanOpen(sb);
+
+    while (reason == NULL && *endProgram == 0) {
+        uint64_t now_us = standbyTime_us();
+        uint64_t elapsed_us = now_us - lastMessage_us;
+        uint64_t wait_us;
+        if (elapsed_us < CO_STANDBY_TIMEOUT_US) {
+            wait_us = CO_STANDBY_TIMEOUT_US - elapsed_us;
+        } else {
+            /* 主动实例不发送。它可能挂起但仍在总线上：只有它的心跳也丢失时才接管 */
+            /* active instance does not send. It may be hung, but still on the bus: take over only if its heartbeat
+             * is also missing */
+            uint64_t hbTimeout_us = standbyHbTimeout(sb, fdCan);
+            uint64_t hbElapsed_us = now_us - lastHeartbeat_us;
+            if (hbTimeout_us == 0) {
+                reason = "timeout, heartbeat not watched";
+                break;
+            }
+            if (hbElapsed_us >= hbTimeout_us) {
+                reason = "timeout, no heartbeat";
+                break;
+            }
+            if (!hbAlive) {
+                log_printf(LOG_WARNING, DBG_STANDBY_INFO, sb->path,
+                           "active does not send, but its heartbeat is on the bus");
+                hbAlive = true;
+            }
+            wait_us = hbTimeout_us - hbElapsed_us;
+        }
+        struct pollfd pfd[2] = {{.fd = sb->fd, .events = POLLIN}, {.fd = fdCan, .events = POLLIN}};
+        int n = poll(pfd, 2, (int)((wait_us + 999) / 1000));
+        if (n < 0) {
+            if (errno != EINTR) {
+                reason = "poll error";
+            }
+            continue;
+        }
+
+        /* 主动节点的心跳，节点 ID 来自复制的运行时状态 */
+        /* heartbeat of the active node, node-ID is from replicated runtime state */
+        struct can_frame frame;
+        while ((pfd[1].revents & POLLIN) != 0 && read(fdCan, &frame, sizeof(frame)) == (ssize_t)sizeof(frame)) {
+            if (sb->synced && frame.can_id == (canid_t)(CO_CAN_ID_HEARTBEAT + sb->runtime.nodeId)
+                && frame.can_dlc >= 1) {
+                lastHeartbeat_us = standbyTime_us();
+            }
+        }
+        if ((pfd[0].revents & (POLLIN | POLLHUP | POLLERR)) == 0) {
+            continue;
+        }
+        ssize_t len = recv(sb->fd, sb->msg, CO_STANDBY_MSG_MAX, 0);
+        if (len <= 0) {
+            if (len < 0 && errno == EINTR) {
+                continue;
+            }
+            /* 主动实例在关闭 CAN 之后才关闭连接，崩溃时内核同时关闭所有套接字 */
+            /* active instance closes connection after CAN is closed, on crash kernel closes all sockets */
+            reason = "connection closed";
+            break;
+        }
+        lastMessage_us = standbyTime_us();
+        if (hbAlive) {
+            log_printf(LOG_NOTICE, DBG_STANDBY_INFO, sb->path, "active sends again");
+            hbAlive = false;
+        }
+        sb->statBytes += (uint64_t)len;
+        if (!standbyReceive(sb, (size_t)len)) {
+            log_printf(LOG_CRIT, DBG_STANDBY_PROTOCOL, sb->path);
+            ret = CO_ERROR_DATA_CORRUPT;
+            break;
+        }
+    }
+
+    if (fdCan >= 0) {
+        close(fdCan);
+    }
+    close(sb->fd);
+    sb->fd = -1;
+    if (ret != CO_ERROR_NO || *endProgram != 0) {
+        return ret;
+    }
+    log_printf(LOG_NOTICE, DBG_STANDBY_TAKEOVER, reason, (unsigned)(standbyTime_us() - lastMessage_us),
+               sb->statUpdates, sb->synced ? "replicated" : "local");
+    /* 没有提交的暂存数据丢弃，shadow 保存已提交的数据，存储初始化之后再次应用 */
+    /* staged data without commit are discarded, shadow keeps committed data, applied again after storage init */
+    offset = 0;
+    for (uint8_t i = 0; i < sb->blocksCount; i++) {
+        memcpy(&sb->shadow[offset], sb->blocks[i].addr, sb->blocks[i].len);
+        offset += sb->blocks[i].len;
+    }
+    /* 绑定新的套接字文件，仍在运行的主动实例发现后隔离自己 */
+    /* bind new socket file, active instance, which still runs, notices it and fences itself */
+    return standbyListen(sb);
+}
+
+bool_t
+CO_standbyLinux_applyReplicated(CO_standbyLinux_t* sb) {
+    if (sb == NULL || sb->standby || !sb->synced) {
+        return false;
+    }
+    size_t offset = 0;
+    for (uint8_t i = 0; i < sb->blocksCount; i++) {
+        memcpy(sb->blocks[i].addr, &sb->shadow[offset], sb->blocks[i].len);
+        offset += sb->blocks[i].len;
+    }
+    return true;
+}
+
+void
+CO_standbyLinux_getRuntime(CO_t* co, CO_standbyLinux_runtime_t* runtime) {
+    memset(runtime, 0, sizeof(*runtime));
+    runtime->nodeId = co->NMT->nodeId;
+    runtime->nmtState = (int8_t)CO_NMT_getInternalState(co->NMT);
+    runtime->hbProducerTime_us = co->NMT->HBproducerTime_us;
+#if (CO_CONFIG_HB_CONS) & CO_CONFIG_HB_CONS_ENABLE
+    CO_HBconsumer_t* HBcons = co->HBcons;
+    for (uint8_t i = 0; HBcons != NULL && i < HBcons->numberOfMonitoredNodes && i < 127; i++) {
+        CO_HBconsNode_t* monitoredNode = &HBcons->monitoredNodes[i];
+        runtime->hb[i].nodeId = monitoredNode->nodeId;
+        runtime->hb[i].HBstate = (uint8_t)monitoredNode->HBstate;
+        runtime->hb[i].NMTstate = (int8_t)monitoredNode->NMTstate;
+        runtime->hbCount = i + 1;
+    }
+#endif
+#if (CO_CONFIG_GTW) & CO_CONFIG_GTW_ASCII
+    if (co->gtwa != NULL) {
+        runtime->gtwNet = co->gtwa->net_default;
+        runtime->gtwNode = co->gtwa->node_default;
+        runtime->gtwSdoTimeout = co->gtwa->SDOtimeoutTime;
+        runtime->gtwBlock = co->gtwa->SDOblockTransferEnable ? 1 : 0;
+    }
+#endif
+}
+
+void
+CO_standbyLinux_setRuntime(CO_t* co, const CO_standbyLinux_runtime_t* runtime) {
+    if (runtime->nodeId != co->NMT->nodeId) {
+        return;
+    }
+    /* 非初始化状态下 CO_NMT_process() 不发送启动报文，前一状态相同时不调用回调 */
+    /* CO_NMT_process() sends no boot-up message, if not initializing, and no callback, if previous state is equal */
+    if (runtime->nmtState == CO_NMT_PRE_OPERATIONAL || runtime->nmtState == CO_NMT_OPERATIONAL
+        || runtime->nmtState == CO_NMT_STOPPED) {
+        co->NMT->operatingState = (CO_NMT_internalState_t)runtime->nmtState;
+        co->NMT->operatingStatePrev = (CO_NMT_internalState_t)runtime->nmtState;
+    }
+#if (CO_CONFIG_HB_CONS) & CO_CONFIG_HB_CONS_ENABLE
+    /* 按节点 ID 匹配，心跳消费者配置可能不同。超时定时器重新开始 */
+    /* match by node-ID, heartbeat consumer configuration may differ. Timeout timer starts again */
+    CO_HBconsumer_t* HBcons = co->HBcons;
+    for (uint8_t i = 0; HBcons != NULL && i < HBcons->numberOfMonitoredNodes; i++) {
+        CO_HBconsNode_t* monitoredNode = &HBcons->monitoredNodes[i];
+        for (uint8_t j = 0; j < runtime->hbCount && j < 127; j++) {
+            if (runtime->hb[j].nodeId == monitoredNode->nodeId && monitoredNode->HBstate != CO_HBconsumer_UNCONFIGURED
+                && runtime->hb[j].HBstate != CO_HBconsumer_UNCONFIGURED) {
+                monitoredNode->HBstate = (CO_HBconsumer_state_t)runtime->hb[j].HBstate;
+                monitoredNode->NMTstate = (CO_NMT_internalState_t)runtime->hb[j].NMTstate;
+                monitoredNode->NMTstatePrev = monitoredNode->NMTstate;
+                monitoredNode->timeoutTimer = 0;
+                break;
+            }
+        }
+    }
+#endif
+#if (CO_CONFIG_GTW) & CO_CONFIG_GTW_ASCII
+    if (co->gtwa != NULL) {
+        co->gtwa->net_default = runtime->gtwNet;
+        co->gtwa->node_default = runtime->gtwNode;
+        co->gtwa->SDOtimeoutTime = runtime->gtwSdoTimeout;
+        co->gtwa->SDOblockTransferEnable = runtime->gtwBlock != 0;
+    }
+#endif
+}
+
+/* 发送已组装的消息。套接字缓冲区满时返回 false，连接出错时关闭连接 */
+/* Send assembled message. Return false, if socket buffer is full, close connection on error */
+static bool_t
+standbySend(CO_standbyLinux_t* sb, size_t len) {
+    ssize_t n = send(sb->fd, sb->msg, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (n == (ssize_t)len) {
+        sb->statBytes += len;
+        return true;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return false;
+    }
+    log_printf(LOG_NOTICE, DBG_STANDBY_INFO, sb->path, "standby disconnected");
+    close(sb->fd);
+    sb->fd = -1;
+    return false;
+}
+
+/* 向消息添加记录，消息满时先发送。太长的数据分成多个记录 */
+/* Add record to message, send it first if full. Too long data are split into multiple records */
+static bool_t
+standbyAdd(CO_standbyLinux_t* sb, size_t* len, uint16_t type, uint16_t block, uint32_t offset, const void* data,
+           size_t length) {
+    /* 每个消息保留提交记录的空间 */
+    /* space for commit record is reserved in each message */
+    const size_t space = CO_STANDBY_MSG_MAX - 2 * sizeof(standbyRecord_t);
+
+    do {
+        if (*len + sizeof(standbyRecord_t) >= space) {
+            if (!standbySend(sb, *len)) {
+                return false;
+            }
+            *len = 0;
+        }
+        size_t chunk = space - *len - sizeof(standbyRecord_t);
+        if (chunk > length) {
+            chunk = length;
+        }
+        standbyRecord_t rec = {.type = type, .block = block, .offset = offset, .length = (uint32_t)chunk};
+        memcpy(&sb->msg[*len], &rec, sizeof(rec));
+        memcpy(&sb->msg[*len + sizeof(rec)], data, chunk);
+        *len += sizeof(rec) + chunk;
+        data = (const uint8_t*)data + chunk;
+        offset += (uint32_t)chunk;
+        length -= chunk;
+    } while (length > 0);
+    return true;
+}
+
+/* 发送一次更新：与 shadow 不同的字节范围（全量时所有数据）、改变的运行时状态和提交记录 */
+/* Send one update: byte ranges, which differ from shadow (all data if full), changed runtime state and commit */
+static bool_t
+standbyUpdate(CO_standbyLinux_t* sb, bool_t full) {
+    size_t len = 0;
+    size_t blockOffset = 0;
+
+    if (full) {
+        uint32_t lengths[256];
+        for (uint8_t i = 0; i < sb->blocksCount; i++) {
+            lengths[i] = (uint32_t)sb->blocks[i].len;
+        }
+        if (!standbyAdd(sb, &len, REC_HELLO, sb->blocksCount, sb->odLayoutId, lengths,
+                        sb->blocksCount * sizeof(uint32_t))) {
+            return false;
+        }
+    }
+    for (uint16_t b = 0; b < sb->blocksCount; b++) {
+        const uint8_t* cur = &sb->current[blockOffset];
+        const uint8_t* old = &sb->shadow[blockOffset];
+        size_t blockLen = sb->blocks[b].len;
+        size_t i = 0;
+
+        while (i < blockLen) {
+            if (!full && cur[i] == old[i]) {
+                i++;
+                continue;
+            }
+            /* 差异范围，间隔小于记录头时合并 */
+            /* changed range, gaps smaller than record header are merged */
+            size_t start = i, end = i + 1;
+            if (full) {
+                end = blockLen;
+            } else {
+                for (size_t j = end; j < blockLen && j - end < sizeof(standbyRecord_t); j++) {
+                    if (cur[j] != old[j]) {
+                        end = j + 1;
+                    }
+                }
+            }
+            if (!standbyAdd(sb, &len, REC_DATA, b, (uint32_t)start, &cur[start], end - start)) {
+                return false;
+            }
+            i = end;
+        }
+        blockOffset += blockLen;
+    }
+    if (full || memcmp(&sb->runtimeNew, &sb->runtime, sizeof(sb->runtime)) != 0) {
+        if (!standbyAdd(sb, &len, REC_RUNTIME, 0, 0, &sb->runtimeNew, sizeof(sb->runtimeNew))) {
+            return false;
+        }
+    }
+    standbyRecord_t commit = {.type = REC_COMMIT, .offset = sb->sequence + 1};
+    memcpy(&sb->msg[len], &commit, sizeof(commit));
+    if (!standbySend(sb, len + sizeof(commit))) {
+        return false;
+    }
+    sb->sequence++;
+    sb->statUpdates++;
+    return true;
+}
+
+bool_t
+CO_standbyLinux_process(CO_standbyLinux_t* sb, CO_t* co, CO_epoll_t* ep) {
+    struct stat st;
+
+    if (sb == NULL || sb->standby || sb->fdListen < 0) {
+        return true;
+    }
+
+    /* 隔离：套接字文件被替换，被动实例已接管（例如本进程曾挂起）。不删除它的套接字文件。每个心跳周期检查一次，
+     * 主线程停顿后立即检查：比 CO_STANDBY_TIMEOUT_US 短的停顿不会引起接管 */
+    /* fencing: socket file was replaced, standby took over (this process was hung, for example). Its socket file is
+     * not removed. Check once per heartbeat period and immediately after the mainline was stalled: shorter stall than
+     * CO_STANDBY_TIMEOUT_US can not cause take over */
+    uint32_t fenceInterval_us = co->NMT->HBproducerTime_us != 0 ? co->NMT->HBproducerTime_us : CO_STANDBY_TIMEOUT_US;
+    sb->fenceTimer_us += ep->timeDifference_us;
+    bool_t fenceCheck = sb->fenceTimer_us >= fenceInterval_us
+                        || ep->timeDifference_us >= CO_STANDBY_TIMEOUT_US - CO_STANDBY_INTERVAL_US;
+    if (fenceCheck) {
+        sb->fenceTimer_us = 0;
+    }
+    if (fenceCheck && sb->pathIno != 0 && stat(sb->path, &st) == 0 && (uint64_t)st.st_ino != sb->pathIno) {
+        log_printf(LOG_CRIT, DBG_STANDBY_FENCED, sb->path);
+        if (sb->fd >= 0) {
+            close(sb->fd);
+            sb->fd = -1;
+        }
+        close(sb->fdListen);
+        sb->fdListen = -1;
+        return false;
+    }
+
+    if (sb->fd < 0) {
+        sb->fd = accept(sb->fdListen, NULL, NULL);
+        if (sb->fd < 0) {
+            return true;
+        }
+        sb->fullPending = true;
+        sb->timer_us = CO_STANDBY_INTERVAL_US;
+        log_printf(LOG_INFO, DBG_STANDBY_INFO, sb->path, "standby connected");
+    }
+
+    sb->timer_us += ep->timeDifference_us;
+    if (sb->timer_us < CO_STANDBY_INTERVAL_US) {
+        uint32_t diff = CO_STANDBY_INTERVAL_US - sb->timer_us;
+        if (ep->timerNext_us > diff) {
+            ep->timerNext_us = diff;
+        }
+        return true;
+    }
+    sb->timer_us = 0;
+
+    /* 在 OD 锁下只复制数据，比较和发送在锁外 */
+    /* only copy data under OD lock, compare and send outside of it */
+    size_t offset = 0;
+    CO_LOCK_OD(co->CANmodule);
+    for (uint8_t i = 0; i < sb->blocksCount; i++) {
+        memcpy(&sb->current[offset], sb->blocks[i].addr, sb->blocks[i].len);
+        offset += sb->blocks[i].len;
+    }
+    CO_standbyLinux_getRuntime(co, &sb->runtimeNew);
+    CO_UNLOCK_OD(co->CANmodule);
+
+    if (standbyUpdate(sb, sb->fullPending)) {
+        uint8_t* swap = sb->shadow;
+        sb->shadow = sb->current;
+        sb->current = swap;
+        sb->runtime = sb->runtimeNew;
+        sb->fullPending = false;
+    } else {
+        /* 被动实例可能收到了部分记录，下一次发送全部数据 */
+        /* standby may have received part of records, send all data next time */
+        sb->fullPending = true;
+    }
+    if (ep->timerNext_us > CO_STANDBY_INTERVAL_US) {
+        ep->timerNext_us = CO_STANDBY_INTERVAL_US;
+    }
+    return true;
+}
+
+CO_ReturnError_t
+CO_standbyLinux_snapshotSave(const char* filename, CO_t* co, uint32_t odLayoutId, const CO_standbyLinux_block_t* blocks,
+                             uint8_t blocksCount) {
+    snapshotHeader_t header = {.magic = SNAPSHOT_MAGIC,
+                               .version = SNAPSHOT_VERSION,
+                               .blocksCount = blocksCount,
+                               .runtimeSize = sizeof(CO_standbyLinux_runtime_t),
+                               .odLayoutId = odLayoutId};
+    uint32_t lengths[256];
+    CO_standbyLinux_runtime_t runtime;
+    char name_tmp[PATH_MAX];
+
+    if (filename == NULL || co == NULL || blocks == NULL
+        || snprintf(name_tmp, sizeof(name_tmp), "%s.tmp", filename) >= (int)sizeof(name_tmp)) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    for (uint8_t i = 0; i < blocksCount; i++) {
+        lengths[i] = (uint32_t)blocks[i].len;
+        header.dataSize += lengths[i];
+    }
+    uint8_t* data = malloc(header.dataSize + 1);
+    if (data == NULL) {
+        return CO_ERROR_OUT_OF_MEMORY;
+    }
+
+    /* 在 OD 锁下只复制，CRC 和写入在锁外 */
+    /* only copy under OD lock, CRC and write outside of it */
+    size_t offset = 0;
+    CO_LOCK_OD(co->CANmodule);
+    for (uint8_t i = 0; i < blocksCount; i++) {
+        memcpy(&data[offset], blocks[i].addr, blocks[i].len);
+        offset += blocks[i].len;
+    }
+    CO_standbyLinux_getRuntime(co, &runtime);
+    CO_UNLOCK_OD(co->CANmodule);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    header.time_s = (int64_t)ts.tv_sec;
+    header.time_ns = (uint32_t)ts.tv_nsec;
+    header.crc = crc16_ccitt((const uint8_t*)lengths, blocksCount * sizeof(uint32_t), 0);
+    header.crc = crc16_ccitt((const uint8_t*)&runtime, sizeof(runtime), header.crc);
+    header.crc = crc16_ccitt(data, header.dataSize, header.crc);
+
+    struct iovec iov[4] = {{&header, sizeof(header)},
+                           {lengths, blocksCount * sizeof(uint32_t)},
+                           {&runtime, sizeof(runtime)},
+                           {data, header.dataSize}};
+    size_t size = sizeof(header) + blocksCount * sizeof(uint32_t) + sizeof(runtime) + header.dataSize;
+    CO_ReturnError_t ret = CO_ERROR_NO;
+    int fd = open(name_tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0 || pwritev(fd, iov, 4, 0) != (ssize_t)size) {
+        ret = CO_ERROR_SYSCALL;
+    }
+    if (fd >= 0 && close(fd) != 0) {
+        ret = CO_ERROR_SYSCALL;
+    }
+    if (ret == CO_ERROR_NO && rename(name_tmp, filename) != 0) {
+        ret = CO_ERROR_SYSCALL;
+    }
+    if (ret != CO_ERROR_NO) {
+        log_printf(LOG_CRIT, DBG_SNAPSHOT_INFO, filename, "write error");
+        unlink(name_tmp);
+    } else {
+        log_printf(LOG_INFO, DBG_SNAPSHOT_INFO, filename, "written");
+    }
+    free(data);
+    return ret;
+}
+
+/* 验证快照文件内容，有效时返回 NULL，否则返回原因 */
+/* Verify content of snapshot file, return NULL if valid, reason otherwise */
+static const char*
+snapshotVerify(const uint8_t* buf, size_t size, uint32_t odLayoutId, const CO_standbyLinux_block_t* blocks,
+               uint8_t blocksCount, uint32_t* age_ms) {
+    snapshotHeader_t header;
+
+    if (size < sizeof(header)) {
+        return "invalid";
+    }
+    memcpy(&header, buf, sizeof(header));
+    size_t lengthsSize = blocksCount * sizeof(uint32_t);
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 || header.version != SNAPSHOT_VERSION
+        || header.runtimeSize != sizeof(CO_standbyLinux_runtime_t) || header.blocksCount != blocksCount
+        || size != sizeof(header) + lengthsSize + header.runtimeSize + header.dataSize) {
+        return "invalid or different data blocks";
+    }
+    /* 数据块长度相同，但对象字典可能不同，例如新程序版本改变了 OD 条目 */
+    /* block lengths may be equal with a different Object Dictionary, for example OD entries changed in new program */
+    if (header.odLayoutId != odLayoutId) {
+        return "different Object Dictionary";
+    }
+    for (uint8_t i = 0; i < blocksCount; i++) {
+        uint32_t len;
+        memcpy(&len, &buf[sizeof(header) + i * sizeof(uint32_t)], sizeof(len));
+        if (len != blocks[i].len) {
+            return "invalid or different data blocks";
+        }
+    }
+    if (crc16_ccitt(&buf[sizeof(header)], size - sizeof(header), 0) != header.crc) {
+        return "CRC error";
+    }
+
+    /* 旧快照可能来自崩溃前，网络已经注意到节点丢失 */
+    /* old snapshot may be from before a crash, network has already noticed the lost node */
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    int64_t age = ((int64_t)ts.tv_sec - header.time_s) * 1000 + ((int64_t)ts.tv_nsec - header.time_ns) / 1000000;
+    if (age < -1000 || age > (int64_t)CO_STANDBY_SNAPSHOT_MAX_AGE_S * 1000) {
+        return "stale";
+    }
+    *age_ms = age > 0 ? (uint32_t)age : 0;
+    return NULL;
+}
+
+CO_ReturnError_t
+CO_standbyLinux_snapshotLoad(const char* filename, uint32_t odLayoutId, const CO_standbyLinux_block_t* blocks,
+                             uint8_t blocksCount, CO_standbyLinux_runtime_t* runtime) {
+    struct stat st;
+
+    if (filename == NULL || blocks == NULL || runtime == NULL) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    int fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        /* no snapshot, normal startup */
+        return CO_ERROR_DATA_CORRUPT;
+    }
+    uint8_t* buf = NULL;
+    size_t size = 0;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        size = (size_t)st.st_size;
+        buf = malloc(size);
+    }
+    if (buf != NULL && read(fd, buf, size) != (ssize_t)size) {
+        free(buf);
+        buf = NULL;
+    }
+    close(fd);
+    /* 快照只恢复一次，之后的重启是正常启动 */
+    /* snapshot is restored only once, later restarts are normal startups */
+    unlink(filename);
+
+    uint32_t age_ms = 0;
+    const char* reason = buf != NULL ? snapshotVerify(buf, size, odLayoutId, blocks, blocksCount, &age_ms)
+                                     : "read error";
+    if (reason != NULL) {
+        log_printf(LOG_NOTICE, DBG_SNAPSHOT_INFO, filename, reason);
+        free(buf);
+        return CO_ERROR_DATA_CORRUPT;
+    }
+    size_t offset = sizeof(snapshotHeader_t) + blocksCount * sizeof(uint32_t);
+    memcpy(runtime, &buf[offset], sizeof(*runtime));
+    offset += sizeof(*runtime);
+    for (uint8_t i = 0; i < blocksCount; i++) {
+        memcpy(blocks[i].addr, &buf[offset], blocks[i].len);
+        offset += blocks[i].len;
+    }
+    free(buf);
+    log_printf(LOG_INFO, DBG_SNAPSHOT_RESTORED, filename, runtime->nodeId, age_ms);
+    return CO_ERROR_NO;
+}
+
+void
+CO_standbyLinux_close(CO_standbyLinux_t* sb) {
+    if (sb == NULL) {
+        return;
+    }
+    if (sb->fd >= 0) {
+        close(sb->fd);
+        sb->fd = -1;
+    }
+    if (sb->fdListen >= 0) {
+        /* 只删除自己的套接字文件，被动实例可能已经接管 */
+        /* remove own socket file only, standby may have taken over */
+        struct stat st;
+        if (stat(sb->path, &st) == 0 && (uint64_t)st.st_ino == sb->pathIno) {
+            unlink(sb->path);
+        }
+        close(sb->fdListen);
+        sb->fdListen = -1;
+    }
+    free(sb->shadow);
+    free(sb->current);
+    free(sb->msg);
+    sb->shadow = NULL;
+    sb->current = NULL;
+    sb->msg = NULL;
+}
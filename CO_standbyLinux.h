@@ -0,0 +1,399 @@
+/* Linux 平台的热备份复制
+ * 两个 canopend 进程通过本地套接字配对：主动实例运行 CANopen，并把对象字典数据的改变、NMT 状态、
+ * 心跳消费者表和网关会话状态连续发送给被动实例。主动实例结束或停止发送时，被动实例以相同的节点 ID
+ * 和状态接管，不发送启动报文。同样的状态也可以写入运行时快照文件，用于计划重启。
+ */
+/**
+ * Hot standby replication for Linux
+ *
+ * @file        CO_standbyLinux.h
+ * @ingroup     CO_standbyLinux
+ * @author      CANopenLinux contributors
+ * @copyright   2026 CANopenLinux contributors
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#ifndef CO_STANDBY_LINUX_H
+#define CO_STANDBY_LINUX_H
+
+#include <signal.h>
+
+#include "CANopen.h"
+#include "CO_epoll_interface.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup CO_standbyLinux Hot standby with Linux
+ * Replication of runtime state to a passive canopend instance, which takes over the node.
+ *
+ * @ingroup CO_socketCAN
+ * @{
+ * Two canopend instances are started with the same local socket path. The first one binds the socket and becomes
+ * active, the second one connects and becomes standby. Standby does not initialize CANopen, it only receives the
+ * stream:
+ * - full copy of the registered data blocks (Object Dictionary variables) after connection, then only changed byte
+ *   ranges,
+ * - runtime state (see @ref CO_standbyLinux_runtime_t), when it changes,
+ * - commit record at the end of each update, also as keep-alive, when nothing changes.
+ *
+ * Records of one update are staged and applied to the data blocks on commit, so standby always has a consistent
+ * copy. When the connection is closed (active process ended or crashed), standby takes over immediately: active
+ * instance closes the connection only after its CAN sockets are closed, a crashed process has all of them closed by
+ * the kernel. When no message arrives for @ref CO_STANDBY_TIMEOUT_US, active process may be hung, but still on the
+ * bus. Standby then watches heartbeat of the active node on its own receive-only CAN socket and takes over only after
+ * the heartbeat is missing for @ref CO_STANDBY_HB_TIMEOUT_PCT of the producer time. If messages arrive again, it
+ * continues as standby. On take over standby binds the socket for a new standby, initializes CANopen with replicated
+ * data and node-ID and applies the runtime state before CAN is started, so no boot-up message is sent and NMT state
+ * is kept.
+ *
+ * Active instance fences itself: @ref CO_standbyLinux_process() compares the socket file with the bound one once per
+ * heartbeat producer time and immediately after the mainline was stalled. If the file was replaced, other instance
+ * took over and this one must end immediately, for example after a hung process continues.
+ *
+ * The same data blocks and runtime state can also be written to a runtime snapshot file for planned restarts (see
+ * @ref CO_standbyLinux_snapshotSave()). New process restores it instead of a normal startup, so it continues without
+ * boot-up message and without reconfiguration by the NMT master.
+ *
+ * Block lengths alone do not show, that data belong to the same Object Dictionary. Connection to the standby and
+ * snapshot file therefore carry the identity of the OD layout, hash of index, subindex and size of all OD entries.
+ * It is generated at build time into CO_odLayout.h (CO_OD_LAYOUT_ID) by CO_odLayoutGen, data with a different identity
+ * are rejected.
+ */
+
+/* 主动实例发送更新的间隔（微秒），也是保活间隔 */
+/** Interval of updates from the active instance in microseconds, also keep-alive interval */
+#ifndef CO_STANDBY_INTERVAL_US
+#define CO_STANDBY_INTERVAL_US 10000
+#endif
+
+/* 被动实例在该时间（微秒）内没有收到消息时接管 */
+/** Standby takes over, if no message is received for this time in microseconds */
+#ifndef CO_STANDBY_TIMEOUT_US
+#define CO_STANDBY_TIMEOUT_US 100000
+#endif
+
+/* 复制流超时后，主动节点的心跳在其生产者时间的该百分比内没有收到，被动实例才接管 */
+/** After timeout of the replication stream standby takes over only, if heartbeat of the active node was not received
+ * for this percentage of its producer time */
+#ifndef CO_STANDBY_HB_TIMEOUT_PCT
+#define CO_STANDBY_HB_TIMEOUT_PCT 150
+#endif
+
+/* 一个消息的最大大小，更大的更新分成多个消息，提交记录在最后一个中 */
+/** Maximum size of one message, larger updates are split into multiple messages, commit record is in the last one */
+#ifndef CO_STANDBY_MSG_MAX
+#define CO_STANDBY_MSG_MAX 65536
+#endif
+
+/* 运行时快照的最大有效时间（秒），更旧的快照不被恢复 */
+/** Maximum age of runtime snapshot in seconds, older snapshots are not restored */
+#ifndef CO_STANDBY_SNAPSHOT_MAX_AGE_S
+#define CO_STANDBY_SNAPSHOT_MAX_AGE_S 10
+#endif
+
+/* 复制的数据块，例如 OD_RAM 和 OD_PERSIST_COMM。两个实例必须注册相同大小的块 */
+/** Replicated data block, for example OD_RAM or OD_PERSIST_COMM. Both instances must register blocks of equal sizes */
+typedef struct {
+    void* addr; /**< Address of data */
+    size_t len; /**< Length of data */
+} CO_standbyLinux_block_t;
+
+/* 运行时状态：不在数据块中的 NMT、心跳消费者和网关状态 */
+/** Runtime state, which is not inside data blocks: NMT, heartbeat consumer and gateway */
+typedef struct {
+    uint8_t nodeId;             /**< Active node-ID */
+    int8_t nmtState;            /**< NMT operating state, @ref CO_NMT_internalState_t */
+    uint8_t hbCount;            /**< Number of used entries in hb */
+    uint8_t gtwBlock;           /**< Gateway: SDO block transfer enabled */
+    int32_t gtwNet;             /**< Gateway: default net */
+    int16_t gtwNode;            /**< Gateway: default node */
+    uint16_t gtwSdoTimeout;     /**< Gateway: SDO client timeout in milliseconds */
+    uint32_t hbProducerTime_us; /**< Heartbeat producer time of the node, watched by standby */
+    struct {
+        uint8_t nodeId;   /**< Monitored node-ID */
+        uint8_t HBstate;  /**< @ref CO_HBconsumer_state_t */
+        int8_t NMTstate;  /**< Last received NMT state of the node */
+        uint8_t reserved; /**< Reserved, zero */
+    } hb[127];            /**< Heartbeat consumer table */
+} CO_standbyLinux_runtime_t;
+
+/* 热备份对象 */
+/** Hot standby object */
+typedef struct {
+    CO_standbyLinux_block_t* blocks;      /**< Replicated data blocks, from @ref CO_standbyLinux_init() */
+    uint8_t blocksCount;                  /**< Number of blocks */
+    size_t dataSize;                      /**< Sum of block lengths */
+    char path[108];                       /**< Local socket path */
+    int canIfindex;                       /**< CAN interface, where standby watches heartbeat of the active node */
+    uint32_t odLayoutId;                  /**< Identity of the Object Dictionary layout, must match the other one */
+    bool_t standby;                       /**< True in standby role, until take over */
+    int fdListen;                         /**< Active: listening socket, -1 if none */
+    int fd;                               /**< Connection to the other instance, -1 if none */
+    uint8_t* shadow;                      /**< Active: last sent data; standby: staged data, committed on take over */
+    uint8_t* current;                     /**< Active: snapshot of data blocks */
+    uint8_t* msg;                         /**< Message buffer of CO_STANDBY_MSG_MAX bytes */
+    uint64_t pathIno;                     /**< Active: inode of the bound socket file */
+    CO_standbyLinux_runtime_t runtime;    /**< Active: runtime state as last sent; standby: committed state */
+    CO_standbyLinux_runtime_t runtimeNew; /**< Active: current runtime state; standby: staged state */
+    bool_t synced;                        /**< Standby: full copy was received and committed */
+    bool_t fullPending;                   /**< Active: next update sends full copy */
+    uint32_t fenceTimer_us;               /**< Active: time since the last check of the socket file */
+    uint32_t timer_us;                    /**< Active: time since the last update */
+    uint32_t sequence;                    /**< Sequence number of the last commit */
+    uint32_t statUpdates;                 /**< Statistics: number of commits sent or applied */
+    uint64_t statBytes;                   /**< Statistics: bytes sent or received */
+} CO_standbyLinux_t;
+
+/* 初始化热备份对象
+ * 函数功能：连接本地套接字 path。连接成功时本实例是被动实例，否则删除过期的套接字文件，绑定并监听，
+ *         本实例是主动实例
+ * 使用说明：在存储初始化之前调用：被动实例不能打开主动实例正在使用的存储文件。接管后初始化存储，然后调用
+ *         CO_standbyLinux_applyReplicated()
+ * 参数说明：
+ *   - sb: 要初始化的对象，必须永久存在
+ *   - path: 本地套接字路径
+ *   - canIfindex: CAN 接口索引，被动实例在它上面监视主动节点的心跳，0 表示不监视
+ *   - odLayoutId: 对象字典布局标识（CO_OD_LAYOUT_ID），必须与另一个实例相同
+ *   - blocks: 复制的数据块数组，必须永久存在
+ *   - blocksCount: 数据块数量
+ * 返回值说明：
+ *   - CO_ERROR_NO: 成功，角色见 sb->standby
+ *   - CO_ERROR_ILLEGAL_ARGUMENT: 参数非法
+ *   - CO_ERROR_OUT_OF_MEMORY: 内存不足
+ *   - CO_ERROR_SYSCALL: 套接字错误
+ */
+/**
+ * Initialize hot standby object
+ *
+ * Connect to local socket path. If connected, this instance is standby. Otherwise remove stale socket file, bind and
+ * listen; this instance is active. Call before storage is initialized: standby must not open storage files, which
+ * are still used by the active instance. After take over initialize storage and then call
+ * @ref CO_standbyLinux_applyReplicated().
+ *
+ * @param sb This object will be initialized, must exist permanently.
+ * @param path Local socket path.
+ * @param canIfindex Index of CAN interface, where standby watches heartbeat of the active node, 0 for none.
+ * @param odLayoutId Identity of the Object Dictionary layout (CO_OD_LAYOUT_ID), must be equal in both instances.
+ * @param blocks Array of replicated data blocks, must exist permanently.
+ * @param blocksCount Number of blocks.
+ *
+ * @return CO_ERROR_NO (role is in sb->standby), CO_ERROR_ILLEGAL_ARGUMENT, CO_ERROR_OUT_OF_MEMORY or CO_ERROR_SYSCALL.
+ */
+CO_ReturnError_t CO_standbyLinux_init(CO_standbyLinux_t* sb, const char* path, int canIfindex, uint32_t odLayoutId,
+                                      CO_standbyLinux_block_t* blocks, uint8_t blocksCount);
+
+/* 被动实例：接收复制流，直到主动实例丢失
+ * 函数功能：阻塞接收并应用更新。连接关闭时，或超时 CO_STANDBY_TIMEOUT_US 并且主动节点的心跳也丢失时，
+ *         绑定套接字成为主动实例并返回。心跳生产者时间为 0、没有 CAN 接口或还没有复制数据时只用超时
+ * 参数说明：
+ *   - sb: 热备份对象
+ *   - endProgram: 不为零时提前返回
+ * 返回值说明：
+ *   - CO_ERROR_NO: 接管（sb->synced 表示数据已复制）或程序结束
+ *   - CO_ERROR_DATA_CORRUPT: 协议错误，或数据块大小或对象字典布局与主动实例不一致，不接管
+ *   - CO_ERROR_SYSCALL: 接管时套接字错误
+ */
+/**
+ * Standby: receive replication stream until the active instance is lost
+ *
+ * Function blocks, receives and applies updates. When connection is closed, or on timeout @ref CO_STANDBY_TIMEOUT_US
+ * if heartbeat of the active node is also missing, it binds the socket, becomes active and returns. If heartbeat
+ * producer time is zero, there is no CAN interface or nothing was replicated yet, only the timeout is used.
+ *
+ * @param sb This object
+ * @param endProgram Function returns early, if it is not zero.
+ *
+ * @return CO_ERROR_NO on take over (sb->synced is set, if data were replicated) or program end, CO_ERROR_DATA_CORRUPT
+ * on protocol error or if block sizes or Object Dictionary layout differ from the active instance (no take over),
+ * CO_ERROR_SYSCALL.
+ */
+CO_ReturnError_t CO_standbyLinux_follow(CO_standbyLinux_t* sb, volatile sig_atomic_t* endProgram);
+
+/* 接管后把复制的数据再次应用到数据块
+ * 函数功能：接管时已提交的数据保存在 sb->shadow 中。存储初始化从文件读取数据块，文件可能比复制的数据旧，
+ *         所以之后再复制一次。自动存储随后把改变的条目写入文件
+ * 使用说明：CO_standbyLinux_follow() 接管后，在存储初始化之后、CANopen 初始化之前调用
+ * 参数说明：
+ *   - sb: 热备份对象
+ * 返回值说明：数据已复制时返回 true，这时用 sb->runtime 初始化 CANopen；否则数据块保持存储中的数据
+ */
+/**
+ * Apply replicated data to data blocks again after take over
+ *
+ * On take over committed data are kept in sb->shadow. Storage initialization reads data blocks from files, which may
+ * be older than the replicated data, so they are copied once more afterwards. Auto storage then writes changed entries
+ * to the files. Call after take over by @ref CO_standbyLinux_follow(), after storage is initialized and before CANopen
+ * initialization.
+ *
+ * @param sb This object
+ *
+ * @return true, if data were replicated, then initialize CANopen with sb->runtime. Otherwise data blocks keep data from
+ * storage.
+ */
+bool_t CO_standbyLinux_applyReplicated(CO_standbyLinux_t* sb);
+
+/* 读取 CANopen 对象的运行时状态
+ * 参数说明：
+ *   - co: CANopen 对象
+ *   - runtime: [输出] 运行时状态
+ */
+/**
+ * Read runtime state from CANopen objects
+ *
+ * @param co CANopen object
+ * @param [out] runtime Runtime state
+ */
+void CO_standbyLinux_getRuntime(CO_t* co, CO_standbyLinux_runtime_t* runtime);
+
+/* 把运行时状态应用到 CANopen 对象
+ * 函数功能：设置 NMT 状态（跳过启动报文）、心跳消费者中相同节点的状态和网关默认值
+ * 使用说明：在 CO_CANopenInit() 之后、CO_CANsetNormalMode() 之前调用，节点 ID 必须相同
+ * 参数说明：
+ *   - co: CANopen 对象
+ *   - runtime: 运行时状态
+ */
+/**
+ * Apply runtime state to CANopen objects
+ *
+ * Set NMT state (boot-up message is skipped), state of the same nodes in heartbeat consumer and gateway defaults.
+ * Call after @ref CO_CANopenInit() and before @ref CO_CANsetNormalMode(), node-ID must be the same.
+ *
+ * @param co CANopen object
+ * @param runtime Runtime state
+ */
+void CO_standbyLinux_setRuntime(CO_t* co, const CO_standbyLinux_runtime_t* runtime);
+
+/* 主动实例：接受被动实例的连接并发送更新
+ * 函数功能：每个心跳生产者周期一次，以及主线程停顿之后立即检查套接字文件仍是自己绑定的那个，否则其他实例
+ *         已接管，本实例被隔离。每 CO_STANDBY_INTERVAL_US 在
+ *         CO_LOCK_OD() 下复制数据块，把与上次发送不同的字节范围、改变的运行时状态和提交记录发送给被动实例。
+ *         降低 ep->timerNext_us
+ * 使用说明：在主线程中周期调用，在 CO_epoll_processMain() 之前，这样被隔离的实例不再处理 SDO 等
+ * 参数说明：
+ *   - sb: 热备份对象
+ *   - co: CANopen 对象
+ *   - ep: 主线程 epoll 对象
+ * 返回值说明：false 表示本实例被隔离，必须立即停止 CAN 通信（结束进程）
+ */
+/**
+ * Active: accept connection from standby and send updates
+ *
+ * Once per heartbeat producer time and immediately after the mainline was stalled, verify, that socket file is still
+ * the one bound by this instance. Otherwise other instance took over and this one is fenced. Every
+ * @ref CO_STANDBY_INTERVAL_US copy data blocks under @ref CO_LOCK_OD() and send byte ranges, which differ from the
+ * last sent data, changed runtime state and commit record to standby. Function lowers ep->timerNext_us. Call it
+ * cyclically from mainline, before @ref CO_epoll_processMain(), so fenced instance does not process SDO and other
+ * objects any more.
+ *
+ * @param sb This object
+ * @param co CANopen object
+ * @param ep Epoll object of the mainline
+ *
+ * @return false, if this instance is fenced: it must stop CAN communication immediately (end the process).
+ */
+bool_t CO_standbyLinux_process(CO_standbyLinux_t* sb, CO_t* co, CO_epoll_t* ep);
+
+/* 把数据块和运行时状态写入运行时快照文件
+ * 函数功能：在 CO_LOCK_OD() 下复制数据块并读取运行时状态，然后用一次 pwritev() 写入临时文件，原子地重命名为
+ *         filename。文件包含版本、对象字典布局标识、块长度、写入时间和 CRC。不调用 fdatasync()，快照用于进程重启，
+ *         不用于断电
+ * 使用说明：在计划重启前调用，例如程序结束时在实时线程停止之后
+ * 参数说明：
+ *   - filename: 快照文件路径
+ *   - co: CANopen 对象
+ *   - odLayoutId: 对象字典布局标识（CO_OD_LAYOUT_ID）
+ *   - blocks: 数据块数组
+ *   - blocksCount: 数据块数量
+ * 返回值说明：
+ *   - CO_ERROR_NO: 成功
+ *   - CO_ERROR_ILLEGAL_ARGUMENT: 参数非法
+ *   - CO_ERROR_OUT_OF_MEMORY: 内存不足
+ *   - CO_ERROR_SYSCALL: 文件错误
+ */
+/**
+ * Write data blocks and runtime state to runtime snapshot file
+ *
+ * Data blocks are copied and runtime state is read under @ref CO_LOCK_OD(), then they are written to temporary file
+ * with one pwritev() and atomically renamed to filename. File contains version, identity of the Object Dictionary
+ * layout, block lengths, time of writing and CRC. fdatasync() is not called, snapshot is for process restart, not for
+ * power loss. Call it before planned restart, for example at program end after realtime thread is stopped.
+ *
+ * @param filename Path of the snapshot file
+ * @param co CANopen object
+ * @param odLayoutId Identity of the Object Dictionary layout (CO_OD_LAYOUT_ID)
+ * @param blocks Array of data blocks
+ * @param blocksCount Number of blocks
+ *
+ * @return CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT, CO_ERROR_OUT_OF_MEMORY or CO_ERROR_SYSCALL.
+ */
+CO_ReturnError_t CO_standbyLinux_snapshotSave(const char* filename, CO_t* co, uint32_t odLayoutId,
+                                              const CO_standbyLinux_block_t* blocks, uint8_t blocksCount);
+
+/* 从运行时快照文件恢复数据块和运行时状态
+ * 函数功能：读取并验证快照，把数据复制到数据块，然后删除文件，快照只恢复一次。对象字典布局或块长度不同、
+ *         CRC 错误或快照比 CO_STANDBY_SNAPSHOT_MAX_AGE_S 旧时数据块不改变
+ * 使用说明：在数据块从存储初始化之后、CANopen 初始化之前调用。成功时用 runtime->nodeId 初始化 CANopen，
+ *         然后调用 CO_standbyLinux_setRuntime()
+ * 参数说明：
+ *   - filename: 快照文件路径
+ *   - odLayoutId: 对象字典布局标识（CO_OD_LAYOUT_ID），必须与写入时相同
+ *   - blocks: 数据块数组，与写入时相同
+ *   - blocksCount: 数据块数量
+ *   - runtime: [输出] 运行时状态
+ * 返回值说明：
+ *   - CO_ERROR_NO: 已恢复
+ *   - CO_ERROR_ILLEGAL_ARGUMENT: 参数非法
+ *   - CO_ERROR_DATA_CORRUPT: 没有快照文件，或快照无效、过期、对象字典或数据块不同，正常启动
+ */
+/**
+ * Restore data blocks and runtime state from runtime snapshot file
+ *
+ * Snapshot is read and verified, data are copied to data blocks and file is removed, so snapshot is restored only
+ * once. Data blocks are not changed, if Object Dictionary layout or block lengths differ, CRC is wrong or snapshot is
+ * older than @ref CO_STANDBY_SNAPSHOT_MAX_AGE_S. Call after data blocks are initialized from storage and before CANopen
+ * initialization. On success initialize CANopen with runtime->nodeId and call @ref CO_standbyLinux_setRuntime().
+ *
+ * @param filename Path of the snapshot file
+ * @param odLayoutId Identity of the Object Dictionary layout (CO_OD_LAYOUT_ID), the same as when written
+ * @param blocks Array of data blocks, the same as when written
+ * @param blocksCount Number of blocks
+ * @param [out] runtime Runtime state
+ *
+ * @return CO_ERROR_NO if restored, CO_ERROR_ILLEGAL_ARGUMENT or CO_ERROR_DATA_CORRUPT if there is no snapshot file or
+ * if snapshot is invalid, stale or has different Object Dictionary or data blocks (normal startup).
+ */
+CO_ReturnError_t CO_standbyLinux_snapshotLoad(const char* filename, uint32_t odLayoutId,
+                                              const CO_standbyLinux_block_t* blocks, uint8_t blocksCount,
+                                              CO_standbyLinux_runtime_t* runtime);
+
+/* 关闭套接字并释放内存，主动实例删除套接字文件
+ * 参数说明：
+ *   - sb: 热备份对象
+ */
+/**
+ * Close sockets and free memory, active instance removes socket file
+ *
+ * @param sb This object
+ */
+void CO_standbyLinux_close(CO_standbyLinux_t* sb);
+
+/** @} */ /* CO_standbyLinux */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CO_STANDBY_LINUX_H */
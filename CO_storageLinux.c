@@ -20,123 +20,749 @@
 #include "CO_storageLinux.h"
 #include "301/crc16-ccitt.h"
 
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#ifndef CO_SINGLE_THREAD
+#include <pthread.h>
+#endif
 
 #if (CO_CONFIG_STORAGE) & CO_CONFIG_STORAGE_ENABLE
 
-/* 函数功能: 在"存储参数"命令时写入数据到文件 - OD对象1010
- * 执行步骤:
- *   步骤1: 创建临时文件名和旧文件名
- *   步骤2: 打开临时文件并写入数据和CRC校验和
- *   步骤3: 验证写入的数据: 读取临时文件并检查长度和CRC
- *   步骤4: 将现有文件重命名为.old，临时文件重命名为正式文件
- *   步骤5: 清理内存资源
- * 参数说明:
- *   - entry: 存储条目指针，包含文件名、地址和长度信息
- *   - CANmodule: CAN模块指针(本函数未使用)
- * 返回值说明: 返回ODR_t类型错误码(ODR_OK成功，ODR_OUT_OF_MEM内存不足，ODR_HW硬件错误)
- */
-/*
- * Function for writing data on "Store parameters" command - OD object 1010
- *
- * For more information see file CO_storage.h, CO_storage_entry_t.
+/* Linux 部分的存储状态
+ * 结构说明：每个协议栈存储对象一个，由 storageInit() 在第一次初始化时分配，同一存储对象再次初始化时重用，
+ *         条目的 owner 指向它。可以有多个存储对象（例如多个 CANopen 设备在同一个进程中）
+ * 成员说明：
+ *   - storage: 协议栈的存储对象，0x1010/0x1011 的扩展对象指向它
+ *   - next: 所有已分配状态的链表
+ *   - stats: 自动存储统计，写线程更新的字段由 writerMutex 保护
+ *   - container: 所有条目存储在容器文件 containerFilename 中
+ *   - containerGeneration: 容器文件的版本号，每次提交加一
+ *   - containerBatch, containerStaged: 子索引 1（所有条目）的存储或恢复只提交一次容器
+ *   - containerWrite1010Orig, containerWrite1011Orig: 0x1010/0x1011 原来的写函数
+ *   - writerMutex, writerCond, writerThreadId, writerRunning, writerStop: 自动存储的后台写线程
  */
+/* Linux state of the storage object: one per storage object of the stack, allocated by storageInit() on the first
+ * initialization, reused if the same storage object is initialized again. Entries point to it with owner. There may be
+ * more storage objects in one process (for more CANopen devices, for example). */
+typedef struct CO_storageLinux {
+    CO_storage_t* storage;        /* Storage object of the stack, extension object of 0x1010 and 0x1011 */
+    struct CO_storageLinux* next; /* List of all allocated states */
+    CO_storageLinux_stats_t stats; /* Auto storage statistics, fields from writer thread protected by writerMutex */
+    bool_t container;              /* All entries are stored in container file containerFilename */
+    char containerFilename[CO_STORAGE_PATH_MAX]; /* Name of the container file */
+    uint32_t containerGeneration;                /* Generation of the container file, incremented on each commit */
+    bool_t containerBatch;  /* Store or restore of sub-index 1 (all entries) is in progress, commit once */
+    bool_t containerStaged; /* Entry was staged during the batch, container has to be committed */
+    ODR_t (*containerWrite1010Orig)(OD_stream_t* stream, const void* buf, OD_size_t count, OD_size_t* countWritten);
+    ODR_t (*containerWrite1011Orig)(OD_stream_t* stream, const void* buf, OD_size_t count, OD_size_t* countWritten);
+#ifndef CO_SINGLE_THREAD
+    pthread_mutex_t writerMutex; /* Protects write state of entries and statistics */
+    pthread_cond_t writerCond;   /* Signals queued snapshots to the writer thread and finished writes back */
+    pthread_t writerThreadId;    /* Background writer thread of auto storage */
+    bool_t writerRunning;        /* Writer thread is running */
+    bool_t writerStop;           /* Request for the writer thread to finish */
+#endif
+} CO_storageLinux_t;
+
+/* 已分配的状态，只在初始化时修改 */
+/* Allocated states, modified only by initialization */
+static CO_storageLinux_t* storageLinuxList = NULL;
+
+/* 返回存储对象的 Linux 状态，存储对象未初始化时返回 NULL */
+/* Return Linux state of the storage object or NULL, if storage object is not initialized */
+static CO_storageLinux_t*
+storageLinuxOf(const CO_storage_t* storage) {
+    if (storage == NULL || storage->entries == NULL || storage->entriesCount == 0) {
+        return NULL;
+    }
+    return storage->entries[0].owner;
+}
+
+/* 自动存储条目的写状态 */
+/* Write state of auto storage entry */
+enum { WRITE_IDLE, WRITE_QUEUED, WRITE_BUSY };
+
+/* 单调时钟时间（微秒） */
+/* Monotonic time in microseconds */
+static uint64_t
+storageTime_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+/* 标记条目已改变，时间在标志之前写入，这样 auto_process 看到标志时时间有效 */
+/* Mark entry dirty, times are written before the flag, so they are valid, when auto_process sees the flag */
+static void
+markEntry(CO_storage_entry_t* entry) {
+    uint64_t now = storageTime_us();
+
+    if (!entry->dirty) {
+        entry->dirtyFirst_us = now;
+    }
+    entry->dirtyLast_us = now;
+    CO_MemoryBarrier();
+    entry->dirty = 1;
+}
+
+/* 把文件名拆分为目录和文件名，打开目录。返回目录文件描述符，出错返回 -1 */
+/* Split filename into directory and base name and open the directory. Return directory file descriptor or -1 */
+static int
+openDir(const char* filename, const char** base) {
+    const char* slash = strrchr(filename, '/');
+    char dir[CO_STORAGE_PATH_MAX];
+
+    if (slash == NULL) {
+        *base = filename;
+        return open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    }
+    *base = slash + 1;
+    size_t len = slash == filename ? 1 : (size_t)(slash - filename);
+    memcpy(dir, filename, len);
+    dir[len] = '\0';
+    return open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+}
+
+/* 原子地替换文件：iov 用一次 pwritev() 写入临时文件并同步，现有文件保留为 *.old，临时文件被重命名为现有文件，
+ * 然后同步目录。任何时刻都存在完整的旧文件或完整的新文件 */
+/* Atomically replace the file: iov is written to temporary file with one pwritev() and synced, existing file is kept
+ * as *.old, temporary file is renamed over existing file, then directory is synced. At any moment either complete old
+ * or complete new file exists. */
 static ODR_t
-storeLinux(CO_storage_entry_t* entry, CO_CANmodule_t* CANmodule) {
-    (void)CANmodule;
+writeFileAtomic(const char* filename, const struct iovec* iov, int iovcnt) {
     ODR_t ret = ODR_OK;
-    uint16_t crc_store;
+    const char* base;
+    char name_tmp[CO_STORAGE_PATH_MAX + 4];
+    char name_old[CO_STORAGE_PATH_MAX + 4];
+    size_t size = 0;
+
+    int dirfd = openDir(filename, &base);
+    if (dirfd < 0) {
+        return ODR_HW;
+    }
+    snprintf(name_tmp, sizeof(name_tmp), "%s.tmp", base);
+    snprintf(name_old, sizeof(name_old), "%s.old", base);
 
-    /* 创建临时文件名和旧文件备份名 */
-    /* Create names for temporary and old file */
-    size_t fn_len = strlen(entry->filename) + 5;
-    char* filename_tmp = malloc(fn_len);
-    char* filename_old = malloc(fn_len);
-    /* 内存分配失败处理 */
-    if (filename_tmp == NULL || filename_old == NULL) {
-        if (filename_tmp != NULL) {
-            free(filename_tmp);
+    for (int i = 0; i < iovcnt; i++) {
+        size += iov[i].iov_len;
+    }
+    int fd = openat(dirfd, name_tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd < 0) {
+        ret = ODR_HW;
+    } else {
+        if (pwritev(fd, iov, iovcnt, 0) != (ssize_t)size || fdatasync(fd) != 0) {
+            ret = ODR_HW;
         }
-        if (filename_old != NULL) {
-            free(filename_old);
+        if (close(fd) != 0) {
+            ret = ODR_HW;
         }
-        ret = ODR_OUT_OF_MEM;
-    } else {
-        strcpy(filename_tmp, entry->filename);
-        strcpy(filename_old, entry->filename);
-        strcat(filename_tmp, ".tmp");
-        strcat(filename_old, ".old");
     }
 
-    /* 打开临时文件并写入数据 */
-    /* Open a temporary file and write data to it */
     if (ret == ODR_OK) {
-        FILE* fp = fopen(filename_tmp, "w");
-        if (fp == NULL) {
+        unlinkat(dirfd, name_old, 0);
+        linkat(dirfd, base, dirfd, name_old, 0);
+        if (renameat(dirfd, name_tmp, dirfd, base) != 0 || fsync(dirfd) != 0) {
             ret = ODR_HW;
-        } else {
-            /* 写入数据和CRC: 注意以下两行存在竞态条件，但由于该函数仅被SDO服务器调用，已通过CO_LOCK_OD保护 */
-            /* following two lines are subject to race conditions. This function is called only by SDO server
-             * and so it is already protected by CO_LOCK_OD. */
-            size_t cnt = fwrite(entry->addr, 1, entry->len, fp);
-            crc_store = crc16_ccitt(entry->addr, entry->len, 0);
-            cnt += fwrite(&crc_store, 1, sizeof(crc_store), fp);
-            fclose(fp);
-            if (cnt != (entry->len + sizeof(crc_store))) {
-                ret = ODR_HW;
+        }
+    } else {
+        unlinkat(dirfd, name_tmp, 0);
+    }
+    close(dirfd);
+    return ret;
+}
+
+/* 原子地替换条目的文件，写入数据和计算的 CRC */
+/* Atomically replace file of the entry with data and calculated CRC */
+static ODR_t
+replaceFile(CO_storage_entry_t* entry, const void* data, uint16_t* crc) {
+    *crc = crc16_ccitt(data, entry->len, 0);
+    struct iovec iov[2] = {{.iov_base = (void*)data, .iov_len = entry->len},
+                           {.iov_base = crc, .iov_len = sizeof(*crc)}};
+    return writeFileAtomic(entry->filename, iov, 2);
+}
+
+/* 日志记录头，后面是 length 字节的数据。一次存储的最后一个记录是 JOURNAL_COMMIT，重放时只应用完整的存储 */
+/* Journal record header, followed by length bytes of data. The last record of one store is JOURNAL_COMMIT, only
+ * complete stores are applied on replay. */
+typedef struct {
+    uint16_t magic;  /* JOURNAL_RECORD or JOURNAL_COMMIT */
+    uint16_t crc;    /* CRC of offset, length and data */
+    uint32_t offset; /* Offset of data inside entry */
+    uint32_t length; /* Length of data */
+} journalRecord_t;
+
+#define JOURNAL_RECORD 0x524A
+#define JOURNAL_COMMIT 0x434A
+/* 一次存储的最大记录数，更多的改变范围合并到最后一个记录 */
+/* Maximum records of one store, more changed ranges are merged into the last record */
+#define JOURNAL_RECORDS_MAX 16
+/* 日志大小未知，日志内容必须先被压缩清空 */
+/* Journal size is unknown, journal must be emptied by compaction first */
+#define JOURNAL_SIZE_INVALID SIZE_MAX
+
+/* 日志记录的 CRC */
+/* CRC of journal record */
+static uint16_t
+journalCrc(const journalRecord_t* rec, const uint8_t* data) {
+    uint16_t crc = crc16_ccitt((const uint8_t*)&rec->offset, sizeof(rec->offset) + sizeof(rec->length), 0);
+    return crc16_ccitt(data, rec->length, crc);
+}
+
+/* 打开日志文件 <filename>.jrn，返回文件描述符，出错返回 -1 */
+/* Open journal file <filename>.jrn, return file descriptor or -1 */
+static int
+journalOpen(CO_storage_entry_t* entry) {
+    char name[CO_STORAGE_PATH_MAX + 4];
+
+    snprintf(name, sizeof(name), "%s.jrn", entry->filename);
+    return open(name, O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+}
+
+/* 关闭日志文件，释放存储数据的副本 */
+/* Close journal file, free copy of the stored data */
+static void
+journalClose(CO_storage_entry_t* entry) {
+    if (entry->journalFd >= 0) {
+        close(entry->journalFd);
+        entry->journalFd = -1;
+    }
+    free(entry->stored);
+    entry->stored = NULL;
+}
+
+/* 在 data 上重放日志。第一遍查找最后一个完整存储的结尾，第二遍应用记录，之后的内容被截断 */
+/* Replay journal over data. First pass finds the end of the last complete store, second pass applies records, rest
+ * is truncated. */
+static bool_t
+journalReplay(CO_storage_entry_t* entry, uint8_t* data) {
+    journalRecord_t rec;
+    struct stat st;
+
+    if (fstat(entry->journalFd, &st) != 0) {
+        return false;
+    }
+    size_t size = (size_t)st.st_size;
+    uint8_t* buf = malloc(size + 1);
+    if (buf == NULL || pread(entry->journalFd, buf, size, 0) != (ssize_t)size) {
+        free(buf);
+        return false;
+    }
+
+    size_t pos = 0;
+    size_t committed = 0;
+    while (size - pos >= sizeof(rec)) {
+        memcpy(&rec, &buf[pos], sizeof(rec));
+        if ((rec.magic != JOURNAL_RECORD && rec.magic != JOURNAL_COMMIT) || rec.offset > entry->len
+            || rec.length > entry->len - rec.offset || rec.length > size - pos - sizeof(rec)
+            || journalCrc(&rec, &buf[pos + sizeof(rec)]) != rec.crc) {
+            break;
+        }
+        pos += sizeof(rec) + rec.length;
+        if (rec.magic == JOURNAL_COMMIT) {
+            committed = pos;
+        }
+    }
+    for (pos = 0; pos < committed; pos += sizeof(rec) + rec.length) {
+        memcpy(&rec, &buf[pos], sizeof(rec));
+        memcpy(&data[rec.offset], &buf[pos + sizeof(rec)], rec.length);
+    }
+    free(buf);
+
+    entry->journalSize = committed;
+    return committed == size || ftruncate(entry->journalFd, (off_t)committed) == 0;
+}
+
+/* 把存储数据的副本原子地写入数据文件，然后清空日志。返回 true 表示成功 */
+/* Atomically write copy of the stored data into the data file, then empty the journal. Return true on success */
+static bool_t
+journalCompact(CO_storage_entry_t* entry, size_t* bytes) {
+    uint16_t crc;
+
+    if (replaceFile(entry, entry->stored, &crc) != ODR_OK || ftruncate(entry->journalFd, 0) != 0
+        || fdatasync(entry->journalFd) != 0) {
+        return false;
+    }
+    entry->journalSize = 0;
+    *bytes += entry->len + sizeof(crc);
+    return true;
+}
+
+/* 把与存储数据不同的字节范围追加到日志并同步。相距小于记录头的范围合并。返回 true 表示成功 */
+/* Append byte ranges, which differ from the stored data, to the journal and sync it. Ranges closer than record header
+ * are merged. Return true on success. */
+static bool_t
+journalAppend(CO_storage_entry_t* entry, const uint8_t* data, size_t* bytes) {
+    size_t start[JOURNAL_RECORDS_MAX];
+    size_t end[JOURNAL_RECORDS_MAX];
+    uint8_t count = 0;
+    size_t size = 0;
+
+    /* 写入失败后日志未能截断：先压缩 */
+    /* journal was not truncated after failed write: compact first */
+    *bytes = 0;
+    if (entry->journalSize == JOURNAL_SIZE_INVALID && !journalCompact(entry, bytes)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < entry->len;) {
+        if (data[i] == entry->stored[i]) {
+            i++;
+            continue;
+        }
+        size_t rangeEnd = i + 1;
+        for (size_t j = rangeEnd; j < entry->len && (j - rangeEnd) < sizeof(journalRecord_t); j++) {
+            if (data[j] != entry->stored[j]) {
+                rangeEnd = j + 1;
             }
         }
+        if (count < JOURNAL_RECORDS_MAX) {
+            start[count] = i;
+            count++;
+        }
+        end[count - 1] = rangeEnd;
+        i = rangeEnd;
+    }
+    if (count == 0) {
+        return true;
     }
 
-    /* 验证写入的数据 */
-    /* Verify data */
-    if (ret == ODR_OK) {
-        uint8_t* buf = NULL;
-        FILE* fp = NULL;
-        size_t cnt = 0;
-        uint16_t crc_verify, crc_read;
-
-        buf = malloc(entry->len + 4);
-        if (buf != NULL) {
-            fp = fopen(filename_tmp, "r");
-            if (fp != NULL) {
-                cnt = fread(buf, 1, entry->len + 4, fp);
-                crc_verify = crc16_ccitt(buf, entry->len, 0);
-                fclose(fp);
-                memcpy(&crc_read, &buf[entry->len], sizeof(crc_read));
+    for (uint8_t r = 0; r < count; r++) {
+        size += sizeof(journalRecord_t) + end[r] - start[r];
+    }
+    uint8_t* buf = malloc(size);
+    if (buf == NULL) {
+        return false;
+    }
+    size_t pos = 0;
+    for (uint8_t r = 0; r < count; r++) {
+        journalRecord_t rec;
+        rec.magic = (r == count - 1) ? JOURNAL_COMMIT : JOURNAL_RECORD;
+        rec.offset = (uint32_t)start[r];
+        rec.length = (uint32_t)(end[r] - start[r]);
+        rec.crc = journalCrc(&rec, &data[start[r]]);
+        memcpy(&buf[pos], &rec, sizeof(rec));
+        memcpy(&buf[pos + sizeof(rec)], &data[start[r]], rec.length);
+        pos += sizeof(rec) + rec.length;
+    }
+
+    bool_t ok = pwrite(entry->journalFd, buf, size, (off_t)entry->journalSize) == (ssize_t)size
+                && fdatasync(entry->journalFd) == 0;
+    free(buf);
+    if (!ok) {
+        /* 不完整的存储不能留在日志中，否则后面的存储会让它生效 */
+        /* incomplete store must not stay in the journal, later store would make it valid */
+        if (ftruncate(entry->journalFd, (off_t)entry->journalSize) != 0) {
+            entry->journalSize = JOURNAL_SIZE_INVALID;
+        }
+        return false;
+    }
+    for (uint8_t r = 0; r < count; r++) {
+        memcpy(&entry->stored[start[r]], &data[start[r]], end[r] - start[r]);
+    }
+    entry->journalSize += size;
+    *bytes = size;
+    return true;
+}
+
+/* 容器文件头，后面是条目表(每个条目为 containerItem_t 和名称)，然后是数据 */
+/* Container file header, followed by the entry table (containerItem_t and name for each entry), then by data */
+typedef struct {
+    uint32_t magic;      /* CONTAINER_MAGIC */
+    uint16_t version;    /* CONTAINER_VERSION */
+    uint16_t count;      /* Number of entries in the table */
+    uint32_t generation; /* Incremented on each commit */
+    uint32_t tableSize;  /* Size of the entry table in bytes */
+    uint16_t tableCrc;   /* CRC of the header fields above and of the entry table */
+    uint16_t reserved;
+} containerHeader_t;
+
+/* 容器条目表中的条目，后面是 nameLen 字节的名称(条目文件名，不含路径) */
+/* Entry in the container entry table, followed by nameLen bytes of name (entry filename without path) */
+typedef struct {
+    uint32_t offset;  /* Offset of data from the start of the file */
+    uint32_t length;  /* Length of data, 0 for default values after "Restore default parameters" */
+    uint16_t crc;     /* CRC of data */
+    uint16_t nameLen; /* Length of the name */
+} containerItem_t;
+
+#define CONTAINER_MAGIC   0x54534F43 /* "COST" */
+#define CONTAINER_VERSION 1
+
+/* 条目在容器中的名称: 文件名，不含路径 */
+/* Name of the entry in the container: filename without path */
+static const char*
+containerName(const CO_storage_entry_t* entry) {
+    const char* slash = strrchr(entry->filename, '/');
+    return slash != NULL ? slash + 1 : entry->filename;
+}
+
+/* 容器头和条目表的 CRC */
+/* CRC of container header and entry table */
+static uint16_t
+containerCrc(const containerHeader_t* header, const uint8_t* table) {
+    uint16_t crc = crc16_ccitt((const uint8_t*)header, offsetof(containerHeader_t, tableCrc), 0);
+    return crc16_ccitt(table, header->tableSize, crc);
+}
+
+/* 映射容器文件并验证文件头和条目表。返回映射地址，文件不存在或无效时返回 NULL */
+/* Map container file and verify header and entry table. Return mapped address or NULL, if file is missing or invalid */
+static const uint8_t*
+containerMap(CO_storageLinux_t* storageLinux, size_t* size) {
+    containerHeader_t header;
+    struct stat st;
+    void* map = MAP_FAILED;
+
+    int fd = open(storageLinux->containerFilename, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(header)) {
+        *size = (size_t)st.st_size;
+        map = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+
+    memcpy(&header, map, sizeof(header));
+    if (header.magic != CONTAINER_MAGIC || header.version != CONTAINER_VERSION
+        || header.tableSize > *size - sizeof(header)
+        || containerCrc(&header, (const uint8_t*)map + sizeof(header)) != header.tableCrc) {
+        munmap(map, *size);
+        return NULL;
+    }
+    storageLinux->containerGeneration = header.generation;
+    return map;
+}
+
+/* 在映射的容器中查找条目，验证并复制数据到条目地址，设置条目的 CRC。返回 true 表示成功，也包括存储的默认值 */
+/* Find entry in the mapped container, verify and copy data to entry address, set CRC of the entry. Return true on
+ * success, also if default values were stored */
+static bool_t
+containerLoad(const uint8_t* map, size_t size, CO_storage_entry_t* entry) {
+    containerHeader_t header;
+    containerItem_t item;
+    const char* name = containerName(entry);
+    size_t nameLen = strlen(name);
+
+    memcpy(&header, map, sizeof(header));
+    size_t pos = sizeof(header);
+    size_t end = sizeof(header) + header.tableSize;
+    for (uint16_t i = 0; i < header.count && end - pos >= sizeof(item); i++) {
+        memcpy(&item, &map[pos], sizeof(item));
+        pos += sizeof(item);
+        if (item.nameLen > end - pos) {
+            return false;
+        }
+        if (item.nameLen == nameLen && memcmp(&map[pos], name, nameLen) == 0) {
+            if (item.length == 0) {
+                entry->crc = crc16_ccitt(entry->addr, entry->len, 0);
+                return true;
+            }
+            if (item.length != entry->len || item.offset > size || item.length > size - item.offset
+                || crc16_ccitt(&map[item.offset], item.length, 0) != item.crc) {
+                return false;
             }
-            free(buf);
+            memcpy(entry->addr, &map[item.offset], item.length);
+            entry->crc = item.crc;
+            return true;
         }
-        /* 如果大小或CRC不匹配，报告错误 */
-        /* If size or CRC differs, report error */
-        if (buf == NULL || fp == NULL || cnt != (entry->len + sizeof(crc_verify)) || crc_store != crc_verify
-            || crc_store != crc_read) {
-            ret = ODR_HW;
+        pos += item.nameLen;
+    }
+    return false;
+}
+
+/* 把所有条目的存储数据作为新的容器文件原子地提交，数据用一次 pwritev() 直接从存储数据的副本写入。调用者必须锁定
+ * 写线程或者是写线程。返回 true 表示成功 */
+/* Atomically commit stored data of all entries as new container file, data are written directly from copies of the
+ * stored data with one pwritev(). Caller must hold the writer lock or be the writer. Return true on success */
+static bool_t
+containerCommit(CO_storageLinux_t* storageLinux, size_t* bytes) {
+    containerHeader_t header = {.magic = CONTAINER_MAGIC, .version = CONTAINER_VERSION};
+    CO_storage_t* storage = storageLinux->storage;
+    size_t tableSize = 0;
+
+    for (uint8_t i = 0; i < storage->entriesCount; i++) {
+        tableSize += sizeof(containerItem_t) + strlen(containerName(&storage->entries[i]));
+    }
+    size_t headSize = sizeof(header) + tableSize;
+    uint8_t* head = malloc(headSize);
+    struct iovec* iov = malloc((storage->entriesCount + 1U) * sizeof(struct iovec));
+    if (head == NULL || iov == NULL) {
+        free(head);
+        free(iov);
+        return false;
+    }
+
+    size_t pos = sizeof(header);
+    size_t offset = headSize;
+    int iovcnt = 1;
+    for (uint8_t i = 0; i < storage->entriesCount; i++) {
+        CO_storage_entry_t* entry = &storage->entries[i];
+        containerItem_t item = {0};
+        const char* name = containerName(entry);
+
+        item.nameLen = (uint16_t)strlen(name);
+        if (!entry->defaults) {
+            item.offset = (uint32_t)offset;
+            item.length = (uint32_t)entry->len;
+            item.crc = crc16_ccitt(entry->stored, entry->len, 0);
+            iov[iovcnt].iov_base = entry->stored;
+            iov[iovcnt].iov_len = entry->len;
+            iovcnt++;
+            offset += entry->len;
         }
+        memcpy(&head[pos], &item, sizeof(item));
+        memcpy(&head[pos + sizeof(item)], name, item.nameLen);
+        pos += sizeof(item) + item.nameLen;
     }
+    header.count = storage->entriesCount;
+    header.generation = storageLinux->containerGeneration + 1;
+    header.tableSize = (uint32_t)tableSize;
+    header.tableCrc = containerCrc(&header, &head[sizeof(header)]);
+    memcpy(head, &header, sizeof(header));
+    iov[0].iov_base = head;
+    iov[0].iov_len = headSize;
 
-    /* 将现有文件重命名为*.old，临时文件重命名为正式文件名 */
-    /* rename existing file to *.old and *.tmp to existing */
-    if (ret == ODR_OK) {
-        rename(entry->filename, filename_old);
-        if (rename(filename_tmp, entry->filename) != 0) {
-            ret = ODR_HW;
+    bool_t ok = writeFileAtomic(storageLinux->containerFilename, iov, iovcnt) == ODR_OK;
+    if (ok) {
+        storageLinux->containerGeneration++;
+        *bytes += offset;
+    }
+    free(head);
+    free(iov);
+    return ok;
+}
+
+/* 将快照写入存储：容器模式下提交容器；日志模式下追加改变的字节范围，日志过大时压缩；否则用临时文件和重命名原子地
+ * 替换文件，与"存储参数"命令相同。然后同步到存储介质，返回 true 表示成功 */
+/* Write snapshot to the storage: in container mode commit the container; in journal mode append changed byte ranges
+ * and compact, if journal is too large; otherwise replace the file atomically with temporary file and rename, the same
+ * as "Store parameters" command. Data are synced to the storage, return true on success */
+static bool_t
+writeSnapshot(CO_storage_entry_t* entry, uint32_t* write_us, size_t* bytes, bool_t* compacted) {
+    uint64_t start = storageTime_us();
+    bool_t ok;
+
+    *compacted = false;
+    if (entry->owner->container) {
+        memcpy(entry->stored, entry->snapshot, entry->len);
+        *bytes = 0;
+        ok = containerCommit(entry->owner, bytes);
+    } else if (entry->journalFd >= 0) {
+        ok = journalAppend(entry, entry->snapshot, bytes);
+        /* 压缩失败不是错误，数据已在日志中 */
+        /* failed compaction is not an error, data are in the journal */
+        if (ok && entry->journalSize > CO_STORAGE_JOURNAL_MAX) {
+            *compacted = journalCompact(entry, bytes);
         }
+    } else {
+        /* 快照缓冲区包含数据和 CRC */
+        /* snapshot buffer contains data and CRC */
+        struct iovec iov = {.iov_base = entry->snapshot, .iov_len = entry->len + sizeof(uint16_t)};
+        *bytes = iov.iov_len;
+        ok = writeFileAtomic(entry->filename, &iov, 1) == ODR_OK;
     }
 
-    if (ret != ODR_OUT_OF_MEM) {
-        free(filename_tmp);
-        free(filename_old);
+    *write_us = (uint32_t)(storageTime_us() - start);
+    return ok;
+}
+
+/* 写完成：更新 CRC、错误标志和统计。多线程时在 writerMutex 内调用 */
+/* Write is finished: update CRC, error flag and statistics. Called inside writerMutex, if multi threaded */
+static void
+writeDone(CO_storage_entry_t* entry, bool_t ok, uint32_t write_us, size_t bytes, bool_t compacted) {
+    CO_storageLinux_stats_t* stats = &entry->owner->stats;
+    uint32_t latency_us = (uint32_t)(storageTime_us() - entry->snapshotTime_us);
+
+    if (ok) {
+        memcpy(&entry->crc, &entry->snapshot[entry->len], sizeof(entry->crc));
+        entry->autoSaveError = false;
+        stats->writes++;
+        stats->writeBytes += bytes;
+    } else {
+        /* 保存失败，稍后重试 */
+        /* error with save, retry later */
+        entry->autoSaveError = true;
+        stats->writeErrors++;
+        markEntry(entry);
+    }
+    if (compacted) {
+        stats->compactions++;
+    }
+    stats->writeTotal_us += write_us;
+    if (write_us > stats->writeMax_us) {
+        stats->writeMax_us = write_us;
+    }
+    stats->latencyTotal_us += latency_us;
+    if (latency_us > stats->latencyMax_us) {
+        stats->latencyMax_us = latency_us;
+    }
+}
+
+#ifndef CO_SINGLE_THREAD
+/* 写线程：依次写入排队的快照，停止时先完成所有排队的快照 */
+/* Writer thread: write queued snapshots, on stop finish all queued snapshots first */
+static void*
+writerThread(void* arg) {
+    CO_storageLinux_t* storageLinux = arg;
+    CO_storage_t* storage = storageLinux->storage;
+
+    pthread_mutex_lock(&storageLinux->writerMutex);
+    for (;;) {
+        CO_storage_entry_t* entry = NULL;
+
+        for (uint8_t i = 0; i < storage->entriesCount; i++) {
+            if (storage->entries[i].writeState == WRITE_QUEUED) {
+                entry = &storage->entries[i];
+                break;
+            }
+        }
+        if (entry == NULL) {
+            if (storageLinux->writerStop) {
+                break;
+            }
+            pthread_cond_wait(&storageLinux->writerCond, &storageLinux->writerMutex);
+            continue;
+        }
+
+        /* 文件I/O在锁外执行 */
+        /* file I/O is outside the lock */
+        uint32_t write_us = 0;
+        size_t bytes = 0;
+        bool_t ok = false;
+        bool_t compacted = false;
+        entry->writeState = WRITE_BUSY;
+        pthread_mutex_unlock(&storageLinux->writerMutex);
+        ok = writeSnapshot(entry, &write_us, &bytes, &compacted);
+        pthread_mutex_lock(&storageLinux->writerMutex);
+        writeDone(entry, ok, write_us, bytes, compacted);
+        CO_MemoryBarrier();
+        entry->writeState = WRITE_IDLE;
+        pthread_cond_broadcast(&storageLinux->writerCond);
+    }
+    pthread_mutex_unlock(&storageLinux->writerMutex);
+    return NULL;
+}
+
+/* 停止写线程，等待所有排队的快照写完 */
+/* Stop writer thread, wait until all queued snapshots are written */
+static void
+writerStopAndJoin(CO_storageLinux_t* storageLinux) {
+    if (!storageLinux->writerRunning) {
+        return;
+    }
+    pthread_mutex_lock(&storageLinux->writerMutex);
+    storageLinux->writerStop = true;
+    pthread_cond_broadcast(&storageLinux->writerCond);
+    pthread_mutex_unlock(&storageLinux->writerMutex);
+    pthread_join(storageLinux->writerThreadId, NULL);
+    storageLinux->writerRunning = false;
+}
+#endif /* CO_SINGLE_THREAD */
+
+/* 锁定写线程：获取 writerMutex 并等待条目的快照写完。容器模式下所有条目共用一个文件，等待所有条目 */
+/* Lock the writer: take writerMutex and wait until snapshot of the entry is written. In container mode all entries
+ * share one file, so wait for all entries. */
+static void
+writerLock(CO_storageLinux_t* storageLinux, CO_storage_entry_t* entry) {
+#ifndef CO_SINGLE_THREAD
+    CO_storage_t* storage = storageLinux->storage;
+
+    pthread_mutex_lock(&storageLinux->writerMutex);
+    for (;;) {
+        bool_t busy = entry != NULL && entry->writeState != WRITE_IDLE;
+        for (uint8_t i = 0; storageLinux->container && i < storage->entriesCount; i++) {
+            if (storage->entries[i].writeState != WRITE_IDLE) {
+                busy = true;
+            }
+        }
+        if (!busy) {
+            break;
+        }
+        pthread_cond_wait(&storageLinux->writerCond, &storageLinux->writerMutex);
     }
+#else
+    (void)storageLinux;
+    (void)entry;
+#endif
+}
 
+/* 解锁写线程 */
+/* Unlock the writer */
+static void
+writerUnlock(CO_storageLinux_t* storageLinux) {
+#ifndef CO_SINGLE_THREAD
+    pthread_mutex_unlock(&storageLinux->writerMutex);
+#else
+    (void)storageLinux;
+#endif
+}
+
+/* 函数功能: 在"存储参数"命令时写入数据到文件 - OD对象1010
+ * 执行步骤:
+ *   步骤1: 等待写线程完成该条目的快照
+ *   步骤2: 日志模式: 把改变的字节范围追加到日志，日志过大时压缩
+ *   步骤3: 否则原子地替换文件: 用一次pwritev()写入数据和CRC，fdatasync()，renameat()，fsync()目录
+ *   步骤4: 成功后自动存储继续（"恢复默认参数"之后暂停）
+ * 参数说明:
+ *   - entry: 存储条目指针，包含文件名、地址和长度信息
+ *   - CANmodule: CAN模块指针(本函数未使用)
+ * 返回值说明: 返回ODR_t类型错误码(ODR_OK成功，ODR_HW硬件错误)
+ */
+/*
+ * Function for writing data on "Store parameters" command - OD object 1010
+ *
+ * In journal mode changed byte ranges are appended to the journal. Otherwise data are written from memory together
+ * with CRC in a single pass, synced, then atomically renamed over the existing file.
+ *
+ * For more information see file CO_storage.h, CO_storage_entry_t.
+ */
+static ODR_t
+storeLinux(CO_storage_entry_t* entry, CO_CANmodule_t* CANmodule) {
+    (void)CANmodule;
+    ODR_t ret = ODR_OK;
+    uint16_t crc_store;
+
+    /* 写线程不能同时访问该条目的文件。注意存在竞态条件，但由于该函数仅被SDO服务器调用，已通过CO_LOCK_OD保护 */
+    /* Writer thread must not access files of this entry at the same time. Data are subject to race conditions. This
+     * function is called only by SDO server and so it is already protected by CO_LOCK_OD. */
+    writerLock(entry->owner, entry);
+
+    if (entry->journalFd >= 0) {
+        /* 日志模式，压缩失败不是错误，数据已在日志中 */
+        /* journal mode, failed compaction is not an error, data are in the journal */
+        size_t bytes;
+        if (!journalAppend(entry, entry->addr, &bytes)) {
+            ret = ODR_HW;
+        } else if (entry->journalSize > CO_STORAGE_JOURNAL_MAX && journalCompact(entry, &bytes)) {
+            entry->owner->stats.compactions++;
+        }
+        crc_store = crc16_ccitt(entry->addr, entry->len, 0);
+    } else {
+        ret = replaceFile(entry, entry->addr, &crc_store);
+    }
+    if (ret == ODR_OK) {
+        entry->crc = crc_store;
+        entry->defaults = false;
+    }
+
+    writerUnlock(entry->owner);
     return ret;
 }
 
 /* 函数功能: 恢复默认参数 - OD对象1011
  * 执行步骤:
- *   步骤1: 如果是自动存储模式，先关闭已打开的文件
+ *   步骤1: 自动存储暂停到下一次存储命令；日志模式下关闭并删除日志
  *   步骤2: 创建.old后缀的备份文件名
  *   步骤3: 将现有文件重命名为备份文件
  *   步骤4: 创建新的空文件并写入"-\n"标记(表示使用默认值)
@@ -155,12 +781,18 @@ restoreLinux(CO_storage_entry_t* entry, CO_CANmodule_t* CANmodule) {
     (void)CANmodule;
     ODR_t ret = ODR_OK;
 
-    /* 如果是自动存储模式，先关闭文件 */
-    /* close the file first, if auto storage */
-    if ((entry->attr & CO_storage_auto) != 0 && entry->fp != NULL) {
-        fclose(entry->fp);
-        entry->fp = NULL;
+    /* 自动存储暂停到下一次"存储参数"命令。日志模式下关闭并删除日志，之后的存储替换整个文件 */
+    /* auto storage is suspended until the next "Store parameters" command. In journal mode close and delete the
+     * journal, later stores replace the whole file */
+    writerLock(entry->owner, entry);
+    entry->defaults = true;
+    if (entry->journalFd >= 0) {
+        char name[CO_STORAGE_PATH_MAX + 4];
+        journalClose(entry);
+        snprintf(name, sizeof(name), "%s.jrn", entry->filename);
+        unlink(name);
     }
+    writerUnlock(entry->owner);
 
     /* 将现有文件重命名为*.old */
     /* Rename existing filename to *.old. */
@@ -189,54 +821,118 @@ restoreLinux(CO_storage_entry_t* entry, CO_CANmodule_t* CANmodule) {
     return ret;
 }
 
-/* 函数功能: 初始化Linux平台的CANopen存储系统(重要函数)
+/* 函数功能: 容器模式下的"存储参数"命令 - OD对象1010
  * 执行步骤:
- *   步骤1: 验证所有输入参数的有效性
- *   步骤2: 初始化存储对象和OD扩展，注册存储和恢复回调函数
- *   步骤3: 遍历所有存储条目进行初始化
- *   步骤4: 对每个条目: 打开文件，读取数据，验证CRC校验和
- *   步骤5: 如果数据有效，复制到目标地址; 如果无效，使用默认值
- *   步骤6: 对于自动存储条目，保持文件打开以供后续自动保存
- *   步骤7: 记录所有初始化错误到storageInitError位图
+ *   步骤1: 等待写线程空闲，把条目的数据复制到存储数据的副本
+ *   步骤2: 如果正在写1010，只记录有待提交的数据，写完后一次提交；否则立即提交容器
  * 参数说明:
- *   - storage: 存储对象指针
- *   - CANmodule: CAN模块指针
- *   - OD_1010_StoreParameters: 存储参数OD条目(1010h)
- *   - OD_1011_RestoreDefaultParam: 恢复默认参数OD条目(1011h)
- *   - entries: 存储条目数组指针
- *   - entriesCount: 存储条目数量
- *   - storageInitError: 初始化错误位图指针
- * 返回值说明: 返回CO_ReturnError_t错误码
+ *   - entry: 存储条目指针
+ *   - CANmodule: CAN模块指针(本函数未使用)
+ * 返回值说明: 返回ODR_t类型错误码(ODR_OK成功，ODR_HW硬件错误)
  */
-CO_ReturnError_t
-CO_storageLinux_init(CO_storage_t* storage, CO_CANmodule_t* CANmodule, OD_entry_t* OD_1010_StoreParameters,
-                     OD_entry_t* OD_1011_RestoreDefaultParam, CO_storage_entry_t* entries, uint8_t entriesCount,
-                     uint32_t* storageInitError) {
-    CO_ReturnError_t ret;
+static ODR_t
+storeContainer(CO_storage_entry_t* entry, CO_CANmodule_t* CANmodule) {
+    (void)CANmodule;
+    ODR_t ret = ODR_OK;
 
-    /* 验证参数有效性 */
-    /* verify arguments */
-    if (storage == NULL || entries == NULL || entriesCount == 0 || storageInitError == NULL) {
-        return CO_ERROR_ILLEGAL_ARGUMENT;
+    writerLock(entry->owner, entry);
+    memcpy(entry->stored, entry->addr, entry->len);
+    entry->crc = crc16_ccitt(entry->stored, entry->len, 0);
+    entry->defaults = false;
+    if (entry->owner->containerBatch) {
+        entry->owner->containerStaged = true;
+    } else {
+        size_t bytes = 0;
+        if (!containerCommit(entry->owner, &bytes)) {
+            ret = ODR_HW;
+        }
+    }
+    writerUnlock(entry->owner);
+    return ret;
+}
+
+/* 函数功能: 容器模式下的"恢复默认参数"命令 - OD对象1011
+ * 执行步骤:
+ *   步骤1: 等待写线程空闲，标记条目存储默认值，容器中不再包含它的数据。自动存储暂停到下一次存储命令
+ *   步骤2: 如果正在写1011，写完后一次提交；否则立即提交容器
+ * 参数说明:
+ *   - entry: 存储条目指针
+ *   - CANmodule: CAN模块指针(本函数未使用)
+ * 返回值说明: 返回ODR_t类型错误码(ODR_OK成功，ODR_HW硬件错误)
+ */
+static ODR_t
+restoreContainer(CO_storage_entry_t* entry, CO_CANmodule_t* CANmodule) {
+    (void)CANmodule;
+    ODR_t ret = ODR_OK;
+
+    /* 自动存储暂停到下一次"存储参数"命令，storeContainer() 再次启用它 */
+    /* auto storage is suspended until the next "Store parameters" command, storeContainer() enables it again */
+    writerLock(entry->owner, entry);
+    entry->defaults = true;
+    if (entry->owner->containerBatch) {
+        entry->owner->containerStaged = true;
+    } else {
+        size_t bytes = 0;
+        if (!containerCommit(entry->owner, &bytes)) {
+            ret = ODR_HW;
+        }
     }
+    writerUnlock(entry->owner);
+    return ret;
+}
 
-    storage->enabled = false;
+/* 容器模式下 1010 和 1011 的写：CO_storage 对每个选择的条目调用存储或恢复，它们只更新内存中的数据，然后所有改变
+ * 在一次原子提交中写入 */
+/* Write to 1010 and 1011 in container mode: CO_storage calls store or restore for each selected entry, they only
+ * update data in memory, then all changes are written in one atomic commit */
+static ODR_t
+containerWrite(OD_stream_t* stream, const void* buf, OD_size_t count, OD_size_t* countWritten,
+               ODR_t (*write)(OD_stream_t* stream, const void* buf, OD_size_t count, OD_size_t* countWritten)) {
+    /* 扩展对象是协议栈的存储对象 */
+    /* extension object is the storage object of the stack */
+    CO_storageLinux_t* storageLinux = storageLinuxOf(stream->object);
 
-    /* 初始化存储对象和OD扩展 */
-    /* initialize storage and OD extensions */
-    ret = CO_storage_init(storage, CANmodule, OD_1010_StoreParameters, OD_1011_RestoreDefaultParam, storeLinux,
-                          restoreLinux, entries, entriesCount);
-    if (ret != CO_ERROR_NO) {
-        return ret;
+    storageLinux->containerBatch = true;
+    storageLinux->containerStaged = false;
+    ODR_t ret = write(stream, buf, count, countWritten);
+    storageLinux->containerBatch = false;
+
+    if (storageLinux->containerStaged) {
+        size_t bytes = 0;
+        writerLock(storageLinux, NULL);
+        if (!containerCommit(storageLinux, &bytes) && ret == ODR_OK) {
+            ret = ODR_HW;
+        }
+        writerUnlock(storageLinux);
     }
+    return ret;
+}
+
+static ODR_t
+containerWrite1010(OD_stream_t* stream, const void* buf, OD_size_t count, OD_size_t* countWritten) {
+    return containerWrite(stream, buf, count, countWritten,
+                          storageLinuxOf(stream->object)->containerWrite1010Orig);
+}
+
+static ODR_t
+containerWrite1011(OD_stream_t* stream, const void* buf, OD_size_t count, OD_size_t* countWritten) {
+    return containerWrite(stream, buf, count, countWritten,
+                          storageLinuxOf(stream->object)->containerWrite1011Orig);
+}
+
+/* 初始化所有存储条目：从各自的文件或映射的容器读取数据，验证并复制到条目地址。返回 CO_ERROR_NO、
+ * CO_ERROR_DATA_CORRUPT 或其他错误，见 CO_storageLinux_init() */
+/* Initialize all storage entries: read data from own files or from mapped container, verify them and copy them to
+ * entry addresses. Return CO_ERROR_NO, CO_ERROR_DATA_CORRUPT or other error, see CO_storageLinux_init() */
+static CO_ReturnError_t
+initEntries(CO_storageLinux_t* storageLinux, CO_storage_entry_t* entries, uint8_t entriesCount, const uint8_t* map,
+            size_t mapSize, uint32_t* storageInitError, bool_t* hasAuto) {
+    CO_ReturnError_t ret = CO_ERROR_NO;
 
-    /* 初始化所有存储条目 */
-    /* initialize entries */
     *storageInitError = 0;
     for (uint8_t i = 0; i < entriesCount; i++) {
         CO_storage_entry_t* entry = &entries[i];
         bool_t dataCorrupt = false;
-        char* writeFileAccess = "w";
 
         /* 验证条目参数 */
         /* verify arguments */
@@ -245,47 +941,109 @@ CO_storageLinux_init(CO_storage_t* storage, CO_CANmodule_t* CANmodule, OD_entry_
             return CO_ERROR_ILLEGAL_ARGUMENT;
         }
 
-        /* 打开文件，检查是否存在并创建临时缓冲区 */
-        /* Open file, check existence and create temporary buffer */
-        uint8_t* buf = NULL;
-        FILE* fp = fopen(entry->filename, "r");
-        if (fp == NULL) {
-            dataCorrupt = true;
-            ret = CO_ERROR_DATA_CORRUPT;
+        if (storageLinux->container) {
+            /* 容器模式：从映射的容器文件中复制数据 */
+            /* container mode: copy data from mapped container file */
+            if (map == NULL || !containerLoad(map, mapSize, entry)) {
+                dataCorrupt = true;
+                ret = CO_ERROR_DATA_CORRUPT;
+            }
         } else {
-            buf = malloc(entry->len + sizeof(uint16_t));
-            if (buf == NULL) {
+            /* 打开文件，检查是否存在并创建临时缓冲区 */
+            /* Open file, check existence and create temporary buffer */
+            uint8_t* buf = NULL;
+            FILE* fp = fopen(entry->filename, "r");
+            if (fp == NULL) {
+                dataCorrupt = true;
+                ret = CO_ERROR_DATA_CORRUPT;
+            } else {
+                buf = malloc(entry->len + sizeof(uint16_t));
+                if (buf == NULL) {
+                    fclose(fp);
+                    *storageInitError = i;
+                    return CO_ERROR_OUT_OF_MEMORY;
+                }
+            }
+
+            /* 先读取数据到临时缓冲区，然后验证并复制到目标地址 */
+            /* Read data into temporary buffer first. Then verify and copy to addr */
+            if (!dataCorrupt) {
+                size_t cnt = fread(buf, 1, entry->len + sizeof(uint16_t), fp);
+
+                /* 如果文件为空(包含"-"标记)，跳过加载，使用默认值，不报错；否则验证长度和CRC后复制数据 */
+                /* If file is empty, just skip loading, default values will be used,
+                 * no error. Otherwise verify length and crc and copy data. */
+                if (!(cnt == 2 && buf[0] == '-')) {
+                    uint16_t crc1, crc2;
+                    crc1 = crc16_ccitt(buf, entry->len, 0);
+                    memcpy(&crc2, &buf[entry->len], sizeof(crc2));
+
+                    if (crc1 == crc2 && cnt == (entry->len + sizeof(crc2))) {
+                        memcpy(entry->addr, buf, entry->len);
+                        entry->crc = crc1;
+                    } else {
+                        dataCorrupt = true;
+                        ret = CO_ERROR_DATA_CORRUPT;
+                    }
+                }
+
+                free(buf);
                 fclose(fp);
-                *storageInitError = i;
-                return CO_ERROR_OUT_OF_MEMORY;
             }
         }
 
-        /* 先读取数据到临时缓冲区，然后验证并复制到目标地址 */
-        /* Read data into temporary buffer first. Then verify and copy to addr */
-        if (!dataCorrupt) {
-            size_t cnt = fread(buf, 1, entry->len + sizeof(uint16_t), fp);
-
-            /* 如果文件为空(包含"-"标记)，跳过加载，使用默认值，不报错；否则验证长度和CRC后复制数据 */
-            /* If file is empty, just skip loading, default values will be used,
-             * no error. Otherwise verify length and crc and copy data. */
-            if (!(cnt == 2 && buf[0] == '-')) {
-                uint16_t crc1, crc2;
-                crc1 = crc16_ccitt(buf, entry->len, 0);
-                memcpy(&crc2, &buf[entry->len], sizeof(crc2));
+        entry->dirty = 0;
+        entry->autoSaveError = false;
+        entry->hooks = NULL;
+        entry->hooksCount = 0;
+        entry->snapshot = NULL;
+        entry->writeState = WRITE_IDLE;
+        entry->stored = NULL;
+        entry->journalFd = -1;
+        entry->journalSize = 0;
+        entry->defaults = false;
+        entry->owner = storageLinux;
 
-                if (crc1 == crc2 && cnt == (entry->len + sizeof(crc2))) {
-                    memcpy(entry->addr, buf, entry->len);
-                    entry->crc = crc1;
-                    writeFileAccess = "r+";
-                } else {
+        /* 日志模式: 在数据文件上重放日志并保存存储数据的副本。数据文件无效时，日志与它不匹配: 用当前数据
+         * (默认值)替换数据文件并清空日志 */
+        /* journal mode: replay journal over the data file and keep copy of the stored data. If data file is not
+         * valid, journal does not match it: replace data file with current data (default values) and empty journal */
+        if (entry->journal && !storageLinux->container) {
+            size_t bytes = 0;
+            entry->stored = malloc(entry->len);
+            entry->journalFd = journalOpen(entry);
+            if (entry->stored == NULL || entry->journalFd < 0) {
+                *storageInitError = i;
+                return entry->stored == NULL ? CO_ERROR_OUT_OF_MEMORY : CO_ERROR_ILLEGAL_ARGUMENT;
+            }
+            if (!dataCorrupt) {
+                memcpy(entry->stored, entry->addr, entry->len);
+                if (!journalReplay(entry, entry->stored)) {
                     dataCorrupt = true;
-                    ret = CO_ERROR_DATA_CORRUPT;
+                } else {
+                    memcpy(entry->addr, entry->stored, entry->len);
+                    entry->crc = crc16_ccitt(entry->stored, entry->len, 0);
                 }
             }
+            if (dataCorrupt) {
+                memcpy(entry->stored, entry->addr, entry->len);
+                entry->crc = crc16_ccitt(entry->stored, entry->len, 0);
+                journalCompact(entry, &bytes);
+            }
+        }
 
-            free(buf);
-            fclose(fp);
+        /* 容器模式: 保存存储数据的副本，每次提交都写入所有条目 */
+        /* container mode: keep copy of the stored data, each commit writes all entries */
+        if (storageLinux->container) {
+            entry->stored = malloc(entry->len);
+            if (entry->stored == NULL) {
+                *storageInitError = i;
+                return CO_ERROR_OUT_OF_MEMORY;
+            }
+            memcpy(entry->stored, entry->addr, entry->len);
+            if (dataCorrupt) {
+                entry->crc = crc16_ccitt(entry->stored, entry->len, 0);
+            }
         }
 
         /* 错误情况下的附加信息 */
@@ -296,35 +1054,377 @@ CO_storageLinux_init(CO_storage_t* storage, CO_CANmodule_t* CANmodule, OD_entry_
                 errorBit = 31;
             }
             *storageInitError |= ((uint32_t)1) << errorBit;
+            ret = CO_ERROR_DATA_CORRUPT;
         }
 
-        /* 如果设置了自动存储，打开文件以供后续使用 */
-        /* open file for auto storage, if set so */
+        /* 如果设置了自动存储，检查文件可以写入(日志和容器模式不需要)，并分配快照缓冲区(数据和CRC)。快照像存储命令
+         * 一样原子地替换文件，所以文件不保持打开 */
+        /* if auto storage, check that the file is writable (not needed in journal and container mode), and allocate
+         * snapshot buffer (data and CRC). Snapshots replace the file atomically like store command, so the file is not
+         * kept open */
         if ((entry->attr & CO_storage_auto) != 0) {
-            entry->fp = fopen(entry->filename, writeFileAccess);
-            if (entry->fp == NULL) {
+            if (!entry->journal && !storageLinux->container) {
+                FILE* fp = fopen(entry->filename, "a");
+                if (fp == NULL) {
+                    *storageInitError = i;
+                    return CO_ERROR_ILLEGAL_ARGUMENT;
+                }
+                fclose(fp);
+            }
+            entry->snapshot = malloc(entry->len + sizeof(uint16_t));
+            if (entry->snapshot == NULL) {
                 *storageInitError = i;
-                return CO_ERROR_ILLEGAL_ARGUMENT;
+                return CO_ERROR_OUT_OF_MEMORY;
             }
+            *hasAuto = true;
         }
     } /* 所有条目初始化完成 for (entries) */
 
+    return ret;
+}
+
+/* 函数功能: 初始化Linux平台的CANopen存储系统(重要函数)
+ * 执行步骤:
+ *   步骤1: 验证所有输入参数的有效性，清除统计、写线程和容器的状态
+ *   步骤2: 初始化存储对象和OD扩展，注册存储和恢复回调函数
+ *   步骤3: 容器模式: 包装1010和1011的写，映射容器文件
+ *   步骤4: 初始化所有存储条目: 读取数据，验证CRC校验和，有效时复制到目标地址，否则使用默认值
+ *   步骤5: 对于自动存储条目，检查文件可以写入并分配快照缓冲区(文件不保持打开，快照原子地替换文件)，启动写线程
+ *   步骤6: 记录所有初始化错误到storageInitError位图
+ * 参数说明:
+ *   - storage: 存储对象指针
+ *   - CANmodule: CAN模块指针
+ *   - OD_1010_StoreParameters: 存储参数OD条目(1010h)
+ *   - OD_1011_RestoreDefaultParam: 恢复默认参数OD条目(1011h)
+ *   - entries: 存储条目数组指针
+ *   - entriesCount: 存储条目数量
+ *   - container: 容器文件名，NULL表示每个条目使用自己的文件
+ *   - storageInitError: 初始化错误位图指针
+ * 返回值说明: 返回CO_ReturnError_t错误码
+ */
+static CO_ReturnError_t
+storageInit(CO_storage_t* storage, CO_CANmodule_t* CANmodule, OD_entry_t* OD_1010_StoreParameters,
+            OD_entry_t* OD_1011_RestoreDefaultParam, CO_storage_entry_t* entries, uint8_t entriesCount,
+            const char* container, uint32_t* storageInitError) {
+    CO_ReturnError_t ret;
+
+    /* 验证参数有效性 */
+    /* verify arguments */
+    if (storage == NULL || entries == NULL || entriesCount == 0 || storageInitError == NULL
+        || (container != NULL && (strlen(container) == 0 || strlen(container) >= CO_STORAGE_PATH_MAX))) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* 查找或分配存储对象的Linux状态，清除它。协议栈的存储对象由CO_storage_init()初始化 */
+    /* find or allocate Linux state of the storage object and clear it. Storage object of the stack is initialized by
+     * CO_storage_init() */
+    CO_storageLinux_t* storageLinux = storageLinuxList;
+    while (storageLinux != NULL && storageLinux->storage != storage) {
+        storageLinux = storageLinux->next;
+    }
+    if (storageLinux == NULL) {
+        storageLinux = calloc(1, sizeof(*storageLinux));
+        if (storageLinux == NULL) {
+            return CO_ERROR_OUT_OF_MEMORY;
+        }
+        storageLinux->storage = storage;
+        storageLinux->next = storageLinuxList;
+        storageLinuxList = storageLinux;
+    }
+    memset(&storageLinux->stats, 0, sizeof(*storageLinux) - offsetof(CO_storageLinux_t, stats));
+    storage->enabled = false;
+    storageLinux->container = container != NULL;
+#ifndef CO_SINGLE_THREAD
+    if (pthread_mutex_init(&storageLinux->writerMutex, NULL) != 0
+        || pthread_cond_init(&storageLinux->writerCond, NULL) != 0) {
+        return CO_ERROR_SYSCALL;
+    }
+#endif
+
+    /* 初始化存储对象和OD扩展 */
+    /* initialize storage and OD extensions */
+    ret = CO_storage_init(storage, CANmodule, OD_1010_StoreParameters, OD_1011_RestoreDefaultParam,
+                          container != NULL ? storeContainer : storeLinux,
+                          container != NULL ? restoreContainer : restoreLinux, entries, entriesCount);
+    if (ret != CO_ERROR_NO) {
+        return ret;
+    }
+
+    /* 容器模式: 1010和1011的写只更新内存中的数据，写完后一次提交。容器文件只映射一次 */
+    /* container mode: 1010 and 1011 writes only update data in memory, commit is done once after the write.
+     * Container file is mapped only once */
+    const uint8_t* map = NULL;
+    size_t mapSize = 0;
+    if (container != NULL) {
+        strcpy(storageLinux->containerFilename, container);
+        storageLinux->containerWrite1010Orig = storage->OD_1010_extension.write;
+        storageLinux->containerWrite1011Orig = storage->OD_1011_extension.write;
+        storage->OD_1010_extension.write = containerWrite1010;
+        storage->OD_1011_extension.write = containerWrite1011;
+        map = containerMap(storageLinux, &mapSize);
+    }
+
+    /* 初始化所有存储条目 */
+    /* initialize entries */
+    bool_t hasAuto = false;
+    ret = initEntries(storageLinux, entries, entriesCount, map, mapSize, storageInitError, &hasAuto);
+    if (map != NULL) {
+        munmap((void*)map, mapSize);
+    }
+    if (ret != CO_ERROR_NO && ret != CO_ERROR_DATA_CORRUPT) {
+        return ret;
+    }
+
+#ifndef CO_SINGLE_THREAD
+    /* 启动自动存储的后台写线程 */
+    /* start background writer for auto storage */
+    if (hasAuto) {
+        if (pthread_create(&storageLinux->writerThreadId, NULL, writerThread, storageLinux) != 0) {
+            return CO_ERROR_SYSCALL;
+        }
+        storageLinux->writerRunning = true;
+    }
+#else
+    (void)hasAuto;
+#endif
+
     /* 启用存储功能 */
     storage->enabled = true;
     return ret;
 }
 
-/* 函数功能: 自动存储处理函数 - 定期保存变化的数据(重要函数)
+CO_ReturnError_t
+CO_storageLinux_init(CO_storage_t* storage, CO_CANmodule_t* CANmodule, OD_entry_t* OD_1010_StoreParameters,
+                     OD_entry_t* OD_1011_RestoreDefaultParam, CO_storage_entry_t* entries, uint8_t entriesCount,
+                     uint32_t* storageInitError) {
+    return storageInit(storage, CANmodule, OD_1010_StoreParameters, OD_1011_RestoreDefaultParam, entries,
+                       entriesCount, NULL, storageInitError);
+}
+
+CO_ReturnError_t
+CO_storageLinux_initContainer(CO_storage_t* storage, CO_CANmodule_t* CANmodule,
+                              OD_entry_t* OD_1010_StoreParameters, OD_entry_t* OD_1011_RestoreDefaultParam,
+                              CO_storage_entry_t* entries, uint8_t entriesCount, const char* filename,
+                              uint32_t* storageInitError) {
+    if (filename == NULL) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    return storageInit(storage, CANmodule, OD_1010_StoreParameters, OD_1011_RestoreDefaultParam, entries,
+                       entriesCount, filename, storageInitError);
+}
+
+/* OD 读钩子：转发给原来的扩展 */
+/* OD read hook: forward to the original extension */
+static ODR_t
+hookRead(OD_stream_t* stream, void* buf, OD_size_t count, OD_size_t* countRead) {
+    CO_storageLinux_hook_t* hook = stream->object;
+    ODR_t ret;
+
+    if (hook->extensionOrig == NULL) {
+        return OD_readOriginal(stream, buf, count, countRead);
+    }
+    if (hook->readOrig == NULL) {
+        return ODR_UNSUPP_ACCESS;
+    }
+    stream->object = hook->objectOrig;
+    ret = hook->readOrig(stream, buf, count, countRead);
+    stream->object = hook;
+    return ret;
+}
+
+/* OD 写钩子：转发给原来的扩展或写入原始数据，然后标记存储条目 */
+/* OD write hook: forward to the original extension or write original data, then mark storage entry */
+static ODR_t
+hookWrite(OD_stream_t* stream, const void* buf, OD_size_t count, OD_size_t* countWritten) {
+    CO_storageLinux_hook_t* hook = stream->object;
+    ODR_t ret;
+
+    if (hook->extensionOrig == NULL) {
+        ret = OD_writeOriginal(stream, buf, count, countWritten);
+    } else if (hook->writeOrig == NULL) {
+        ret = ODR_UNSUPP_ACCESS;
+    } else {
+        stream->object = hook->objectOrig;
+        ret = hook->writeOrig(stream, buf, count, countWritten);
+        stream->object = hook;
+    }
+    if (ret == ODR_OK || ret == ODR_PARTIAL) {
+        markEntry(hook->storageEntry);
+    }
+    return ret;
+}
+
+/* 钩子是否安装在 OD 对象的扩展上，也包括链接在同一扩展上的其它钩子后面 */
+/* Is hook installed on extension of the OD object, also behind other hooks chained into the same extension */
+static bool_t
+hookInstalled(const CO_storageLinux_hook_t* hook) {
+    const OD_extension_t* ext = hook->entry->extension;
+    const CO_storageLinux_hook_t* h = ext != NULL && ext->write == hookWrite ? ext->object : NULL;
+
+    while (h != NULL) {
+        if (h == hook) {
+            return true;
+        }
+        h = h->extensionOrig == ext && h->writeOrig == hookWrite ? h->objectOrig : NULL;
+    }
+    return false;
+}
+
+/* 从 OD 对象移除钩子，只有在它仍在链的顶部时才恢复原来的扩展 */
+/* Remove hook from OD object, original extension is restored only if hook is still on top of the chain */
+static void
+hookRemove(CO_storageLinux_hook_t* hook) {
+    OD_extension_t* ext = hook->entry->extension;
+
+    if (hook->extensionOrig == NULL) {
+        if (ext == &hook->extension) {
+            hook->entry->extension = NULL;
+        }
+    } else if (ext == hook->extensionOrig && ext->object == hook && ext->write == hookWrite) {
+        ext->object = hook->objectOrig;
+        ext->read = hook->readOrig;
+        ext->write = hook->writeOrig;
+    }
+}
+
+/* 查找数据与 OD 对象重叠的自动存储条目，没有则返回 NULL */
+/* Find auto storage entry, which overlaps data of the OD entry, NULL if none */
+static CO_storage_entry_t*
+findStorageEntry(CO_storage_t* storage, OD_entry_t* odEntry) {
+    uint8_t found = 0;
+
+    for (uint16_t sub = 0; sub <= 0xFF && found < odEntry->subEntriesCount; sub++) {
+        OD_IO_t io;
+        if (OD_getSub(odEntry, (uint8_t)sub, &io, true) != ODR_OK) {
+            continue;
+        }
+        found++;
+        const uint8_t* data = io.stream.dataOrig;
+        if (data == NULL) {
+            continue;
+        }
+        for (uint8_t i = 0; i < storage->entriesCount; i++) {
+            CO_storage_entry_t* entry = &storage->entries[i];
+            const uint8_t* addr = entry->addr;
+            if ((entry->attr & CO_storage_auto) != 0 && data < addr + entry->len
+                && data + io.stream.dataLength > addr) {
+                return entry;
+            }
+        }
+    }
+    return NULL;
+}
+
+/* 函数功能: 安装OD写钩子，用于自动存储的改变跟踪
  * 执行步骤:
- *   步骤1: 验证存储对象指针有效性
- *   步骤2: 遍历所有存储条目
- *   步骤3: 跳过非自动存储条目或文件未打开的条目
- *   步骤4: 计算当前数据的CRC校验和
- *   步骤5: 如果CRC与上次保存的不同，说明数据已变化
- *   步骤6: 将文件指针重置到开头，写入新数据和CRC
- *   步骤7: 刷新文件缓冲区确保数据写入磁盘
- *   步骤8: 如果写入失败，设置错误位
- *   步骤9: 如果需要，关闭所有文件
+ *   步骤1: 第一次调用时，遍历对象字典，统计每个自动存储条目内的OD对象并分配钩子
+ *   步骤2: 对每个未安装的钩子(协议栈重新初始化了扩展)，OD对象没有扩展时安装钩子自己的扩展，
+ *          否则链接到已有的扩展(只替换object、read和write，TPDO标志保持不变)
+ * 参数说明:
+ *   - storage: 存储对象指针
+ *   - od: 对象字典
+ * 返回值说明: 返回CO_ReturnError_t错误码
+ */
+CO_ReturnError_t
+CO_storageLinux_initHooks(CO_storage_t* storage, OD_t* od) {
+    if (storage == NULL || od == NULL) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* 第一次调用：分配钩子 */
+    /* first call: allocate hooks */
+    for (uint8_t i = 0; i < storage->entriesCount; i++) {
+        CO_storage_entry_t* entry = &storage->entries[i];
+        uint16_t count = 0;
+
+        if ((entry->attr & CO_storage_auto) == 0 || entry->hooks != NULL) {
+            continue;
+        }
+        for (uint16_t j = 0; j < od->size; j++) {
+            if (findStorageEntry(storage, &od->list[j]) == entry) {
+                count++;
+            }
+        }
+        if (count == 0) {
+            continue;
+        }
+        entry->hooks = calloc(count, sizeof(CO_storageLinux_hook_t));
+        if (entry->hooks == NULL) {
+            return CO_ERROR_OUT_OF_MEMORY;
+        }
+        for (uint16_t j = 0; j < od->size && entry->hooksCount < count; j++) {
+            if (findStorageEntry(storage, &od->list[j]) == entry) {
+                CO_storageLinux_hook_t* hook = &entry->hooks[entry->hooksCount++];
+                hook->entry = &od->list[j];
+                hook->storageEntry = entry;
+            }
+        }
+    }
+
+    /* 安装钩子，协议栈可能已经在通信复位时替换了扩展 */
+    /* install hooks, stack may have replaced extensions on communication reset */
+    for (uint8_t i = 0; i < storage->entriesCount; i++) {
+        CO_storage_entry_t* entry = &storage->entries[i];
+
+        for (uint16_t j = 0; j < entry->hooksCount; j++) {
+            CO_storageLinux_hook_t* hook = &entry->hooks[j];
+
+            OD_extension_t* ext = hook->entry->extension;
+
+            if (hookInstalled(hook)) {
+                continue;
+            }
+            if (ext == NULL) {
+                /* 没有扩展: 安装钩子自己的扩展 */
+                /* no extension: install own extension of the hook */
+                memset(&hook->extension, 0, sizeof(hook->extension));
+                hook->extension.object = hook;
+                hook->extension.read = hookRead;
+                hook->extension.write = hookWrite;
+                hook->extensionOrig = NULL;
+                OD_extension_init(hook->entry, &hook->extension);
+            } else {
+                /* 链接到已有的扩展，它的TPDO标志保持有效 */
+                /* chain into existing extension, its TPDO flags stay valid */
+                hook->extensionOrig = ext;
+                hook->objectOrig = ext->object;
+                hook->readOrig = ext->read;
+                hook->writeOrig = ext->write;
+                ext->object = hook;
+                ext->read = hookRead;
+                ext->write = hookWrite;
+            }
+        }
+    }
+    return CO_ERROR_NO;
+}
+
+void
+CO_storageLinux_markDirty(CO_storage_t* storage, const void* addr, size_t len) {
+    if (storage == NULL || addr == NULL) {
+        return;
+    }
+    for (uint8_t i = 0; i < storage->entriesCount; i++) {
+        CO_storage_entry_t* entry = &storage->entries[i];
+        const uint8_t* entryAddr = entry->addr;
+
+        if ((entry->attr & CO_storage_auto) != 0 && (const uint8_t*)addr < entryAddr + entry->len
+            && (const uint8_t*)addr + len > entryAddr) {
+            markEntry(entry);
+        }
+    }
+}
+
+/* 函数功能: 自动存储处理函数 - 保存已改变的数据(重要函数)
+ * 执行步骤:
+ *   步骤1: 验证存储对象指针有效性，程序结束时先停止写线程
+ *   步骤2: 遍历所有存储条目，跳过非自动存储条目、没有快照缓冲区的条目和已恢复默认参数的条目
+ *   步骤3: 跳过未标记改变的条目、去抖时间未到的条目和快照还在写的条目(除非closeFiles)
+ *   步骤4: 在OD锁保护下清除改变标志并把数据复制到快照缓冲区，记录锁保持时间
+ *   步骤5: 在锁外计算快照的CRC校验和，如果与上次保存的相同，不写入
+ *   步骤6: 把快照交给写线程(单线程或程序结束时直接写入: 临时文件、fdatasync、renameat、fsync目录)
+ *   步骤7: 上次写入失败的条目设置错误位
+ *   步骤8: 如果需要，释放快照缓冲区，所有条目写完后关闭日志，释放存储数据的副本并移除OD写钩子
  * 参数说明:
  *   - storage: 存储对象指针
  *   - closeFiles: 是否关闭文件的布尔标志
@@ -333,60 +1433,152 @@ CO_storageLinux_init(CO_storage_t* storage, CO_CANmodule_t* CANmodule, OD_entry_
 uint32_t
 CO_storageLinux_auto_process(CO_storage_t* storage, bool_t closeFiles) {
     uint32_t storageError = 0;
+    uint64_t now = 0;
 
     /* 验证参数 */
     /* verify arguments */
-    if (storage == NULL) {
+    CO_storageLinux_t* storageLinux = storageLinuxOf(storage);
+    if (storageLinux == NULL) {
         return false;
     }
 
+#ifndef CO_SINGLE_THREAD
+    /* 程序结束：写完所有排队的快照，剩余的条目在本线程中写入 */
+    /* end of program: write all queued snapshots, remaining entries are written by this thread */
+    if (closeFiles) {
+        writerStopAndJoin(storageLinux);
+    }
+#endif
+
     /* 遍历所有存储条目 */
     /* loop through entries */
     for (uint8_t i = 0; i < storage->entriesCount; i++) {
         CO_storage_entry_t* entry = &storage->entries[i];
 
-        /* 跳过非自动存储条目 */
-        if ((entry->attr & CO_storage_auto) == 0 || entry->fp == NULL) {
+        /* 跳过非自动存储条目和已恢复默认参数的条目 */
+        /* skip entries without auto storage and entries with restored default parameters */
+        if ((entry->attr & CO_storage_auto) == 0 || entry->snapshot == NULL || entry->defaults) {
             continue;
         }
 
-        /* 如果当前数据的CRC与保存的不同，则保存文件 */
-        /* If CRC of the current data differs, save the file */
-        uint16_t crc = crc16_ccitt(entry->addr, entry->len, 0);
-        if (crc != entry->crc) {
-            size_t cnt;
-            /* 重置文件指针到开头 */
-            rewind(entry->fp);
-            /* 在OD锁保护下写入数据 */
+        /* 没有改变时不计算CRC。程序结束时验证所有条目，也包括未标记的改变 */
+        /* No CRC calculation without change. On end of program verify all entries, also unmarked changes. */
+        bool_t save = closeFiles;
+        if (!closeFiles && entry->dirty && entry->writeState == WRITE_IDLE) {
+            if (now == 0) {
+                now = storageTime_us();
+            }
+            /* 保存失败后，间隔CO_STORAGE_AUTO_INTERVAL后重试 */
+            /* after failed save retry after CO_STORAGE_AUTO_INTERVAL */
+            if (entry->autoSaveError) {
+                save = (now - entry->dirtyFirst_us) >= CO_STORAGE_AUTO_INTERVAL;
+            } else {
+                save = (now - entry->dirtyLast_us) >= CO_STORAGE_AUTO_DEBOUNCE_US
+                       || (now - entry->dirtyFirst_us) >= CO_STORAGE_AUTO_INTERVAL;
+            }
+        }
+
+        if (save) {
+            /* 在锁内只复制数据，标志在锁内清除，之后的改变会再次标记条目 */
+            /* Only copy data inside lock. Flag is cleared inside lock, later changes mark entry again. */
+            CO_MemoryBarrier();
+            uint64_t lockStart = storageTime_us();
             CO_LOCK_OD(storage->CANmodule);
-            cnt = fwrite(entry->addr, 1, entry->len, entry->fp);
+            entry->dirty = 0;
+            memcpy(entry->snapshot, entry->addr, entry->len);
             CO_UNLOCK_OD(storage->CANmodule);
-            /* 写入CRC校验和 */
-            cnt += fwrite(&crc, 1, sizeof(crc), entry->fp);
-            /* 刷新文件缓冲区 */
-            fflush(entry->fp);
-            if (cnt == (entry->len + sizeof(crc))) {
-                /* 更新保存的CRC值 */
-                entry->crc = crc;
-            } else {
-                /* 保存失败，记录错误 */
-                /* error with save */
-                uint32_t errorBit = entry->subIndexOD;
-                if (errorBit > 31) {
-                    errorBit = 31;
+            uint64_t lockEnd = storageTime_us();
+            uint32_t lock_us = (uint32_t)(lockEnd - lockStart);
+
+#ifndef CO_SINGLE_THREAD
+            pthread_mutex_lock(&storageLinux->writerMutex);
+#endif
+            storageLinux->stats.snapshots++;
+            storageLinux->stats.lockTotal_us += lock_us;
+            if (lock_us > storageLinux->stats.lockMax_us) {
+                storageLinux->stats.lockMax_us = lock_us;
+            }
+#ifndef CO_SINGLE_THREAD
+            pthread_mutex_unlock(&storageLinux->writerMutex);
+#endif
+
+            /* 如果快照的CRC与保存的不同，则保存文件 */
+            /* If CRC of the snapshot differs, save the file */
+            uint16_t crc = crc16_ccitt(entry->snapshot, entry->len, 0);
+            if (crc != entry->crc) {
+                memcpy(&entry->snapshot[entry->len], &crc, sizeof(crc));
+                entry->snapshotTime_us = lockEnd;
+#ifndef CO_SINGLE_THREAD
+                if (!closeFiles) {
+                    /* 交给写线程 */
+                    /* hand over to the writer thread */
+                    pthread_mutex_lock(&storageLinux->writerMutex);
+                    entry->writeState = WRITE_QUEUED;
+                    pthread_cond_signal(&storageLinux->writerCond);
+                    pthread_mutex_unlock(&storageLinux->writerMutex);
+                } else
+#endif
+                {
+                    uint32_t write_us;
+                    size_t bytes;
+                    bool_t compacted;
+                    bool_t ok = writeSnapshot(entry, &write_us, &bytes, &compacted);
+                    writeDone(entry, ok, write_us, bytes, compacted);
                 }
-                storageError |= ((uint32_t)1) << errorBit;
             }
         }
 
-        /* 如果需要，关闭文件 */
+        /* 上次写入失败的条目设置错误位 */
+        /* error bit for entries, where the last save failed */
+        if (entry->autoSaveError) {
+            uint32_t errorBit = entry->subIndexOD;
+            if (errorBit > 31) {
+                errorBit = 31;
+            }
+            storageError |= ((uint32_t)1) << errorBit;
+        }
+
+        /* 如果需要，释放快照缓冲区。存储数据的副本在所有条目写完后释放，容器的提交写入所有条目 */
+        /* if required, free snapshot buffer. Copies of the stored data are freed after all entries are written, commit
+         * of the container writes all entries */
         if (closeFiles) {
-            fclose(entry->fp);
-            entry->fp = NULL;
+            free(entry->snapshot);
+            entry->snapshot = NULL;
+        }
+    }
+
+    /* 关闭日志，释放存储数据的副本，移除OD写钩子，顺序与安装相反，这样链接在同一扩展上的钩子被正确地解开 */
+    /* close journals, free copies of the stored data, remove OD write hooks in reverse order of installation, so hooks
+     * chained into the same extension unwind */
+    for (uint8_t i = storage->entriesCount; closeFiles && i > 0; i--) {
+        CO_storage_entry_t* entry = &storage->entries[i - 1];
+
+        journalClose(entry);
+
+        for (uint16_t j = entry->hooksCount; j > 0; j--) {
+            hookRemove(&entry->hooks[j - 1]);
         }
+        free(entry->hooks);
+        entry->hooks = NULL;
+        entry->hooksCount = 0;
     }
 
     return storageError;
 }
 
+void
+CO_storageLinux_getStats(CO_storage_t* storage, CO_storageLinux_stats_t* stats) {
+    CO_storageLinux_t* storageLinux = storageLinuxOf(storage);
+    if (storageLinux == NULL || stats == NULL) {
+        return;
+    }
+#ifndef CO_SINGLE_THREAD
+    pthread_mutex_lock(&storageLinux->writerMutex);
+#endif
+    *stats = storageLinux->stats;
+#ifndef CO_SINGLE_THREAD
+    pthread_mutex_unlock(&storageLinux->writerMutex);
+#endif
+}
+
 #endif /* (CO_CONFIG_STORAGE) & CO_CONFIG_STORAGE_ENABLE */
@@ -40,14 +40,76 @@ extern "C" {
  * @ingroup CO_socketCAN
  * @{
  * See also @ref CO_storage.
+ *
+ * Functions take the storage object of the stack, CO_storage_t, as in CANopenNode. Linux state of each storage object
+ * (auto storage statistics, background writer thread and container file) is allocated by @ref CO_storageLinux_init()
+ * or @ref CO_storageLinux_initContainer() on the first call for that object and reused, if the same object is
+ * initialized again. Entries point to it, so there may be more independent storage objects in one process.
+ */
+
+/* 自动存储去抖时间：最后一次改变后经过该时间（微秒）没有新的改变，才保存数据 */
+/** Auto storage debounce: data are saved, when there was no change for this time in microseconds */
+#ifndef CO_STORAGE_AUTO_DEBOUNCE_US
+#define CO_STORAGE_AUTO_DEBOUNCE_US 200000
+#endif
+
+/* 持续改变时自动存储的最大延时（微秒），从第一次未保存的改变开始计时 */
+/** Maximum delay of auto storage in microseconds from the first unsaved change, if data change continuously */
+#ifndef CO_STORAGE_AUTO_INTERVAL
+#define CO_STORAGE_AUTO_INTERVAL 60000000
+#endif
+
+/* 日志模式：日志文件超过该大小（字节）时，压缩到数据文件中 */
+/** Journal mode: journal is compacted into the data file, when it grows over this size in bytes */
+#ifndef CO_STORAGE_JOURNAL_MAX
+#define CO_STORAGE_JOURNAL_MAX 16384
+#endif
+
+/* 自动存储统计，见 CO_storageLinux_getStats() */
+/** Statistics of auto storage, see @ref CO_storageLinux_getStats() */
+typedef struct {
+    uint32_t snapshots;       /**< Number of snapshots of dirty entries */
+    uint32_t lockMax_us;      /**< Maximum time of @ref CO_LOCK_OD() hold, while data are copied to snapshot */
+    uint64_t lockTotal_us;    /**< Total time of @ref CO_LOCK_OD() hold */
+    uint32_t writes;          /**< Number of successful writes (data, CRC and fdatasync) */
+    uint32_t writeErrors;     /**< Number of failed writes */
+    uint64_t writeBytes;      /**< Bytes written, including journal compactions */
+    uint32_t writeMax_us;     /**< Maximum time of write and fdatasync */
+    uint64_t writeTotal_us;   /**< Total time of writes and fdatasync */
+    uint32_t latencyMax_us;   /**< Maximum storage latency: time from snapshot until data are on the storage */
+    uint64_t latencyTotal_us; /**< Total storage latency */
+    uint32_t compactions;     /**< Number of journal compactions */
+} CO_storageLinux_stats_t;
+
+/* OD 写钩子
+ * 安装在数据位于自动存储条目内的 OD 对象上。写入先转发给原来的扩展（或原始数据），
+ * 然后将存储条目标记为已改变。如果 OD 对象已有扩展，钩子链接到它里面（只替换 object、read 和 write），
+ * 这样扩展的 TPDO 标志保持在 TPDO 和应用程序使用的位置。
+ */
+/**
+ * OD write hook
+ *
+ * Installed on OD objects with data inside auto storage entry. Write is forwarded to the original extension (or to
+ * the original data), then storage entry is marked dirty. If OD object already has an extension, hook is chained into
+ * it (only object, read and write are replaced), so its TPDO flags stay where TPDO and application use them.
  */
+typedef struct CO_storageLinux_hook {
+    OD_extension_t extension;         /**< Own extension, installed on OD entry without extension */
+    OD_extension_t* extensionOrig;    /**< Existing extension, which hook is chained into, or NULL */
+    void* objectOrig;                 /**< Original object of the chained extension */
+    ODR_t (*readOrig)(OD_stream_t* stream, void* buf, OD_size_t count, OD_size_t* countRead);
+    ODR_t (*writeOrig)(OD_stream_t* stream, const void* buf, OD_size_t count, OD_size_t* countWritten);
+    OD_entry_t* entry;                /**< OD entry */
+    CO_storage_entry_t* storageEntry; /**< Storage entry, which contains data of the OD entry */
+} CO_storageLinux_hook_t;
 
 /* 初始化数据存储对象（Linux 平台特定）
  * 函数功能：初始化数据存储对象，设置对象字典扩展（0x1010 和 0x1011），从文件读取数据，
  *         验证数据并写入到条目指定的地址。此函数内部调用 CO_storage_init()
  * 使用说明：应该在程序启动后、CO_CANopenInit() 之前由应用程序调用
  * 参数说明：
- *   - storage: 要初始化的存储对象，必须由应用程序定义并永久存在
+ *   - storage: 要初始化的存储对象，必须由应用程序定义并永久存在。再次初始化之前必须调用
+ *              CO_storageLinux_auto_process(closeFiles = true)
  *   - CANmodule: CAN 设备，用于 CO_LOCK_OD() 宏
  *   - OD_1010_StoreParameters: 0x1010 "存储参数"对象字典条目，可选，可为 NULL
  *   - OD_1011_RestoreDefaultParam: 0x1011 "恢复默认参数"对象字典条目，可选，可为 NULL
@@ -55,6 +117,10 @@ extern "C" {
  *   - entriesCount: 存储条目数量
  *   - storageInitError: [输出] 如果函数返回 CO_ERROR_DATA_CORRUPT，则此变量包含 subIndexOD
  *                      值的位掩码，表示数据未能正确初始化。如果是其他错误，则包含出错条目的索引
+ * 日志模式：条目设置 journal 时，存储只把与上次存储不同的字节范围作为带 CRC 的记录追加到日志文件
+ *         <filename>.jrn 并执行 fdatasync。初始化时在数据文件上重放日志，只应用完整的存储，末尾不完整的
+ *         记录被截断。日志超过 CO_STORAGE_JOURNAL_MAX 时压缩：数据文件被原子地替换，日志被清空。自动
+ *         存储条目在后台写线程中压缩
  * 返回值说明：
  *   - CO_ERROR_NO: 成功
  *   - CO_ERROR_DATA_CORRUPT: 数据无法初始化
@@ -68,7 +134,14 @@ extern "C" {
  * initializes storage object, OD extensions on objects 1010 and 1011, reads data from file, verifies them and writes
  * data to addresses specified inside entries. This function internally calls @ref CO_storage_init().
  *
+ * Journal mode: if entry has journal set, store appends only byte ranges, which differ from the previous store, as
+ * records with CRC to the journal file <filename>.jrn and calls fdatasync. Journal is replayed over the data file
+ * here, only complete stores are applied, incomplete records at the end are truncated. When journal grows over
+ * @ref CO_STORAGE_JOURNAL_MAX, it is compacted: data file is atomically replaced and journal is emptied. Auto storage
+ * entries are compacted by the background writer thread.
+ *
  * @param storage This object will be initialized. It must be defined by application and must exist permanently.
+ * Before it is initialized again, @ref CO_storageLinux_auto_process() with closeFiles set must be called.
  * @param CANmodule CAN device, used for @ref CO_LOCK_OD() macro.
  * @param OD_1010_StoreParameters OD entry for 0x1010 -"Store parameters". Entry is optional, may be NULL.
  * @param OD_1011_RestoreDefaultParam OD entry for 0x1011 -"Restore default parameters". Entry is optional, may be NULL.
@@ -85,28 +158,130 @@ CO_ReturnError_t CO_storageLinux_init(CO_storage_t* storage, CO_CANmodule_t* CAN
                                       OD_entry_t* OD_1010_StoreParameters, OD_entry_t* OD_1011_RestoreDefaultParam,
                                       CO_storage_entry_t* entries, uint8_t entriesCount, uint32_t* storageInitError);
 
-/* 自动保存数据（如果与上次调用不同）
- * 函数功能：周期性调用以自动保存数据。每次调用时验证数据的 CRC 校验和是否与上次的
- *         校验和不同。如果不同，则将数据保存到预先打开的文件中
- * 使用说明：应该由程序周期性调用
+/* 初始化数据存储对象，所有条目存储在一个容器文件中
+ * 函数功能：与 CO_storageLinux_init() 相同，但所有条目存储在一个带版本号的容器文件中。文件包含条目表（每个条目的
+ *         名称、偏移、长度和 CRC，名称为条目文件名，不含路径）和所有条目的数据。启动时容器文件只打开和映射一次，
+ *         所有条目在一遍中恢复。每次存储把所有条目写入新的临时文件并原子地重命名，因此一次"存储参数"或"恢复默认
+ *         参数"命令（也包括所有条目的子索引 1）是一次原子提交。条目的 journal 被忽略
+ * 参数说明：
+ *   - filename: 容器文件名（包括路径）
+ *   - 其他参数见 CO_storageLinux_init()
+ * 返回值说明：见 CO_storageLinux_init()。容器文件不存在、无效或不包含条目时，条目的位在 storageInitError 中设置
+ */
+/**
+ * Initialize data storage object, all entries are stored in one container file
+ *
+ * Same as @ref CO_storageLinux_init(), but all entries are stored in one versioned container file. File contains entry
+ * table (name, offset, length and CRC of each entry, name is entry filename without path) and data of all entries.
+ * Container file is opened and mapped only once at startup, all entries are restored in one pass. Each store writes
+ * all entries into new temporary file and renames it atomically, so one "Store parameters" or "Restore default
+ * parameters" command (also sub-index 1 for all entries) is one atomic commit. Journal of entries is ignored.
+ *
+ * @param filename Name of the container file including path.
+ * @param storage, CANmodule, OD_1010_StoreParameters, OD_1011_RestoreDefaultParam, entries, entriesCount,
+ * storageInitError See @ref CO_storageLinux_init().
+ *
+ * @return See @ref CO_storageLinux_init(). If container file is missing, invalid or does not contain the entry, bit of
+ * the entry is set in storageInitError.
+ */
+CO_ReturnError_t CO_storageLinux_initContainer(CO_storage_t* storage, CO_CANmodule_t* CANmodule,
+                                               OD_entry_t* OD_1010_StoreParameters,
+                                               OD_entry_t* OD_1011_RestoreDefaultParam, CO_storage_entry_t* entries,
+                                               uint8_t entriesCount, const char* filename, uint32_t* storageInitError);
+
+/* 安装 OD 写钩子，用于自动存储的改变跟踪
+ * 函数功能：在数据位于自动存储条目内的所有 OD 对象上安装写钩子。通过 SDO 等 OD 接口的写入将
+ *         对应条目标记为已改变。RPDO 在 CO_CANopenInitPDO() 中取得映射对象的 OD 接口，因此必须在它之前
+ *         调用本函数。协议栈在每次通信复位时重新初始化其 OD 扩展，因此在 CO_CANopenInitPDO() 之后应再调用
+ *         一次，已安装的钩子保持不变。已有的扩展保持有效，钩子链接到它里面，写入会转发给它
+ * 使用说明：不经过 OD 接口改变数据的代码（应用程序）必须调用 CO_storageLinux_markDirty()
+ * 参数说明：
+ *   - storage: 存储对象
+ *   - od: 对象字典
+ * 返回值说明：CO_ERROR_NO、CO_ERROR_ILLEGAL_ARGUMENT 或 CO_ERROR_OUT_OF_MEMORY
+ */
+/**
+ * Install OD write hooks for change tracking of auto storage
+ *
+ * Write hook is installed on each OD object, which has data inside auto storage entry. Writes through the OD interface
+ * (SDO and RPDO for example) mark the storage entry dirty. RPDOs take OD interface of mapped objects on
+ * @ref CO_CANopenInitPDO(), so this function must be called before it. Stack initializes its OD extensions on each
+ * communication reset, so it should be called again after CO_CANopenInitPDO(), installed hooks are kept. Existing
+ * extensions stay functional, hook is chained into them and writes are forwarded.
+ *
+ * Code, which changes data without OD interface (application), must call @ref CO_storageLinux_markDirty().
+ *
+ * @param storage This object
+ * @param od Object dictionary
+ *
+ * @return CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT or CO_ERROR_OUT_OF_MEMORY.
+ */
+CO_ReturnError_t CO_storageLinux_initHooks(CO_storage_t* storage, OD_t* od);
+
+/* 标记数据已改变
+ * 函数功能：将包含 [addr, addr + len) 范围内数据的自动存储条目标记为已改变。可以从任意线程调用
  * 参数说明：
  *   - storage: 存储对象
- *   - closeFiles: 如果为 true，则关闭所有文件。在程序结束时使用
+ *   - addr: 已改变数据的地址
+ *   - len: 已改变数据的长度
+ */
+/**
+ * Mark data changed
+ *
+ * Auto storage entries, which contain data in range [addr, addr + len), are marked dirty. May be called from any
+ * thread.
+ *
+ * @param storage This object
+ * @param addr Address of changed data
+ * @param len Length of changed data
+ */
+void CO_storageLinux_markDirty(CO_storage_t* storage, const void* addr, size_t len);
+
+/* 自动保存已改变的数据
+ * 函数功能：周期性调用以自动保存数据。只处理已标记为改变的条目：最后一次改变后经过
+ *         CO_STORAGE_AUTO_DEBOUNCE_US，或第一次改变后经过 CO_STORAGE_AUTO_INTERVAL，在 CO_LOCK_OD()
+ *         内把数据复制到快照缓冲区，在锁外验证快照的 CRC 校验和，如果与上次不同，则把快照交给后台
+ *         写线程。写线程原子地替换文件：用 pwritev() 写入临时文件，fdatasync()，renameat() 到目标文件名，
+ *         再 fsync() 目录；或者追加到日志，或者提交容器。没有改变时不计算 CRC。单线程（CO_SINGLE_THREAD）
+ *         时直接写入。写入失败的错误位在下一次调用时报告
+ * 使用说明：应该由程序在每个主线程周期调用，调用开销很小
+ * 参数说明：
+ *   - storage: 存储对象
+ *   - closeFiles: 如果为 true，则验证所有条目的 CRC（包括未标记的改变），保存并关闭所有文件。在程序结束时使用
  * 返回值说明：成功返回 0，或返回 subIndexOD 值的位掩码，表示无法保存数据的条目
  */
 /**
- * Automatically save data if differs from previous call.
+ * Automatically save changed data.
  *
- * Should be called cyclically by program. Each interval it verifies, if crc checksum of data differs from previous
- * checksum. If it does, data are saved into pre-opened file.
+ * Should be called cyclically by program, on each mainline cycle, call is cheap. Only entries marked dirty are
+ * processed: when there was no change for @ref CO_STORAGE_AUTO_DEBOUNCE_US or when @ref CO_STORAGE_AUTO_INTERVAL
+ * passed from the first change, data are copied to snapshot buffer inside @ref CO_LOCK_OD(). Outside the lock it
+ * verifies, if crc checksum of the snapshot differs from previous checksum. If it does, snapshot is handed to the
+ * background writer thread, which replaces the file atomically (temporary file, fdatasync, rename), appends to the
+ * journal or commits the container. No CRC is calculated, if nothing is dirty. With CO_SINGLE_THREAD snapshot is
+ * written directly. Error bits of failed writes are reported on the next calls.
  *
  * @param storage This object
- * @param closeFiles If true, then all files will be closed. Use on end of the program.
+ * @param closeFiles If true, then CRC of all entries is verified (also unmarked changes), data are saved and all files
+ * will be closed. Use on end of the program.
  *
  * @return 0 on success or bit mask from subIndexOD values, where data was not able to be saved.
  */
 uint32_t CO_storageLinux_auto_process(CO_storage_t* storage, bool_t closeFiles);
 
+/* 读取自动存储统计：OD 锁保持时间、写入时间和存储延时
+ * 参数说明：
+ *   - storage: 存储对象
+ *   - stats: [输出] 统计
+ */
+/**
+ * Get statistics of auto storage: OD lock hold time, write time and storage latency
+ *
+ * @param storage This object
+ * @param [out] stats Statistics
+ */
+void CO_storageLinux_getStats(CO_storage_t* storage, CO_storageLinux_stats_t* stats);
+
 /** @} */ /* CO_storageLinux */
 
 #ifdef __cplusplus
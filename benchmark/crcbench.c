@@ -0,0 +1,142 @@
+/*
+ * Verification and throughput benchmark of CRC16-CCITT implementations of CO_crc16Linux.
+ *
+ * @file        crcbench.c
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "CO_crc16Linux.h"
+
+#define DATA_SIZE (1 << 20)
+
+static const struct {
+    CO_crc16Linux_impl_t impl;
+    const char* name;
+} impls[] = {{CO_CRC16_IMPL_TABLE, "table"}, {CO_CRC16_IMPL_SLICE8, "slice8"}, {CO_CRC16_IMPL_CLMUL, "clmul"}};
+#define IMPLS (sizeof(impls) / sizeof(impls[0]))
+
+static double
+now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* Compare selected implementation with the bitwise reference, return number of mismatches */
+static unsigned
+verify(const uint8_t* data) {
+    unsigned errors = 0;
+
+    if (crc16_ccitt((const uint8_t*)"123456789", 9, 0) != 0x31C3) {
+        fprintf(stderr, "  check value 0x%04X, expected 0x31C3\n", crc16_ccitt((const uint8_t*)"123456789", 9, 0));
+        errors++;
+    }
+    /* all lengths around block sizes, all alignments, random initial value */
+    for (size_t len = 0; len <= 4096; len++) {
+        for (size_t offset = 0; offset < 16; offset++) {
+            uint16_t init = (uint16_t)rand();
+            if (crc16_ccitt(&data[offset], len, init) != CO_crc16Linux_reference(&data[offset], len, init)) {
+                if (errors++ < 5) {
+                    fprintf(stderr, "  mismatch: length %zu, offset %zu, init 0x%04X\n", len, offset, init);
+                }
+            }
+        }
+    }
+    /* random lengths up to the whole buffer */
+    for (int i = 0; i < 200; i++) {
+        size_t offset = (size_t)rand() % 64;
+        size_t len = (size_t)rand() % (DATA_SIZE - offset);
+        if (crc16_ccitt(&data[offset], len, 0) != CO_crc16Linux_reference(&data[offset], len, 0)) {
+            if (errors++ < 5) {
+                fprintf(stderr, "  mismatch: length %zu, offset %zu\n", len, offset);
+            }
+        }
+    }
+    return errors;
+}
+
+/* Throughput in MB/s over payload of size bytes, about mb megabytes are processed */
+static double
+throughput(const uint8_t* data, size_t size, double mb) {
+    size_t count = (size_t)(mb * 1e6 / (double)size) + 1;
+    volatile uint16_t sink = 0;
+    double start = now_s();
+
+    for (size_t i = 0; i < count; i++) {
+        /* different offsets, so small payloads are not always at the same address */
+        sink ^= crc16_ccitt(&data[(i * 64) % (DATA_SIZE - size)], size, sink);
+    }
+    return (double)size * (double)count / (now_s() - start) / 1e6;
+}
+
+int
+main(int argc, char* argv[]) {
+    static const size_t sizes[] = {4, 8, 16, 64, 256, 1024, 4096, 65536, 1 << 19};
+    double mb = argc > 1 ? atof(argv[1]) : 200;
+    uint8_t* data = malloc(DATA_SIZE);
+    double results[IMPLS][sizeof(sizes) / sizeof(sizes[0])];
+    bool_t supported[IMPLS];
+    unsigned errors = 0;
+
+    if (data == NULL || mb <= 0) {
+        fprintf(stderr, "Usage: %s [<megabytes per measurement>]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    srand(1);
+    for (size_t i = 0; i < DATA_SIZE; i++) {
+        data[i] = (uint8_t)rand();
+    }
+
+    CO_crc16Linux_select(CO_CRC16_IMPL_AUTO);
+    fprintf(stderr, "CRC16-CCITT, automatically selected: %s, %.0f MB per measurement\n", CO_crc16Linux_name(), mb);
+    for (size_t i = 0; i < IMPLS; i++) {
+        supported[i] = CO_crc16Linux_select(impls[i].impl);
+        if (!supported[i]) {
+            fprintf(stderr, "%-8s not supported\n", impls[i].name);
+            continue;
+        }
+        unsigned err = verify(data);
+        fprintf(stderr, "%-8s %s (%s)\n", impls[i].name, err == 0 ? "bit-exact with reference" : "FAILED",
+                CO_crc16Linux_name());
+        errors += err;
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            results[i][s] = throughput(data, sizes[s], mb);
+        }
+    }
+
+    fprintf(stderr, "\n%8s", "bytes");
+    for (size_t i = 0; i < IMPLS; i++) {
+        fprintf(stderr, " %9s[MB/s]", impls[i].name);
+    }
+    fprintf(stderr, "\n");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        fprintf(stderr, "%8zu", sizes[s]);
+        for (size_t i = 0; i < IMPLS; i++) {
+            if (supported[i]) {
+                fprintf(stderr, " %15.1f", results[i][s]);
+            } else {
+                fprintf(stderr, " %15s", "-");
+            }
+        }
+        fprintf(stderr, "\n");
+    }
+
+    CO_crc16Linux_select(CO_CRC16_IMPL_AUTO);
+    free(data);
+    return errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,583 @@
+/*
+ * End-to-end SDO and PDO latency benchmark for two canopend nodes on virtual CAN.
+ *
+ * @file        e2ebench.c
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <signal.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+
+#include "libcocomm.h"
+
+#ifndef CMD_SIZE
+#define CMD_SIZE 2000
+#endif
+/* Socket receive buffer size, so frames of block transfers are not lost between two commands */
+#ifndef CAN_RCVBUF
+#define CAN_RCVBUF (4 * 1024 * 1024)
+#endif
+/* Time to wait for echoed TPDO */
+#define PDO_TIMEOUT_MS 100
+
+#define COB_SYNC  0x080
+#define COB_TPDO1 0x180
+#define COB_RPDO1 0x200
+#define COB_SDO_S 0x580 /* server response */
+#define COB_SDO_C 0x600 /* client request */
+
+/* Latencies of one test, in microseconds */
+typedef struct {
+    uint32_t* lat;
+    size_t count;
+    size_t size;
+} latencies_t;
+
+/* Result of one test */
+typedef struct {
+    const char* name;
+    const char* protocol; /* SDO protocol, detected from CAN frames */
+    unsigned long count;
+    unsigned long errors;
+    unsigned long long bytes;
+    double duration_s;
+    latencies_t gtw; /* command sent to reply received on the gateway */
+    latencies_t can; /* first request frame to last response frame on CAN */
+} result_t;
+
+/* configuration */
+static char* socketPath = "/tmp/CO_command_socket";
+static char* hostname = NULL;
+static char* tcpPort = "60000";
+static char* canDevice = "vcan0";
+static int node = 2;
+static long repetitions = 1000;
+static char* label = "";
+static char* outPath = NULL;
+static unsigned segIndex = 0x1008, segSub = 0;
+static int segWrite = 0;
+static unsigned pdoIndex = 0, pdoSub = 0, pdoBits = 0;
+
+static cocomm_conn_t* conn;
+static int canFd = -1;
+static FILE* outFile = NULL;
+
+static void
+printUsage(char* progName) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "\n"
+            "Program measures end-to-end latency between canopend commander with command\n"
+            "interface and canopend server node on the same (virtual) CAN network:\n"
+            "  - SDO expedited, segmented and block transfer: round trip time through the\n"
+            "    gateway and on CAN (first request to last response frame), throughput.\n"
+            "  - PDO echo: RPDO1 and SYNC are sent to the server, which maps the same\n"
+            "    object to TPDO1. Latency is from SYNC to TPDO with received value.\n"
+            "Results are printed as table and appended to <file> as JSON lines.\n"
+            "\n"
+            "Options:\n"
+            "  -s <socket path>  Path to the unix socket. Default is '/tmp/CO_command_socket'.\n"
+            "  -t <host>         Connect via tcp to remote <host>. Unix socket is used by default.\n"
+            "  -p <port>         Tcp port to connect to when using -t. Default is 60000.\n"
+            "  -c <can device>   CAN device for capture and PDO frames. Default is 'vcan0'.\n"
+            "  -n <node>         Node-ID of the server node. Default is 2.\n"
+            "  -r <count>        Repetitions of each test. Default is 1000.\n"
+            "  -S <index>:<sub>  Object for segmented and block transfer. Default is\n"
+            "                    '0x1008:0'. Block protocol is used by the server only for\n"
+            "                    objects larger than protocol switch threshold.\n"
+            "  -w                Also write the data of -S object back (must be writable).\n"
+            "  -m <idx>:<sub>:<bits>  Object mapped to RPDO1 and TPDO1 of the server for\n"
+            "                    PDO echo, for example '0x2110:1:32'. It must be RPDO and\n"
+            "                    TPDO mappable. PDO echo is skipped without this option.\n"
+            "  -l <label>        Build label written to results, for example 'rt-thread'.\n"
+            "  -o <file>         Append results to <file> as JSON lines.\n"
+            "  --help            Display this help.\n"
+            "\n"
+            "See also: https://github.com/CANopenNode/CANopenLinux\n"
+            "\n",
+            progName);
+}
+
+static uint64_t
+now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static int64_t
+diff_us(const struct timespec* a, const struct timespec* b) {
+    return ((int64_t)b->tv_sec - a->tv_sec) * 1000000 + ((int64_t)b->tv_nsec - a->tv_nsec) / 1000;
+}
+
+static void
+addLatency(latencies_t* st, int64_t lat) {
+    if (st->count >= st->size) {
+        size_t size = st->size > 0 ? st->size * 2 : 4096;
+        uint32_t* p = realloc(st->lat, size * sizeof(uint32_t));
+        if (p == NULL) {
+            perror("latencies realloc");
+            exit(EXIT_FAILURE);
+        }
+        st->lat = p;
+        st->size = size;
+    }
+    st->lat[st->count++] = lat < 0 ? 0 : (uint32_t)lat;
+}
+
+static int
+compareU32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static uint32_t
+percentile(const latencies_t* st, double p) {
+    size_t i = (size_t)(p / 100.0 * (double)(st->count - 1) + 0.5);
+    return st->lat[i];
+}
+
+/* open raw CAN socket with kernel timestamps, receive SDO frames of the node, SYNC and TPDO1 */
+static int
+openCan(void) {
+    struct sockaddr_can addr = {.can_family = AF_CAN};
+    const canid_t mask = CAN_SFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG;
+    struct can_filter filter[4] = {{COB_SDO_C + node, mask},
+                                   {COB_SDO_S + node, mask},
+                                   {COB_SYNC, mask},
+                                   {COB_TPDO1 + node, mask}};
+    int one = 1;
+    int rcvbuf = CAN_RCVBUF;
+
+    addr.can_ifindex = (int)if_nametoindex(canDevice);
+    if (addr.can_ifindex == 0) {
+        fprintf(stderr, "CAN device '%s' not found\n", canDevice);
+        return -1;
+    }
+    canFd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (canFd < 0) {
+        perror("CAN socket");
+        return -1;
+    }
+    /* own frames (RPDO and SYNC) are received too, with transmit timestamp */
+    if (setsockopt(canFd, SOL_CAN_RAW, CAN_RAW_FILTER, filter, sizeof(filter)) < 0
+        || setsockopt(canFd, SOL_CAN_RAW, CAN_RAW_RECV_OWN_MSGS, &one, sizeof(one)) < 0
+        || setsockopt(canFd, SOL_SOCKET, SO_TIMESTAMPNS, &one, sizeof(one)) < 0
+        || setsockopt(canFd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)) < 0
+        || bind(canFd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("CAN socket setup");
+        close(canFd);
+        canFd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+/* receive one frame, wait up to timeout_ms. Return 1 if received, 0 on timeout, -1 on error */
+static int
+recvFrame(int timeout_ms, struct can_frame* frame, struct timespec* ts, int* own) {
+    struct pollfd pfd = {.fd = canFd, .events = POLLIN};
+    char ctrl[CMSG_SPACE(sizeof(struct timespec))];
+    struct iovec iov = {.iov_base = frame, .iov_len = sizeof(*frame)};
+    struct msghdr msg = {.msg_iov = &iov, .msg_iovlen = 1, .msg_control = ctrl, .msg_controllen = sizeof(ctrl)};
+
+    int n = poll(&pfd, 1, timeout_ms);
+    if (n <= 0) {
+        return n;
+    }
+    if (recvmsg(canFd, &msg, 0) < (ssize_t)sizeof(*frame)) {
+        return -1;
+    }
+    *own = (msg.msg_flags & MSG_CONFIRM) != 0;
+    memset(ts, 0, sizeof(*ts));
+    for (struct cmsghdr* c = CMSG_FIRSTHDR(&msg); c != NULL; c = CMSG_NXTHDR(&msg, c)) {
+        if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS) {
+            memcpy(ts, CMSG_DATA(c), sizeof(*ts));
+        }
+    }
+    return 1;
+}
+
+/* drain SDO frames of the last command and return CAN round trip in microseconds (-1 if not seen) */
+static int64_t
+sdoCanRoundTrip(const char** protocol) {
+    struct can_frame frame;
+    struct timespec ts, first = {0, 0}, last = {0, 0};
+    int own, haveFirst = 0, haveLast = 0, initiate = 1;
+    uint8_t request = 0;
+
+    while (recvFrame(0, &frame, &ts, &own) == 1) {
+        canid_t id = frame.can_id & CAN_SFF_MASK;
+        if (id == (canid_t)(COB_SDO_C + node)) {
+            if (!haveFirst) {
+                first = ts;
+                haveFirst = 1;
+                request = frame.data[0];
+            }
+        } else if (id == (canid_t)(COB_SDO_S + node) && haveFirst) {
+            last = ts;
+            haveLast = 1;
+            if (initiate && frame.can_dlc > 0 && protocol != NULL) {
+                /* download protocol is chosen by the client, upload protocol by the server response */
+                uint8_t scs = frame.data[0] >> 5;
+                if (scs == 4) {
+                    *protocol = "abort";
+                } else if ((request >> 5) == 1) {
+                    *protocol = (request & 0x02) != 0 ? "expedited" : "segmented";
+                } else if (scs == 5 || scs == 6) {
+                    *protocol = "block";
+                } else if (scs == 2) {
+                    *protocol = (frame.data[0] & 0x02) != 0 ? "expedited" : "segmented";
+                }
+            }
+            initiate = 0;
+        }
+    }
+    return haveFirst && haveLast ? diff_us(&first, &last) : -1;
+}
+
+/* execute command through the gateway, print error unless quiet. Return status */
+static int
+command(const char* cmd, char** reply, int quiet) {
+    char* r = NULL;
+    int status = cocomm_command(conn, cmd, &r);
+
+    if (status != COCOMM_OK && !quiet) {
+        fprintf(stderr, "'%s': %s\n", cmd, r != NULL ? r : "connection error");
+    }
+    if (reply != NULL) {
+        *reply = r;
+    } else {
+        free(r);
+    }
+    return status;
+}
+
+/* number of data bytes in base64 string */
+static size_t
+base64Bytes(const char* s, size_t len) {
+    while (len > 0 && (s[len - 1] == '=' || s[len - 1] == '\r' || s[len - 1] == '\n')) {
+        len--;
+    }
+    return len * 3 / 4;
+}
+
+/* repeat SDO command and measure it. For reads with domain data, transferred bytes are counted from reply */
+static void
+sdoTest(result_t* res, const char* name, const char* cmd, size_t bytes) {
+    const char* protocol = "unknown";
+
+    memset(res, 0, sizeof(*res));
+    res->name = name;
+    sdoCanRoundTrip(NULL); /* frames of previous commands */
+    uint64_t start = now_us();
+    for (long i = 0; i < repetitions; i++) {
+        char* reply = NULL;
+        uint64_t t = now_us();
+        int status = command(cmd, &reply, res->errors > 0);
+        uint64_t lat = now_us() - t;
+        int64_t canLat = sdoCanRoundTrip(&protocol);
+
+        if (status == COCOMM_OK) {
+            addLatency(&res->gtw, (int64_t)lat);
+            if (canLat >= 0) {
+                addLatency(&res->can, canLat);
+            }
+            res->bytes += bytes > 0 ? bytes : reply != NULL ? base64Bytes(reply, strlen(reply)) : 0;
+            res->count++;
+        } else {
+            res->errors++;
+        }
+        free(reply);
+    }
+    res->duration_s = (double)(now_us() - start) / 1000000.0;
+    res->protocol = protocol;
+}
+
+/* configure RPDO1 and TPDO1 of the server node with the same mapped object, both synchronous */
+static int
+configurePdo(void) {
+    uint32_t map = ((uint32_t)pdoIndex << 16) | (pdoSub << 8) | pdoBits;
+    char cmds[12][CMD_SIZE];
+    int n = 0;
+
+    snprintf(cmds[n++], CMD_SIZE, "%d preop", node);
+    snprintf(cmds[n++], CMD_SIZE, "%d w 0x1400 1 u32 0x%X", node, 0x80000000U + COB_RPDO1 + node);
+    snprintf(cmds[n++], CMD_SIZE, "%d w 0x1400 2 u8 0", node);
+    snprintf(cmds[n++], CMD_SIZE, "%d w 0x1600 0 u8 0", node);
+    snprintf(cmds[n++], CMD_SIZE, "%d w 0x1600 1 u32 0x%08X", node, map);
+    snprintf(cmds[n++], CMD_SIZE, "%d w 0x1600 0 u8 1", node);
+    snprintf(cmds[n++], CMD_SIZE, "%d w 0x1400 1 u32 0x%X", node, COB_RPDO1 + node);
+    snprintf(cmds[n++], CMD_SIZE, "%d w 0x1800 1 u32 0x%X", node, 0x80000000U + COB_TPDO1 + node);
+    snprintf(cmds[n++], CMD_SIZE, "%d w 0x1800 2 u8 1", node);
+    snprintf(cmds[n++], CMD_SIZE, "%d w 0x1A00 0 u8 0", node);
+    snprintf(cmds[n++], CMD_SIZE, "%d w 0x1A00 1 u32 0x%08X", node, map);
+    snprintf(cmds[n++], CMD_SIZE, "%d w 0x1A00 0 u8 1", node);
+    for (int i = 0; i < n; i++) {
+        if (command(cmds[i], NULL, 0) != COCOMM_OK) {
+            return -1;
+        }
+    }
+    /* TPDO is enabled after mapping, then node is started */
+    snprintf(cmds[0], CMD_SIZE, "%d w 0x1800 1 u32 0x%X", node, COB_TPDO1 + node);
+    snprintf(cmds[1], CMD_SIZE, "%d start", node);
+    if (command(cmds[0], NULL, 0) != COCOMM_OK || command(cmds[1], NULL, 0) != COCOMM_OK) {
+        return -1;
+    }
+    usleep(100000);
+    return 0;
+}
+
+static int
+sendFrame(canid_t id, const uint8_t* data, uint8_t dlc) {
+    struct can_frame frame = {.can_id = id, .can_dlc = dlc};
+
+    memcpy(frame.data, data, dlc);
+    return write(canFd, &frame, sizeof(frame)) == (ssize_t)sizeof(frame) ? 0 : -1;
+}
+
+/* RPDO1 with counter value, then SYNC. Server copies RPDO to OD on SYNC and sends TPDO1 with the same value */
+static void
+pdoTest(result_t* res) {
+    uint8_t len = (uint8_t)(pdoBits / 8);
+
+    memset(res, 0, sizeof(*res));
+    res->name = "pdo_echo";
+    res->protocol = "sync";
+    uint64_t start = now_us();
+    for (long i = 0; i < repetitions; i++) {
+        uint8_t data[8] = {0};
+        uint64_t value = (uint64_t)i + 1;
+        struct can_frame frame;
+        struct timespec ts, tSync = {0, 0};
+        int own, haveSync = 0, echoed = 0;
+
+        for (int b = 0; b < len; b++) {
+            data[b] = (uint8_t)(value >> (8 * b));
+        }
+        sdoCanRoundTrip(NULL); /* old frames */
+        if (sendFrame(COB_RPDO1 + node, data, len) < 0 || sendFrame(COB_SYNC, data, 0) < 0) {
+            if (res->errors == 0) {
+                perror("CAN write");
+            }
+            res->errors++;
+            continue;
+        }
+        uint64_t deadline = now_us() + PDO_TIMEOUT_MS * 1000;
+        while (!echoed) {
+            int64_t left = (int64_t)(deadline - now_us());
+            if (left <= 0 || recvFrame((int)(left / 1000) + 1, &frame, &ts, &own) <= 0) {
+                break;
+            }
+            canid_t id = frame.can_id & CAN_SFF_MASK;
+            if (id == COB_SYNC && own) {
+                tSync = ts;
+                haveSync = 1;
+            } else if (id == (canid_t)(COB_TPDO1 + node) && haveSync && frame.can_dlc >= len
+                       && memcmp(frame.data, data, len) == 0) {
+                addLatency(&res->can, diff_us(&tSync, &ts));
+                echoed = 1;
+            }
+        }
+        if (echoed) {
+            res->count++;
+            res->bytes += len;
+        } else {
+            res->errors++;
+        }
+    }
+    res->duration_s = (double)(now_us() - start) / 1000000.0;
+}
+
+static void
+printLatencies(const latencies_t* st) {
+    if (st->count == 0) {
+        printf(" %8s %8s %8s %8s", "-", "-", "-", "-");
+    } else {
+        printf(" %8u %8u %8u %8u", percentile(st, 50), percentile(st, 90), percentile(st, 99), st->lat[st->count - 1]);
+    }
+}
+
+static void
+writeLatencies(const char* name, const latencies_t* st) {
+    if (st->count == 0) {
+        fprintf(outFile, ",\"%s\":null", name);
+    } else {
+        fprintf(outFile, ",\"%s\":{\"p50\":%u,\"p90\":%u,\"p99\":%u,\"max\":%u}", name, percentile(st, 50),
+                percentile(st, 90), percentile(st, 99), st->lat[st->count - 1]);
+    }
+}
+
+static void
+report(result_t* res) {
+    qsort(res->gtw.lat, res->gtw.count, sizeof(uint32_t), compareU32);
+    qsort(res->can.lat, res->can.count, sizeof(uint32_t), compareU32);
+    double ops = res->duration_s > 0 ? (double)res->count / res->duration_s : 0;
+    double bps = res->duration_s > 0 ? (double)res->bytes / res->duration_s : 0;
+
+    printf("%-16s %-9s %7lu %6lu %9.1f %10.0f", res->name, res->protocol, res->count, res->errors, ops, bps);
+    printLatencies(&res->gtw);
+    printLatencies(&res->can);
+    printf("\n");
+
+    if (outFile != NULL) {
+        fprintf(outFile,
+                "{\"build\":\"%s\",\"test\":\"%s\",\"protocol\":\"%s\",\"node\":%d,\"count\":%lu,\"errors\":%lu,"
+                "\"bytes\":%llu,\"duration_s\":%.6f,\"ops_per_s\":%.1f,\"bytes_per_s\":%.0f",
+                label, res->name, res->protocol, node, res->count, res->errors, res->bytes, res->duration_s, ops, bps);
+        writeLatencies("gateway_us", &res->gtw);
+        writeLatencies("can_us", &res->can);
+        fprintf(outFile, "}\n");
+        fflush(outFile);
+    }
+    free(res->gtw.lat);
+    free(res->can.lat);
+}
+
+int
+main(int argc, char* argv[]) {
+    char cmd[CMD_SIZE];
+    char* reply = NULL;
+    result_t res;
+    int opt;
+
+    if (argc >= 2 && strcmp(argv[1], "--help") == 0) {
+        printUsage(argv[0]);
+        exit(EXIT_SUCCESS);
+    }
+    while ((opt = getopt(argc, argv, "s:t:p:c:n:r:S:wm:l:o:")) != -1) {
+        switch (opt) {
+            case 's':
+                hostname = NULL;
+                socketPath = optarg;
+                break;
+            case 't': hostname = optarg; break;
+            case 'p': tcpPort = optarg; break;
+            case 'c': canDevice = optarg; break;
+            case 'n': node = atoi(optarg); break;
+            case 'r': repetitions = atol(optarg); break;
+            case 'S':
+                if (sscanf(optarg, "%i:%i", (int*)&segIndex, (int*)&segSub) != 2) {
+                    fprintf(stderr, "Wrong object '%s'\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'w': segWrite = 1; break;
+            case 'm':
+                if (sscanf(optarg, "%i:%i:%i", (int*)&pdoIndex, (int*)&pdoSub, (int*)&pdoBits) != 3
+                    || (pdoBits != 8 && pdoBits != 16 && pdoBits != 32 && pdoBits != 64)) {
+                    fprintf(stderr, "Wrong mapped object '%s'\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'l': label = optarg; break;
+            case 'o': outPath = optarg; break;
+            default: printUsage(argv[0]); exit(EXIT_FAILURE);
+        }
+    }
+    if (node < 1 || node > 127 || repetitions < 1 || segIndex > 0xFFFF || segSub > 0xFF) {
+        printUsage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    if (signal(SIGPIPE, SIG_IGN) == SIG_ERR) {
+        perror("signal");
+        exit(EXIT_FAILURE);
+    }
+
+    conn = hostname != NULL ? cocomm_connect_tcp(hostname, tcpPort) : cocomm_connect_local(socketPath);
+    if (conn == NULL) {
+        perror("connect to gateway");
+        exit(EXIT_FAILURE);
+    }
+    if (openCan() < 0) {
+        exit(EXIT_FAILURE);
+    }
+    if (outPath != NULL && (outFile = fopen(outPath, "a")) == NULL) {
+        perror(outPath);
+        exit(EXIT_FAILURE);
+    }
+
+    /* value for expedited write is read first, so the server is not changed */
+    snprintf(cmd, sizeof(cmd), "%d r 0x1017 0 u16", node);
+    if (command(cmd, &reply, 0) != COCOMM_OK) {
+        exit(EXIT_FAILURE);
+    }
+    unsigned long hbTime = strtoul(reply, NULL, 0);
+    free(reply);
+
+    printf("node %d on %s, %ld repetitions%s%s\n", node, canDevice, repetitions, label[0] != '\0' ? ", " : "", label);
+    printf("%-16s %-9s %7s %6s %9s %10s %8s %8s %8s %8s %8s %8s %8s %8s\n", "test", "protocol", "count", "errors",
+           "ops/s", "bytes/s", "gtw p50", "p90", "p99", "max[us]", "can p50", "p90", "p99", "max[us]");
+
+    sdoTest(&res, "sdo_exp_read", cmd, 2);
+    report(&res);
+    snprintf(cmd, sizeof(cmd), "%d w 0x1017 0 u16 %lu", node, hbTime);
+    sdoTest(&res, "sdo_exp_write", cmd, 2);
+    report(&res);
+
+    /* segmented and block transfer of the same object, data base64 encoded by the gateway */
+    for (int block = 0; block <= 1; block++) {
+        snprintf(cmd, sizeof(cmd), "set sdo_block %d", block);
+        if (command(cmd, NULL, 0) != COCOMM_OK) {
+            exit(EXIT_FAILURE);
+        }
+        snprintf(cmd, sizeof(cmd), "%d r 0x%04X %u d", node, segIndex, segSub);
+        if (command(cmd, &reply, 0) != COCOMM_OK) {
+            exit(EXIT_FAILURE);
+        }
+        size_t len = strlen(reply);
+        sdoTest(&res, block ? "sdo_block_read" : "sdo_seg_read", cmd, 0);
+        report(&res);
+        if (segWrite) {
+            char* wcmd = malloc(len + 64);
+            if (wcmd == NULL) {
+                perror("malloc");
+                exit(EXIT_FAILURE);
+            }
+            sprintf(wcmd, "%d w 0x%04X %u d %s", node, segIndex, segSub, reply);
+            sdoTest(&res, block ? "sdo_block_write" : "sdo_seg_write", wcmd, base64Bytes(reply, len));
+            report(&res);
+            free(wcmd);
+        }
+        free(reply);
+    }
+    command("set sdo_block 0", NULL, 0);
+
+    if (pdoBits == 0) {
+        printf("pdo_echo         skipped, no mapped object (-m)\n");
+    } else if (configurePdo() < 0) {
+        fprintf(stderr, "PDO configuration of node %d failed\n", node);
+        exit(EXIT_FAILURE);
+    } else {
+        pdoTest(&res);
+        report(&res);
+    }
+
+    if (outFile != NULL) {
+        fclose(outFile);
+    }
+    close(canFd);
+    cocomm_close(conn);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,333 @@
+/*
+ * Failover time of canopend hot standby, measured on the CAN bus.
+ *
+ * @file        failoverbench.c
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <signal.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+
+#define COB_SDO_S 0x580 /* server response */
+#define COB_SDO_C 0x600 /* client request */
+#define COB_HB    0x700 /* heartbeat and boot-up */
+/* Heartbeat producer time written to the node */
+#define HB_TIME_MS 100
+/* Time to watch for responses of the fenced instance after SIGCONT */
+#define FENCE_WATCH_MS 500
+
+/* configuration */
+static char* canDevice = "vcan0";
+static int node = 2;
+static long interval_us = 1000;
+static long warmup_ms = 1000;
+static long timeout_ms = 5000;
+static pid_t killPid = 0;
+static int stopActive = 0;
+static char* label = "";
+static char* outPath = NULL;
+
+static int canFd = -1;
+
+static void
+printUsage(char* progName) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "\n"
+            "Program measures failover time of canopend hot standby (option -H). It sends\n"
+            "SDO expedited upload of 0x1017 to the node every <interval> on raw CAN socket\n"
+            "and records the responses. After warm-up it kills the active canopend with\n"
+            "SIGKILL and measures the time until standby responds again. Requests without\n"
+            "response, boot-up messages and NMT state from heartbeat before and after the\n"
+            "take over are reported. Heartbeat producer time 0x1017 is first written to\n"
+            "100 ms, so the value read after take over also shows, that OD writes are\n"
+            "replicated.\n"
+            "\n"
+            "With -s the active canopend is stopped with SIGSTOP instead, like a hung\n"
+            "process. Standby takes over after the replication timeout and heartbeat\n"
+            "silence. Then the stopped process is continued with SIGCONT, it must fence\n"
+            "itself: responses to a request from both instances are reported.\n"
+            "\n"
+            "Options:\n"
+            "  -c <can device>   CAN device. Default is 'vcan0'.\n"
+            "  -n <node>         Node-ID of the canopend pair. Default is 2.\n"
+            "  -k <pid>          Process ID of the active canopend. Without it only the\n"
+            "                    responses are watched until timeout, for manual kill.\n"
+            "  -s                Stop the active canopend (SIGSTOP) instead of kill.\n"
+            "  -p <us>           Request interval in microseconds. Default is 1000.\n"
+            "  -w <ms>           Warm-up time before kill. Default is 1000.\n"
+            "  -t <ms>           Timeout for the first response after kill. Default is 5000.\n"
+            "  -l <label>        Label written to results.\n"
+            "  -o <file>         Append results to <file> as JSON lines.\n"
+            "  --help            Display this help.\n"
+            "\n"
+            "See also: https://github.com/CANopenNode/CANopenLinux\n"
+            "\n",
+            progName);
+}
+
+static uint64_t
+now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+/* open raw CAN socket, receive SDO responses and heartbeats of the node */
+static int
+openCan(void) {
+    struct sockaddr_can addr = {.can_family = AF_CAN};
+    const canid_t mask = CAN_SFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG;
+    struct can_filter filter[2] = {{COB_SDO_S + node, mask}, {COB_HB + node, mask}};
+
+    addr.can_ifindex = (int)if_nametoindex(canDevice);
+    if (addr.can_ifindex == 0) {
+        fprintf(stderr, "CAN device '%s' not found\n", canDevice);
+        return -1;
+    }
+    canFd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (canFd < 0) {
+        perror("CAN socket");
+        return -1;
+    }
+    if (setsockopt(canFd, SOL_CAN_RAW, CAN_RAW_FILTER, filter, sizeof(filter)) < 0
+        || bind(canFd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("CAN socket setup");
+        close(canFd);
+        canFd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+static const char*
+nmtName(int state) {
+    switch (state) {
+        case -1: return "none";
+        case 0: return "boot-up";
+        case 4: return "stopped";
+        case 5: return "operational";
+        case 127: return "pre-operational";
+        default: return "unknown";
+    }
+}
+
+int
+main(int argc, char* argv[]) {
+    static const uint8_t request[8] = {0x40, 0x17, 0x10, 0x00, 0, 0, 0, 0};
+    static const uint8_t download[8] = {0x2B, 0x17, 0x10, 0x00, HB_TIME_MS & 0xFF, HB_TIME_MS >> 8, 0, 0};
+    struct can_frame frame = {.can_id = COB_SDO_C + node, .can_dlc = 8};
+    unsigned long requests = 0, responses = 0, lost = 0, lostAfterKill = 0, bootups = 0, wrongValue = 0;
+    unsigned long duplicates = 0;
+    int nmtBefore = -1, nmtAfter = -1;
+    uint64_t start, killTime = 0, lastResponse = 0, firstAfter = 0;
+    int answered = 1, opt;
+
+    if (argc >= 2 && strcmp(argv[1], "--help") == 0) {
+        printUsage(argv[0]);
+        exit(EXIT_SUCCESS);
+    }
+    while ((opt = getopt(argc, argv, "c:n:k:sp:w:t:l:o:")) != -1) {
+        switch (opt) {
+            case 'c': canDevice = optarg; break;
+            case 'n': node = atoi(optarg); break;
+            case 'k': killPid = (pid_t)atol(optarg); break;
+            case 's': stopActive = 1; break;
+            case 'p': interval_us = atol(optarg); break;
+            case 'w': warmup_ms = atol(optarg); break;
+            case 't': timeout_ms = atol(optarg); break;
+            case 'l': label = optarg; break;
+            case 'o': outPath = optarg; break;
+            default: printUsage(argv[0]); exit(EXIT_FAILURE);
+        }
+    }
+    if (node < 1 || node > 127 || interval_us < 100 || warmup_ms < 0 || timeout_ms < 1) {
+        printUsage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    if (openCan() < 0) {
+        exit(EXIT_FAILURE);
+    }
+    frame.can_id = COB_SDO_C + node;
+    memcpy(frame.data, download, sizeof(download));
+    if (write(canFd, &frame, sizeof(frame)) != sizeof(frame)) {
+        perror("CAN write");
+        exit(EXIT_FAILURE);
+    }
+    usleep(10000);
+    memcpy(frame.data, request, sizeof(request));
+
+    start = now_us();
+    for (uint64_t next = start; firstAfter == 0;) {
+        uint64_t now = now_us();
+
+        if (killTime == 0 && now - start >= (uint64_t)warmup_ms * 1000) {
+            if (responses == 0) {
+                fprintf(stderr, "No response from node %d during warm-up\n", node);
+                exit(EXIT_FAILURE);
+            }
+            if (killPid > 0 && kill(killPid, stopActive ? SIGSTOP : SIGKILL) < 0) {
+                perror("kill");
+                exit(EXIT_FAILURE);
+            }
+            killTime = now_us();
+        }
+        if (killTime != 0 && now - killTime >= (uint64_t)timeout_ms * 1000) {
+            break;
+        }
+
+        /* next request, previous one was lost if it has no response till now */
+        if (now >= next) {
+            if (!answered) {
+                lost++;
+                if (killTime != 0) {
+                    lostAfterKill++;
+                }
+            }
+            if (write(canFd, &frame, sizeof(frame)) != sizeof(frame)) {
+                perror("CAN write");
+                exit(EXIT_FAILURE);
+            }
+            requests++;
+            answered = 0;
+            next += (uint64_t)interval_us;
+            if (next < now) {
+                next = now + (uint64_t)interval_us;
+            }
+            continue;
+        }
+
+        struct pollfd pfd = {.fd = canFd, .events = POLLIN};
+        if (poll(&pfd, 1, (int)((next - now + 999) / 1000)) <= 0) {
+            continue;
+        }
+        struct can_frame rx;
+        if (read(canFd, &rx, sizeof(rx)) != sizeof(rx)) {
+            continue;
+        }
+        now = now_us();
+        if (rx.can_id == (canid_t)(COB_HB + node) && rx.can_dlc >= 1) {
+            int state = rx.data[0] & 0x7F;
+            if (killTime == 0) {
+                nmtBefore = state;
+            } else {
+                nmtAfter = state;
+                if (state == 0) {
+                    bootups++;
+                }
+            }
+        } else if (rx.can_id == (canid_t)(COB_SDO_S + node) && rx.can_dlc == 8 && rx.data[0] == 0x4B
+                   && rx.data[1] == 0x17 && rx.data[2] == 0x10 && rx.data[3] == 0x00) {
+            responses++;
+            answered = 1;
+            if ((rx.data[4] | (rx.data[5] << 8)) != HB_TIME_MS) {
+                wrongValue++;
+            }
+            if (killTime == 0) {
+                lastResponse = now;
+            } else if (now > killTime + interval_us / 2) {
+                /* response from the new active instance (earlier ones may still come from the killed one) */
+                firstAfter = now;
+            }
+        }
+    }
+
+    /* wait for one heartbeat of the new active instance */
+    for (uint64_t hbEnd = now_us() + 2000000; firstAfter != 0 && nmtAfter < 0 && now_us() < hbEnd;) {
+        struct pollfd pfd = {.fd = canFd, .events = POLLIN};
+        struct can_frame rx;
+        if (poll(&pfd, 1, 100) > 0 && read(canFd, &rx, sizeof(rx)) == sizeof(rx)
+            && rx.can_id == (canid_t)(COB_HB + node) && rx.can_dlc >= 1) {
+            nmtAfter = rx.data[0] & 0x7F;
+            if (nmtAfter == 0) {
+                bootups++;
+            }
+        }
+    }
+
+    /* stopped active instance continues, it must find out, that it was replaced, and end without any response */
+    if (stopActive && killPid > 0 && firstAfter != 0) {
+        int answers = 0;
+        if (kill(killPid, SIGCONT) < 0) {
+            perror("kill");
+            exit(EXIT_FAILURE);
+        }
+        for (uint64_t end = now_us() + FENCE_WATCH_MS * 1000, next = 0; now_us() < end;) {
+            uint64_t now = now_us();
+            struct can_frame rx;
+            if (now >= next) {
+                if (write(canFd, &frame, sizeof(frame)) != sizeof(frame)) {
+                    perror("CAN write");
+                    exit(EXIT_FAILURE);
+                }
+                answers = 0;
+                next = now + (uint64_t)interval_us;
+                continue;
+            }
+            struct pollfd pfd = {.fd = canFd, .events = POLLIN};
+            if (poll(&pfd, 1, (int)((next - now + 999) / 1000)) > 0 && read(canFd, &rx, sizeof(rx)) == sizeof(rx)
+                && rx.can_id == (canid_t)(COB_SDO_S + node) && rx.can_dlc == 8 && rx.data[0] == 0x4B
+                && rx.data[1] == 0x17 && rx.data[2] == 0x10 && rx.data[3] == 0x00 && ++answers > 1) {
+                duplicates++;
+            }
+        }
+    }
+
+    double fromKill_ms = firstAfter != 0 ? (double)(firstAfter - killTime) / 1000.0 : -1.0;
+    double gap_ms = firstAfter != 0 ? (double)(firstAfter - lastResponse) / 1000.0 : -1.0;
+    fprintf(stderr, "node %d on %s, request interval %ld us\n", node, canDevice, interval_us);
+    if (firstAfter == 0) {
+        fprintf(stderr, "NO RESPONSE within %ld ms after kill\n", timeout_ms);
+    } else {
+        fprintf(stderr, "  failover (kill to first response)        %10.3f ms\n", fromKill_ms);
+        fprintf(stderr, "  gap (last response to first response)    %10.3f ms\n", gap_ms);
+    }
+    fprintf(stderr, "  requests %lu, responses %lu, lost %lu (%lu after kill)\n", requests, responses, lost,
+            lostAfterKill);
+    fprintf(stderr, "  boot-up messages %lu, NMT state before %s, after %s\n", bootups, nmtName(nmtBefore),
+            nmtName(nmtAfter));
+    fprintf(stderr, "  responses with wrong 0x1017 value %lu\n", wrongValue);
+    if (stopActive) {
+        fprintf(stderr, "  responses from both instances after SIGCONT %lu\n", duplicates);
+    }
+
+    if (outPath != NULL) {
+        FILE* f = fopen(outPath, "a");
+        if (f == NULL) {
+            perror(outPath);
+            exit(EXIT_FAILURE);
+        }
+        fprintf(f,
+                "{\"label\":\"%s\",\"node\":%d,\"interval_us\":%ld,\"failover_ms\":%.3f,\"gap_ms\":%.3f,"
+                "\"requests\":%lu,\"lost\":%lu,\"bootups\":%lu,\"nmt_before\":%d,\"nmt_after\":%d,"
+                "\"wrong_value\":%lu,\"stopped\":%d,\"duplicates\":%lu}\n",
+                label, node, interval_us, fromKill_ms, gap_ms, requests, lostAfterKill, bootups, nmtBefore,
+                nmtAfter, wrongValue, stopActive, duplicates);
+        fclose(f);
+    }
+    close(canFd);
+    return firstAfter != 0 && bootups == 0 && nmtBefore == nmtAfter && wrongValue == 0 && duplicates == 0
+               ? EXIT_SUCCESS
+               : EXIT_FAILURE;
+}
@@ -0,0 +1,428 @@
+/*
+ * Throughput and latency benchmark for CANopenNode ASCII command interface.
+ *
+ * @file        gtwbench.c
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <netdb.h>
+#include <limits.h>
+#include <time.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#ifndef BUF_SIZE
+#define BUF_SIZE 1000
+#endif
+#define CLIENTS_MAX 64
+#define NODES_MAX   127
+
+/* Types of benchmark commands */
+enum { CMD_READ, CMD_WRITE, CMD_NMT, CMD_COUNT };
+static const char* cmdName[CMD_COUNT] = {"read", "write", "nmt"};
+
+/* Latencies of one command type, in microseconds */
+typedef struct {
+    uint32_t* lat;
+    size_t count;
+    size_t size;
+    unsigned long errors;
+} latencies_t;
+
+/* Benchmark client, one thread and one connection each */
+typedef struct {
+    int id;
+    pthread_t thread;
+    int fd;
+    unsigned long long rnd;
+    latencies_t stat[CMD_COUNT];
+    int failed;
+} client_t;
+
+/* configuration, shared by all clients */
+static char* socketPath = "/tmp/CO_command_socket";
+static char hostname[HOST_NAME_MAX];
+static char tcpPort[20] = "60000";
+static int useTcp = 0;
+static unsigned mix[CMD_COUNT] = {70, 20, 10};
+static uint8_t nodes[NODES_MAX];
+static int nodeCount = 0;
+static char* cmdRead = "r 0x1017 0 u16";
+static char* cmdWrite = "w 0x1017 0 u16 1000";
+static char* cmdNmt = "start";
+static long commandsPerClient = 0;
+static volatile int stop = 0;
+
+static void
+printUsage(char* progName) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "\n"
+            "Program opens <clients> connections to canopend command interface and sends\n"
+            "a mix of SDO read, SDO write and NMT commands to remote nodes. Each client\n"
+            "waits for the response before sending the next command. At the end number of\n"
+            "commands per second and latency percentiles are printed for each command type.\n"
+            "\n"
+            "Options:\n"
+            "  -s <socket path>  Path to the unix socket. Default is '/tmp/CO_command_socket'.\n"
+            "  -t <host>         Connect via tcp to remote <host>. Unix socket is used by default.\n"
+            "  -p <port>         Tcp port to connect to when using -t. Default is 60000.\n"
+            "  -c <clients>      Number of concurrent clients (1 .. %d). Default is 1.\n"
+            "  -d <seconds>      Duration of the benchmark. Default is 10.\n"
+            "  -N <count>        Send <count> commands per client, then exit (instead of -d).\n"
+            "  -m <r>,<w>,<n>    Relative weights of read, write and NMT commands.\n"
+            "                    Default is '70,20,10'.\n"
+            "  -n <nodes>        Remote nodes, list and ranges, for example '2,5,10-20'.\n"
+            "                    Commands are distributed among them. Default is '2'.\n"
+            "  -R <command>      Read command without node. Default is 'r 0x1017 0 u16'.\n"
+            "  -W <command>      Write command without node. Default is 'w 0x1017 0 u16 1000'.\n"
+            "  -M <command>      NMT command without node. Default is 'start'.\n"
+            "  --help            Display this help.\n"
+            "\n"
+            "See also: https://github.com/CANopenNode/CANopenLinux\n"
+            "\n",
+            progName, CLIENTS_MAX);
+}
+
+/* parse list of nodes, for example "2,5,10-20" */
+static int
+parseNodes(const char* str) {
+    const char* c = str;
+
+    nodeCount = 0;
+    while (*c != '\0') {
+        char* end;
+        long first = strtol(c, &end, 0);
+        long last = first;
+        if (end == c) {
+            return -1;
+        }
+        if (*end == '-') {
+            c = end + 1;
+            last = strtol(c, &end, 0);
+            if (end == c) {
+                return -1;
+            }
+        }
+        if (first < 1 || last > NODES_MAX || first > last) {
+            return -1;
+        }
+        for (long n = first; n <= last && nodeCount < NODES_MAX; n++) {
+            nodes[nodeCount++] = (uint8_t)n;
+        }
+        if (*end == ',') {
+            end++;
+        } else if (*end != '\0') {
+            return -1;
+        }
+        c = end;
+    }
+    return nodeCount > 0 ? 0 : -1;
+}
+
+static uint64_t
+now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+/* simple pseudo random generator, so command sequence is repeatable */
+static uint32_t
+nextRandom(client_t* cl) {
+    cl->rnd = cl->rnd * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (uint32_t)(cl->rnd >> 33);
+}
+
+static int
+addLatency(latencies_t* st, uint32_t lat) {
+    if (st->count >= st->size) {
+        size_t size = st->size > 0 ? st->size * 2 : 4096;
+        uint32_t* p = realloc(st->lat, size * sizeof(uint32_t));
+        if (p == NULL) {
+            return -1;
+        }
+        st->lat = p;
+        st->size = size;
+    }
+    st->lat[st->count++] = lat;
+    return 0;
+}
+
+static int
+connectGateway(void) {
+    int fd = -1;
+
+    if (useTcp) {
+        struct addrinfo hints, *res, *rp;
+
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        if (getaddrinfo(hostname, tcpPort, &hints, &res) != 0) {
+            fprintf(stderr, "Error! Getaddrinfo for host %s failed\n", hostname);
+            return -1;
+        }
+        for (rp = res; rp != NULL; rp = rp->ai_next) {
+            fd = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
+            if (fd == -1) {
+                continue;
+            }
+            if (connect(fd, rp->ai_addr, rp->ai_addrlen) != -1) {
+                break; /* Success */
+            }
+            close(fd);
+            fd = -1;
+        }
+        freeaddrinfo(res);
+    } else {
+        struct sockaddr_un addr_un;
+
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd == -1) {
+            perror("Socket creation failed");
+            return -1;
+        }
+        memset(&addr_un, 0, sizeof(struct sockaddr_un));
+        addr_un.sun_family = AF_UNIX;
+        strncpy(addr_un.sun_path, socketPath, sizeof(addr_un.sun_path) - 1);
+        if (connect(fd, (struct sockaddr*)&addr_un, sizeof(struct sockaddr_un)) == -1) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    if (fd < 0) {
+        perror("Socket connection failed");
+    }
+    return fd;
+}
+
+/* send one command and wait for the response line. Return 1 on error response, -1 on connection error */
+static int
+transfer(client_t* cl, unsigned long seq, int type, uint32_t* lat) {
+    char buf[BUF_SIZE + 1];
+    const char* cmd = type == CMD_READ ? cmdRead : type == CMD_WRITE ? cmdWrite : cmdNmt;
+    int node = nodes[nextRandom(cl) % (uint32_t)nodeCount];
+    int len = snprintf(buf, sizeof(buf), "[%lu] %d %s\n", seq, node, cmd);
+    size_t count = 0;
+    uint64_t start = now_us();
+
+    if (len <= 0 || len >= (int)sizeof(buf) || write(cl->fd, buf, (size_t)len) != len) {
+        perror("Socket write failed");
+        return -1;
+    }
+
+    /* responses of benchmark commands are single line */
+    for (;;) {
+        ssize_t nRead = read(cl->fd, &buf[count], BUF_SIZE - count);
+        if (nRead <= 0) {
+            fprintf(stderr, "client %d: connection closed\n", cl->id);
+            return -1;
+        }
+        count += (size_t)nRead;
+        buf[count] = '\0';
+        if (memchr(buf, '\n', count) != NULL) {
+            break;
+        }
+        if (count >= BUF_SIZE) {
+            count = 0; /* long response, keep only the tail */
+        }
+    }
+    *lat = (uint32_t)(now_us() - start);
+
+    return strstr(buf, "] ERROR:") != NULL ? 1 : 0;
+}
+
+static void*
+clientThread(void* arg) {
+    client_t* cl = (client_t*)arg;
+    unsigned mixTotal = mix[CMD_READ] + mix[CMD_WRITE] + mix[CMD_NMT];
+
+    for (unsigned long seq = 1; !stop && (commandsPerClient == 0 || (long)seq <= commandsPerClient); seq++) {
+        uint32_t r = nextRandom(cl) % mixTotal;
+        int type = r < mix[CMD_READ] ? CMD_READ : r < mix[CMD_READ] + mix[CMD_WRITE] ? CMD_WRITE : CMD_NMT;
+        uint32_t lat;
+        int ret = transfer(cl, seq, type, &lat);
+
+        if (ret < 0) {
+            cl->failed = 1;
+            break;
+        }
+        if (ret > 0) {
+            cl->stat[type].errors++;
+        }
+        if (addLatency(&cl->stat[type], lat) < 0) {
+            perror("latencies realloc");
+            cl->failed = 1;
+            break;
+        }
+    }
+    return NULL;
+}
+
+static int
+compareU32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static uint32_t
+percentile(const latencies_t* st, double p) {
+    size_t i = (size_t)(p / 100.0 * (double)(st->count - 1) + 0.5);
+    return st->lat[i];
+}
+
+static void
+printStat(const char* name, latencies_t* st, double duration_s) {
+    if (st->count == 0) {
+        return;
+    }
+    qsort(st->lat, st->count, sizeof(uint32_t), compareU32);
+    printf("%-6s %9zu %9lu %10.1f %8u %8u %8u %8u %8u\n", name, st->count, st->errors, (double)st->count / duration_s,
+           percentile(st, 50), percentile(st, 90), percentile(st, 99), percentile(st, 99.9), st->lat[st->count - 1]);
+}
+
+static void
+sigHandler(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+int
+main(int argc, char* argv[]) {
+    static client_t clients[CLIENTS_MAX];
+    int clientCount = 1;
+    long duration_s = 10;
+    int opt;
+    int ret = EXIT_SUCCESS;
+
+    if (argc >= 2 && strcmp(argv[1], "--help") == 0) {
+        printUsage(argv[0]);
+        exit(EXIT_SUCCESS);
+    }
+    parseNodes("2");
+
+    while ((opt = getopt(argc, argv, "s:t:p:c:d:N:m:n:R:W:M:")) != -1) {
+        switch (opt) {
+            case 's':
+                useTcp = 0;
+                socketPath = optarg;
+                break;
+            case 't':
+                useTcp = 1;
+                strncpy(hostname, optarg, sizeof(hostname) - 1);
+                break;
+            case 'p': strncpy(tcpPort, optarg, sizeof(tcpPort) - 1); break;
+            case 'c': clientCount = atoi(optarg); break;
+            case 'd': duration_s = atol(optarg); break;
+            case 'N': commandsPerClient = atol(optarg); break;
+            case 'm':
+                if (sscanf(optarg, "%u,%u,%u", &mix[CMD_READ], &mix[CMD_WRITE], &mix[CMD_NMT]) != 3) {
+                    fprintf(stderr, "Wrong command mix '%s'\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'n':
+                if (parseNodes(optarg) < 0) {
+                    fprintf(stderr, "Wrong node list '%s'\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'R': cmdRead = optarg; break;
+            case 'W': cmdWrite = optarg; break;
+            case 'M': cmdNmt = optarg; break;
+            default: printUsage(argv[0]); exit(EXIT_FAILURE);
+        }
+    }
+    if (clientCount < 1 || clientCount > CLIENTS_MAX || duration_s < 1
+        || mix[CMD_READ] + mix[CMD_WRITE] + mix[CMD_NMT] == 0) {
+        printUsage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (signal(SIGPIPE, SIG_IGN) == SIG_ERR || signal(SIGINT, sigHandler) == SIG_ERR) {
+        perror("signal");
+        exit(EXIT_FAILURE);
+    }
+
+    /* connect all clients before the measurement starts */
+    for (int i = 0; i < clientCount; i++) {
+        clients[i].id = i;
+        clients[i].rnd = (unsigned long long)i + 1;
+        clients[i].fd = connectGateway();
+        if (clients[i].fd < 0) {
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    uint64_t start = now_us();
+    for (int i = 0; i < clientCount; i++) {
+        if (pthread_create(&clients[i].thread, NULL, clientThread, &clients[i]) != 0) {
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (commandsPerClient == 0) {
+        struct timespec ts = {.tv_sec = duration_s, .tv_nsec = 0};
+        while (!stop && nanosleep(&ts, &ts) != 0) {}
+        stop = 1;
+    }
+    for (int i = 0; i < clientCount; i++) {
+        pthread_join(clients[i].thread, NULL);
+        close(clients[i].fd);
+    }
+    double elapsed_s = (double)(now_us() - start) / 1000000.0;
+
+    /* merge latencies of all clients */
+    latencies_t total[CMD_COUNT + 1];
+    memset(total, 0, sizeof(total));
+    for (int i = 0; i < clientCount; i++) {
+        if (clients[i].failed) {
+            ret = EXIT_FAILURE;
+        }
+        for (int t = 0; t < CMD_COUNT; t++) {
+            latencies_t* st = &clients[i].stat[t];
+            for (size_t j = 0; j < st->count; j++) {
+                if (addLatency(&total[t], st->lat[j]) < 0 || addLatency(&total[CMD_COUNT], st->lat[j]) < 0) {
+                    perror("latencies realloc");
+                    exit(EXIT_FAILURE);
+                }
+            }
+            total[t].errors += st->errors;
+            total[CMD_COUNT].errors += st->errors;
+            free(st->lat);
+        }
+    }
+
+    printf("%s %s, %d client(s), %.2f s\n", useTcp ? "tcp" : "local", useTcp ? hostname : socketPath, clientCount,
+           elapsed_s);
+    printf("%-6s %9s %9s %10s %8s %8s %8s %8s %8s\n", "type", "commands", "errors", "cmd/s", "p50[us]", "p90[us]",
+           "p99[us]", "p99.9", "max[us]");
+    for (int t = 0; t < CMD_COUNT; t++) {
+        printStat(cmdName[t], &total[t], elapsed_s);
+    }
+    printStat("all", &total[CMD_COUNT], elapsed_s);
+    for (int t = 0; t <= CMD_COUNT; t++) {
+        free(total[t].lat);
+    }
+
+    return ret;
+}
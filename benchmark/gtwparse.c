@@ -0,0 +1,684 @@
+/*
+ * Parser microbenchmark of the CANopen ASCII command interface (gateway), with a command corpus.
+ *
+ * @file        gtwparse.c
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "CO_asciiLinux.h"
+
+#ifdef GTWPARSE_STACK
+#include "301/CO_fifo.h"
+#include "CO_fifoLinux.h"
+#endif
+
+#define CORPUS_MAX   1000
+#define LINE_MAX_LEN 256
+
+typedef struct {
+    char line[LINE_MAX_LEN];
+    size_t len;
+} corpusLine_t;
+
+/* Result of the pre-parser of one command line, the same for both implementations */
+typedef struct {
+    int batch;      /* 1 if node field is a node-set, -1 on syntax error of the node-set */
+    int nodeCount;  /* number of nodes in the node-set */
+    char list[512]; /* comma separated node list, as in the aggregated response */
+} preparse_t;
+
+static corpusLine_t corpus[CORPUS_MAX];
+static size_t corpusCount;
+
+static double
+now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int
+isNodeSet(const char* tok, size_t len, int table) {
+    if (len >= 3 && strncmp(tok, "all", 3) == 0 && (len == 3 || tok[3] == ':')) {
+        return 1;
+    }
+    if (len == 0 || !(table ? CO_ascii_isDigit(tok[0]) : isdigit((unsigned char)tok[0]))) {
+        return 0;
+    }
+    return memchr(tok, ',', len) != NULL || memchr(tok, '-', len) != NULL;
+}
+
+/* Previous implementation of canopend: isspace(), strspn(), strtoul() and snprintf() */
+static const char*
+tokenLibc(const char* line, size_t len, size_t* pos, size_t* tokLen) {
+    size_t i = *pos;
+    while (i < len && isspace((unsigned char)line[i])) {
+        i++;
+    }
+    size_t start = i;
+    while (i < len && !isspace((unsigned char)line[i])) {
+        i++;
+    }
+    *pos = i;
+    *tokLen = i - start;
+    return &line[start];
+}
+
+static void
+preparseLibc(const char* line, size_t len, preparse_t* r) {
+    size_t pos = 0, tokLen;
+    const char* tok = tokenLibc(line, len, &pos, &tokLen);
+    char selected[128] = {0};
+
+    r->batch = 0;
+    r->nodeCount = 0;
+    r->list[0] = '\0';
+    if (tokLen == 0 || tok[0] != '[') {
+        return;
+    }
+    pos = (size_t)((const char*)memchr(tok, ']', len - (size_t)(tok - line)) - line) + 1;
+    for (int field = 0; field < 2; field++) {
+        tok = tokenLibc(line, len, &pos, &tokLen);
+        if (isNodeSet(tok, tokLen, 0)) {
+            r->batch = 1;
+            break;
+        }
+        if (tokLen == 0 || strspn(tok, "0123456789") != tokLen) {
+            return;
+        }
+    }
+    if (!r->batch || strncmp(tok, "all", 3) == 0) {
+        return;
+    }
+    for (size_t i = 0; i < tokLen;) {
+        char* end;
+        unsigned long first = strtoul(&tok[i], &end, 0), last = first;
+        if (end == &tok[i]) {
+            r->batch = -1;
+            return;
+        }
+        i = (size_t)(end - tok);
+        if (i < tokLen && tok[i] == '-') {
+            i++;
+            last = strtoul(&tok[i], &end, 0);
+            if (end == &tok[i]) {
+                r->batch = -1;
+                return;
+            }
+            i = (size_t)(end - tok);
+        }
+        if (first < 1 || last > 127 || first > last || (i < tokLen && tok[i] != ',')) {
+            r->batch = -1;
+            return;
+        }
+        for (unsigned long n = first; n <= last; n++) {
+            selected[n] = 1;
+        }
+        i++;
+    }
+    int used = 0;
+    for (int n = 1; n <= 127; n++) {
+        if (selected[n]) {
+            used += snprintf(&r->list[used], sizeof(r->list) - (size_t)used, "%s%d", used > 0 ? "," : "", n);
+            r->nodeCount++;
+        }
+    }
+}
+
+/* Implementation of canopend with CO_asciiLinux */
+static void
+preparseTable(const char* line, size_t len, preparse_t* r) {
+    size_t pos = 0, tokLen;
+    const char* tok = CO_ascii_token(line, len, &pos, &tokLen);
+    char selected[128] = {0};
+
+    r->batch = 0;
+    r->nodeCount = 0;
+    r->list[0] = '\0';
+    if (tokLen == 0 || tok[0] != '[') {
+        return;
+    }
+    pos = (size_t)((const char*)memchr(tok, ']', len - (size_t)(tok - line)) - line) + 1;
+    for (int field = 0; field < 2; field++) {
+        tok = CO_ascii_token(line, len, &pos, &tokLen);
+        if (isNodeSet(tok, tokLen, 1)) {
+            r->batch = 1;
+            break;
+        }
+        if (tokLen == 0 || CO_ascii_spanDigits(tok, tokLen) != tokLen) {
+            return;
+        }
+    }
+    if (!r->batch || strncmp(tok, "all", 3) == 0) {
+        return;
+    }
+    for (size_t i = 0; i < tokLen;) {
+        uint32_t first, last;
+        size_t used = CO_ascii_parseU32(&tok[i], tokLen - i, &first);
+        if (used == 0) {
+            r->batch = -1;
+            return;
+        }
+        i += used;
+        last = first;
+        if (i < tokLen && tok[i] == '-') {
+            i++;
+            used = CO_ascii_parseU32(&tok[i], tokLen - i, &last);
+            if (used == 0) {
+                r->batch = -1;
+                return;
+            }
+            i += used;
+        }
+        if (first < 1 || last > 127 || first > last || (i < tokLen && tok[i] != ',')) {
+            r->batch = -1;
+            return;
+        }
+        for (uint32_t n = first; n <= last; n++) {
+            selected[n] = 1;
+        }
+        i++;
+    }
+    size_t used = 0;
+    for (uint32_t n = 1; n <= 127; n++) {
+        if (selected[n]) {
+            if (used > 0) {
+                r->list[used++] = ',';
+            }
+            used += CO_ascii_formatU32(&r->list[used], n);
+            r->nodeCount++;
+        }
+    }
+}
+
+/* Pre-parse the corpus reps times, return commands per second */
+static double
+benchPreparse(void (*preparse)(const char*, size_t, preparse_t*), long reps) {
+    preparse_t r;
+    volatile int sink = 0;
+    double start = now_s();
+
+    for (long k = 0; k < reps; k++) {
+        for (size_t i = 0; i < corpusCount; i++) {
+            preparse(corpus[i].line, corpus[i].len, &r);
+            sink += r.nodeCount;
+        }
+    }
+    return (double)reps * (double)corpusCount / (now_s() - start);
+}
+
+/* Numbers from all tokens of the corpus, which start with a digit */
+static const char* numbers[CORPUS_MAX * 16];
+static size_t numberLens[CORPUS_MAX * 16];
+static size_t numberCount;
+
+static double
+benchParse(int table, long reps) {
+    volatile uint32_t sink = 0;
+    double start = now_s();
+
+    for (long k = 0; k < reps; k++) {
+        for (size_t i = 0; i < numberCount; i++) {
+            if (table) {
+                uint32_t v = 0;
+                CO_ascii_parseU32(numbers[i], numberLens[i], &v);
+                sink += v;
+            } else {
+                sink += (uint32_t)strtoul(numbers[i], NULL, 0);
+            }
+        }
+    }
+    return (double)reps * (double)numberCount / (now_s() - start);
+}
+
+static double
+benchFormat(int table, long reps) {
+    char buf[16];
+    volatile size_t sink = 0;
+    double start = now_s();
+
+    for (long k = 0; k < reps; k++) {
+        for (uint32_t n = 1; n <= 127; n++) {
+            if (table) {
+                sink += CO_ascii_formatU32(buf, n * (uint32_t)k);
+            } else {
+                sink += (size_t)snprintf(buf, sizeof(buf), "%u", n * (uint32_t)k);
+            }
+        }
+    }
+    return (double)reps * 127.0 / (now_s() - start);
+}
+
+#ifdef GTWPARSE_STACK
+/* Tokenize the corpus with CO_fifo_readToken() of CANopenNode, as CO_GTWA_process() does, return commands per second
+ */
+static double
+benchStack(long reps) {
+    uint8_t fifoBuf[LINE_MAX_LEN + 2];
+    CO_fifo_t fifo;
+    char tok[LINE_MAX_LEN];
+    volatile size_t sink = 0;
+    double start = now_s();
+
+    CO_fifo_init(&fifo, fifoBuf, sizeof(fifoBuf));
+    for (long k = 0; k < reps; k++) {
+        for (size_t i = 0; i < corpusCount; i++) {
+            CO_fifo_reset(&fifo);
+            CO_fifo_write(&fifo, (const uint8_t*)corpus[i].line, corpus[i].len, NULL);
+            CO_fifo_write(&fifo, (const uint8_t*)"\n", 1, NULL);
+            for (int t = 0; t < 64; t++) {
+                char closed = -1;
+                bool_t err = false;
+                size_t n = CO_fifo_readToken(&fifo, tok, sizeof(tok), &closed, &err);
+                sink += n;
+                if (n == 0 || err || closed == 1) {
+                    break;
+                }
+            }
+        }
+    }
+    return (double)reps * (double)corpusCount / (now_s() - start);
+}
+
+/* Originals of CO_fifo.c, the __wrap_ functions of CO_fifoLinux.c replace them with -Wl,--wrap=<function> */
+size_t __real_CO_fifo_readU82a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+size_t __real_CO_fifo_readU162a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+size_t __real_CO_fifo_readU322a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+size_t __real_CO_fifo_readU642a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+size_t __real_CO_fifo_readX82a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+size_t __real_CO_fifo_readX162a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+size_t __real_CO_fifo_readX322a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+size_t __real_CO_fifo_readX642a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+size_t __real_CO_fifo_readI82a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+size_t __real_CO_fifo_readI162a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+size_t __real_CO_fifo_readI322a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+size_t __real_CO_fifo_readI642a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+size_t __real_CO_fifo_readHex2a(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+size_t __real_CO_fifo_cpyTok2Hex(CO_fifo_t* dest, CO_fifo_t* src, CO_fifo_st* status);
+
+typedef size_t (*readFn_t)(CO_fifo_t* fifo, char* buf, size_t count, bool_t end);
+typedef size_t (*cpyFn_t)(CO_fifo_t* dest, CO_fifo_t* src, CO_fifo_st* status);
+
+/* Gateway data types with replaced conversions, size 0 is octet string */
+static const struct {
+    const char* name;
+    size_t size;
+    readFn_t orig, table;
+} convTypes[] = {
+    {"u8", 1, __real_CO_fifo_readU82a, __wrap_CO_fifo_readU82a},
+    {"u16", 2, __real_CO_fifo_readU162a, __wrap_CO_fifo_readU162a},
+    {"u32", 4, __real_CO_fifo_readU322a, __wrap_CO_fifo_readU322a},
+    {"u64", 8, __real_CO_fifo_readU642a, __wrap_CO_fifo_readU642a},
+    {"x8", 1, __real_CO_fifo_readX82a, __wrap_CO_fifo_readX82a},
+    {"x16", 2, __real_CO_fifo_readX162a, __wrap_CO_fifo_readX162a},
+    {"x32", 4, __real_CO_fifo_readX322a, __wrap_CO_fifo_readX322a},
+    {"x64", 8, __real_CO_fifo_readX642a, __wrap_CO_fifo_readX642a},
+    {"i8", 1, __real_CO_fifo_readI82a, __wrap_CO_fifo_readI82a},
+    {"i16", 2, __real_CO_fifo_readI162a, __wrap_CO_fifo_readI162a},
+    {"i32", 4, __real_CO_fifo_readI322a, __wrap_CO_fifo_readI322a},
+    {"i64", 8, __real_CO_fifo_readI642a, __wrap_CO_fifo_readI642a},
+    {"os", 0, __real_CO_fifo_readHex2a, __wrap_CO_fifo_readHex2a},
+};
+#define CONV_TYPES (sizeof(convTypes) / sizeof(convTypes[0]))
+#define CONV_OS    (CONV_TYPES - 1)
+
+/* Bytes of an octet string value returned to SDO read commands */
+#define OS_READ_SIZE 32
+
+/* SDO commands of the corpus with replaced conversion: read of all types (value to text), write of octet string
+ * (text to value) */
+typedef struct {
+    size_t type;
+    int write;
+    uint8_t data[OS_READ_SIZE]; /* value returned to read */
+    const char* text;           /* value of write, terminated with newline */
+    size_t textLen;
+} conv_t;
+
+static conv_t convs[CORPUS_MAX];
+static size_t convCount;
+
+static int
+tokenIs(const char* tok, size_t tokLen, const char* str) {
+    return tokLen == strlen(str) && strncmp(tok, str, tokLen) == 0;
+}
+
+/* Find SDO read and write commands with replaced conversion in the corpus */
+static void
+convFind(void) {
+    for (size_t i = 0; i < corpusCount; i++) {
+        const char* line = corpus[i].line;
+        size_t len = corpus[i].len, pos = 0, tokLen;
+        const char* tok;
+        do {
+            tok = CO_ascii_token(line, len, &pos, &tokLen);
+        } while (tokLen > 0 && !tokenIs(tok, tokLen, "r") && !tokenIs(tok, tokLen, "read") && !tokenIs(tok, tokLen, "w")
+                 && !tokenIs(tok, tokLen, "write"));
+        if (tokLen == 0) {
+            continue;
+        }
+        int write = tok[0] == 'w';
+        CO_ascii_token(line, len, &pos, &tokLen); /* index */
+        CO_ascii_token(line, len, &pos, &tokLen); /* subindex */
+        tok = CO_ascii_token(line, len, &pos, &tokLen);
+        for (size_t t = 0; t < CONV_TYPES; t++) {
+            if (!tokenIs(tok, tokLen, convTypes[t].name) || (write && t != CONV_OS)) {
+                continue;
+            }
+            conv_t* c = &convs[convCount++];
+            c->type = t;
+            c->write = write;
+            for (size_t b = 0; b < OS_READ_SIZE; b++) {
+                c->data[b] = (uint8_t)rand();
+            }
+            /* corpus lines are null terminated, newline is added by the benchmark */
+            c->text = &line[pos];
+            c->textLen = len - pos;
+            break;
+        }
+    }
+}
+
+/* Execute the conversions of the corpus reps times, return commands per second */
+static double
+benchConvert(int table, long reps) {
+    uint8_t srcBuf[LINE_MAX_LEN + 2], destBuf[LINE_MAX_LEN + 2];
+    CO_fifo_t src, dest;
+    char resp[LINE_MAX_LEN * 2];
+    volatile size_t sink = 0;
+    cpyFn_t cpy = table ? __wrap_CO_fifo_cpyTok2Hex : __real_CO_fifo_cpyTok2Hex;
+    double start = now_s();
+
+    CO_fifo_init(&src, srcBuf, sizeof(srcBuf));
+    CO_fifo_init(&dest, destBuf, sizeof(destBuf));
+    for (long k = 0; k < reps; k++) {
+        for (size_t i = 0; i < convCount; i++) {
+            const conv_t* c = &convs[i];
+            CO_fifo_reset(&dest);
+            if (c->write) {
+                CO_fifo_st st;
+                CO_fifo_reset(&src);
+                CO_fifo_write(&src, (const uint8_t*)c->text, c->textLen, NULL);
+                CO_fifo_write(&src, (const uint8_t*)"\n", 1, NULL);
+                sink += cpy(&dest, &src, &st);
+            } else {
+                size_t size = convTypes[c->type].size != 0 ? convTypes[c->type].size : OS_READ_SIZE;
+                CO_fifo_write(&dest, c->data, size, NULL);
+                sink += (table ? convTypes[c->type].table : convTypes[c->type].orig)(&dest, resp, sizeof(resp), true);
+            }
+        }
+    }
+    return (double)reps * (double)convCount / (now_s() - start);
+}
+
+/* Encode or decode octet string of size bytes reps times, return MB/s of binary data */
+static double
+benchHex(int table, int decode, size_t size, long reps) {
+    static uint8_t srcBuf[3 * 4096 + 2], destBuf[3 * 4096 + 2];
+    static char text[3 * 4096 + 2];
+    CO_fifo_t src, dest;
+    volatile size_t sink = 0;
+
+    CO_fifo_init(&src, srcBuf, sizeof(srcBuf));
+    CO_fifo_init(&dest, destBuf, sizeof(destBuf));
+    for (size_t b = 0; b < size; b++) {
+        CO_fifo_putc(&dest, (uint8_t)rand());
+    }
+    size_t textLen = __real_CO_fifo_readHex2a(&dest, text, sizeof(text), true);
+    text[textLen++] = '\n';
+
+    double start = now_s();
+    for (long k = 0; k < reps; k++) {
+        CO_fifo_reset(&dest);
+        if (decode) {
+            CO_fifo_st st;
+            CO_fifo_reset(&src);
+            CO_fifo_write(&src, (const uint8_t*)text, textLen, NULL);
+            sink += (table ? __wrap_CO_fifo_cpyTok2Hex : __real_CO_fifo_cpyTok2Hex)(&dest, &src, &st);
+        } else {
+            char* resp = (char*)srcBuf;
+            dest.writePtr = size;
+            sink += (table ? __wrap_CO_fifo_readHex2a : __real_CO_fifo_readHex2a)(&dest, resp, sizeof(srcBuf), true);
+        }
+    }
+    return (double)reps * (double)size / (now_s() - start) / 1e6;
+}
+
+/* Compare CO_fifoLinux with the originals: numbers with edge values, octet strings read in chunks, hex text with
+ * spaces, comments and errors written in chunks into small buffers. Return number of mismatches */
+static unsigned
+verifyConvert(void) {
+    uint8_t bufA[64], bufB[64], srcBufA[64], srcBufB[64];
+    CO_fifo_t a, b, srcA, srcB;
+    char respA[160], respB[160];
+    unsigned errors = 0;
+
+    CO_fifo_init(&a, bufA, sizeof(bufA));
+    CO_fifo_init(&b, bufB, sizeof(bufB));
+    for (size_t t = 0; t < CONV_OS; t++) {
+        size_t size = convTypes[t].size;
+        for (int k = 0; k < 20000; k++) {
+            uint64_t v = ((uint64_t)rand() << 40) ^ ((uint64_t)rand() << 20) ^ (uint64_t)rand();
+            uint64_t sign = (uint64_t)1 << (size * 8 - 1);
+            const uint64_t edge[] = {0, 1, sign - 1, sign, sign + 1, UINT64_MAX};
+            if (k < 6) {
+                v = edge[k];
+            }
+            /* exactly the value and one byte more (hex) */
+            for (size_t extra = 0; extra < 2; extra++) {
+                CO_fifo_reset(&a);
+                CO_fifo_reset(&b);
+                for (size_t i = 0; i < size + extra; i++) {
+                    CO_fifo_putc(&a, (uint8_t)(v >> ((i % 8) * 8)));
+                    CO_fifo_putc(&b, (uint8_t)(v >> ((i % 8) * 8)));
+                }
+                size_t nA = convTypes[t].orig(&a, respA, sizeof(respA), true);
+                size_t nB = convTypes[t].table(&b, respB, sizeof(respB), true);
+                if (nA != nB || memcmp(respA, respB, nA + 1) != 0) {
+                    if (errors++ < 5) {
+                        fprintf(stderr, "  %s 0x%016llX: \"%.*s\", \"%.*s\"\n", convTypes[t].name,
+                                (unsigned long long)v, (int)nA, respA, (int)nB, respB);
+                    }
+                }
+            }
+        }
+    }
+
+    /* octet string read in chunks, as the gateway fills the response buffer */
+    for (int k = 0; k < 20000; k++) {
+        size_t size = (size_t)rand() % 60, count = 4 + (size_t)rand() % 40;
+        CO_fifo_reset(&a);
+        CO_fifo_reset(&b);
+        for (size_t i = 0; i < size; i++) {
+            uint8_t c = (uint8_t)rand();
+            CO_fifo_putc(&a, c);
+            CO_fifo_putc(&b, c);
+        }
+        for (;;) {
+            size_t nA = __real_CO_fifo_readHex2a(&a, respA, count, true);
+            size_t nB = __wrap_CO_fifo_readHex2a(&b, respB, count, true);
+            if (nA != nB || memcmp(respA, respB, nA) != 0) {
+                if (errors++ < 5) {
+                    fprintf(stderr, "  os read %zu bytes by %zu: \"%.*s\", \"%.*s\"\n", size, count, (int)nA, respA,
+                            (int)nB, respB);
+                }
+                break;
+            }
+            if (nA == 0) {
+                break;
+            }
+        }
+    }
+
+    /* hex text written in chunks */
+    static const char alphabet[] = "0123456789abcdefABCDEF     \t#xg\n";
+    CO_fifo_init(&srcA, srcBufA, sizeof(srcBufA));
+    CO_fifo_init(&srcB, srcBufB, sizeof(srcBufB));
+    for (int k = 0; k < 50000; k++) {
+        char text[48];
+        size_t len = 1 + (size_t)rand() % sizeof(text), pos = 0;
+        for (size_t i = 0; i < len; i++) {
+            /* mostly hex digits and spaces */
+            text[i] = alphabet[(size_t)rand() % ((rand() % 8) == 0 ? sizeof(alphabet) - 1 : 27)];
+        }
+        CO_fifo_init(&a, bufA, 2 + (size_t)rand() % 16);
+        CO_fifo_init(&b, bufB, a.bufSize);
+        CO_fifo_reset(&srcA);
+        CO_fifo_reset(&srcB);
+        for (int call = 0; call < 200; call++) {
+            size_t chunk = 1 + (size_t)rand() % 12;
+            if (chunk > len - pos) {
+                chunk = len - pos;
+            }
+            CO_fifo_write(&srcA, (const uint8_t*)&text[pos], chunk, NULL);
+            CO_fifo_write(&srcB, (const uint8_t*)&text[pos], chunk, NULL);
+            pos += chunk;
+            CO_fifo_st stA = 0, stB = 0;
+            size_t nA = __real_CO_fifo_cpyTok2Hex(&a, &srcA, &stA);
+            size_t nB = __wrap_CO_fifo_cpyTok2Hex(&b, &srcB, &stB);
+            size_t rA = CO_fifo_read(&a, (uint8_t*)respA, sizeof(respA), NULL);
+            size_t rB = CO_fifo_read(&b, (uint8_t*)respB, sizeof(respB), NULL);
+            if (nA != nB || stA != stB || rA != rB || memcmp(respA, respB, rA) != 0
+                || CO_fifo_getOccupied(&srcA) != CO_fifo_getOccupied(&srcB)) {
+                if (errors++ < 5) {
+                    fprintf(stderr, "  os write \"%.*s\", call %d: %zu bytes 0x%02X, %zu bytes 0x%02X\n",
+                            (int)len, text, call, nA, (unsigned)stA, nB, (unsigned)stB);
+                }
+                break;
+            }
+            if ((stA & (CO_fifo_st_closed | CO_fifo_st_errMask)) != 0 || (pos == len && nA == 0)) {
+                break;
+            }
+        }
+    }
+
+    return errors;
+}
+#endif
+
+static void
+usage(const char* name) {
+    fprintf(stderr, "Usage: %s [-c <corpus file>] [-r <repetitions>]\n", name);
+    fprintf(stderr, "  -c  Command corpus, one command per line, default gtwparse_corpus.txt\n");
+    fprintf(stderr, "  -r  Repetitions of the corpus, default 200000\n");
+}
+
+int
+main(int argc, char* argv[]) {
+    const char* corpusFile = "gtwparse_corpus.txt";
+    long reps = 200000;
+    int opt, errors = 0, batchCount = 0;
+
+    while ((opt = getopt(argc, argv, "c:r:h")) != -1) {
+        switch (opt) {
+            case 'c': corpusFile = optarg; break;
+            case 'r': reps = atol(optarg); break;
+            default: usage(argv[0]); exit(EXIT_FAILURE);
+        }
+    }
+    FILE* f = fopen(corpusFile, "r");
+    if (f == NULL || reps <= 0) {
+        usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    char line[LINE_MAX_LEN];
+    while (corpusCount < CORPUS_MAX && fgets(line, sizeof(line), f) != NULL) {
+        size_t len = strcspn(line, "\r\n");
+        if (len == 0 || line[0] == '#') {
+            continue;
+        }
+        memcpy(corpus[corpusCount].line, line, len);
+        corpus[corpusCount].line[len] = '\0';
+        corpus[corpusCount].len = len;
+        corpusCount++;
+    }
+    fclose(f);
+    if (corpusCount == 0) {
+        fprintf(stderr, "No commands in %s\n", corpusFile);
+        exit(EXIT_FAILURE);
+    }
+
+    /* both implementations must give the same result */
+    for (size_t i = 0; i < corpusCount; i++) {
+        preparse_t a, b;
+        preparseLibc(corpus[i].line, corpus[i].len, &a);
+        preparseTable(corpus[i].line, corpus[i].len, &b);
+        if (a.batch != b.batch || a.nodeCount != b.nodeCount || strcmp(a.list, b.list) != 0) {
+            fprintf(stderr, "mismatch: \"%s\": %d/%d nodes \"%s\", %d/%d nodes \"%s\"\n", corpus[i].line, a.batch,
+                    a.nodeCount, a.list, b.batch, b.nodeCount, b.list);
+            errors++;
+        }
+        batchCount += a.batch != 0;
+
+        size_t pos = 0, tokLen;
+        for (;;) {
+            const char* tok = CO_ascii_token(corpus[i].line, corpus[i].len, &pos, &tokLen);
+            if (tokLen == 0) {
+                break;
+            }
+            if (CO_ascii_isDigit(tok[0]) && numberCount < sizeof(numbers) / sizeof(numbers[0])) {
+                numbers[numberCount] = tok;
+                numberLens[numberCount++] = tokLen;
+            }
+        }
+    }
+
+    fprintf(stderr, "corpus %s: %zu commands, %d with node-set, %zu numbers, %ld repetitions%s\n", corpusFile,
+            corpusCount, batchCount, numberCount, reps, errors == 0 ? "" : ", RESULTS DIFFER");
+    fprintf(stderr, "%-26s %14s %14s %8s\n", "", "libc", "table", "speedup");
+
+    double l = benchPreparse(preparseLibc, reps), t = benchPreparse(preparseTable, reps);
+    fprintf(stderr, "%-26s %14.0f %14.0f %7.2fx\n", "pre-parse [cmd/s]", l, t, t / l);
+    l = benchParse(0, reps);
+    t = benchParse(1, reps);
+    fprintf(stderr, "%-26s %14.0f %14.0f %7.2fx\n", "parse number [1/s]", l, t, t / l);
+    l = benchFormat(0, reps);
+    t = benchFormat(1, reps);
+    fprintf(stderr, "%-26s %14.0f %14.0f %7.2fx\n", "format node-ID [1/s]", l, t, t / l);
+#ifdef GTWPARSE_STACK
+    fprintf(stderr, "%-26s %14.0f\n", "CO_fifo_readToken [cmd/s]", benchStack(reps));
+
+    /* conversions of OD values, originals of CANopenNode and CO_fifoLinux must give the same results */
+    convFind();
+    unsigned convErrors = verifyConvert();
+    errors += (int)convErrors;
+    fprintf(stderr, "\nvalue conversions: %zu SDO commands%s\n", convCount, convErrors == 0 ? "" : ", RESULTS DIFFER");
+    fprintf(stderr, "%-26s %14s %14s %8s\n", "", "CO_fifo.c", "CO_fifoLinux", "speedup");
+    l = benchConvert(0, reps);
+    t = benchConvert(1, reps);
+    fprintf(stderr, "%-26s %14.0f %14.0f %7.2fx\n", "convert value [cmd/s]", l, t, t / l);
+    for (size_t size = 8; size <= 4096; size *= 8) {
+        long hexReps = reps * 40 / (long)size + 1;
+        char label[32];
+        l = benchHex(0, 0, size, hexReps);
+        t = benchHex(1, 0, size, hexReps);
+        snprintf(label, sizeof(label), "os read %zu B [MB/s]", size);
+        fprintf(stderr, "%-26s %14.1f %14.1f %7.2fx\n", label, l, t, t / l);
+        l = benchHex(0, 1, size, hexReps);
+        t = benchHex(1, 1, size, hexReps);
+        snprintf(label, sizeof(label), "os write %zu B [MB/s]", size);
+        fprintf(stderr, "%-26s %14.1f %14.1f %7.2fx\n", label, l, t, t / l);
+    }
+#else
+    fprintf(stderr, "CANopenNode sources not found, CO_fifo_readToken() and value conversions not measured\n");
+#endif
+
+    return errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
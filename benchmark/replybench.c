@@ -0,0 +1,94 @@
+/*
+ * Parse rate benchmark for cocomm reply parser on multi-megabyte responses.
+ *
+ * @file        replybench.c
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "cocomm_reply.h"
+
+static double
+now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* Domain reply "[1] <base64 lines>\r\n" of size bytes, optionally ending with SDO abort */
+static char*
+makeReply(size_t size, int abort, size_t* len) {
+    static const char b64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    const char* tail = abort ? "\n...ERROR:0x05040000\r\n" : "\r\n";
+    char* buf = malloc(size + 64);
+    size_t n = (size_t)sprintf(buf, "[1] ");
+
+    if (buf == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    while (n < size) {
+        buf[n] = (n % 77) == 76 ? '\n' : b64[(n * 7) % 64];
+        n++;
+    }
+    strcpy(&buf[n], tail);
+    *len = n + strlen(tail);
+    return buf;
+}
+
+static void
+run(size_t size, size_t chunk, int abort, int repeat) {
+    static cocommReply_t rp;
+    size_t len;
+    char* reply = makeReply(size, abort, &len);
+    double start = now_s();
+
+    for (int r = 0; r < repeat; r++) {
+        cocommReply_init(&rp, stdout, "", "", "");
+        for (size_t i = 0; i < len && !cocommReply_done(&rp); i += chunk) {
+            cocommReply_parse(&rp, &reply[i], len - i < chunk ? len - i : chunk);
+        }
+        if (!cocommReply_done(&rp) || rp.ret != (abort ? EXIT_FAILURE : EXIT_SUCCESS)) {
+            fprintf(stderr, "Error: reply not parsed correctly\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    double elapsed = now_s() - start;
+    fprintf(stderr, "%6zu MB %7zu B chunks %-6s %9.1f MB/s\n", size >> 20, chunk, abort ? "abort" : "ok",
+            (double)len * repeat / elapsed / 1e6);
+    free(reply);
+}
+
+int
+main(int argc, char* argv[]) {
+    int repeat = argc > 1 ? atoi(argv[1]) : 5;
+
+    /* value data are written to stdout, measure parser and chunked output only */
+    if (freopen("/dev/null", "w", stdout) == NULL) {
+        perror("freopen");
+        exit(EXIT_FAILURE);
+    }
+    fprintf(stderr, "cocomm reply parser, %d repetitions\n", repeat);
+    for (size_t mb = 1; mb <= 16; mb *= 4) {
+        run(mb << 20, 1000, 0, repeat);
+        run(mb << 20, 65536, 0, repeat);
+    }
+    run(16 << 20, 65536, 1, repeat);
+
+    return EXIT_SUCCESS;
+}
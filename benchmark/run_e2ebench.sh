@@ -0,0 +1,64 @@
+#!/bin/sh
+# End-to-end benchmark: build canopend single threaded (CO_SINGLE_THREAD) and with RT thread, then for each build
+# start server node 2 and commander node 1 with local socket command interface on virtual CAN and run e2ebench.
+#
+# Usage: ./run_e2ebench.sh [<can device> [<repetitions> [<results file>]]]
+# Default: vcan0, 1000, e2ebench_results.json (JSON lines, one per test and build, file is overwritten).
+# Environment variable PDO_OBJECT sets object for PDO echo (e2ebench -m), SDO_OBJECT object for segmented and
+# block transfer (e2ebench -S). Creating the vcan device requires root privileges.
+
+DEV=${1:-vcan0}
+REPS=${2:-1000}
+RESULTS=${3:-e2ebench_results.json}
+TMP=$(mktemp -d /tmp/e2ebench.XXXXXX)
+SOCK=$TMP/CO_command_socket
+PIDS=""
+
+cleanup() {
+    [ -n "$PIDS" ] && kill $PIDS 2>/dev/null
+    wait 2>/dev/null
+    rm -rf "$TMP"
+}
+trap cleanup EXIT INT TERM
+
+if [ ! -x ./e2ebench ]; then
+    echo "Build e2ebench first: 'make'" >&2
+    exit 1
+fi
+
+if ! ip link show "$DEV" >/dev/null 2>&1; then
+    modprobe vcan && ip link add dev "$DEV" type vcan && ip link set up "$DEV" || exit 1
+fi
+
+# both builds of canopend, parent directory is left with the default build
+make -C .. OPT="-g -O2 -DCO_SINGLE_THREAD" >/dev/null && cp ../canopend "$TMP/canopend-single-thread" || exit 1
+make -C .. OPT="-g -O2" LDFLAGS="-pthread" >/dev/null && cp ../canopend "$TMP/canopend-rt-thread" || exit 1
+make -C .. >/dev/null || exit 1
+
+rm -f "$RESULTS"
+for BUILD in single-thread rt-thread; do
+    CANOPEND=$TMP/canopend-$BUILD
+    rm -f "$TMP"/node*
+    "$CANOPEND" "$DEV" -i 2 -s "$TMP/node2_" >/dev/null 2>&1 &
+    SERVER=$!
+    "$CANOPEND" "$DEV" -i 1 -s "$TMP/node1_" -c "local-$SOCK" >"$TMP/canopend.log" 2>&1 &
+    COMMANDER=$!
+    PIDS="$SERVER $COMMANDER"
+
+    i=0
+    while [ ! -S "$SOCK" ] && [ $i -lt 50 ]; do
+        sleep 0.1
+        i=$((i + 1))
+    done
+    sleep 1 # boot-up of server node
+
+    ./e2ebench -s "$SOCK" -c "$DEV" -n 2 -r "$REPS" -l "$BUILD" -o "$RESULTS" \
+        ${SDO_OBJECT:+-S "$SDO_OBJECT"} ${PDO_OBJECT:+-m "$PDO_OBJECT"} || exit 1
+    echo
+
+    kill $PIDS 2>/dev/null
+    wait 2>/dev/null
+    PIDS=""
+    rm -f "$SOCK"
+done
+echo "Results written to $RESULTS"
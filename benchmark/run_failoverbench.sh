@@ -0,0 +1,71 @@
+#!/bin/sh
+# Hot standby failover benchmark: build canopend, start active and standby instance with the same -H socket on virtual
+# CAN, then repeatedly kill the active instance with failoverbench, which measures the time until standby responds,
+# and start a new standby for the next run. With mode "stop" the active instance is stopped instead of killed, like a
+# hung process, and continued after the take over, it must fence itself and end.
+#
+# Usage: ./run_failoverbench.sh [<can device> [<runs> [<results file> [kill|stop]]]]
+# Default: vcan0, 10, failoverbench_results.json (JSON lines, one per run, file is overwritten), kill.
+# Creating the vcan device requires root privileges.
+
+DEV=${1:-vcan0}
+RUNS=${2:-10}
+RESULTS=${3:-failoverbench_results.json}
+MODE=${4:-kill}
+TMP=$(mktemp -d /tmp/failoverbench.XXXXXX)
+SOCK=$TMP/standby.sock
+PIDS=""
+
+cleanup() {
+    [ -n "$PIDS" ] && kill $PIDS 2>/dev/null
+    wait 2>/dev/null
+    rm -rf "$TMP"
+}
+trap cleanup EXIT INT TERM
+
+if [ ! -x ./failoverbench ]; then
+    echo "Build failoverbench first: 'make'" >&2
+    exit 1
+fi
+
+if ! ip link show "$DEV" >/dev/null 2>&1; then
+    modprobe vcan && ip link add dev "$DEV" type vcan && ip link set up "$DEV" || exit 1
+fi
+
+make -C .. >/dev/null && cp ../canopend "$TMP/canopend" || exit 1
+
+# both instances share storage files, only the active one writes them
+startInstance() {
+    "$TMP/canopend" "$DEV" -i 2 -s "$TMP/node2_" -H "$SOCK" >>"$TMP/canopend.log" 2>&1 &
+    LAST=$!
+}
+
+startInstance
+ACTIVE=$LAST
+i=0
+while [ ! -S "$SOCK" ] && [ $i -lt 50 ]; do
+    sleep 0.1
+    i=$((i + 1))
+done
+startInstance
+STANDBY=$LAST
+PIDS="$ACTIVE $STANDBY"
+sleep 1 # boot-up of active node and full copy to standby
+
+rm -f "$RESULTS"
+FAILED=0
+RUN=1
+while [ $RUN -le "$RUNS" ]; do
+    echo "run $RUN: $MODE active pid $ACTIVE, standby pid $STANDBY"
+    STOP=""
+    [ "$MODE" = "stop" ] && STOP="-s"
+    ./failoverbench -c "$DEV" -n 2 -k "$ACTIVE" $STOP -l "run$MODE$RUN" -o "$RESULTS" || FAILED=$((FAILED + 1))
+    wait "$ACTIVE" 2>/dev/null
+    ACTIVE=$STANDBY
+    startInstance
+    STANDBY=$LAST
+    PIDS="$ACTIVE $STANDBY"
+    sleep 0.5 # new standby connects and receives full copy
+    RUN=$((RUN + 1))
+done
+echo "Results written to $RESULTS, $FAILED of $RUNS runs failed"
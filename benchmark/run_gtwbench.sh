@@ -0,0 +1,58 @@
+#!/bin/sh
+# Gateway benchmark: start canopend commander (node 1) with local socket and tcp command interfaces and
+# canopend instances as simulated remote nodes on virtual CAN, then run gtwbench with 1 and with N clients.
+#
+# Usage: ./run_gtwbench.sh [<can device> [<remote nodes> [<clients> [<seconds>]]]]
+# Default: vcan0, 2-4, 4, 10. Environment variable CANOPEND sets path to canopend (default ../canopend).
+# Creating the vcan device requires root privileges.
+
+DEV=${1:-vcan0}
+NODES=${2:-2-4}
+CLIENTS=${3:-4}
+SECONDS_RUN=${4:-10}
+CANOPEND=${CANOPEND:-../canopend}
+PORT=60123
+TMP=$(mktemp -d /tmp/gtwbench.XXXXXX)
+SOCK=$TMP/CO_command_socket
+PIDS=""
+
+cleanup() {
+    [ -n "$PIDS" ] && kill $PIDS 2>/dev/null
+    wait 2>/dev/null
+    rm -rf "$TMP"
+}
+trap cleanup EXIT INT TERM
+
+if [ ! -x "$CANOPEND" ] || [ ! -x ./gtwbench ]; then
+    echo "Build canopend and gtwbench first: 'make -C ..' and 'make'" >&2
+    exit 1
+fi
+
+if ! ip link show "$DEV" >/dev/null 2>&1; then
+    modprobe vcan && ip link add dev "$DEV" type vcan && ip link set up "$DEV" || exit 1
+fi
+
+# simulated remote nodes
+FIRST=${NODES%-*}
+LAST=${NODES#*-}
+for n in $(seq "$FIRST" "$LAST"); do
+    "$CANOPEND" "$DEV" -i "$n" -s "$TMP/node${n}_" >/dev/null 2>&1 &
+    PIDS="$PIDS $!"
+done
+
+# commander under test
+"$CANOPEND" "$DEV" -i 1 -s "$TMP/node1_" -c "local-$SOCK" -c "tcp-$PORT" >"$TMP/canopend.log" 2>&1 &
+PIDS="$PIDS $!"
+
+i=0
+while [ ! -S "$SOCK" ] && [ $i -lt 50 ]; do
+    sleep 0.1
+    i=$((i + 1))
+done
+sleep 1 # boot-up of remote nodes
+
+./gtwbench -s "$SOCK" -c 1 -d "$SECONDS_RUN" -n "$NODES" || exit 1
+echo
+./gtwbench -s "$SOCK" -c "$CLIENTS" -d "$SECONDS_RUN" -n "$NODES" || exit 1
+echo
+./gtwbench -t localhost -p $PORT -c "$CLIENTS" -d "$SECONDS_RUN" -n "$NODES" || exit 1
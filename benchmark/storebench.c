@@ -0,0 +1,410 @@
+/*
+ * Latency benchmark and kill-during-write test for "Store parameters" of CO_storageLinux.
+ *
+ * @file        storebench.c
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/wait.h>
+
+#include "CO_storageLinux.h"
+
+/* configuration */
+static char* directory = "/tmp";
+static size_t entrySize = 256;
+static long stores = 1000;
+static long killCycles = 0;
+static long killDelayMax_us = 2000;
+static size_t changeSize = 0; /* 0 = whole entry */
+static bool_t journal = false;
+static bool_t container = false;
+static long entriesCount = 1;
+static long restores = 100;
+
+#define ENTRIES_MAX 64
+
+static uint8_t* data;
+static CO_storage_t storage;
+static CO_storage_entry_t entries[ENTRIES_MAX]; /* entries[0] is measured, others are only stored */
+static CO_CANmodule_t CANmodule;
+
+static void
+printUsage(char* progName) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "\n"
+            "Program measures latency of \"Store parameters\" (object 0x1010) of the\n"
+            "CO_storageLinux backend: data and CRC are written to a temporary file, synced\n"
+            "and renamed over the existing file. With -j only changed byte ranges are\n"
+            "appended to the journal file. Bytes written per store are read from\n"
+            "/proc/self/io: wchar (passed to write calls) and write_bytes (sent to the\n"
+            "block device, 0 on tmpfs). Then startup time of restoring all entries is\n"
+            "measured, with files in page cache.\n"
+            "\n"
+            "With -k program runs kill-during-write test: child process stores continuously\n"
+            "and reports each completed store, parent kills it with SIGKILL after random\n"
+            "delay. Then file is loaded with CO_storageLinux_init(). It must have a valid\n"
+            "CRC and contain data of the last completed store or of the interrupted one.\n"
+            "\n"
+            "Options:\n"
+            "  -d <directory>    Directory for storage file, on the device under test.\n"
+            "                    Default is '/tmp'.\n"
+            "  -s <bytes>        Size of the storage entry. Default is 256.\n"
+            "  -n <count>        Number of stores for latency measurement. Default is 1000.\n"
+            "  -c <bytes>        Bytes changed before each store, like a single parameter\n"
+            "                    change. Default is the whole entry.\n"
+            "  -j                Journal mode of the storage entries.\n"
+            "  -e <count>        Number of storage entries of the same size, max 64.\n"
+            "                    Default is 1.\n"
+            "  -C                Store all entries in one container file.\n"
+            "  -r <count>        Number of restores (CO_storageLinux_init()) for startup\n"
+            "                    time measurement. Default is 100.\n"
+            "  -k <cycles>       Run kill-during-write test with <cycles> kills.\n"
+            "  -D <us>           Maximum delay before kill in microseconds. Default is 2000.\n"
+            "  --help            Display this help.\n"
+            "\n"
+            "See also: https://github.com/CANopenNode/CANopenLinux\n"
+            "\n",
+            progName);
+}
+
+static uint64_t
+now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static int
+compareU32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/* data of the store number <n>: counter repeated over the whole entry */
+static void
+fillData(uint32_t n) {
+    for (size_t i = 0; i < entrySize; i++) {
+        data[i] = (uint8_t)(n >> (8 * (i % 4)));
+    }
+}
+
+/* return counter, if data are consistent pattern of one store, otherwise -1 */
+static long
+checkData(void) {
+    uint32_t n = 0;
+
+    for (size_t i = 0; i < 4 && i < entrySize; i++) {
+        n |= (uint32_t)data[i] << (8 * i);
+    }
+    for (size_t i = 0; i < entrySize; i++) {
+        if (data[i] != (uint8_t)(n >> (8 * (i % 4)))) {
+            return -1;
+        }
+    }
+    return (long)n;
+}
+
+/* initialize storage, data are loaded from the files. Return CO_storageLinux_init() result */
+static CO_ReturnError_t
+initStorage(void) {
+    uint32_t storageInitError = 0;
+    char filename[CO_STORAGE_PATH_MAX];
+
+    for (long i = 0; i < entriesCount; i++) {
+        CO_storage_entry_t* entry = &entries[i];
+        memset(entry, 0, sizeof(*entry));
+        entry->addr = &data[(size_t)i * entrySize];
+        entry->len = entrySize;
+        entry->subIndexOD = 2;
+        entry->attr = CO_storage_cmd | CO_storage_restore;
+        entry->journal = journal;
+        snprintf(entry->filename, sizeof(entry->filename),
+                 i == 0 ? "%s/storebench.persist" : "%s/storebench%ld.persist", directory, i);
+    }
+    if (container) {
+        snprintf(filename, sizeof(filename), "%s/storebench.container", directory);
+        return CO_storageLinux_initContainer(&storage, &CANmodule, NULL, NULL, entries, (uint8_t)entriesCount,
+                                             filename, &storageInitError);
+    }
+    return CO_storageLinux_init(&storage, &CANmodule, NULL, NULL, entries, (uint8_t)entriesCount, &storageInitError);
+}
+
+/* delete files of all entries */
+static void
+deleteFiles(void) {
+    char filename[CO_STORAGE_PATH_MAX + 20];
+
+    for (long i = 0; i < ENTRIES_MAX; i++) {
+        snprintf(filename, sizeof(filename), i == 0 ? "%s/storebench.persist" : "%s/storebench%ld.persist", directory,
+                 i);
+        unlink(filename);
+        strcat(filename, ".jrn");
+        unlink(filename);
+    }
+    snprintf(filename, sizeof(filename), "%s/storebench.container", directory);
+    unlink(filename);
+}
+
+/* read wchar and write_bytes of this process from /proc/self/io, false if not available */
+static bool_t
+readIo(unsigned long long* wchar, unsigned long long* writeBytes) {
+    char line[100];
+    int found = 0;
+    FILE* fp = fopen("/proc/self/io", "r");
+
+    if (fp == NULL) {
+        return false;
+    }
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (sscanf(line, "wchar: %llu", wchar) == 1 || sscanf(line, "write_bytes: %llu", writeBytes) == 1) {
+            found++;
+        }
+    }
+    fclose(fp);
+    return found == 2;
+}
+
+/* change <changeSize> bytes at rotating position, or the whole entry */
+static void
+changeData(uint32_t n) {
+    if (changeSize == 0 || changeSize >= entrySize) {
+        fillData(n);
+        return;
+    }
+    size_t pos = ((size_t)n * changeSize) % entrySize;
+    for (size_t i = 0; i < changeSize; i++) {
+        data[(pos + i) % entrySize]++;
+    }
+}
+
+static int
+latencyTest(void) {
+    uint32_t* lat = malloc((size_t)stores * sizeof(uint32_t));
+    unsigned long errors = 0;
+    unsigned long long wchar0 = 0, writeBytes0 = 0, wchar1 = 0, writeBytes1 = 0;
+
+    if (lat == NULL) {
+        perror("malloc");
+        return -1;
+    }
+    bool_t io = readIo(&wchar0, &writeBytes0);
+    uint64_t start = now_us();
+    for (long i = 0; i < stores; i++) {
+        changeData((uint32_t)i);
+        uint64_t t = now_us();
+        if (storage.store(&entries[0], &CANmodule) != ODR_OK) {
+            errors++;
+        }
+        lat[i] = (uint32_t)(now_us() - t);
+    }
+    double elapsed_s = (double)(now_us() - start) / 1000000.0;
+    io = io && readIo(&wchar1, &writeBytes1);
+
+    qsort(lat, (size_t)stores, sizeof(uint32_t), compareU32);
+    printf("%s%s, %ld entries of %zu bytes, %zu changed per store, %ld stores, %.2f s\n", entries[0].filename,
+           container ? " (container)" : journal ? " (journal)" : "", entriesCount, entrySize,
+           changeSize == 0 || changeSize >= entrySize ? entrySize : changeSize, stores, elapsed_s);
+    printf("%9s %9s %10s %8s %8s %8s %8s\n", "stores", "errors", "stores/s", "p50[us]", "p90[us]", "p99[us]",
+           "max[us]");
+    printf("%9ld %9lu %10.1f %8u %8u %8u %8u\n", stores, errors, (double)stores / elapsed_s, lat[stores / 2],
+           lat[(size_t)((double)(stores - 1) * 0.9)], lat[(size_t)((double)(stores - 1) * 0.99)], lat[stores - 1]);
+    if (io) {
+        printf("bytes per store: wchar %.1f, write_bytes %.1f\n", (double)(wchar1 - wchar0) / (double)stores,
+               (double)(writeBytes1 - writeBytes0) / (double)stores);
+    }
+    free(lat);
+    return errors > 0 ? -1 : 0;
+}
+
+/* startup: restore all entries with CO_storageLinux_init() */
+static int
+restoreTest(void) {
+    uint32_t* lat = malloc((size_t)restores * sizeof(uint32_t));
+    unsigned long errors = 0;
+
+    if (lat == NULL) {
+        perror("malloc");
+        return -1;
+    }
+    for (long i = 0; i < restores; i++) {
+        uint64_t t = now_us();
+        if (initStorage() != CO_ERROR_NO) {
+            errors++;
+        }
+        lat[i] = (uint32_t)(now_us() - t);
+        CO_storageLinux_auto_process(&storage, true);
+    }
+    qsort(lat, (size_t)restores, sizeof(uint32_t), compareU32);
+    printf("%9s %9s %8s %8s %8s\n", "restores", "errors", "p50[us]", "p90[us]", "max[us]");
+    printf("%9ld %9lu %8u %8u %8u\n", restores, errors, lat[restores / 2], lat[(size_t)((double)(restores - 1) * 0.9)],
+           lat[restores - 1]);
+    free(lat);
+    return errors > 0 ? -1 : 0;
+}
+
+/* child: store continuously, write counter of each completed store to the pipe */
+static void
+storeLoop(int fd, uint32_t first) {
+    for (uint32_t n = first;; n++) {
+        fillData(n);
+        if (storage.store(&entries[0], &CANmodule) != ODR_OK || write(fd, &n, sizeof(n)) != sizeof(n)) {
+            _exit(EXIT_FAILURE);
+        }
+    }
+}
+
+static int
+killTest(void) {
+    unsigned seed = (unsigned)now_us();
+    unsigned long failures = 0, interrupted = 0;
+    long lastFound = 0;
+
+    /* start with the pattern of store 0, latency test may have changed only part of the data */
+    if (initStorage() != CO_ERROR_NO) {
+        fprintf(stderr, "CO_storageLinux_init() failed\n");
+        return -1;
+    }
+    fillData(0);
+    if (storage.store(&entries[0], &CANmodule) != ODR_OK) {
+        fprintf(stderr, "store failed\n");
+        return -1;
+    }
+    CO_storageLinux_auto_process(&storage, true);
+
+    for (long cycle = 0; cycle < killCycles; cycle++) {
+        int pfd[2];
+        if (pipe(pfd) != 0) {
+            perror("pipe");
+            return -1;
+        }
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return -1;
+        }
+        if (pid == 0) {
+            close(pfd[0]);
+            if (initStorage() != CO_ERROR_NO) {
+                _exit(EXIT_FAILURE);
+            }
+            storeLoop(pfd[1], (uint32_t)(lastFound + 1));
+        }
+        close(pfd[1]);
+        usleep((useconds_t)(rand_r(&seed) % (unsigned)(killDelayMax_us + 1)));
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+
+        /* last completed store, reported by the child */
+        long lastDone = -1;
+        uint32_t n;
+        while (read(pfd[0], &n, sizeof(n)) == sizeof(n)) {
+            lastDone = (long)n;
+        }
+        close(pfd[0]);
+
+        /* stored file must contain complete data of the last completed or of the interrupted store */
+        memset(data, 0xAA, entrySize);
+        CO_ReturnError_t err = initStorage();
+        long found = err == CO_ERROR_NO ? checkData() : -1;
+        CO_storageLinux_auto_process(&storage, true); /* closes the journal */
+        long expectedOld = lastDone >= 0 ? lastDone : lastFound;
+        if (found < 0 || (found != expectedOld && found != expectedOld + 1)) {
+            failures++;
+            fprintf(stderr, "cycle %ld: init err=%d, found %ld, last completed store %ld\n", cycle, err, found,
+                    expectedOld);
+        } else if (found == expectedOld + 1) {
+            interrupted++;
+        }
+        if (found >= 0) {
+            lastFound = found;
+        }
+    }
+    printf("kill-during-write: %ld cycles, %lu failures, %lu stores completed, but not reported before kill\n",
+           killCycles, failures, interrupted);
+    return failures > 0 ? -1 : 0;
+}
+
+int
+main(int argc, char* argv[]) {
+    int opt;
+
+    if (argc >= 2 && strcmp(argv[1], "--help") == 0) {
+        printUsage(argv[0]);
+        exit(EXIT_SUCCESS);
+    }
+    while ((opt = getopt(argc, argv, "d:s:n:c:je:Cr:k:D:")) != -1) {
+        switch (opt) {
+            case 'd': directory = optarg; break;
+            case 's': entrySize = (size_t)atol(optarg); break;
+            case 'n': stores = atol(optarg); break;
+            case 'c': changeSize = (size_t)atol(optarg); break;
+            case 'j': journal = true; break;
+            case 'e': entriesCount = atol(optarg); break;
+            case 'C': container = true; break;
+            case 'r': restores = atol(optarg); break;
+            case 'k': killCycles = atol(optarg); break;
+            case 'D': killDelayMax_us = atol(optarg); break;
+            default: printUsage(argv[0]); exit(EXIT_FAILURE);
+        }
+    }
+    if (entrySize < 4 || stores < 1 || killCycles < 0 || killDelayMax_us < 0 || entriesCount < 1
+        || entriesCount > ENTRIES_MAX || restores < 1) {
+        printUsage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    data = malloc(entrySize * (size_t)entriesCount);
+    if (data == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+
+    /* files from previous run may have different size */
+    deleteFiles();
+    CO_ReturnError_t err = initStorage();
+    if (err != CO_ERROR_NO && err != CO_ERROR_DATA_CORRUPT) {
+        fprintf(stderr, "CO_storageLinux_init() failed, err=%d\n", err);
+        exit(EXIT_FAILURE);
+    }
+
+    /* all entries are stored once, so they can be restored */
+    int ret = 0;
+    for (long i = 0; i < entriesCount && ret == 0; i++) {
+        if (storage.store(&entries[i], &CANmodule) != ODR_OK) {
+            fprintf(stderr, "store failed\n");
+            ret = -1;
+        }
+    }
+    if (ret == 0) {
+        ret = latencyTest();
+    }
+    CO_storageLinux_auto_process(&storage, true);
+    if (ret == 0 && restoreTest() < 0) {
+        ret = -1;
+    }
+    if (killCycles > 0) {
+        if (killTest() < 0) {
+            ret = -1;
+        }
+    }
+    free(data);
+    return ret < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,851 @@
+/*
+ * Storage I/O benchmark and fault-injection harness for CO_storageLinux.
+ *
+ * @file        storeio.c
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+
+#include "CO_storageLinux.h"
+
+/* configuration */
+static char* directory = "/tmp";
+static size_t entrySize = 256;
+static long entriesCount = 4;
+static long count = 200;
+static bool_t journal = false;
+static bool_t container = false;
+static bool_t faults = false;
+
+#define ENTRIES_MAX 64
+/* data pattern of an entry with default values, see fillData() */
+#define DEFAULT_N 0xAAAAAAAAUL
+/* time to wait for retry of failed auto storage */
+#define AUTO_RETRY_TIMEOUT_US 2000000
+
+static uint8_t* data;
+static CO_storage_t storage;
+static CO_storage_entry_t entries[ENTRIES_MAX];
+static CO_CANmodule_t CANmodule;
+
+/*
+ * System call interposition. Calls from CO_storageLinux.c (and from this file) are redirected to the __wrap_ functions
+ * with linker option --wrap, see Makefile. They count calls and inject one fault, when armed.
+ */
+typedef struct {
+    unsigned long open, read, write, sync, meta;
+    unsigned long long bytes;
+} calls_t;
+
+typedef enum {
+    FAULT_NONE,
+    FAULT_ENOSPC_OPEN,  /* creating a file fails with ENOSPC */
+    FAULT_ENOSPC_WRITE, /* write, pwrite or pwritev fails with ENOSPC */
+    FAULT_SHORT_WRITE,  /* write, pwrite or pwritev writes only half of the data */
+    FAULT_EIO_SYNC,     /* fsync or fdatasync fails with EIO */
+    FAULT_EIO_RENAME    /* rename or renameat fails with EIO */
+} fault_t;
+
+static calls_t calls;
+static fault_t faultArmed = FAULT_NONE;
+static unsigned long faultsInjected;
+
+static bool_t
+injectFault(fault_t fault) {
+    if (faultArmed != fault) {
+        return false;
+    }
+    faultArmed = FAULT_NONE;
+    faultsInjected++;
+    return true;
+}
+
+int __real_open(const char* path, int flags, ...);
+int __real_openat(int dirfd, const char* path, int flags, ...);
+FILE* __real_fopen(const char* path, const char* mode);
+ssize_t __real_read(int fd, void* buf, size_t count);
+ssize_t __real_pread(int fd, void* buf, size_t count, off_t offset);
+size_t __real_fread(void* ptr, size_t size, size_t nmemb, FILE* fp);
+void* __real_mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset);
+ssize_t __real_write(int fd, const void* buf, size_t count);
+ssize_t __real_pwrite(int fd, const void* buf, size_t count, off_t offset);
+ssize_t __real_pwritev(int fd, const struct iovec* iov, int iovcnt, off_t offset);
+int __real_fsync(int fd);
+int __real_fdatasync(int fd);
+int __real_rename(const char* oldpath, const char* newpath);
+int __real_renameat(int olddirfd, const char* oldpath, int newdirfd, const char* newpath);
+int __real_linkat(int olddirfd, const char* oldpath, int newdirfd, const char* newpath, int flags);
+int __real_unlink(const char* path);
+int __real_unlinkat(int dirfd, const char* path, int flags);
+int __real_ftruncate(int fd, off_t length);
+
+int
+__wrap_open(const char* path, int flags, ...) {
+    mode_t mode = 0;
+    if ((flags & O_CREAT) != 0) {
+        va_list ap;
+        va_start(ap, flags);
+        mode = (mode_t)va_arg(ap, int);
+        va_end(ap);
+        if (injectFault(FAULT_ENOSPC_OPEN)) {
+            errno = ENOSPC;
+            return -1;
+        }
+    }
+    calls.open++;
+    return __real_open(path, flags, mode);
+}
+
+int
+__wrap_openat(int dirfd, const char* path, int flags, ...) {
+    mode_t mode = 0;
+    if ((flags & O_CREAT) != 0) {
+        va_list ap;
+        va_start(ap, flags);
+        mode = (mode_t)va_arg(ap, int);
+        va_end(ap);
+        if (injectFault(FAULT_ENOSPC_OPEN)) {
+            errno = ENOSPC;
+            return -1;
+        }
+    }
+    calls.open++;
+    return __real_openat(dirfd, path, flags, mode);
+}
+
+FILE*
+__wrap_fopen(const char* path, const char* mode) {
+    if (mode[0] != 'r' && injectFault(FAULT_ENOSPC_OPEN)) {
+        errno = ENOSPC;
+        return NULL;
+    }
+    calls.open++;
+    return __real_fopen(path, mode);
+}
+
+ssize_t
+__wrap_read(int fd, void* buf, size_t count) {
+    calls.read++;
+    return __real_read(fd, buf, count);
+}
+
+ssize_t
+__wrap_pread(int fd, void* buf, size_t count, off_t offset) {
+    calls.read++;
+    return __real_pread(fd, buf, count, offset);
+}
+
+size_t
+__wrap_fread(void* ptr, size_t size, size_t nmemb, FILE* fp) {
+    calls.read++;
+    return __real_fread(ptr, size, nmemb, fp);
+}
+
+void*
+__wrap_mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset) {
+    calls.read++;
+    return __real_mmap(addr, length, prot, flags, fd, offset);
+}
+
+ssize_t
+__wrap_write(int fd, const void* buf, size_t count) {
+    if (injectFault(FAULT_ENOSPC_WRITE)) {
+        errno = ENOSPC;
+        return -1;
+    }
+    if (injectFault(FAULT_SHORT_WRITE)) {
+        count /= 2;
+    }
+    calls.write++;
+    ssize_t n = __real_write(fd, buf, count);
+    calls.bytes += n > 0 ? (unsigned long long)n : 0;
+    return n;
+}
+
+ssize_t
+__wrap_pwrite(int fd, const void* buf, size_t count, off_t offset) {
+    if (injectFault(FAULT_ENOSPC_WRITE)) {
+        errno = ENOSPC;
+        return -1;
+    }
+    if (injectFault(FAULT_SHORT_WRITE)) {
+        count /= 2;
+    }
+    calls.write++;
+    ssize_t n = __real_pwrite(fd, buf, count, offset);
+    calls.bytes += n > 0 ? (unsigned long long)n : 0;
+    return n;
+}
+
+ssize_t
+__wrap_pwritev(int fd, const struct iovec* iov, int iovcnt, off_t offset) {
+    if (injectFault(FAULT_ENOSPC_WRITE)) {
+        errno = ENOSPC;
+        return -1;
+    }
+    calls.write++;
+    if (injectFault(FAULT_SHORT_WRITE)) {
+        /* only half of the total length, as a full disk or a signal would leave it */
+        size_t total = 0, half;
+        for (int i = 0; i < iovcnt; i++) {
+            total += iov[i].iov_len;
+        }
+        half = total / 2;
+        ssize_t n = 0;
+        for (int i = 0; i < iovcnt && half > 0; i++) {
+            size_t len = iov[i].iov_len < half ? iov[i].iov_len : half;
+            ssize_t w = __real_pwrite(fd, iov[i].iov_base, len, offset + n);
+            if (w < 0) {
+                return n > 0 ? n : w;
+            }
+            n += w;
+            half -= (size_t)w;
+        }
+        calls.bytes += (unsigned long long)n;
+        return n;
+    }
+    ssize_t n = __real_pwritev(fd, iov, iovcnt, offset);
+    calls.bytes += n > 0 ? (unsigned long long)n : 0;
+    return n;
+}
+
+int
+__wrap_fsync(int fd) {
+    if (injectFault(FAULT_EIO_SYNC)) {
+        errno = EIO;
+        return -1;
+    }
+    calls.sync++;
+    return __real_fsync(fd);
+}
+
+int
+__wrap_fdatasync(int fd) {
+    if (injectFault(FAULT_EIO_SYNC)) {
+        errno = EIO;
+        return -1;
+    }
+    calls.sync++;
+    return __real_fdatasync(fd);
+}
+
+int
+__wrap_rename(const char* oldpath, const char* newpath) {
+    if (injectFault(FAULT_EIO_RENAME)) {
+        errno = EIO;
+        return -1;
+    }
+    calls.meta++;
+    return __real_rename(oldpath, newpath);
+}
+
+int
+__wrap_renameat(int olddirfd, const char* oldpath, int newdirfd, const char* newpath) {
+    if (injectFault(FAULT_EIO_RENAME)) {
+        errno = EIO;
+        return -1;
+    }
+    calls.meta++;
+    return __real_renameat(olddirfd, oldpath, newdirfd, newpath);
+}
+
+int
+__wrap_linkat(int olddirfd, const char* oldpath, int newdirfd, const char* newpath, int flags) {
+    calls.meta++;
+    return __real_linkat(olddirfd, oldpath, newdirfd, newpath, flags);
+}
+
+int
+__wrap_unlink(const char* path) {
+    calls.meta++;
+    return __real_unlink(path);
+}
+
+int
+__wrap_unlinkat(int dirfd, const char* path, int flags) {
+    calls.meta++;
+    return __real_unlinkat(dirfd, path, flags);
+}
+
+int
+__wrap_ftruncate(int fd, off_t length) {
+    calls.meta++;
+    return __real_ftruncate(fd, length);
+}
+
+static void
+printUsage(char* progName) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "\n"
+            "Program measures CO_storageLinux operations on the file system of <directory>:\n"
+            "  init     CO_storageLinux_init() of all entries, files in page cache,\n"
+            "  store    \"Store parameters\" of one entry (storeLinux),\n"
+            "  restore  \"Restore default parameters\" of one entry (restoreLinux),\n"
+            "  auto     change of auto storage entry, saved by CO_storageLinux_auto_process().\n"
+            "Latency distribution and system calls per operation are printed. System calls\n"
+            "are counted by interposition (linker option --wrap): open includes fopen, read\n"
+            "includes fread and mmap, meta are rename, link, unlink and ftruncate.\n"
+            "\n"
+            "With -f faults are injected into one store of the first entry: ENOSPC on file\n"
+            "creation or write, short write, EIO on sync or rename, for the store command\n"
+            "and for auto storage. Files are also damaged before startup: truncated to\n"
+            "half, emptied, one byte flipped, stale temporary file, torn journal tail.\n"
+            "For each fault the data loaded by CO_storageLinux_init() in a child process\n"
+            "must be either the previous or the new complete store, or defaults reported as\n"
+            "corrupt, and the next store must succeed. Latency of the faulty operation and\n"
+            "of the recovery are printed.\n"
+            "\n"
+            "Options:\n"
+            "  -d <directory>    Directory for storage files, for example a tmpfs or a\n"
+            "                    mount of the device under test. Default is '/tmp'.\n"
+            "  -s <bytes>        Size of each storage entry. Default is 256.\n"
+            "  -e <count>        Number of storage entries, max 64. Default is 4.\n"
+            "  -n <count>        Number of operations of each type. Default is 200.\n"
+            "  -j                Journal mode of the storage entries.\n"
+            "  -C                Store all entries in one container file.\n"
+            "  -f                Run fault injection.\n"
+            "  --help            Display this help.\n"
+            "\n"
+            "See also: https://github.com/CANopenNode/CANopenLinux\n"
+            "\n",
+            progName);
+}
+
+static uint64_t
+now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static int
+compareU32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/* data of the store number <n> of the entry: counter repeated over the whole entry */
+static void
+fillData(long entry, uint32_t n) {
+    uint8_t* d = &data[(size_t)entry * entrySize];
+    for (size_t i = 0; i < entrySize; i++) {
+        d[i] = (uint8_t)(n >> (8 * (i % 4)));
+    }
+}
+
+/* return counter of the first entry, if data are consistent pattern of one store, otherwise -1 */
+static long
+checkData(void) {
+    uint32_t n = 0;
+
+    for (size_t i = 0; i < 4; i++) {
+        n |= (uint32_t)data[i] << (8 * i);
+    }
+    for (size_t i = 0; i < entrySize; i++) {
+        if (data[i] != (uint8_t)(n >> (8 * (i % 4)))) {
+            return -1;
+        }
+    }
+    return (long)n;
+}
+
+static void
+entryFilename(char* filename, size_t size, long i) {
+    snprintf(filename, size, "%s/storeio%ld.persist", directory, i);
+}
+
+static void
+containerFilename(char* filename, size_t size) {
+    snprintf(filename, size, "%s/storeio.container", directory);
+}
+
+/* initialize storage, data are loaded from the files. Return CO_storageLinux_init() result */
+static CO_ReturnError_t
+initStorage(bool_t autoStorage) {
+    uint32_t storageInitError = 0;
+    char filename[CO_STORAGE_PATH_MAX];
+
+    for (long i = 0; i < entriesCount; i++) {
+        CO_storage_entry_t* entry = &entries[i];
+        memset(entry, 0, sizeof(*entry));
+        entry->addr = &data[(size_t)i * entrySize];
+        entry->len = entrySize;
+        entry->subIndexOD = (uint8_t)(2 + i);
+        entry->attr = CO_storage_cmd | CO_storage_restore | (autoStorage ? CO_storage_auto : 0);
+        entry->journal = journal;
+        entryFilename(entry->filename, sizeof(entry->filename), i);
+    }
+    if (container) {
+        containerFilename(filename, sizeof(filename));
+        return CO_storageLinux_initContainer(&storage, &CANmodule, NULL, NULL, entries, (uint8_t)entriesCount,
+                                             filename, &storageInitError);
+    }
+    return CO_storageLinux_init(&storage, &CANmodule, NULL, NULL, entries, (uint8_t)entriesCount, &storageInitError);
+}
+
+/* close files of the storage, data are already saved */
+static void
+closeStorage(void) {
+    CO_storageLinux_auto_process(&storage, true);
+}
+
+/* delete files of all entries */
+static void
+deleteFiles(void) {
+    static const char* suffix[] = {"", ".jrn", ".old", ".tmp"};
+    char filename[CO_STORAGE_PATH_MAX + 8];
+    char name[CO_STORAGE_PATH_MAX];
+
+    for (long i = 0; i <= ENTRIES_MAX; i++) {
+        if (i < ENTRIES_MAX) {
+            entryFilename(name, sizeof(name), i);
+        } else {
+            containerFilename(name, sizeof(name));
+        }
+        for (size_t s = 0; s < sizeof(suffix) / sizeof(suffix[0]); s++) {
+            snprintf(filename, sizeof(filename), "%s%s", name, suffix[s]);
+            unlink(filename);
+        }
+    }
+}
+
+/* save auto storage entries, which are marked dirty. Return error mask of CO_storageLinux_auto_process() */
+static uint32_t
+autoSave(long entry) {
+    CO_storageLinux_markDirty(&storage, &data[(size_t)entry * entrySize], entrySize);
+    return CO_storageLinux_auto_process(&storage, false);
+}
+
+/* One operation type: latencies and system calls */
+typedef struct {
+    const char* name;
+    uint32_t* lat;
+    long count;
+    unsigned long errors;
+    calls_t calls;
+} opStat_t;
+
+static void
+printOp(const opStat_t* op) {
+    double n = (double)op->count;
+
+    qsort(op->lat, (size_t)op->count, sizeof(uint32_t), compareU32);
+    printf("%-8s %6ld %6lu %8u %8u %8u %8u %6.2f %6.2f %6.2f %6.2f %6.2f %9.1f\n", op->name, op->count, op->errors,
+           op->lat[op->count / 2], op->lat[(size_t)((double)(op->count - 1) * 0.9)],
+           op->lat[(size_t)((double)(op->count - 1) * 0.99)], op->lat[op->count - 1], (double)op->calls.open / n,
+           (double)op->calls.read / n, (double)op->calls.write / n, (double)op->calls.sync / n,
+           (double)op->calls.meta / n, (double)op->calls.bytes / n);
+}
+
+/* begin and end of measured operation, calls are accumulated into op */
+static uint64_t
+opStart(void) {
+    memset(&calls, 0, sizeof(calls));
+    return now_us();
+}
+
+static void
+opEnd(opStat_t* op, long i, uint64_t start, bool_t ok) {
+    op->lat[i] = (uint32_t)(now_us() - start);
+    op->calls.open += calls.open;
+    op->calls.read += calls.read;
+    op->calls.write += calls.write;
+    op->calls.sync += calls.sync;
+    op->calls.meta += calls.meta;
+    op->calls.bytes += calls.bytes;
+    if (!ok) {
+        op->errors++;
+    }
+}
+
+static int
+operationsTest(void) {
+    opStat_t ops[4] = {{.name = "init"}, {.name = "store"}, {.name = "restore"}, {.name = "auto"}};
+    int ret = 0;
+
+    for (int o = 0; o < 4; o++) {
+        ops[o].lat = calloc((size_t)count, sizeof(uint32_t));
+        ops[o].count = count;
+        if (ops[o].lat == NULL) {
+            perror("malloc");
+            return -1;
+        }
+    }
+
+    /* init: all entries are stored, then loaded */
+    for (long i = 0; i < count; i++) {
+        uint64_t t = opStart();
+        CO_ReturnError_t err = initStorage(false);
+        opEnd(&ops[0], i, t, err == CO_ERROR_NO);
+        closeStorage();
+    }
+
+    /* store and restore: entries in turn */
+    initStorage(false);
+    for (long i = 0; i < count; i++) {
+        long e = i % entriesCount;
+        fillData(e, (uint32_t)i);
+        uint64_t t = opStart();
+        bool_t ok = storage.store(&entries[e], &CANmodule) == ODR_OK;
+        opEnd(&ops[1], i, t, ok);
+    }
+    for (long i = 0; i < count; i++) {
+        long e = i % entriesCount;
+        uint64_t t = opStart();
+        bool_t ok = storage.restore(&entries[e], &CANmodule) == ODR_OK;
+        opEnd(&ops[2], i, t, ok);
+        /* store again, so each restore works on stored data */
+        storage.store(&entries[e], &CANmodule);
+    }
+    closeStorage();
+
+    /* auto storage: change of one entry, saved on the next call (debounce time is zero for this program) */
+    initStorage(true);
+    for (long i = 0; i < count; i++) {
+        long e = i % entriesCount;
+        fillData(e, (uint32_t)(i + count));
+        uint64_t t = opStart();
+        bool_t ok = autoSave(e) == 0;
+        opEnd(&ops[3], i, t, ok);
+    }
+    closeStorage();
+
+    printf("%s, %ld entries of %zu bytes%s, %ld operations each\n", directory, entriesCount, entrySize,
+           container ? ", container" : journal ? ", journal" : "", count);
+    printf("%-8s %6s %6s %8s %8s %8s %8s %6s %6s %6s %6s %6s %9s\n", "op", "count", "errors", "p50[us]", "p90[us]",
+           "p99[us]", "max[us]", "open", "read", "write", "sync", "meta", "bytes/op");
+    for (int o = 0; o < 4; o++) {
+        printOp(&ops[o]);
+        if (ops[o].errors > 0) {
+            ret = -1;
+        }
+        free(ops[o].lat);
+    }
+    return ret;
+}
+
+/* load the files in a child process, so storage of this process is not disturbed. Return counter of the first entry,
+ * DEFAULT_N for default values, -1 for inconsistent data, -2 on error. *err is result of CO_storageLinux_init() */
+static long
+loadInChild(CO_ReturnError_t* err, uint32_t* load_us) {
+    struct {
+        CO_ReturnError_t err;
+        uint32_t load_us;
+        long found;
+    } res = {CO_ERROR_NO, 0, -2};
+    int pfd[2];
+
+    if (pipe(pfd) != 0) {
+        return -2;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(pfd[0]);
+        fillData(0, (uint32_t)DEFAULT_N);
+        uint64_t t = now_us();
+        res.err = initStorage(false);
+        res.load_us = (uint32_t)(now_us() - t);
+        res.found = checkData();
+        if (write(pfd[1], &res, sizeof(res)) != sizeof(res)) {
+            _exit(EXIT_FAILURE);
+        }
+        _exit(EXIT_SUCCESS);
+    }
+    close(pfd[1]);
+    if (pid < 0 || read(pfd[0], &res, sizeof(res)) != sizeof(res)) {
+        res.found = -2;
+    }
+    close(pfd[0]);
+    if (pid > 0) {
+        waitpid(pid, NULL, 0);
+    }
+    *err = res.err;
+    *load_us = res.load_us;
+    return res.found;
+}
+
+/* store all entries once with the store command (the first one with pattern 1), so all files exist, then start the
+ * storage again in selected mode, like after restart. Return true on success */
+static bool_t
+storeAll(bool_t autoStorage) {
+    bool_t ok = true;
+
+    deleteFiles();
+    initStorage(false);
+    for (long i = entriesCount - 1; i >= 0; i--) {
+        fillData(i, i == 0 ? 1 : 0);
+        ok = ok && storage.store(&entries[i], &CANmodule) == ODR_OK;
+    }
+    closeStorage();
+    return ok && initStorage(autoStorage) == CO_ERROR_NO && checkData() == 1;
+}
+
+static const char*
+dataName(long found, char* buf, size_t size) {
+    if (found == (long)DEFAULT_N) {
+        return "defaults";
+    }
+    if (found < 0) {
+        return found == -1 ? "TORN" : "error";
+    }
+    snprintf(buf, size, "store %u", (unsigned)found);
+    return buf;
+}
+
+/* store pattern n into the first entry with the store command or auto storage, return true on success */
+static bool_t
+storeFirst(bool_t autoStorage, uint32_t n) {
+    fillData(0, n);
+    if (!autoStorage) {
+        return storage.store(&entries[0], &CANmodule) == ODR_OK;
+    }
+    return autoSave(0) == 0;
+}
+
+/* Verdict of one fault */
+typedef enum { VERDICT_PASS, VERDICT_NA, VERDICT_LOSS, VERDICT_FAIL } verdict_t;
+static const char* verdictName[] = {"PASS", "n/a", "LOSS", "FAIL"};
+
+/* one syscall fault: previous store 1, faulty store 2, recovery store 3 */
+static verdict_t
+syscallFault(const char* name, fault_t fault, bool_t autoStorage) {
+    char b1[20], b2[20];
+    CO_ReturnError_t err, errFound;
+    uint32_t load_us;
+
+    bool_t ok = storeAll(autoStorage);
+
+    faultsInjected = 0;
+    faultArmed = fault;
+    uint64_t t = now_us();
+    bool_t faultOk = storeFirst(autoStorage, 2);
+    uint32_t fault_us = (uint32_t)(now_us() - t);
+    faultArmed = FAULT_NONE;
+    long found = loadInChild(&errFound, &load_us);
+
+    /* recovery: store command again; auto storage retries itself after CO_STORAGE_AUTO_INTERVAL */
+    fillData(0, 3);
+    t = now_us();
+    bool_t recovered;
+    if (!autoStorage) {
+        recovered = storage.store(&entries[0], &CANmodule) == ODR_OK;
+    } else {
+        uint32_t mask;
+        CO_storageLinux_markDirty(&storage, data, entrySize);
+        while ((mask = CO_storageLinux_auto_process(&storage, false)) != 0 && now_us() - t < AUTO_RETRY_TIMEOUT_US) {
+            usleep(1000);
+        }
+        recovered = mask == 0;
+    }
+    uint32_t recovery_us = (uint32_t)(now_us() - t);
+    closeStorage();
+    long after = loadInChild(&err, &load_us);
+
+    /* Data on the storage must be the previous or the new complete store, new only if store reported success.
+     * Defaults, reported as corrupt, mean the previous data were lost. */
+    verdict_t verdict = VERDICT_FAIL;
+    if (!ok || !recovered || after != 3 || err != CO_ERROR_NO) {
+        verdict = VERDICT_FAIL;
+    } else if (faultsInjected == 0) {
+        verdict = VERDICT_NA;
+    } else if ((found == 1 && !faultOk) || found == 2) {
+        verdict = VERDICT_PASS;
+    } else if (found == (long)DEFAULT_N && errFound == CO_ERROR_DATA_CORRUPT) {
+        verdict = VERDICT_LOSS;
+    }
+    printf("%-14s %-5s %8s %9u %-10s %10u %-10s %s\n", name, autoStorage ? "auto" : "store",
+           faultsInjected == 0 ? "-" : faultOk ? "ok" : "error", fault_us, dataName(found, b1, sizeof(b1)),
+           recovery_us, dataName(after, b2, sizeof(b2)), verdictName[verdict]);
+    return verdict;
+}
+
+typedef enum { DAMAGE_TRUNCATE, DAMAGE_EMPTY, DAMAGE_FLIP, DAMAGE_TMP, DAMAGE_JOURNAL_TAIL } damage_t;
+
+/* damage the file of the first entry (or the container) after store 1, return false if not applicable */
+static bool_t
+damageFile(damage_t damage) {
+    char filename[CO_STORAGE_PATH_MAX + 8];
+    char name[CO_STORAGE_PATH_MAX];
+    static const uint8_t garbage[] = {0x02, 0x00, 0x10, 0x00, 0xFF, 0xFF, 0xFF, 0x7F, 0x55, 0x55};
+
+    if (container) {
+        containerFilename(name, sizeof(name));
+    } else {
+        entryFilename(name, sizeof(name), 0);
+    }
+    snprintf(filename, sizeof(filename), "%s%s", name,
+             damage == DAMAGE_TMP ? ".tmp" : damage == DAMAGE_JOURNAL_TAIL ? ".jrn" : "");
+    if (damage == DAMAGE_JOURNAL_TAIL && (!journal || container)) {
+        return false;
+    }
+    int fd = open(filename, O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if (fd < 0) {
+        return false;
+    }
+    off_t size = lseek(fd, 0, SEEK_END);
+    bool_t ok = true;
+    switch (damage) {
+        case DAMAGE_TRUNCATE: ok = ftruncate(fd, size / 2) == 0; break;
+        case DAMAGE_EMPTY: ok = ftruncate(fd, 0) == 0; break;
+        case DAMAGE_FLIP: {
+            uint8_t c;
+            ok = size > 0 && pread(fd, &c, 1, size / 2) == 1;
+            c ^= 0x10;
+            ok = ok && pwrite(fd, &c, 1, size / 2) == 1;
+            break;
+        }
+        case DAMAGE_TMP:
+        case DAMAGE_JOURNAL_TAIL:
+            /* stale temporary file or incomplete record at the end of the journal */
+            ok = pwrite(fd, garbage, sizeof(garbage), size) == (ssize_t)sizeof(garbage);
+            break;
+    }
+    close(fd);
+    return ok;
+}
+
+/* damaged file before startup: data must be store 1 or defaults reported as corrupt, then store 3 must succeed */
+static verdict_t
+fileFault(const char* name, damage_t damage) {
+    char b1[20], b2[20];
+    CO_ReturnError_t err, errAfter;
+    uint32_t load_us, load2_us;
+
+    bool_t ok = storeAll(false);
+    closeStorage();
+    if (!damageFile(damage)) {
+        return VERDICT_NA;
+    }
+
+    long found = loadInChild(&err, &load_us);
+    fillData(0, (uint32_t)DEFAULT_N);
+    initStorage(false);
+    fillData(0, 3);
+    uint64_t t = now_us();
+    bool_t recovered = storage.store(&entries[0], &CANmodule) == ODR_OK;
+    uint32_t recovery_us = (uint32_t)(now_us() - t);
+    closeStorage();
+    long after = loadInChild(&errAfter, &load2_us);
+
+    /* damage from outside can not be repaired, but it must be detected. In container damage may hit other entries */
+    bool_t pass = ok && (found == 1 || (found == (long)DEFAULT_N && err == CO_ERROR_DATA_CORRUPT)) && recovered
+                  && after == 3 && errAfter == CO_ERROR_NO;
+    printf("%-14s %-5s %8s %9u %-10s %10u %-10s %s\n", name, "init", err == CO_ERROR_NO ? "ok" : "corrupt", load_us,
+           dataName(found, b1, sizeof(b1)), recovery_us, dataName(after, b2, sizeof(b2)),
+           verdictName[pass ? VERDICT_PASS : VERDICT_FAIL]);
+    return pass ? VERDICT_PASS : VERDICT_FAIL;
+}
+
+static int
+faultTest(void) {
+    static const struct {
+        const char* name;
+        fault_t fault;
+    } syscallFaults[] = {{"ENOSPC create", FAULT_ENOSPC_OPEN},
+                         {"ENOSPC write", FAULT_ENOSPC_WRITE},
+                         {"short write", FAULT_SHORT_WRITE},
+                         {"EIO sync", FAULT_EIO_SYNC},
+                         {"EIO rename", FAULT_EIO_RENAME}};
+    static const struct {
+        const char* name;
+        damage_t damage;
+    } fileFaults[] = {{"torn file", DAMAGE_TRUNCATE},
+                      {"empty file", DAMAGE_EMPTY},
+                      {"flipped byte", DAMAGE_FLIP},
+                      {"stale tmp", DAMAGE_TMP},
+                      {"torn journal", DAMAGE_JOURNAL_TAIL}};
+    unsigned long verdicts[4] = {0};
+
+    printf("\nfault injection, first entry: store 1, faulty store 2, recovery store 3\n");
+    printf("%-14s %-5s %8s %9s %-10s %10s %-10s %s\n", "fault", "op", "result", "fault[us]", "loaded", "recov[us]",
+           "after", "verdict");
+    for (size_t i = 0; i < sizeof(syscallFaults) / sizeof(syscallFaults[0]); i++) {
+        for (int a = 0; a < 2; a++) {
+            verdicts[syscallFault(syscallFaults[i].name, syscallFaults[i].fault, a == 1)]++;
+        }
+    }
+    for (size_t i = 0; i < sizeof(fileFaults) / sizeof(fileFaults[0]); i++) {
+        verdicts[fileFault(fileFaults[i].name, fileFaults[i].damage)]++;
+    }
+    printf("%lu passed, %lu not applicable, %lu with loss of previous data (detected), %lu failed\n",
+           verdicts[VERDICT_PASS], verdicts[VERDICT_NA], verdicts[VERDICT_LOSS], verdicts[VERDICT_FAIL]);
+    return verdicts[VERDICT_FAIL] > 0 ? -1 : 0;
+}
+
+int
+main(int argc, char* argv[]) {
+    int opt;
+
+    if (argc >= 2 && strcmp(argv[1], "--help") == 0) {
+        printUsage(argv[0]);
+        exit(EXIT_SUCCESS);
+    }
+    while ((opt = getopt(argc, argv, "d:s:e:n:jCf")) != -1) {
+        switch (opt) {
+            case 'd': directory = optarg; break;
+            case 's': entrySize = (size_t)atol(optarg); break;
+            case 'e': entriesCount = atol(optarg); break;
+            case 'n': count = atol(optarg); break;
+            case 'j': journal = true; break;
+            case 'C': container = true; break;
+            case 'f': faults = true; break;
+            default: printUsage(argv[0]); exit(EXIT_FAILURE);
+        }
+    }
+    if (entrySize < 4 || count < 1 || entriesCount < 1 || entriesCount > ENTRIES_MAX) {
+        printUsage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    data = malloc(entrySize * (size_t)entriesCount);
+    if (data == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+
+    /* files from previous run may have different size, all entries are stored once, so they can be loaded */
+    deleteFiles();
+    CO_ReturnError_t err = initStorage(false);
+    if (err != CO_ERROR_NO && err != CO_ERROR_DATA_CORRUPT) {
+        fprintf(stderr, "CO_storageLinux_init() failed, err=%d\n", err);
+        exit(EXIT_FAILURE);
+    }
+    for (long i = 0; i < entriesCount; i++) {
+        fillData(i, 0);
+        if (storage.store(&entries[i], &CANmodule) != ODR_OK) {
+            fprintf(stderr, "store failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    closeStorage();
+
+    int ret = operationsTest();
+    if (faults && faultTest() < 0) {
+        ret = -1;
+    }
+    deleteFiles();
+    free(data);
+    return ret < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
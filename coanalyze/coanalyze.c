@@ -0,0 +1,958 @@
+/*
+ * Offline analyzer of CAN captures, which decodes CANopen events in parallel.
+ *
+ * @file        coanalyze.c
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <linux/can.h>
+
+/* Default CANopen COB-IDs, same as CO_Default_CAN_ID_t in CANopenNode/301/CO_driver.h */
+#define CO_CAN_ID_NMT_SERVICE 0x000
+#define CO_CAN_ID_SYNC        0x080
+#define CO_CAN_ID_EMERGENCY   0x080
+#define CO_CAN_ID_TIME        0x100
+#define CO_CAN_ID_TPDO_1      0x180
+#define CO_CAN_ID_RPDO_4      0x500
+#define CO_CAN_ID_SDO_SRV     0x580
+#define CO_CAN_ID_SDO_CLI     0x600
+#define CO_CAN_ID_HEARTBEAT   0x700
+#define CO_CAN_ID_LSS_SLV     0x7E4
+#define CO_CAN_ID_LSS_MST     0x7E5
+
+/* Files smaller than this are not split */
+#ifndef MIN_CHUNK_SIZE
+#define MIN_CHUNK_SIZE (16 * 1024 * 1024)
+#endif
+/* Number of chunks per thread, for load balancing */
+#define CHUNKS_PER_THREAD 4
+/* Number of consecutive valid pcap records, which confirm a record boundary */
+#define PCAP_SYNC_RECORDS 8
+
+/* pcap file format */
+#define PCAP_MAGIC_US           0xA1B2C3D4
+#define PCAP_MAGIC_NS           0xA1B23C4D
+#define PCAP_LINKTYPE_SOCKETCAN 227
+
+/* classes of CAN frames */
+typedef enum {
+    CL_NMT,
+    CL_SYNC,
+    CL_EMCY,
+    CL_TIME,
+    CL_PDO,
+    CL_SDO_TX, /* SDO server -> client (0x580 + node-ID) */
+    CL_SDO_RX, /* SDO client -> server (0x600 + node-ID) */
+    CL_HB,
+    CL_LSS,
+    CL_OTHER,
+    CL_COUNT
+} frameClass_t;
+
+static const char* classNames[CL_COUNT] = {"NMT", "SYNC", "EMCY", "TIME", "PDO", "SDO tx", "SDO rx", "HB",
+                                           "LSS", "other"};
+
+/* kinds of events */
+typedef enum { EV_NMT, EV_BOOTUP, EV_STATE, EV_HB_GAP, EV_EMCY, EV_SDO_ABORT } eventKind_t;
+
+typedef struct {
+    int64_t ts; /* ns */
+    uint32_t value;
+    uint8_t node;
+    uint8_t kind;
+    uint8_t aux;
+} event_t;
+
+typedef struct {
+    int64_t ts;
+    uint8_t state;
+} hbSample_t;
+
+/* growing array */
+typedef struct {
+    void* data;
+    size_t count;
+    size_t size;
+} vec_t;
+
+/* SDO transaction state */
+enum { SDO_IDLE, SDO_UNKNOWN, SDO_UPLOAD, SDO_DOWNLOAD, SDO_BLK_UP, SDO_BLK_DOWN };
+enum { PH_INIT, PH_DATA, PH_END };
+
+/* statistics of one node in one chunk */
+typedef struct {
+    vec_t hb;     /* hbSample_t */
+    vec_t sdoDur; /* uint32_t, us */
+    unsigned long emcy;
+    unsigned long pdo;
+    unsigned long sdoAborts;
+    unsigned long sdoIncomplete;
+    /* SDO state machine, chunk starts in unknown state */
+    int sdoState;
+    int sdoPhase;
+    int sdoLast;
+    int64_t sdoStart;
+    int64_t sdoLastFrame; /* last SDO frame, 0 if none */
+    int64_t headEnd; /* end of transaction, which started in previous chunk: -1 if not seen in this chunk, 0 if it
+                        ended with the last SDO frame of previous chunk */
+} nodeStat_t;
+
+/* one chunk of the capture file */
+typedef struct {
+    const uint8_t* begin;
+    const uint8_t* end;
+    unsigned long frames;
+    unsigned long classes[CL_COUNT];
+    unsigned long errors; /* lines or records, which can not be parsed */
+    int64_t first;
+    int64_t last;
+    /* SYNC intervals */
+    unsigned long syncCount;
+    int64_t syncFirst;
+    int64_t syncLast;
+    double syncSum;
+    double syncSumSq;
+    int64_t syncMin;
+    int64_t syncMax;
+    vec_t events;
+    nodeStat_t nodes[128];
+} chunk_t;
+
+/* input file */
+typedef struct {
+    const uint8_t* map;
+    size_t size;
+    int pcap;
+    int swapped; /* pcap byte order differs from host */
+    int nsec;    /* pcap timestamps in nanoseconds */
+    uint32_t firstSec; /* timestamp of the first pcap record */
+    chunk_t* chunks;
+    int chunkCount;
+    int nextChunk;
+    pthread_mutex_t lock;
+} capture_t;
+
+static int
+vecPush(vec_t* v, const void* item, size_t itemSize) {
+    if (v->count >= v->size) {
+        size_t size = v->size > 0 ? v->size * 2 : 64;
+        void* data = realloc(v->data, size * itemSize);
+        if (data == NULL) {
+            return -1;
+        }
+        v->data = data;
+        v->size = size;
+    }
+    memcpy((uint8_t*)v->data + v->count * itemSize, item, itemSize);
+    v->count++;
+    return 0;
+}
+
+static void
+addEvent(vec_t* events, int64_t ts, uint8_t node, eventKind_t kind, uint32_t value, uint8_t aux) {
+    event_t ev = {.ts = ts, .value = value, .node = node, .kind = (uint8_t)kind, .aux = aux};
+    vecPush(events, &ev, sizeof(ev));
+}
+
+/* Classify frame by its COB-ID, return class and node-ID (0 if not node specific) */
+static frameClass_t
+classify(canid_t id, uint8_t* node) {
+    *node = 0;
+    if ((id & CAN_EFF_FLAG) != 0 || (id & CAN_ERR_FLAG) != 0) {
+        return CL_OTHER;
+    }
+    id &= CAN_SFF_MASK;
+    if (id == CO_CAN_ID_NMT_SERVICE) {
+        return CL_NMT;
+    }
+    if (id == CO_CAN_ID_SYNC) {
+        return CL_SYNC;
+    }
+    if (id == CO_CAN_ID_TIME) {
+        return CL_TIME;
+    }
+    if (id == CO_CAN_ID_LSS_SLV || id == CO_CAN_ID_LSS_MST) {
+        return CL_LSS;
+    }
+    *node = (uint8_t)(id & 0x7F);
+    if (*node == 0) {
+        return CL_OTHER;
+    }
+    switch (id & 0x780) {
+        case CO_CAN_ID_EMERGENCY: return CL_EMCY;
+        case CO_CAN_ID_SDO_SRV: return CL_SDO_TX;
+        case CO_CAN_ID_SDO_CLI: return CL_SDO_RX;
+        case CO_CAN_ID_HEARTBEAT: return CL_HB;
+        default:
+            if (id >= CO_CAN_ID_TPDO_1 && id < CO_CAN_ID_RPDO_4 + 0x80) {
+                return CL_PDO;
+            }
+    }
+    *node = 0;
+    return CL_OTHER;
+}
+
+/* End of SDO transaction */
+static void
+sdoEnd(chunk_t* ch, nodeStat_t* ns, uint8_t node, int64_t ts, int abort, const uint8_t* data) {
+    if (ns->sdoState == SDO_UNKNOWN) {
+        /* transaction started in previous chunk */
+        ns->headEnd = ts;
+    } else if (ns->sdoState != SDO_IDLE) {
+        uint32_t dur = (uint32_t)((ts - ns->sdoStart) / 1000);
+        vecPush(&ns->sdoDur, &dur, sizeof(dur));
+    }
+    if (abort) {
+        uint32_t code = (uint32_t)data[4] | (uint32_t)data[5] << 8 | (uint32_t)data[6] << 16 | (uint32_t)data[7] << 24;
+        ns->sdoAborts++;
+        addEvent(&ch->events, ts, node, EV_SDO_ABORT, code, 0);
+    }
+    ns->sdoState = SDO_IDLE;
+}
+
+/* SDO state machine, follows transactions of one client with the server */
+static void
+sdoFrame(chunk_t* ch, nodeStat_t* ns, uint8_t node, int64_t ts, int fromClient, const uint8_t* data, uint8_t dlc) {
+    uint8_t cmd = data[0];
+
+    if (dlc < 8) {
+        return;
+    }
+    int64_t prevFrame = ns->sdoLastFrame;
+    ns->sdoLastFrame = ts;
+
+    /* sequence numbers in block data may look like anything, abort is 0x80 only outside data phase */
+    int blockData = (ns->sdoState == SDO_BLK_DOWN && fromClient && ns->sdoPhase == PH_DATA)
+                    || (ns->sdoState == SDO_BLK_UP && !fromClient && ns->sdoPhase == PH_DATA);
+    if (cmd == 0x80 && !blockData) {
+        sdoEnd(ch, ns, node, ts, 1, data);
+        return;
+    }
+
+    if (fromClient && !blockData) {
+        int initiate = (cmd & 0xE0) == 0x20 || cmd == 0x40 || (cmd & 0xE1) == 0xC0 || (cmd & 0xE3) == 0xA0;
+        if (ns->sdoState == SDO_UNKNOWN && initiate) {
+            /* previous transaction ended with the last frame before this one */
+            if (ns->headEnd < 0) {
+                ns->headEnd = prevFrame;
+            }
+            ns->sdoState = SDO_IDLE;
+        }
+        if (ns->sdoState == SDO_IDLE || (initiate && ns->sdoPhase == PH_INIT && ns->sdoState != SDO_UNKNOWN)) {
+            if (ns->sdoState != SDO_IDLE) {
+                ns->sdoIncomplete++; /* repeated request without response */
+            }
+            if (!initiate) {
+                return;
+            }
+            ns->sdoStart = ts;
+            ns->sdoPhase = PH_INIT;
+            ns->sdoLast = 0;
+            if ((cmd & 0xE0) == 0x20) {
+                ns->sdoState = SDO_DOWNLOAD;
+                ns->sdoLast = (cmd & 0x02) != 0; /* expedited */
+            } else if (cmd == 0x40) {
+                ns->sdoState = SDO_UPLOAD;
+            } else if ((cmd & 0xE1) == 0xC0) {
+                ns->sdoState = SDO_BLK_DOWN;
+            } else {
+                ns->sdoState = SDO_BLK_UP;
+            }
+            return;
+        }
+    }
+
+    switch (ns->sdoState) {
+        case SDO_UPLOAD:
+            if (!fromClient) {
+                if ((cmd & 0xE0) == 0x40 && (cmd & 0x02) != 0) {
+                    sdoEnd(ch, ns, node, ts, 0, data); /* expedited */
+                } else if ((cmd & 0xE0) == 0x00 && (cmd & 0x01) != 0) {
+                    sdoEnd(ch, ns, node, ts, 0, data); /* last segment */
+                }
+            }
+            break;
+        case SDO_DOWNLOAD:
+            if (fromClient && (cmd & 0xE0) == 0x00 && (cmd & 0x01) != 0) {
+                ns->sdoLast = 1;
+            } else if (!fromClient && ns->sdoLast && ((cmd & 0xE0) == 0x60 || (cmd & 0xE0) == 0x20)) {
+                sdoEnd(ch, ns, node, ts, 0, data);
+            }
+            break;
+        case SDO_BLK_DOWN:
+            if (ns->sdoPhase == PH_INIT && !fromClient && (cmd & 0xE3) == 0xA0) {
+                ns->sdoPhase = PH_DATA;
+            } else if (ns->sdoPhase == PH_DATA && fromClient && (cmd & 0x80) != 0) {
+                ns->sdoLast = 1;
+            } else if (ns->sdoPhase == PH_DATA && !fromClient && (cmd & 0xE3) == 0xA2) {
+                ns->sdoPhase = ns->sdoLast ? PH_END : PH_DATA;
+            } else if (ns->sdoPhase == PH_END && !fromClient && (cmd & 0xE3) == 0xA1) {
+                sdoEnd(ch, ns, node, ts, 0, data);
+            }
+            break;
+        case SDO_BLK_UP:
+            if (ns->sdoPhase == PH_INIT && fromClient && cmd == 0xA3) {
+                ns->sdoPhase = PH_DATA;
+            } else if (ns->sdoPhase == PH_DATA && !fromClient && (cmd & 0x80) != 0) {
+                ns->sdoLast = 1;
+            } else if (ns->sdoPhase == PH_DATA && fromClient && (cmd & 0xE3) == 0xA2) {
+                ns->sdoPhase = ns->sdoLast ? PH_END : PH_DATA;
+            } else if (ns->sdoPhase == PH_END && fromClient && (cmd & 0xE3) == 0xA1) {
+                sdoEnd(ch, ns, node, ts, 0, data);
+            }
+            break;
+        default: break;
+    }
+}
+
+/* Decode one frame */
+static void
+processFrame(chunk_t* ch, int64_t ts, canid_t id, const uint8_t* data, uint8_t dlc) {
+    uint8_t node;
+    frameClass_t cl = classify(id, &node);
+    nodeStat_t* ns = &ch->nodes[node];
+
+    if (ch->frames == 0) {
+        ch->first = ts;
+    }
+    ch->last = ts;
+    ch->frames++;
+    ch->classes[cl]++;
+
+    switch (cl) {
+        case CL_NMT:
+            if (dlc >= 2) {
+                addEvent(&ch->events, ts, data[1], EV_NMT, data[0], 0);
+            }
+            break;
+        case CL_SYNC:
+            if (ch->syncCount == 0) {
+                ch->syncFirst = ts;
+                ch->syncMin = INT64_MAX;
+            } else {
+                int64_t interval = ts - ch->syncLast;
+                ch->syncSum += (double)interval;
+                ch->syncSumSq += (double)interval * (double)interval;
+                if (interval < ch->syncMin) {
+                    ch->syncMin = interval;
+                }
+                if (interval > ch->syncMax) {
+                    ch->syncMax = interval;
+                }
+            }
+            ch->syncLast = ts;
+            ch->syncCount++;
+            break;
+        case CL_EMCY:
+            ns->emcy++;
+            if (dlc >= 3) {
+                addEvent(&ch->events, ts, node, EV_EMCY, (uint32_t)data[0] | (uint32_t)data[1] << 8, data[2]);
+            }
+            break;
+        case CL_PDO: ns->pdo++; break;
+        case CL_SDO_TX: sdoFrame(ch, ns, node, ts, 0, data, dlc); break;
+        case CL_SDO_RX: sdoFrame(ch, ns, node, ts, 1, data, dlc); break;
+        case CL_HB:
+            if (dlc >= 1 && (id & CAN_RTR_FLAG) == 0) {
+                hbSample_t hb = {.ts = ts, .state = data[0] & 0x7F};
+                vecPush(&ns->hb, &hb, sizeof(hb));
+            }
+            break;
+        default: break;
+    }
+}
+
+static int
+hexNibble(uint8_t c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+/* Parse text line: "(<sec>.<frac>) [<interface>] <id>#<data>", as written by candump -l and cocomm */
+static int
+parseLine(chunk_t* ch, const uint8_t* p, const uint8_t* end) {
+    int64_t sec = 0, frac = 0;
+    int fracDigits = 0;
+    canid_t id = 0;
+    uint8_t data[8] = {0};
+    uint8_t dlc = 0;
+    int idDigits = 0;
+
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+    if (p == end || *p != '(') {
+        return -1;
+    }
+    for (p++; p < end && *p >= '0' && *p <= '9'; p++) {
+        sec = sec * 10 + (*p - '0');
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++) {
+            if (fracDigits < 9) {
+                frac = frac * 10 + (*p - '0');
+                fracDigits++;
+            }
+        }
+    }
+    if (p == end || *p != ')') {
+        return -1;
+    }
+    for (; fracDigits < 9; fracDigits++) {
+        frac *= 10;
+    }
+
+    /* frame is the token with '#' */
+    const uint8_t* hash = memchr(p, '#', (size_t)(end - p));
+    if (hash == NULL) {
+        return -1;
+    }
+    const uint8_t* q = hash;
+    while (q > p && hexNibble(q[-1]) >= 0) {
+        q--;
+    }
+    for (; q < hash; q++) {
+        id = (id << 4) | (canid_t)hexNibble(*q);
+        idDigits++;
+    }
+    if (idDigits == 0) {
+        return -1;
+    }
+    if (idDigits > 3) {
+        id |= CAN_EFF_FLAG;
+    }
+    p = hash + 1;
+    if (p < end && *p == '#') {
+        p += 2; /* CAN FD flags */
+    }
+    if (p < end && *p == 'R') {
+        id |= CAN_RTR_FLAG;
+    } else {
+        while (p + 1 < end && dlc < 8) {
+            int h = hexNibble(p[0]), l = hexNibble(p[1]);
+            if (h < 0 || l < 0) {
+                break;
+            }
+            data[dlc++] = (uint8_t)(h << 4 | l);
+            p += 2;
+        }
+    }
+    processFrame(ch, sec * 1000000000 + frac, id, data, dlc);
+    return 0;
+}
+
+static uint32_t
+pcap32(const capture_t* cap, const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return cap->swapped ? __builtin_bswap32(v) : v;
+}
+
+/* Check pcap record header, return record size or 0 */
+static size_t
+pcapRecord(const capture_t* cap, const uint8_t* p, const uint8_t* end) {
+    if (end - p < 16) {
+        return 0;
+    }
+    uint32_t frac = pcap32(cap, p + 4), caplen = pcap32(cap, p + 8), len = pcap32(cap, p + 12);
+    if (caplen < 8 || caplen > 72 || caplen > len || frac >= (cap->nsec ? 1000000000U : 1000000U)
+        || (size_t)(end - p) < 16 + caplen || p[16 + 6] != 0) {
+        return 0;
+    }
+    return 16 + caplen;
+}
+
+static void
+parseChunk(const capture_t* cap, chunk_t* ch) {
+    const uint8_t* p = ch->begin;
+
+    if (!cap->pcap) {
+        while (p < ch->end) {
+            const uint8_t* nl = memchr(p, '\n', (size_t)(ch->end - p));
+            const uint8_t* lineEnd = nl != NULL ? nl : ch->end;
+            if (lineEnd > p && parseLine(ch, p, lineEnd) < 0) {
+                ch->errors++;
+            }
+            p = lineEnd + 1;
+        }
+        return;
+    }
+
+    while (p < ch->end) {
+        size_t recSize = pcapRecord(cap, p, cap->map + cap->size);
+        if (recSize == 0) {
+            ch->errors++;
+            break;
+        }
+        uint32_t canId;
+        int64_t ts = (int64_t)pcap32(cap, p) * 1000000000 + (int64_t)pcap32(cap, p + 4) * (cap->nsec ? 1 : 1000);
+        memcpy(&canId, p + 16, 4);
+        uint8_t dlc = p[16 + 4];
+        uint8_t data[8] = {0};
+        uint32_t caplen = (uint32_t)recSize - 16;
+        memcpy(data, p + 24, caplen - 8 < 8 ? caplen - 8 : 8);
+        processFrame(ch, ts, ntohl(canId), data, dlc > 8 ? 8 : dlc);
+        p += recSize;
+    }
+}
+
+/* Find beginning of a pcap record at or after p: PCAP_SYNC_RECORDS valid records in a row */
+static const uint8_t*
+pcapSync(const capture_t* cap, const uint8_t* p) {
+    const uint8_t* end = cap->map + cap->size;
+
+    for (; p < end; p++) {
+        const uint8_t* q = p;
+        int i;
+        uint32_t prevSec = cap->firstSec;
+        for (i = 0; i < PCAP_SYNC_RECORDS && q < end; i++) {
+            size_t recSize = pcapRecord(cap, q, end);
+            uint32_t sec = recSize > 0 ? pcap32(cap, q) : 0;
+            /* timestamps are not decreasing and close to each other */
+            if (recSize == 0 || sec < prevSec || (i > 0 && sec - prevSec > 3600)) {
+                break;
+            }
+            prevSec = sec;
+            q += recSize;
+        }
+        if (i == PCAP_SYNC_RECORDS || q == end) {
+            return p;
+        }
+    }
+    return end;
+}
+
+static void*
+workerThread(void* arg) {
+    capture_t* cap = (capture_t*)arg;
+
+    for (;;) {
+        pthread_mutex_lock(&cap->lock);
+        int i = cap->nextChunk++;
+        pthread_mutex_unlock(&cap->lock);
+        if (i >= cap->chunkCount) {
+            break;
+        }
+        parseChunk(cap, &cap->chunks[i]);
+    }
+    return NULL;
+}
+
+static int
+compareU32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static int
+compareI64(const void* a, const void* b) {
+    int64_t x = *(const int64_t*)a, y = *(const int64_t*)b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static int
+compareEvent(const void* a, const void* b) {
+    return compareI64(&((const event_t*)a)->ts, &((const event_t*)b)->ts);
+}
+
+static const char*
+nmtStateName(uint8_t state) {
+    switch (state) {
+        case 0: return "boot-up";
+        case 4: return "stopped";
+        case 5: return "operational";
+        case 127: return "pre-operational";
+        default: return "unknown";
+    }
+}
+
+static const char*
+nmtCommandName(uint8_t cmd) {
+    switch (cmd) {
+        case 1: return "start";
+        case 2: return "stop";
+        case 128: return "preop";
+        case 129: return "reset node";
+        case 130: return "reset communication";
+        default: return "unknown";
+    }
+}
+
+static void
+printEvent(const event_t* ev) {
+    printf("(%lld.%06lld) ", (long long)(ev->ts / 1000000000), (long long)(ev->ts % 1000000000 / 1000));
+    switch (ev->kind) {
+        case EV_NMT:
+            if (ev->node == 0) {
+                printf("NMT %s all nodes\n", nmtCommandName((uint8_t)ev->value));
+            } else {
+                printf("NMT %s node %d\n", nmtCommandName((uint8_t)ev->value), ev->node);
+            }
+            break;
+        case EV_BOOTUP: printf("node %d boot-up\n", ev->node); break;
+        case EV_STATE:
+            printf("node %d %s -> %s\n", ev->node, nmtStateName(ev->aux), nmtStateName((uint8_t)ev->value));
+            break;
+        case EV_HB_GAP: printf("node %d heartbeat gap %u ms\n", ev->node, ev->value); break;
+        case EV_EMCY: printf("node %d EMCY 0x%04X, error register 0x%02X\n", ev->node, ev->value, ev->aux); break;
+        case EV_SDO_ABORT: printf("node %d SDO abort 0x%08X\n", ev->node, ev->value); break;
+        default: break;
+    }
+}
+
+static void
+printUsage(char* progName) {
+    fprintf(stderr,
+            "Usage: %s [options] <capture file>\n"
+            "\n"
+            "Program decodes CAN capture into CANopen events and prints per-node timing\n"
+            "statistics: heartbeat intervals and gaps, NMT state changes, SDO transactions\n"
+            "with durations, EMCY and SYNC jitter. Capture is candump log file\n"
+            "('candump -l', lines '(<time>) <interface> <id>#<data>'), 'cocomm -d' output\n"
+            "or pcap file with SocketCAN link type ('cocomm -b', Wireshark). Large files\n"
+            "are decoded in parallel chunks.\n"
+            "\n"
+            "Options:\n"
+            "  -e               Print events (NMT, boot-up, state changes, heartbeat gaps,\n"
+            "                   EMCY, SDO aborts) in time order.\n"
+            "  -g <factor>      Heartbeat interval longer than <factor> times the median\n"
+            "                   interval of the node is a gap. Default 1.5.\n"
+            "  -j <threads>     Number of threads, default number of CPUs.\n"
+            "  --help           Display this help.\n"
+            "\n"
+            "See also: https://github.com/CANopenNode/CANopenLinux\n"
+            "\n",
+            progName);
+}
+
+int
+main(int argc, char* argv[]) {
+    static capture_t cap;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int printEvents = 0;
+    double gapFactor = 1.5;
+    int opt;
+
+    if (argc >= 2 && strcmp(argv[1], "--help") == 0) {
+        printUsage(argv[0]);
+        exit(EXIT_SUCCESS);
+    }
+    while ((opt = getopt(argc, argv, "eg:j:")) != -1) {
+        switch (opt) {
+            case 'e': printEvents = 1; break;
+            case 'g': gapFactor = atof(optarg); break;
+            case 'j': threads = atoi(optarg); break;
+            default: printUsage(argv[0]); exit(EXIT_FAILURE);
+        }
+    }
+    if (optind != argc - 1 || threads < 1 || gapFactor <= 1.0) {
+        printUsage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    /* map the whole file */
+    int fd = open(argv[optind], O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        perror("Can't open capture file");
+        exit(EXIT_FAILURE);
+    }
+    cap.size = (size_t)st.st_size;
+    if (cap.size == 0) {
+        fprintf(stderr, "Empty capture file\n");
+        exit(EXIT_FAILURE);
+    }
+    cap.map = mmap(NULL, cap.size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (cap.map == MAP_FAILED) {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+    madvise((void*)cap.map, cap.size, MADV_SEQUENTIAL);
+
+    const uint8_t* data = cap.map;
+    if (cap.size >= 24) {
+        uint32_t magic;
+        memcpy(&magic, cap.map, 4);
+        if (magic == PCAP_MAGIC_US || magic == PCAP_MAGIC_NS || __builtin_bswap32(magic) == PCAP_MAGIC_US
+            || __builtin_bswap32(magic) == PCAP_MAGIC_NS) {
+            cap.pcap = 1;
+            cap.swapped = magic != PCAP_MAGIC_US && magic != PCAP_MAGIC_NS;
+            cap.nsec = magic == PCAP_MAGIC_NS || __builtin_bswap32(magic) == PCAP_MAGIC_NS;
+            if (pcap32(&cap, cap.map + 20) != PCAP_LINKTYPE_SOCKETCAN) {
+                fprintf(stderr, "pcap link type is not SocketCAN\n");
+                exit(EXIT_FAILURE);
+            }
+            data += 24;
+            if (cap.size >= 28) {
+                cap.firstSec = pcap32(&cap, data);
+            }
+        }
+    }
+
+    /* split into chunks at line or record boundaries */
+    size_t dataSize = cap.size - (size_t)(data - cap.map);
+    int chunkCount = threads * CHUNKS_PER_THREAD;
+    if (dataSize / MIN_CHUNK_SIZE + 1 < (size_t)chunkCount) {
+        chunkCount = (int)(dataSize / MIN_CHUNK_SIZE + 1);
+    }
+    cap.chunks = calloc((size_t)chunkCount, sizeof(chunk_t));
+    if (cap.chunks == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    const uint8_t* end = cap.map + cap.size;
+    const uint8_t* p = data;
+    for (int i = 0; i < chunkCount && p < end; i++) {
+        const uint8_t* chEnd = i == chunkCount - 1 ? end : data + dataSize / (size_t)chunkCount * (size_t)(i + 1);
+        if (chEnd <= p) {
+            continue;
+        }
+        if (chEnd < end) {
+            if (cap.pcap) {
+                chEnd = pcapSync(&cap, chEnd);
+            } else {
+                const uint8_t* nl = memchr(chEnd, '\n', (size_t)(end - chEnd));
+                chEnd = nl != NULL ? nl + 1 : end;
+            }
+        }
+        chunk_t* ch = &cap.chunks[cap.chunkCount++];
+        ch->begin = p;
+        ch->end = chEnd;
+        for (int n = 0; n < 128; n++) {
+            ch->nodes[n].sdoState = SDO_UNKNOWN;
+            ch->nodes[n].headEnd = -1;
+        }
+        p = chEnd;
+    }
+    /* first chunk starts at the beginning of the capture, nothing is in progress */
+    for (int n = 0; n < 128 && cap.chunkCount > 0; n++) {
+        cap.chunks[0].nodes[n].sdoState = SDO_IDLE;
+    }
+
+    /* decode chunks in parallel */
+    pthread_t* tids = calloc((size_t)threads, sizeof(pthread_t));
+    pthread_mutex_init(&cap.lock, NULL);
+    if (threads > cap.chunkCount) {
+        threads = cap.chunkCount;
+    }
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&tids[i], NULL, workerThread, &cap) != 0) {
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    free(tids);
+
+    /* merge chunks: totals, SYNC intervals, SDO transactions across chunk boundaries */
+    unsigned long frames = 0, errors = 0, classes[CL_COUNT] = {0};
+    unsigned long syncCount = 0, syncIntervals = 0;
+    double syncSum = 0, syncSumSq = 0;
+    int64_t syncMin = INT64_MAX, syncMax = 0, syncLast = 0;
+    int64_t first = 0, last = 0;
+    vec_t events = {0};
+    nodeStat_t* nodes = calloc(128, sizeof(nodeStat_t));
+    if (nodes == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    for (int n = 0; n < 128; n++) {
+        nodes[n].sdoState = SDO_IDLE;
+    }
+
+    for (int i = 0; i < cap.chunkCount; i++) {
+        chunk_t* ch = &cap.chunks[i];
+
+        if (ch->frames > 0) {
+            if (frames == 0) {
+                first = ch->first;
+            }
+            last = ch->last;
+        }
+        frames += ch->frames;
+        errors += ch->errors;
+        for (int c = 0; c < CL_COUNT; c++) {
+            classes[c] += ch->classes[c];
+        }
+
+        if (ch->syncCount > 0) {
+            if (syncCount > 0) {
+                int64_t interval = ch->syncFirst - syncLast;
+                syncSum += (double)interval;
+                syncSumSq += (double)interval * (double)interval;
+                syncMin = interval < syncMin ? interval : syncMin;
+                syncMax = interval > syncMax ? interval : syncMax;
+                syncIntervals++;
+            }
+            syncSum += ch->syncSum;
+            syncSumSq += ch->syncSumSq;
+            if (ch->syncCount > 1) {
+                syncMin = ch->syncMin < syncMin ? ch->syncMin : syncMin;
+                syncMax = ch->syncMax > syncMax ? ch->syncMax : syncMax;
+            }
+            syncIntervals += ch->syncCount - 1;
+            syncCount += ch->syncCount;
+            syncLast = ch->syncLast;
+        }
+
+        for (size_t e = 0; e < ch->events.count; e++) {
+            vecPush(&events, &((event_t*)ch->events.data)[e], sizeof(event_t));
+        }
+        free(ch->events.data);
+
+        for (int n = 1; n < 128; n++) {
+            nodeStat_t* src = &ch->nodes[n];
+            nodeStat_t* dst = &nodes[n];
+
+            /* transaction, which was open at the end of previous chunks, ended in this chunk */
+            if (i > 0 && src->headEnd >= 0 && dst->sdoState != SDO_IDLE) {
+                int64_t endTs = src->headEnd > 0 ? src->headEnd : dst->sdoLastFrame;
+                uint32_t dur = (uint32_t)((endTs - dst->sdoStart) / 1000);
+                vecPush(&dst->sdoDur, &dur, sizeof(dur));
+                dst->sdoState = SDO_IDLE;
+            }
+            /* state at the end of this chunk, unless whole chunk was inside the transaction */
+            if (src->sdoState != SDO_UNKNOWN) {
+                dst->sdoState = src->sdoState;
+                dst->sdoStart = src->sdoStart;
+            }
+            if (src->sdoLastFrame != 0) {
+                dst->sdoLastFrame = src->sdoLastFrame;
+            }
+
+            for (size_t k = 0; k < src->sdoDur.count; k++) {
+                vecPush(&dst->sdoDur, &((uint32_t*)src->sdoDur.data)[k], sizeof(uint32_t));
+            }
+            for (size_t k = 0; k < src->hb.count; k++) {
+                vecPush(&dst->hb, &((hbSample_t*)src->hb.data)[k], sizeof(hbSample_t));
+            }
+            free(src->sdoDur.data);
+            free(src->hb.data);
+            dst->emcy += src->emcy;
+            dst->pdo += src->pdo;
+            dst->sdoAborts += src->sdoAborts;
+            dst->sdoIncomplete += src->sdoIncomplete;
+        }
+    }
+
+    /* heartbeat intervals, gaps and state changes per node */
+    printf("%lu frames, %.3f s, %d chunk(s), %d thread(s)", frames, (double)(last - first) / 1e9, cap.chunkCount,
+           threads);
+    if (errors > 0) {
+        printf(", %lu unparsed lines or records", errors);
+    }
+    printf("\n");
+    for (int c = 0; c < CL_COUNT; c++) {
+        if (classes[c] > 0) {
+            printf("  %-8s %12lu\n", classNames[c], classes[c]);
+        }
+    }
+    if (syncIntervals > 0) {
+        double mean = syncSum / (double)syncIntervals;
+        double var = syncSumSq / (double)syncIntervals - mean * mean;
+        printf("SYNC: %lu frames, period %.1f us, jitter (std dev) %.1f us, min %.1f us, max %.1f us\n", syncCount,
+               mean / 1000, sqrt(var > 0 ? var : 0) / 1000, (double)syncMin / 1000, (double)syncMax / 1000);
+    }
+
+    printf("%4s %7s %9s %9s %5s %6s %5s %6s %5s %5s %9s %9s %9s %8s\n", "node", "hb", "hb[ms]", "hbMax[ms]",
+           "gaps", "states", "emcy", "sdo", "abort", "lost", "sdo p50", "sdo p99", "max[us]", "pdo");
+    for (int n = 1; n < 128; n++) {
+        nodeStat_t* ns = &nodes[n];
+        hbSample_t* hb = (hbSample_t*)ns->hb.data;
+        uint32_t* dur = (uint32_t*)ns->sdoDur.data;
+        int64_t median = 0, maxInterval = 0;
+        unsigned long gaps = 0, changes = 0;
+
+        if (ns->hb.count == 0 && ns->sdoDur.count == 0 && ns->emcy == 0 && ns->pdo == 0 && ns->sdoAborts == 0) {
+            continue;
+        }
+        if (ns->hb.count > 1) {
+            int64_t* intervals = malloc((ns->hb.count - 1) * sizeof(int64_t));
+            if (intervals == NULL) {
+                perror("malloc");
+                exit(EXIT_FAILURE);
+            }
+            for (size_t k = 1; k < ns->hb.count; k++) {
+                intervals[k - 1] = hb[k].ts - hb[k - 1].ts;
+            }
+            qsort(intervals, ns->hb.count - 1, sizeof(int64_t), compareI64);
+            median = intervals[(ns->hb.count - 2) / 2];
+            maxInterval = intervals[ns->hb.count - 2];
+            free(intervals);
+        }
+        for (size_t k = 0; k < ns->hb.count; k++) {
+            if (k > 0 && (double)(hb[k].ts - hb[k - 1].ts) > gapFactor * (double)median && median > 0) {
+                gaps++;
+                addEvent(&events, hb[k].ts, (uint8_t)n, EV_HB_GAP,
+                         (uint32_t)((hb[k].ts - hb[k - 1].ts) / 1000000), 0);
+            }
+            if (hb[k].state == 0) {
+                changes++;
+                addEvent(&events, hb[k].ts, (uint8_t)n, EV_BOOTUP, 0, 0);
+            } else if (k > 0 && hb[k].state != hb[k - 1].state) {
+                changes++;
+                addEvent(&events, hb[k].ts, (uint8_t)n, EV_STATE, hb[k].state, hb[k - 1].state);
+            }
+        }
+        if (ns->sdoDur.count > 0) {
+            qsort(dur, ns->sdoDur.count, sizeof(uint32_t), compareU32);
+        }
+        size_t sc = ns->sdoDur.count;
+        printf("%4d %7zu %9.1f %9.1f %5lu %6lu %5lu %6zu %5lu %5lu %9u %9u %9u %8lu\n", n, ns->hb.count,
+               (double)median / 1e6, (double)maxInterval / 1e6, gaps, changes, ns->emcy, sc, ns->sdoAborts,
+               ns->sdoIncomplete, sc > 0 ? dur[(sc - 1) * 50 / 100] : 0, sc > 0 ? dur[(sc - 1) * 99 / 100] : 0, sc > 0 ? dur[sc - 1] : 0,
+               ns->pdo);
+        free(ns->hb.data);
+        free(ns->sdoDur.data);
+    }
+
+    if (printEvents) {
+        if (events.count > 0) {
+            qsort(events.data, events.count, sizeof(event_t), compareEvent);
+        }
+        printf("\n");
+        for (size_t e = 0; e < events.count; e++) {
+            printEvent(&((event_t*)events.data)[e]);
+        }
+    }
+
+    free(events.data);
+    free(nodes);
+    free(cap.chunks);
+    munmap((void*)cap.map, cap.size);
+    return errors > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -23,19 +23,23 @@
 #include <unistd.h>
 #include <bits/getopt_core.h>
 #include <string.h>
-#include <netdb.h>
 #include <limits.h>
 #include <net/if.h>
 #include <sys/types.h>
 #include <sys/socket.h>
-#include <sys/un.h>
 #include <linux/can.h>
 #include <signal.h>
 
+#include "cocomm_reply.h"
+#include "libcocomm.h"
+#include "cocomm_candump.h"
+#include "cocomm_bench.h"
+#include "cocomm_domain.h"
+#include "cocomm_fanout.h"
+
 #ifndef BUF_SIZE
 #define BUF_SIZE 1000
 #endif
-#define BUF_LAG 100 /* max size of error response */
 
 /* colors and stream for printing status */
 char *greenC, *redC, *resetC;
@@ -68,13 +72,39 @@ printUsage(char* progName) {
             "  -o all|data|flat By defult (setting 'all') outupt is split to colored stderr\n"
             "                   and stdout. 'data' prints data only to stdout. 'flat' prints\n"
             "                   all to stdout, set also with 'export cocomm_flat=<0|1>'.\n"
-            "  -d <can device>  If specified, then candump of specified CAN device will be\n"
-            "                   printed after the command response. Set also with\n"
+            "  -d <can device>  If specified, then CAN frames on specified CAN device are\n"
+            "                   captured during command execution and printed after the\n"
+            "                   command responses, with kernel timestamps. Set also with\n"
             "                   'export cocomm_candump=<can device>'. Not used by default.\n"
-            "  -n <count>       Print <count> of candump messages, then exit. Set also with\n"
-            "                   'export cocomm_candump_count=<count>'. Default is 10.\n"
+            "  -n <count>       Capture <count> CAN frames, then exit, 0 for unlimited. Set\n"
+            "                   also with 'export cocomm_candump_count=<count>'. Default is 10.\n"
             "  -T <msec>        Exit candump after <msec> without reception. Set also with\n"
             "                   'export cocomm_candump_timeout=<msec>'. Default is 1000.\n"
+            "  -b <file>        Write captured frames to pcap file (SocketCAN link type)\n"
+            "                   instead of text, '-' for stdout. Set also with\n"
+            "                   'export cocomm_candump_bin=<file>'.\n"
+            "  -w <window>      Pipelined mode: keep up to <window> commands in flight.\n"
+            "                   Commands are numbered by cocomm and replies are printed in\n"
+            "                   order of commands with original sequence numbers. Set also\n"
+            "                   with 'export cocomm_window=<window>'.\n"
+            "                   Default is 1 (wait for each reply before next command).\n"
+            "  -B <seconds>     Benchmark mode: send commands (from arguments or file) in a\n"
+            "                   loop for <seconds> and print throughput and latency\n"
+            "                   percentiles instead of replies. With -d, latency is split\n"
+            "                   into SDO time (from CAN frame timestamps) and gateway time.\n"
+            "  -R <count>       Benchmark mode: send <count> commands per connection.\n"
+            "  -P <connections> Number of parallel connections in benchmark mode. Default 1.\n"
+            "  -D <file>        Domain download: append <file>, base64 encoded, to the single\n"
+            "                   write command string, for example '4 w 0x1F50 1 d'. '-' for\n"
+            "                   stdin. File is streamed, its size is not limited by memory.\n"
+            "  -U <file>        Domain upload: write the reply of the single read command\n"
+            "                   string, for example '4 r 0x1F50 1 d', base64 decoded, to\n"
+            "                   <file>. '-' for stdout.\n"
+            "  -E <endpoints>   Fan-out mode: run commands (from arguments, file or stdin)\n"
+            "                   on all endpoints concurrently and print replies grouped by\n"
+            "                   endpoint, with a summary. <endpoints> is comma separated\n"
+            "                   list of unix socket paths and tcp '<host>:<port>', option\n"
+            "                   may be repeated. Set also with 'export cocomm_endpoints=...'.\n"
             "  --help           Display this help.\n"
             "\n"
             "For help on command strings type '%s \"help\"'.\n"
@@ -84,105 +114,203 @@ printUsage(char* progName) {
             progName, progName);
 }
 
-/* print reply, status to errStream (red or green), value to stdout */
+/* Reply printing. Replies are delivered in order of commands, so one parser is used for all. */
+static cocommReply_t replyParser;
+static int replyStarted = 0;
+static int commandsRet = EXIT_SUCCESS;
+static unsigned long commandCount = 0;
+
+/* submitted command */
+typedef struct {
+    char tag[24];       /* sequence number from input (or generated one), printed with the reply */
+    cocommSource_t src; /* continuation of the command line, if src.fp is not NULL */
+    cocommSink_t* sink; /* domain upload to file, NULL for printed reply */
+} commandCtx_t;
+
+static long
+commandSourceCb(void* arg, char* buf, size_t size) {
+    return cocommSource_read(&((commandCtx_t*)arg)->src, buf, size);
+}
+
+/* reply data from libcocomm: status to errStream (red or green), value to stdout or to upload file */
+static void
+replyDataCb(void* arg, const char* data, size_t len) {
+    commandCtx_t* ctx = (commandCtx_t*)arg;
+
+    if (ctx->sink != NULL) {
+        cocommSink_write(ctx->sink, data, len);
+        return;
+    }
+    if (!replyStarted) {
+        cocommReply_init(&replyParser, errStream, greenC, redC, resetC);
+        replyParser.tag = ctx->tag;
+        replyStarted = 1;
+    }
+    cocommReply_parse(&replyParser, data, len);
+}
+
+static void
+replyDoneCb(void* arg, const cocomm_result_t* result) {
+    commandCtx_t* ctx = (commandCtx_t*)arg;
+
+    if (result->status == COCOMM_ERR_CONN) {
+        fprintf(errStream, "%s%s Error, zero response%s\n", redC, ctx->tag, resetC);
+        commandsRet = EXIT_FAILURE;
+    } else if (ctx->sink != NULL) {
+        if (cocommSink_finish(ctx->sink) < 0) {
+            fprintf(errStream, "%s%s %s%s\r\n", redC, ctx->tag, ctx->sink->err, resetC);
+            commandsRet = EXIT_FAILURE;
+        } else {
+            fprintf(errStream, "%s%s%s %llu bytes uploaded\r\n", greenC, ctx->tag, resetC, ctx->sink->bytes);
+        }
+    } else if (!replyStarted || replyParser.ret == EXIT_FAILURE) {
+        commandsRet = EXIT_FAILURE;
+    }
+    fflush(stdout);
+    replyStarted = 0;
+    free(ctx);
+}
+
+/* Submit command line. Sequence number from the line (or generated one) is printed with the reply, libcocomm uses
+ * own sequence numbers. Empty lines and comments are not sent, because they have no reply. If src is not NULL,
+ * command line continues with data from it. If sink is not NULL, reply is decoded into file. */
+static void
+submitCommand(cocomm_conn_t* conn, const char* comm, const cocommSource_t* src, cocommSink_t* sink) {
+    commandCtx_t* ctx;
+
+    commandCount++;
+    comm += strspn(comm, " \t");
+    if (comm[0] == '\0' || comm[0] == '\r' || comm[0] == '\n' || comm[0] == '#') {
+        return;
+    }
+
+    ctx = malloc(sizeof(commandCtx_t));
+    if (ctx == NULL) {
+        perror("Command submit");
+        exit(EXIT_FAILURE);
+    }
+    memset(&ctx->src, 0, sizeof(ctx->src));
+    if (src != NULL) {
+        ctx->src = *src;
+    }
+    ctx->sink = sink;
+    const char* tagEnd = comm[0] == '[' ? strchr(comm, ']') : NULL;
+    if (tagEnd != NULL && (size_t)(tagEnd - comm) < sizeof(ctx->tag) - 1) {
+        memcpy(ctx->tag, comm, (size_t)(tagEnd - comm) + 1);
+        ctx->tag[tagEnd - comm + 1] = 0;
+        comm = tagEnd + 1;
+        comm += strspn(comm, " \t");
+    } else {
+        snprintf(ctx->tag, sizeof(ctx->tag), "[%lu]", commandCount);
+    }
+
+    unsigned long seq = src != NULL ? cocomm_submit_source(conn, comm, commandSourceCb, replyDataCb, replyDoneCb, ctx)
+                                    : cocomm_submit(conn, comm, replyDataCb, replyDoneCb, ctx);
+    if (seq == 0) {
+        perror("Command submit");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* Process replies until at most maxPending commands are in flight */
+static void
+waitReplies(cocomm_conn_t* conn, size_t maxPending) {
+    while (cocomm_pending(conn) > maxPending) {
+        if (cocomm_poll(conn, -1) < 0) {
+            /* pending commands are completed with error */
+            commandsRet = EXIT_FAILURE;
+        }
+    }
+}
+
+/* Add comma separated endpoints for fan-out mode */
+static void
+addEndpoints(cocommFanout_t* fanout, const char* list) {
+    char* copy = strdup(list);
+    char* save = NULL;
+
+    if (copy == NULL) {
+        perror("Endpoints");
+        exit(EXIT_FAILURE);
+    }
+    for (char* ep = strtok_r(copy, ",", &save); ep != NULL; ep = strtok_r(NULL, ",", &save)) {
+        fanout->endpoints = realloc(fanout->endpoints, (size_t)(fanout->endpointCount + 1) * sizeof(char*));
+        if (fanout->endpoints == NULL) {
+            perror("Endpoints");
+            exit(EXIT_FAILURE);
+        }
+        fanout->endpoints[fanout->endpointCount++] = ep;
+    }
+}
+
+/* Read commands from file (or stdin, if path is "-") or from arguments, for benchmark and fan-out modes. Sequence
+ * numbers are removed from commands and stored into tags, if not NULL. Empty lines and comments are skipped. Return
+ * number of commands. Memory is released at exit. */
 static int
-printReply(int fd_gtw) {
-    char* replyBuf = malloc(BUF_SIZE + BUF_LAG + 1);
-    size_t count = 0; /* count of bytes in replyBuf */
-    int firstPass = 1;
-    int ret = EXIT_SUCCESS;
-
-    if (replyBuf == NULL) {
-        perror("replyBuf malloc");
+readCommands(const char* path, char** args, int argCount, char*** commands, char*** tags) {
+    char* line = NULL;
+    size_t lineSize = 0;
+    FILE* fp = NULL;
+    int count = 0;
+    int lineNo = 0;
+
+    if (path != NULL && (fp = strcmp(path, "-") == 0 ? stdin : fopen(path, "r")) == NULL) {
+        perror("Can't open input file");
         exit(EXIT_FAILURE);
     }
+    *commands = NULL;
+    if (tags != NULL) {
+        *tags = NULL;
+    }
+    for (int argIdx = 0;;) {
+        char* comm;
+        char tag[24];
 
-    for (;;) {
-        ssize_t nRead = read(fd_gtw, &replyBuf[count], BUF_SIZE); /* blocking */
-
-        if (nRead > 0) {
-            count += nRead;
-            replyBuf[count] = 0;
-
-            if (firstPass == 1) {
-                /* check for response type. Only response value goes to stdout */
-                if (strstr(replyBuf, "] ERROR:") != NULL && strstr(replyBuf, "\r\n") != NULL) {
-                    fprintf(errStream, "%s%s%s", redC, replyBuf, resetC);
-                    ret = EXIT_FAILURE;
-                    break;
-                } else if (strstr(replyBuf, "] OK\r\n") != NULL) {
-                    fprintf(errStream, "%s%s%s", greenC, replyBuf, resetC);
-                    break;
-                } else {
-                    char* replyBufTrimmed = replyBuf;
-                    char* seq = strstr(replyBuf, "] ");
-                    char* end = strstr(replyBuf, "\r\n");
-                    if (seq != NULL && (size_t)(seq - replyBuf) < 15) {
-                        replyBufTrimmed = seq + 2;
-                        seq[1] = 0;
-                        count -= strlen(replyBuf) + 1;
-                        fprintf(errStream, "%s%s%s ", greenC, replyBuf, resetC);
-                    }
-                    if (end != NULL) {
-                        end[0] = 0;
-                        fputs(replyBufTrimmed, stdout);
-                        fflush(stdout);
-                        fputs("\r\n", errStream);
-                        break;
-                    } else {
-                        /* print replyBuf to stdout, except last BUF_LAG bytes.
-                         * move them to the beginning of the replyBuf */
-                        if (count > BUF_LAG) {
-                            size_t nWrite = count - BUF_LAG;
-                            fwrite(replyBufTrimmed, 1, nWrite, stdout);
-                            replyBufTrimmed += nWrite;
-                            count = BUF_LAG;
-                        }
-                        memmove(replyBuf, replyBufTrimmed, count);
-                    }
-                }
-                firstPass = 0;
-            } else {
-                char* end = strstr(replyBuf, "\r\n");
-                if (end != NULL) {
-                    char* errResp = strstr(replyBuf, "\n...ERROR:0x");
-                    if (errResp != NULL) {
-                        errResp[0] = 0;
-                        fputs(replyBuf, stdout);
-                        fflush(stdout);
-                        fprintf(errStream, "\n%s%s%s", redC, &errResp[1], resetC);
-                        ret = EXIT_FAILURE;
-                    } else {
-                        end[0] = 0;
-                        fputs(replyBuf, stdout);
-                        fflush(stdout);
-                        fprintf(errStream, "\n%s...success%s\r\n", greenC, resetC);
-                    }
-                    break;
-                }
-                /* print replyBuf to stdout, except last BUF_LAG bytes.
-                 * move them to the beginning of the replyBuf */
-                if (count > BUF_LAG) {
-                    size_t nWrite = count - BUF_LAG;
-                    fwrite(replyBuf, 1, nWrite, stdout);
-                    count = BUF_LAG;
-                    memmove(replyBuf, &replyBuf[nWrite], count);
-                }
+        if (fp != NULL) {
+            if (getline(&line, &lineSize, fp) < 0) {
+                break;
             }
-        } else if (nRead == 0) {
-            fprintf(errStream, "%sError, zero response%s\n", redC, resetC);
-            ret = EXIT_FAILURE;
+            comm = line;
+        } else if (argIdx < argCount) {
+            comm = args[argIdx++];
+        } else {
             break;
+        }
+        lineNo++;
+        comm += strspn(comm, " \t");
+        if (comm[0] == '\0' || comm[0] == '\r' || comm[0] == '\n' || comm[0] == '#') {
+            continue;
+        }
+        const char* tagEnd = comm[0] == '[' ? strchr(comm, ']') : NULL;
+        if (tagEnd != NULL && (size_t)(tagEnd - comm) < sizeof(tag) - 1) {
+            memcpy(tag, comm, (size_t)(tagEnd - comm) + 1);
+            tag[tagEnd - comm + 1] = 0;
+            comm += tagEnd - comm + 1;
+            comm += strspn(comm, " \t");
         } else {
-            perror("Socket read failed");
-            free(replyBuf);
+            snprintf(tag, sizeof(tag), "[%d]", lineNo);
+        }
+
+        *commands = realloc(*commands, (size_t)(count + 1) * sizeof(char*));
+        if (*commands == NULL || ((*commands)[count] = strdup(comm)) == NULL) {
+            perror("Commands");
             exit(EXIT_FAILURE);
         }
-        fflush(stdout);
+        (*commands)[count][strcspn(comm, "\r\n")] = '\0';
+        if (tags != NULL) {
+            *tags = realloc(*tags, (size_t)(count + 1) * sizeof(char*));
+            if (*tags == NULL || ((*tags)[count] = strdup(tag)) == NULL) {
+                perror("Commands");
+                exit(EXIT_FAILURE);
+            }
+        }
+        count++;
     }
-    free(replyBuf);
-
-    return ret;
+    if (fp != NULL && fp != stdin) {
+        fclose(fp);
+    }
+    free(line);
+    return count;
 }
 
 int
@@ -198,12 +326,18 @@ main(int argc, char* argv[]) {
     char* candump = NULL;
     long candumpCount = 10;
     long candumpTmo = 1000;
-
-    char* commBuf;
-    int fd_gtw;
-    int fd_candump;
+    long window = 1;
+    long benchDuration_ms = 0;
+    long benchCount = 0;
+    int benchConnections = 1;
+    char* domainFilePath = NULL;
+    cocommFanout_t fanout = {0};
+    int domainUpload = 0;
+
+    cocomm_conn_t* conn;
+    char* candumpBin = NULL;
+    cocommCandump_t cd;
     int opt;
-    struct sockaddr_un addr_un;
     sa_family_t addrFamily = AF_UNIX;
     errStream = stderr;
 
@@ -241,9 +375,20 @@ main(int argc, char* argv[]) {
     if ((env = getenv("cocomm_candump_timeout")) != NULL) {
         candumpTmo = atol(env);
     }
+    if ((env = getenv("cocomm_candump_bin")) != NULL) {
+        if (strlen(env) > 0) {
+            candumpBin = env;
+        }
+    }
+    if ((env = getenv("cocomm_window")) != NULL) {
+        window = atol(env);
+    }
+    if ((env = getenv("cocomm_endpoints")) != NULL) {
+        addEndpoints(&fanout, env);
+    }
 
     /* Get program options from arguments */
-    while ((opt = getopt(argc, argv, "f:s:t:p:io:d:n:T:")) != -1) {
+    while ((opt = getopt(argc, argv, "f:s:t:p:io:d:n:T:b:w:B:R:P:D:U:E:")) != -1) {
         switch (opt) {
             case 'f': inputFilePath = optarg; break;
             case 's':
@@ -266,6 +411,20 @@ main(int argc, char* argv[]) {
             case 'd': candump = optarg; break;
             case 'n': candumpCount = atol(optarg); break;
             case 'T': candumpTmo = atol(optarg); break;
+            case 'b': candumpBin = optarg; break;
+            case 'w': window = atol(optarg); break;
+            case 'B': benchDuration_ms = (long)(atof(optarg) * 1000); break;
+            case 'R': benchCount = atol(optarg); break;
+            case 'P': benchConnections = atoi(optarg); break;
+            case 'D':
+                domainFilePath = optarg;
+                domainUpload = 0;
+                break;
+            case 'U':
+                domainFilePath = optarg;
+                domainUpload = 1;
+                break;
+            case 'E': addEndpoints(&fanout, optarg); break;
             default: printUsage(argv[0]); exit(EXIT_FAILURE);
         }
     }
@@ -296,127 +455,119 @@ main(int argc, char* argv[]) {
         exit(EXIT_FAILURE);
     }
 
-    /* Create and connect client socket */
-    if (addrFamily == AF_INET) {
-
-        struct addrinfo hints, *res, *rp;
-        int errcode;
-
-        memset(&hints, 0, sizeof(hints));
-        hints.ai_family = AF_INET;
-        hints.ai_socktype = SOCK_STREAM;
-        hints.ai_flags |= AI_CANONNAME;
-
-        errcode = getaddrinfo(hostname, tcpPort, &hints, &res);
-        if (errcode != 0) {
-            fprintf(stderr, "Error! Getaddrinfo for host %s failed\n", hostname);
-            exit(EXIT_FAILURE);
+    /* Benchmark mode */
+    if (benchDuration_ms > 0 || benchCount > 0) {
+        cocommBench_t bench = {.socketPath = socketPath,
+                               .host = addrFamily == AF_INET ? hostname : NULL,
+                               .port = tcpPort,
+                               .connections = benchConnections > 0 ? benchConnections : 1,
+                               .duration_ms = benchDuration_ms,
+                               .count = benchCount,
+                               .commands = NULL,
+                               .commandCount = 0,
+                               .cd = NULL};
+        bench.commandCount = readCommands(inputFilePath, &argv[optind], argc - optind, &bench.commands, NULL);
+        if (candump != NULL) {
+            if (cocommCandump_open(&cd, candump, 0, candumpTmo, candumpBin) < 0 || cocommCandump_start(&cd) < 0) {
+                exit(EXIT_FAILURE);
+            }
+            bench.cd = candumpBin == NULL ? &cd : NULL;
         }
-
-        /* getaddrinfo() returns a list of address structures. Try each address
-         * until we successfully connect. If socket (or connect) fails,
-         * we (close the socket and) try the next address. */
-
-        for (rp = res; rp != NULL; rp = rp->ai_next) {
-            fd_gtw = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
-            if (fd_gtw == -1) {
-                continue;
+        int ret = cocommBench_run(&bench, errStream);
+        if (candump != NULL) {
+            cocommCandump_stop(&cd);
+            if (candumpBin != NULL && cd.binFile != stdout) {
+                fclose(cd.binFile);
             }
+        }
+        exit(ret);
+    }
 
-            if (connect(fd_gtw, rp->ai_addr, rp->ai_addrlen) != -1) {
-                break; /* Success */
-            }
+    /* Fan-out mode */
+    if (fanout.endpointCount > 0) {
+        fanout.window = window < 1 ? 1 : (size_t)window;
+        if (inputFilePath == NULL && optind >= argc) {
+            inputFilePath = "-";
+        }
+        fanout.commandCount = readCommands(inputFilePath, &argv[optind], argc - optind, &fanout.commands, &fanout.tags);
+        exit(cocommFanout_run(&fanout, errStream, greenC, redC, resetC));
+    }
 
-            close(fd_gtw);
-            perror("Socket connection failed");
+    /* Create and connect client socket */
+    if (addrFamily == AF_INET) {
+        conn = cocomm_connect_tcp(hostname, tcpPort);
+        if (conn == NULL) {
+            fprintf(stderr, "Socket connection failed \"%s:%s\": ", hostname, tcpPort);
+            perror(NULL);
             exit(EXIT_FAILURE);
         }
     } else { /* addrFamily == AF_UNIX */
-        fd_gtw = socket(AF_UNIX, SOCK_STREAM, 0);
-        if (fd_gtw == -1) {
-            perror("Socket creation failed");
-            exit(EXIT_FAILURE);
-        }
-
-        memset(&addr_un, 0, sizeof(struct sockaddr_un));
-        addr_un.sun_family = addrFamily;
-        strncpy(addr_un.sun_path, socketPath, sizeof(addr_un.sun_path) - 1);
-
-        if (connect(fd_gtw, (struct sockaddr*)&addr_un, sizeof(struct sockaddr_un)) == -1) {
+        conn = cocomm_connect_local(socketPath);
+        if (conn == NULL) {
             fprintf(stderr, "Socket connection failed \"%s\": ", socketPath);
             perror(NULL);
             exit(EXIT_FAILURE);
         }
     }
+    cocomm_set_window(conn, window < 1 ? 1 : (size_t)window);
 
-    /* Prepare candump */
-    if (candump != NULL && candumpCount > 0 && candumpTmo > 0) {
-        struct sockaddr_can sockAddr;
-
-        fd_candump = socket(PF_CAN, SOCK_RAW, CAN_RAW);
-        if (fd_candump < 0) {
-            perror("CAN socket creation failed");
+    /* Prepare candump, capture runs concurrently with commands */
+    if (candump != NULL && candumpCount >= 0 && candumpTmo > 0) {
+        if (cocommCandump_open(&cd, candump, candumpCount, candumpTmo, candumpBin) < 0
+            || cocommCandump_start(&cd) < 0) {
             exit(EXIT_FAILURE);
         }
+    } else {
+        candump = NULL;
+    }
 
-        struct timeval tv;
-        tv.tv_sec = candumpTmo / 1000;
-        tv.tv_usec = (candumpTmo % 1000) * 1000;
-        setsockopt(fd_candump, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof tv);
+    /* get commands from input file, arguments or stdin, line after line. With window > 1 commands are pipelined. */
+    char* line = NULL;
+    size_t lineSize = 0;
 
-        memset(&sockAddr, 0, sizeof(sockAddr));
-        sockAddr.can_family = AF_CAN;
-        sockAddr.can_ifindex = if_nametoindex(candump);
-        if (sockAddr.can_ifindex == 0) {
-            perror(candump);
+    if (window < 1) {
+        window = 1;
+    }
+
+    if (domainFilePath != NULL) {
+        /* domain download (write) from file or domain upload (read) to file, streamed in constant memory */
+        static cocommSink_t sink;
+        FILE* fp;
+
+        if (optind != argc - 1) {
+            fprintf(errStream, "Options -D and -U require exactly one command string\n");
             exit(EXIT_FAILURE);
         }
-        int ret = bind(fd_candump, (struct sockaddr*)&sockAddr, sizeof(sockAddr));
-        if (ret < 0) {
-            fprintf(stderr, "CAN Socket binding failed \"%s\": ", candump);
-            perror(NULL);
+        if (strcmp(domainFilePath, "-") == 0) {
+            fp = domainUpload ? stdout : stdin;
+        } else if ((fp = fopen(domainFilePath, domainUpload ? "wb" : "rb")) == NULL) {
+            perror("Can't open domain file");
             exit(EXIT_FAILURE);
         }
-    } else {
-        candumpCount = 0;
-    }
-
-    /* get commands from input file, line after line */
-    int ret = EXIT_SUCCESS;
-
-    commBuf = malloc(BUF_SIZE);
-    if (commBuf == NULL) {
-        perror("commBuf malloc");
-        exit(EXIT_FAILURE);
+        if (domainUpload) {
+            cocommSink_init(&sink, fp);
+            submitCommand(conn, argv[optind], NULL, &sink);
+        } else {
+            cocommSource_t src = {.fp = fp, .base64 = 1, .end = 0, .bytes = 0};
+            submitCommand(conn, argv[optind], &src, NULL);
+        }
+        waitReplies(conn, 0);
+        if (fp != stdin && fp != stdout && fclose(fp) != 0) {
+            perror("Domain file");
+            commandsRet = EXIT_FAILURE;
+        }
     }
 
-    if (inputFilePath != NULL) {
+    else if (inputFilePath != NULL) {
         FILE* fp = fopen(inputFilePath, "r");
         if (fp == NULL) {
             perror("Can't open input file");
-            free(commBuf);
             exit(EXIT_FAILURE);
         }
 
-        while (fgets(commBuf, BUF_SIZE, fp) != NULL) {
-            size_t len = strlen(commBuf);
-            if (len < 1) {
-                continue;
-            }
-
-            /* send command */
-            if (write(fd_gtw, commBuf, len) != len) { /* blocking function */
-                perror("Socket write failed");
-                free(commBuf);
-                exit(EXIT_FAILURE);
-            }
-
-            /* print reply, if command is complete */
-            if (commBuf[len - 1] == '\n') {
-                if (printReply(fd_gtw) == EXIT_FAILURE) {
-                    ret = EXIT_FAILURE;
-                }
-            }
+        while (getline(&line, &lineSize, fp) >= 0) {
+            submitCommand(conn, line, NULL, NULL);
+            waitReplies(conn, (size_t)window - 1);
         }
 
         fclose(fp);
@@ -426,116 +577,34 @@ main(int argc, char* argv[]) {
     else if (optind < argc) {
         for (int i = optind; i < argc; i++) {
             char* comm = argv[i];
-            commBuf[0] = 0;
-
-            /* Add sequence number if not present on command line argument */
-            if (comm[0] != '[' && comm[0] != '#') {
-                sprintf(commBuf, "[%d] ", i - optind + 1);
-            }
-
-            if ((strlen(commBuf) + strlen(comm)) >= (BUF_SIZE - 2)) {
-                fprintf(errStream, "%sCommand string too long!%s\n", redC, greenC);
-                continue;
-            }
-
-            strcat(commBuf, comm);
 
             if (additionalReadStdin == 0) {
-                strcat(commBuf, "\n");
-                size_t len = strlen(commBuf);
-                if (write(fd_gtw, commBuf, len) != len) { /* blocking function */
-                    perror("Socket write failed");
-                    free(commBuf);
-                    exit(EXIT_FAILURE);
-                }
+                submitCommand(conn, comm, NULL, NULL);
             } else {
-                strcat(commBuf, " ");
-                size_t len = strlen(commBuf);
-                char lastChar;
-
-                do {
-                    if (fgets(commBuf + len, BUF_SIZE - 1 - len, stdin) == NULL) {
-                        strcat(commBuf, "\n");
-                    }
-
-                    len = strlen(commBuf);
-                    lastChar = commBuf[len - 1];
-
-                    if (len < BUF_SIZE - 2 && lastChar != '\n') {
-                        continue;
-                    }
-
-                    /* send command */
-                    if (write(fd_gtw, commBuf, len) != len) { /* blocking f. */
-                        perror("Socket write failed");
-                        free(commBuf);
-                        exit(EXIT_FAILURE);
-                    }
-
-                    commBuf[0] = 0;
-                    len = 0;
-                } while (lastChar != '\n');
-            }
-
-            if (printReply(fd_gtw) == EXIT_FAILURE) {
-                ret = EXIT_FAILURE;
+                /* continue the command with one line from stdin, streamed to the gateway */
+                cocommSource_t src = {.fp = stdin, .base64 = 0, .end = 0, .bytes = 0};
+                submitCommand(conn, comm, &src, NULL);
             }
+            waitReplies(conn, (size_t)window - 1);
         }
     }
 
     /* get commands from stdin, line after line */
     else {
-        while (fgets(commBuf, BUF_SIZE, stdin) != NULL) {
-            size_t len = strlen(commBuf);
-            if (len < 1) {
-                continue;
-            }
-
-            /* send command */
-            if (write(fd_gtw, commBuf, len) != len) { /* blocking function */
-                perror("Socket write failed");
-                free(commBuf);
-                exit(EXIT_FAILURE);
-            }
-
-            /* print reply, if command is complete */
-            if (commBuf[len - 1] == '\n') {
-                if (printReply(fd_gtw) == EXIT_FAILURE) {
-                    ret = EXIT_FAILURE;
-                }
-            }
+        while (getline(&line, &lineSize, stdin) >= 0) {
+            submitCommand(conn, line, NULL, NULL);
+            waitReplies(conn, (size_t)window - 1);
         }
     }
 
-    close(fd_gtw);
-
-    free(commBuf);
+    waitReplies(conn, 0);
+    int ret = commandsRet;
+    cocomm_close(conn);
+    free(line);
 
     /* candump output */
-    if (candumpCount > 0) {
-        for (int i = 0; i < candumpCount; i++) {
-            const char hex_asc[] = "0123456789ABCDEF";
-            struct can_frame canFrame;
-
-            ssize_t nbytes = read(fd_candump, &canFrame, sizeof(struct can_frame));
-
-            if (nbytes < (ssize_t)sizeof(struct can_frame)) {
-                perror("CAN raw socket read timeout");
-                exit(EXIT_FAILURE);
-            }
-
-            char buf[17];
-            char* pbuf = &buf[0];
-            for (int j = 0; j < canFrame.can_dlc && j < sizeof(buf); j++) {
-                uint8_t byte = canFrame.data[j];
-                *pbuf++ = hex_asc[byte >> 4];
-                *pbuf++ = hex_asc[byte & 0x0F];
-            }
-            *pbuf = 0;
-
-            printf("%03X#%s\n", canFrame.can_id, buf);
-        }
-        close(fd_candump);
+    if (candump != NULL && cocommCandump_finish(&cd, errStream) < 0) {
+        ret = EXIT_FAILURE;
     }
 
     exit(ret);
@@ -0,0 +1,251 @@
+/*
+ * Round-trip latency benchmark mode of cocomm.
+ *
+ * @file        cocomm_bench.c
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "libcocomm.h"
+#include "cocomm_bench.h"
+
+/* one executed command */
+typedef struct {
+    int64_t tSend; /* CLOCK_REALTIME in ns, comparable with kernel timestamps of CAN frames */
+    int64_t tRecv;
+    int status;
+} sample_t;
+
+/* one connection */
+typedef struct {
+    const cocommBench_t* bench;
+    pthread_t thread;
+    cocomm_conn_t* conn;
+    sample_t* samples;
+    size_t count;
+    size_t size;
+    int failed;
+} benchConn_t;
+
+static volatile int benchStop = 0;
+
+static int64_t
+realtime_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void*
+benchThread(void* arg) {
+    benchConn_t* bc = (benchConn_t*)arg;
+    const cocommBench_t* bench = bc->bench;
+
+    for (long i = 0; !benchStop && (bench->count == 0 || i < bench->count); i++) {
+        cocomm_future_t future;
+        sample_t s;
+
+        if (bc->count >= bc->size) {
+            size_t size = bc->size > 0 ? bc->size * 2 : 4096;
+            sample_t* samples = realloc(bc->samples, size * sizeof(sample_t));
+            if (samples == NULL) {
+                bc->failed = 1;
+                break;
+            }
+            bc->samples = samples;
+            bc->size = size;
+        }
+
+        s.tSend = realtime_ns();
+        if (cocomm_submit_future(bc->conn, bench->commands[i % bench->commandCount], &future) == 0) {
+            bc->failed = 1;
+            break;
+        }
+        s.status = cocomm_wait(bc->conn, &future, -1);
+        s.tRecv = realtime_ns();
+        cocomm_future_free(&future);
+
+        bc->samples[bc->count++] = s;
+        if (s.status == COCOMM_ERR_CONN) {
+            bc->failed = 1;
+            break;
+        }
+    }
+    return NULL;
+}
+
+static int
+compareRecv(const void* a, const void* b) {
+    int64_t x = ((const sample_t*)a)->tRecv, y = ((const sample_t*)b)->tRecv;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static int
+compareU32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static int64_t
+frameTime(const cocommCanFrame_t* f) {
+    return (int64_t)f->ts.tv_sec * 1000000000 + f->ts.tv_nsec;
+}
+
+static int
+isSDO(const cocommCanFrame_t* f) {
+    canid_t id = f->frame.can_id;
+    return (id & (CAN_EFF_FLAG | CAN_RTR_FLAG)) == 0 && ((id > 0x580 && id < 0x600) || (id > 0x600 && id < 0x680));
+}
+
+static void
+printLatency(const char* name, uint32_t* lat, size_t count) {
+    if (count == 0) {
+        return;
+    }
+    qsort(lat, count, sizeof(uint32_t), compareU32);
+    printf("%-9s %9u %9u %9u %9u\n", name, lat[(count - 1) * 50 / 100], lat[(count - 1) * 90 / 100],
+           lat[(count - 1) * 99 / 100], lat[count - 1]);
+}
+
+int
+cocommBench_run(const cocommBench_t* bench, FILE* errStream) {
+    benchConn_t* conns = calloc((size_t)bench->connections, sizeof(benchConn_t));
+    int ret = EXIT_SUCCESS;
+    struct timespec start, end;
+
+    if (conns == NULL || bench->commandCount == 0) {
+        fprintf(errStream, "Benchmark: no commands\n");
+        free(conns);
+        return EXIT_FAILURE;
+    }
+    for (int i = 0; i < bench->connections; i++) {
+        conns[i].bench = bench;
+        conns[i].conn = bench->host != NULL ? cocomm_connect_tcp(bench->host, bench->port)
+                                            : cocomm_connect_local(bench->socketPath);
+        if (conns[i].conn == NULL) {
+            perror("Socket connection failed");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < bench->connections; i++) {
+        if (pthread_create(&conns[i].thread, NULL, benchThread, &conns[i]) != 0) {
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (bench->count == 0) {
+        struct timespec ts = {.tv_sec = bench->duration_ms / 1000, .tv_nsec = (bench->duration_ms % 1000) * 1000000};
+        while (nanosleep(&ts, &ts) != 0) {}
+        benchStop = 1;
+    }
+    for (int i = 0; i < bench->connections; i++) {
+        pthread_join(conns[i].thread, NULL);
+        cocomm_close(conns[i].conn);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed_s = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    if (bench->cd != NULL) {
+        cocommCandump_stop(bench->cd);
+    }
+
+    /* merge samples of all connections, in order of execution by the gateway */
+    size_t total = 0, errors = 0;
+    for (int i = 0; i < bench->connections; i++) {
+        total += conns[i].count;
+        if (conns[i].failed) {
+            ret = EXIT_FAILURE;
+        }
+    }
+    sample_t* samples = malloc((total + 1) * sizeof(sample_t));
+    uint32_t* latTotal = malloc((total + 1) * sizeof(uint32_t));
+    uint32_t* latGtw = malloc((total + 1) * sizeof(uint32_t));
+    uint32_t* latSDO = malloc((total + 1) * sizeof(uint32_t));
+    if (samples == NULL || latTotal == NULL || latGtw == NULL || latSDO == NULL) {
+        perror("Benchmark malloc");
+        exit(EXIT_FAILURE);
+    }
+    total = 0;
+    for (int i = 0; i < bench->connections; i++) {
+        memcpy(&samples[total], conns[i].samples, conns[i].count * sizeof(sample_t));
+        total += conns[i].count;
+        free(conns[i].samples);
+    }
+    free(conns);
+    qsort(samples, total, sizeof(sample_t), compareRecv);
+
+    /* split round trip into SDO time (first to last SDO frame) and gateway time */
+    size_t nSDO = 0;
+    size_t f = 0;
+    int64_t prevRecv = 0;
+    const cocommCanFrame_t* frames = bench->cd != NULL ? bench->cd->frames : NULL;
+    size_t frameCount = bench->cd != NULL ? bench->cd->frameCount : 0;
+    for (size_t i = 0; i < total; i++) {
+        sample_t* s = &samples[i];
+        int64_t winStart = s->tSend > prevRecv ? s->tSend : prevRecv;
+        int64_t first = -1, last = -1;
+
+        if (s->status != COCOMM_OK) {
+            errors++;
+        }
+        latTotal[i] = (uint32_t)((s->tRecv - s->tSend) / 1000);
+
+        while (f < frameCount && frameTime(&frames[f]) < winStart) {
+            f++;
+        }
+        for (; f < frameCount && frameTime(&frames[f]) <= s->tRecv; f++) {
+            if (isSDO(&frames[f])) {
+                if (first < 0) {
+                    first = frameTime(&frames[f]);
+                }
+                last = frameTime(&frames[f]);
+            }
+        }
+        if (frames != NULL) {
+            uint32_t sdo = first >= 0 ? (uint32_t)((last - first) / 1000) : 0;
+            latSDO[nSDO] = sdo;
+            latGtw[nSDO] = latTotal[i] > sdo ? latTotal[i] - sdo : 0;
+            nSDO++;
+        }
+        prevRecv = s->tRecv;
+    }
+
+    printf("%zu commands (%d command(s), %d connection(s)), %zu errors, %.2f s, %.1f commands/s\n", total,
+           bench->commandCount, bench->connections, errors, elapsed_s, (double)total / elapsed_s);
+    printf("%-9s %9s %9s %9s %9s\n", "latency", "p50[us]", "p90[us]", "p99[us]", "max[us]");
+    printLatency("total", latTotal, total);
+    printLatency("gateway", latGtw, nSDO);
+    printLatency("SDO", latSDO, nSDO);
+    if (bench->cd != NULL && bench->cd->dropped > 0) {
+        fprintf(errStream, "candump: %u frames dropped by kernel, SDO time may be wrong\n", bench->cd->dropped);
+    }
+    if (errors > 0) {
+        ret = EXIT_FAILURE;
+    }
+
+    if (bench->cd != NULL) {
+        free(bench->cd->frames);
+        bench->cd->frames = NULL;
+    }
+    free(samples);
+    free(latTotal);
+    free(latGtw);
+    free(latSDO);
+    return ret;
+}
@@ -0,0 +1,57 @@
+/*
+ * Round-trip latency benchmark mode of cocomm.
+ *
+ * @file        cocomm_bench.h
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#ifndef COCOMM_BENCH_H
+#define COCOMM_BENCH_H
+
+#include <stdio.h>
+
+#include "cocomm_candump.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Benchmark configuration.
+ *
+ * Each connection runs in its own thread and sends the commands one after another, in a loop, for <duration_ms> or
+ * <count> commands per connection. Gateway executes commands from all connections one at a time, so the CAN traffic
+ * of a command is between its transmission (or reply to the previous command) and its reply. If candump is running,
+ * SDO time of each command is the time between its first and last SDO frame (kernel timestamps) and gateway time is
+ * the rest of the round trip.
+ */
+typedef struct {
+    const char* socketPath; /* local socket path, used if host is NULL */
+    const char* host;       /* tcp host */
+    const char* port;       /* tcp port */
+    int connections;        /* number of parallel connections */
+    long duration_ms;       /* duration of the benchmark, if count is 0 */
+    long count;             /* number of commands per connection */
+    char** commands;        /* commands without sequence numbers */
+    int commandCount;
+    cocommCandump_t* cd;    /* running CAN capture or NULL */
+} cocommBench_t;
+
+/* Run benchmark and print report to stdout. Return EXIT_SUCCESS, or EXIT_FAILURE if any command failed. */
+int cocommBench_run(const cocommBench_t* bench, FILE* errStream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COCOMM_BENCH_H */
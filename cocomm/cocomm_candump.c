@@ -0,0 +1,279 @@
+/*
+ * CAN capture for cocomm, running concurrently with command execution.
+ *
+ * @file        cocomm_candump.c
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <linux/can/raw.h>
+
+#include "cocomm_candump.h"
+
+/* Poll interval of the capture thread for the end condition */
+#define POLL_INTERVAL_MS 50
+
+/* pcap file format with nanosecond timestamps */
+#define PCAP_MAGIC_NS           0xA1B23C4D
+#define PCAP_LINKTYPE_SOCKETCAN 227
+
+int
+cocommCandump_open(cocommCandump_t* cd, const char* device, long count, long timeout_ms, const char* binPath) {
+    struct sockaddr_can sockAddr;
+    int enable = 1;
+    int rcvbuf = COCOMM_CANDUMP_RCVBUF;
+
+    memset(cd, 0, sizeof(cocommCandump_t));
+    cd->count = count;
+    cd->timeout_ms = timeout_ms;
+
+    cd->fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (cd->fd < 0) {
+        perror("CAN socket creation failed");
+        return -1;
+    }
+
+    struct timeval tv = {.tv_sec = 0, .tv_usec = POLL_INTERVAL_MS * 1000};
+    setsockopt(cd->fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(cd->fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    setsockopt(cd->fd, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable));
+    setsockopt(cd->fd, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable));
+
+    memset(&sockAddr, 0, sizeof(sockAddr));
+    sockAddr.can_family = AF_CAN;
+    sockAddr.can_ifindex = if_nametoindex(device);
+    if (sockAddr.can_ifindex == 0) {
+        perror(device);
+        close(cd->fd);
+        return -1;
+    }
+    if (bind(cd->fd, (struct sockaddr*)&sockAddr, sizeof(sockAddr)) < 0) {
+        fprintf(stderr, "CAN Socket binding failed \"%s\": ", device);
+        perror(NULL);
+        close(cd->fd);
+        return -1;
+    }
+
+    if (binPath != NULL) {
+        struct {
+            uint32_t magic;
+            uint16_t versionMajor, versionMinor;
+            int32_t thiszone;
+            uint32_t sigfigs, snaplen, linktype;
+        } hdr = {PCAP_MAGIC_NS, 2, 4, 0, 0, sizeof(struct can_frame), PCAP_LINKTYPE_SOCKETCAN};
+
+        cd->binFile = strcmp(binPath, "-") == 0 ? stdout : fopen(binPath, "wb");
+        if (cd->binFile == NULL) {
+            perror(binPath);
+            close(cd->fd);
+            return -1;
+        }
+        fwrite(&hdr, sizeof(hdr), 1, cd->binFile);
+    }
+    return 0;
+}
+
+static void
+writePcap(cocommCandump_t* cd, const cocommCanFrame_t* f) {
+    struct {
+        uint32_t sec, nsec, caplen, len;
+    } rec = {(uint32_t)f->ts.tv_sec, (uint32_t)f->ts.tv_nsec, sizeof(struct can_frame), sizeof(struct can_frame)};
+    struct can_frame frame = f->frame;
+
+    /* LINKTYPE_CAN_SOCKETCAN has CAN identifier in network byte order */
+    frame.can_id = htonl(frame.can_id);
+    fwrite(&rec, sizeof(rec), 1, cd->binFile);
+    fwrite(&frame, sizeof(frame), 1, cd->binFile);
+}
+
+static int
+storeFrame(cocommCandump_t* cd, const cocommCanFrame_t* f) {
+    if (cd->frameCount >= cd->frameSize) {
+        size_t size = cd->frameSize > 0 ? cd->frameSize * 2 : 1024;
+        cocommCanFrame_t* frames = realloc(cd->frames, size * sizeof(cocommCanFrame_t));
+        if (frames == NULL) {
+            return -1;
+        }
+        cd->frames = frames;
+        cd->frameSize = size;
+    }
+    cd->frames[cd->frameCount++] = *f;
+    return 0;
+}
+
+static long
+elapsed_ms(const struct timespec* since) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long)(now.tv_sec - since->tv_sec) * 1000 + (now.tv_nsec - since->tv_nsec) / 1000000;
+}
+
+static void*
+captureThread(void* arg) {
+    cocommCandump_t* cd = (cocommCandump_t*)arg;
+    struct mmsghdr msgs[COCOMM_CANDUMP_BATCH];
+    struct iovec iov[COCOMM_CANDUMP_BATCH];
+    struct can_frame frames[COCOMM_CANDUMP_BATCH];
+    char ctrl[COCOMM_CANDUMP_BATCH][CMSG_SPACE(sizeof(struct timespec)) + CMSG_SPACE(sizeof(uint32_t))];
+    struct timespec lastRx;
+
+    clock_gettime(CLOCK_MONOTONIC, &lastRx);
+
+    while (cd->count == 0 || cd->captured < (unsigned long)cd->count) {
+        for (int i = 0; i < COCOMM_CANDUMP_BATCH; i++) {
+            iov[i].iov_base = &frames[i];
+            iov[i].iov_len = sizeof(struct can_frame);
+            memset(&msgs[i].msg_hdr, 0, sizeof(struct msghdr));
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            msgs[i].msg_hdr.msg_control = ctrl[i];
+            msgs[i].msg_hdr.msg_controllen = sizeof(ctrl[i]);
+        }
+
+        int n = recvmmsg(cd->fd, msgs, COCOMM_CANDUMP_BATCH, MSG_WAITFORONE, NULL);
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                perror("CAN raw socket read");
+                cd->error = 1;
+                break;
+            }
+            /* end of capture, when commands are finished and bus is quiet */
+            if (cd->commandsDone) {
+                struct timespec* ref = &lastRx;
+                if (cd->doneTime.tv_sec > lastRx.tv_sec
+                    || (cd->doneTime.tv_sec == lastRx.tv_sec && cd->doneTime.tv_nsec > lastRx.tv_nsec)) {
+                    ref = &cd->doneTime;
+                }
+                if (elapsed_ms(ref) >= cd->timeout_ms) {
+                    break;
+                }
+            }
+            continue;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &lastRx);
+        for (int i = 0; i < n && (cd->count == 0 || cd->captured < (unsigned long)cd->count); i++) {
+            cocommCanFrame_t f;
+
+            if (msgs[i].msg_len < sizeof(struct can_frame)) {
+                continue;
+            }
+            memset(&f.ts, 0, sizeof(f.ts));
+            for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsg != NULL;
+                 cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg)) {
+                if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_TIMESTAMPNS) {
+                    memcpy(&f.ts, CMSG_DATA(cmsg), sizeof(struct timespec));
+                } else if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+                    memcpy(&cd->dropped, CMSG_DATA(cmsg), sizeof(uint32_t));
+                }
+            }
+            f.frame = frames[i];
+
+            if (cd->binFile != NULL) {
+                writePcap(cd, &f);
+            } else if (storeFrame(cd, &f) < 0) {
+                perror("candump frames realloc");
+                cd->error = 1;
+                return NULL;
+            }
+            cd->captured++;
+        }
+    }
+    return NULL;
+}
+
+int
+cocommCandump_start(cocommCandump_t* cd) {
+    if (pthread_create(&cd->thread, NULL, captureThread, cd) != 0) {
+        perror("pthread_create");
+        return -1;
+    }
+    return 0;
+}
+
+void
+cocommCandump_stop(cocommCandump_t* cd) {
+    if (cd->fd < 0) {
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &cd->doneTime);
+    cd->commandsDone = 1;
+    pthread_join(cd->thread, NULL);
+    close(cd->fd);
+    cd->fd = -1;
+}
+
+int
+cocommCandump_finish(cocommCandump_t* cd, FILE* errStream) {
+    static const char hex_asc[] = "0123456789ABCDEF";
+    size_t len = 0;
+
+    /* capture thread stores frames until the bus is quiet, size the buffer only after it ended */
+    cocommCandump_stop(cd);
+    char* out = malloc(cd->frameCount * 64 + 1);
+
+    /* text output "(<seconds>.<microseconds>) <id>#<data>", formatted to one buffer */
+    if (out == NULL) {
+        perror("candump output malloc");
+        cd->error = 1;
+    } else {
+        for (size_t i = 0; i < cd->frameCount; i++) {
+            const cocommCanFrame_t* f = &cd->frames[i];
+            const struct can_frame* fr = &f->frame;
+            uint8_t dlc = fr->can_dlc <= CAN_MAX_DLEN ? fr->can_dlc : CAN_MAX_DLEN;
+
+            len += (size_t)sprintf(&out[len], "(%ld.%06ld) ", (long)f->ts.tv_sec, f->ts.tv_nsec / 1000);
+            if (fr->can_id & CAN_EFF_FLAG) {
+                len += (size_t)sprintf(&out[len], "%08X#", fr->can_id & CAN_EFF_MASK);
+            } else {
+                len += (size_t)sprintf(&out[len], "%03X#", fr->can_id & CAN_SFF_MASK);
+            }
+            if (fr->can_id & CAN_RTR_FLAG) {
+                out[len++] = 'R';
+            } else {
+                for (int j = 0; j < dlc; j++) {
+                    out[len++] = hex_asc[fr->data[j] >> 4];
+                    out[len++] = hex_asc[fr->data[j] & 0x0F];
+                }
+            }
+            out[len++] = '\n';
+        }
+        fwrite(out, 1, len, stdout);
+        fflush(stdout);
+        free(out);
+    }
+    free(cd->frames);
+
+    if (cd->binFile != NULL) {
+        if (cd->binFile != stdout) {
+            fclose(cd->binFile);
+        } else {
+            fflush(stdout);
+        }
+    }
+    if (cd->dropped > 0) {
+        fprintf(errStream, "candump: %u frames dropped by kernel\n", cd->dropped);
+    }
+    if (cd->count > 0 && cd->captured < (unsigned long)cd->count) {
+        fprintf(errStream, "candump: timeout, %lu of %ld frames captured\n", cd->captured, cd->count);
+        cd->error = 1;
+    }
+    return cd->error ? -1 : 0;
+}
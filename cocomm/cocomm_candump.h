@@ -0,0 +1,87 @@
+/*
+ * CAN capture for cocomm, running concurrently with command execution.
+ *
+ * @file        cocomm_candump.h
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#ifndef COCOMM_CANDUMP_H
+#define COCOMM_CANDUMP_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+#include <linux/can.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of frames received with one recvmmsg() call */
+#ifndef COCOMM_CANDUMP_BATCH
+#define COCOMM_CANDUMP_BATCH 64
+#endif
+/* Socket receive buffer size, so bursts are not lost while capture thread is not scheduled */
+#ifndef COCOMM_CANDUMP_RCVBUF
+#define COCOMM_CANDUMP_RCVBUF (4 * 1024 * 1024)
+#endif
+
+/* Captured frame with kernel receive timestamp */
+typedef struct {
+    struct timespec ts;
+    struct can_frame frame;
+} cocommCanFrame_t;
+
+/*
+ * Capture object.
+ *
+ * Capture thread receives frames in batches with recvmmsg() and kernel timestamps (SO_TIMESTAMPNS). Frames are
+ * written to binary file (pcap, LINKTYPE_CAN_SOCKETCAN) by the thread, or stored and printed as text after command
+ * replies. Capture ends after <count> frames (0 for unlimited) or when commands are finished and no frame was
+ * received for <timeout>.
+ */
+typedef struct {
+    int fd;
+    long count;
+    long timeout_ms;
+    FILE* binFile;
+    pthread_t thread;
+    volatile int commandsDone;
+    struct timespec doneTime;
+    cocommCanFrame_t* frames; /* frames for text output */
+    size_t frameCount;
+    size_t frameSize;
+    unsigned long captured;
+    uint32_t dropped; /* frames dropped by kernel (SO_RXQ_OVFL) */
+    int error;
+} cocommCandump_t;
+
+/* Open and bind CAN socket. binPath is pcap output file ("-" for stdout) or NULL for text output.
+ * Return 0 on success, -1 on error (message printed). */
+int cocommCandump_open(cocommCandump_t* cd, const char* device, long count, long timeout_ms, const char* binPath);
+
+/* Start capture thread, before commands are sent. Return 0 on success. */
+int cocommCandump_start(cocommCandump_t* cd);
+
+/* Commands are finished: wait for the end of capture and close the socket. Captured frames stay in frames. */
+void cocommCandump_stop(cocommCandump_t* cd);
+
+/* Commands are finished: wait for the end of capture, print text output to stdout and close. Return 0 on success. */
+int cocommCandump_finish(cocommCandump_t* cd, FILE* errStream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COCOMM_CANDUMP_H */
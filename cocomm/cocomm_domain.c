@@ -0,0 +1,191 @@
+/*
+ * Streaming domain transfer for cocomm: base64 encoded file to command line and reply to file.
+ *
+ * @file        cocomm_domain.c
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#include <string.h>
+
+#include "cocomm_domain.h"
+
+enum { SK_HEAD, SK_DATA, SK_PAD, SK_ERROR };
+
+static const char b64enc[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+long
+cocommSource_read(void* arg, char* buf, size_t size) {
+    cocommSource_t* src = (cocommSource_t*)arg;
+
+    if (src->end) {
+        return 0;
+    }
+
+    if (!src->base64) {
+        /* one line of text, without end of line */
+        if (fgets(buf, (int)size, src->fp) == NULL) {
+            src->end = 1;
+            return 0;
+        }
+        size_t len = strlen(buf);
+        if (len > 0 && buf[len - 1] == '\n') {
+            len--;
+            src->end = 1;
+        }
+        src->bytes += len;
+        return (long)len;
+    }
+
+    /* base64: read whole groups of 3 bytes, so padding is only at the end */
+    uint8_t in[(4096 / 4) * 3];
+    size_t max = (size / 4) * 3;
+    size_t n = fread(in, 1, max < sizeof(in) ? max : sizeof(in), src->fp);
+    size_t len = 0;
+
+    if (n == 0) {
+        src->end = 1;
+        return ferror(src->fp) ? -1 : 0;
+    }
+    src->bytes += n;
+    for (size_t i = 0; i < n; i += 3) {
+        uint32_t v = (uint32_t)in[i] << 16;
+        if (i + 1 < n) {
+            v |= (uint32_t)in[i + 1] << 8;
+        }
+        if (i + 2 < n) {
+            v |= in[i + 2];
+        }
+        buf[len++] = b64enc[(v >> 18) & 0x3F];
+        buf[len++] = b64enc[(v >> 12) & 0x3F];
+        buf[len++] = i + 1 < n ? b64enc[(v >> 6) & 0x3F] : '=';
+        buf[len++] = i + 2 < n ? b64enc[v & 0x3F] : '=';
+    }
+    return (long)len;
+}
+
+void
+cocommSink_init(cocommSink_t* sink, FILE* fp) {
+    memset(sink, 0, sizeof(cocommSink_t));
+    sink->fp = fp;
+}
+
+static void
+sinkFlush(cocommSink_t* sink) {
+    if (sink->outLen > 0) {
+        if (fwrite(sink->out, 1, sink->outLen, sink->fp) != sink->outLen && sink->errLen == 0) {
+            sink->errLen = (size_t)snprintf(sink->err, sizeof(sink->err), "Error writing output file");
+        }
+        sink->bytes += sink->outLen;
+        sink->outLen = 0;
+    }
+}
+
+static inline int
+b64dec(char c) {
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A';
+    }
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 26;
+    }
+    if (c >= '0' && c <= '9') {
+        return c - '0' + 52;
+    }
+    return c == '+' ? 62 : c == '/' ? 63 : -1;
+}
+
+static void
+sinkData(cocommSink_t* sink, const char* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        char c = data[i];
+
+        if (sink->state == SK_ERROR) {
+            if (c != '\r' && c != '\n' && sink->errLen < sizeof(sink->err) - 1) {
+                sink->err[sink->errLen++] = c;
+            }
+            continue;
+        }
+        if (c == '\r' || c == '\n' || c == ' ') {
+            continue;
+        }
+        if (c == '=') {
+            sink->state = SK_PAD;
+            continue;
+        }
+        int v = b64dec(c);
+        if (v < 0 || sink->state == SK_PAD) {
+            /* "...ERROR:0x<abort code>" after partial data */
+            sink->state = SK_ERROR;
+            sink->err[sink->errLen++] = c;
+            continue;
+        }
+        sink->quad[sink->n++] = (uint8_t)v;
+        if (sink->n == 4) {
+            if (sink->outLen + 3 > sizeof(sink->out)) {
+                sinkFlush(sink);
+            }
+            sink->out[sink->outLen++] = (uint8_t)((sink->quad[0] << 2) | (sink->quad[1] >> 4));
+            sink->out[sink->outLen++] = (uint8_t)((sink->quad[1] << 4) | (sink->quad[2] >> 2));
+            sink->out[sink->outLen++] = (uint8_t)((sink->quad[2] << 6) | sink->quad[3]);
+            sink->n = 0;
+        }
+    }
+}
+
+void
+cocommSink_write(void* arg, const char* data, size_t len) {
+    cocommSink_t* sink = (cocommSink_t*)arg;
+
+    if (sink->state == SK_HEAD) {
+        /* reply may be an error message instead of data */
+        size_t n = len < sizeof(sink->head) - (size_t)sink->headLen ? len : sizeof(sink->head) - (size_t)sink->headLen;
+        memcpy(&sink->head[sink->headLen], data, n);
+        sink->headLen += (int)n;
+        data += n;
+        len -= n;
+        if (sink->headLen < (int)sizeof(sink->head) && memchr(sink->head, '\n', (size_t)sink->headLen) == NULL) {
+            return;
+        }
+        if (sink->headLen == (int)sizeof(sink->head) && memcmp(sink->head, "ERROR:", 6) == 0) {
+            sink->state = SK_ERROR;
+            memcpy(sink->err, sink->head, sizeof(sink->head));
+            sink->errLen = sizeof(sink->head);
+        } else {
+            sink->state = SK_DATA;
+            sinkData(sink, sink->head, (size_t)sink->headLen);
+        }
+    }
+    sinkData(sink, data, len);
+}
+
+int
+cocommSink_finish(cocommSink_t* sink) {
+    if (sink->state == SK_HEAD && sink->headLen > 0) {
+        sink->state = SK_DATA;
+        sinkData(sink, sink->head, (size_t)sink->headLen);
+    }
+    /* last group without padding */
+    if (sink->n >= 2) {
+        sink->out[sink->outLen++] = (uint8_t)((sink->quad[0] << 2) | (sink->quad[1] >> 4));
+        if (sink->n == 3) {
+            sink->out[sink->outLen++] = (uint8_t)((sink->quad[1] << 4) | (sink->quad[2] >> 2));
+        }
+        sink->n = 0;
+    }
+    sinkFlush(sink);
+    if (fflush(sink->fp) != 0 && sink->errLen == 0) {
+        sink->errLen = (size_t)snprintf(sink->err, sizeof(sink->err), "Error writing output file");
+    }
+    sink->err[sink->errLen] = '\0';
+    return sink->errLen > 0 ? -1 : 0;
+}
@@ -0,0 +1,72 @@
+/*
+ * Streaming domain transfer for cocomm: base64 encoded file to command line and reply to file.
+ *
+ * @file        cocomm_domain.h
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#ifndef COCOMM_DOMAIN_H
+#define COCOMM_DOMAIN_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Size of the output buffer of decoded domain data */
+#ifndef COCOMM_DOMAIN_OUT_SIZE
+#define COCOMM_DOMAIN_OUT_SIZE 65536
+#endif
+
+/* Source of the command line: base64 encoded file or one line from the stream (for -i option) */
+typedef struct {
+    FILE* fp;
+    int base64; /* encode binary file, otherwise copy one text line */
+    int end;
+    unsigned long long bytes; /* bytes read from the file */
+} cocommSource_t;
+
+/* Sink of the domain upload: base64 decoded reply is written to file */
+typedef struct {
+    FILE* fp;
+    uint8_t quad[4];
+    int n;
+    int state; /* internal state */
+    char head[6];
+    int headLen;
+    char err[100]; /* gateway error message */
+    size_t errLen;
+    unsigned long long bytes; /* bytes written to the file */
+    uint8_t out[COCOMM_DOMAIN_OUT_SIZE];
+    size_t outLen;
+} cocommSink_t;
+
+/* Source callback for cocomm_submit_source(), arg is cocommSource_t */
+long cocommSource_read(void* arg, char* buf, size_t size);
+
+/* Initialize sink, which writes to fp */
+void cocommSink_init(cocommSink_t* sink, FILE* fp);
+
+/* Data callback for cocomm_submit() and cocomm_submit_source(), arg is cocommSink_t */
+void cocommSink_write(void* arg, const char* data, size_t len);
+
+/* Flush decoded data. Return 0 on success, -1 if gateway replied with error (message is in err) or write failed. */
+int cocommSink_finish(cocommSink_t* sink);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COCOMM_DOMAIN_H */
@@ -0,0 +1,237 @@
+/*
+ * Fan-out of cocomm commands to multiple gateways.
+ *
+ * @file        cocomm_fanout.c
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <poll.h>
+
+#include "libcocomm.h"
+#include "cocomm_reply.h"
+#include "cocomm_fanout.h"
+
+/* reply of one command on one endpoint */
+typedef struct {
+    char* data; /* raw reply, as received, ends with "\r\n" */
+    size_t len;
+    size_t size;
+    int status;
+} fanoutReply_t;
+
+/* one endpoint */
+typedef struct {
+    const char* name;
+    cocomm_conn_t* conn;
+    fanoutReply_t* replies;
+    int completed;
+    int errors;
+    long time_ms; /* from start to the last reply */
+} fanoutEndpoint_t;
+
+/* argument of the callbacks */
+typedef struct {
+    fanoutEndpoint_t* ep;
+    fanoutReply_t* reply;
+} fanoutArg_t;
+
+static struct timespec fanoutStart;
+
+static long
+elapsed_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long)(ts.tv_sec - fanoutStart.tv_sec) * 1000 + (ts.tv_nsec - fanoutStart.tv_nsec) / 1000000;
+}
+
+static void
+fanoutDataCb(void* arg, const char* data, size_t len) {
+    fanoutReply_t* reply = ((fanoutArg_t*)arg)->reply;
+
+    if (reply->len + len > reply->size) {
+        size_t size = reply->size > 0 ? reply->size * 2 : 64;
+        while (size < reply->len + len) {
+            size *= 2;
+        }
+        char* buf = realloc(reply->data, size);
+        if (buf == NULL) {
+            return;
+        }
+        reply->data = buf;
+        reply->size = size;
+    }
+    memcpy(&reply->data[reply->len], data, len);
+    reply->len += len;
+}
+
+static void
+fanoutDoneCb(void* arg, const cocomm_result_t* result) {
+    fanoutEndpoint_t* ep = ((fanoutArg_t*)arg)->ep;
+    fanoutReply_t* reply = ((fanoutArg_t*)arg)->reply;
+
+    reply->status = result->status;
+    if (result->status != COCOMM_OK) {
+        ep->errors++;
+    }
+    ep->completed++;
+    ep->time_ms = elapsed_ms();
+}
+
+/* endpoint is "<host>:<port>" for tcp, otherwise local socket path */
+static cocomm_conn_t*
+fanoutConnect(const char* name) {
+    const char* colon = strrchr(name, ':');
+
+    if (colon != NULL && strchr(name, '/') == NULL) {
+        char host[256];
+        size_t len = (size_t)(colon - name);
+
+        if (len >= sizeof(host)) {
+            errno = EINVAL;
+            return NULL;
+        }
+        memcpy(host, name, len);
+        host[len] = '\0';
+        return cocomm_connect_tcp(host, colon + 1);
+    }
+    return cocomm_connect_local(name);
+}
+
+int
+cocommFanout_run(const cocommFanout_t* fo, FILE* errStream, const char* greenC, const char* redC,
+                 const char* resetC) {
+    fanoutEndpoint_t* eps = calloc((size_t)fo->endpointCount, sizeof(fanoutEndpoint_t));
+    fanoutArg_t* args = calloc((size_t)fo->endpointCount * (size_t)fo->commandCount + 1, sizeof(fanoutArg_t));
+    struct pollfd* pfds = calloc((size_t)fo->endpointCount, sizeof(struct pollfd));
+    int* pfdEp = calloc((size_t)fo->endpointCount, sizeof(int));
+    int ret = EXIT_SUCCESS;
+
+    if (eps == NULL || args == NULL || pfds == NULL || pfdEp == NULL) {
+        perror("Fan-out malloc");
+        exit(EXIT_FAILURE);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &fanoutStart);
+
+    /* connect and submit all commands to all endpoints, sent within window by cocomm_poll() */
+    for (int e = 0; e < fo->endpointCount; e++) {
+        fanoutEndpoint_t* ep = &eps[e];
+
+        ep->name = fo->endpoints[e];
+        ep->replies = calloc((size_t)fo->commandCount + 1, sizeof(fanoutReply_t));
+        if (ep->replies == NULL) {
+            perror("Fan-out malloc");
+            exit(EXIT_FAILURE);
+        }
+        ep->conn = fanoutConnect(ep->name);
+        if (ep->conn == NULL) {
+            fprintf(errStream, "%sSocket connection failed \"%s\": %s%s\n", redC, ep->name, strerror(errno), resetC);
+            ep->errors = fo->commandCount;
+            ep->completed = fo->commandCount;
+            ret = EXIT_FAILURE;
+            continue;
+        }
+        cocomm_set_window(ep->conn, fo->window);
+        for (int c = 0; c < fo->commandCount; c++) {
+            fanoutArg_t* arg = &args[e * fo->commandCount + c];
+            arg->ep = ep;
+            arg->reply = &ep->replies[c];
+            if (cocomm_submit(ep->conn, fo->commands[c], fanoutDataCb, fanoutDoneCb, arg) == 0) {
+                perror("Command submit");
+                exit(EXIT_FAILURE);
+            }
+        }
+        cocomm_poll(ep->conn, 0);
+    }
+
+    /* serve all connections from one poll() */
+    for (;;) {
+        nfds_t n = 0;
+
+        for (int e = 0; e < fo->endpointCount; e++) {
+            if (eps[e].conn != NULL && cocomm_pending(eps[e].conn) > 0) {
+                pfds[n].fd = cocomm_fd(eps[e].conn);
+                pfds[n].events = POLLIN;
+                pfds[n].revents = 0;
+                pfdEp[n] = e;
+                n++;
+            }
+        }
+        if (n == 0) {
+            break;
+        }
+        if (poll(pfds, n, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("poll");
+            exit(EXIT_FAILURE);
+        }
+        for (nfds_t i = 0; i < n; i++) {
+            if (pfds[i].revents != 0) {
+                cocomm_poll(eps[pfdEp[i]].conn, 0);
+            }
+        }
+    }
+    long total_ms = elapsed_ms();
+
+    /* replies, grouped by endpoint */
+    long sum_ms = 0;
+    int errors = 0;
+    for (int e = 0; e < fo->endpointCount; e++) {
+        fanoutEndpoint_t* ep = &eps[e];
+
+        if (ep->conn != NULL) {
+            fprintf(errStream, "%s==== %s%s\n", ep->errors > 0 ? redC : greenC, ep->name, resetC);
+            for (int c = 0; c < fo->commandCount; c++) {
+                fanoutReply_t* reply = &ep->replies[c];
+                cocommReply_t rp;
+
+                if (reply->status == COCOMM_ERR_CONN || reply->data == NULL) {
+                    fprintf(errStream, "%s%s Error, zero response%s\n", redC, fo->tags[c], resetC);
+                } else {
+                    cocommReply_init(&rp, errStream, greenC, redC, resetC);
+                    rp.tag = fo->tags[c];
+                    cocommReply_parse(&rp, reply->data, reply->len);
+                }
+                free(reply->data);
+            }
+            fflush(stdout);
+            cocomm_close(ep->conn);
+        }
+        free(ep->replies);
+        sum_ms += ep->time_ms;
+        errors += ep->errors;
+    }
+
+    /* summary */
+    fprintf(errStream, "%-32s %9s %9s %9s\n", "endpoint", "commands", "errors", "time[ms]");
+    for (int e = 0; e < fo->endpointCount; e++) {
+        fprintf(errStream, "%s%-32s %9d %9d %9ld%s\n", eps[e].errors > 0 ? redC : greenC, eps[e].name,
+                eps[e].completed, eps[e].errors, eps[e].time_ms, resetC);
+    }
+    fprintf(errStream, "%d endpoint(s), %d error(s), %ld ms (sum of endpoint times %ld ms)\n", fo->endpointCount,
+            errors, total_ms, sum_ms);
+    if (errors > 0) {
+        ret = EXIT_FAILURE;
+    }
+
+    free(eps);
+    free(args);
+    free(pfds);
+    free(pfdEp);
+    return ret;
+}
@@ -0,0 +1,54 @@
+/*
+ * Fan-out of cocomm commands to multiple gateways.
+ *
+ * @file        cocomm_fanout.h
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#ifndef COCOMM_FANOUT_H
+#define COCOMM_FANOUT_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fan-out configuration.
+ *
+ * Each endpoint is a local socket path or tcp "<host>:<port>". All endpoints are connected from a single thread and
+ * all commands are submitted to each of them at once. One poll() loop then serves all connections, so the commands
+ * run concurrently on all gateways and the whole operation takes as long as the slowest gateway. Replies are collected
+ * per endpoint and printed after all endpoints are finished, one endpoint after another.
+ */
+typedef struct {
+    char** endpoints;
+    int endpointCount;
+    char** commands; /* commands without sequence numbers */
+    char** tags;     /* sequence numbers from input, printed with the replies */
+    int commandCount;
+    size_t window;   /* commands in flight per endpoint */
+} cocommFanout_t;
+
+/* Run commands on all endpoints, print replies and summary. Return EXIT_SUCCESS, or EXIT_FAILURE if any command on
+ * any endpoint failed. */
+int cocommFanout_run(const cocommFanout_t* fo, FILE* errStream, const char* greenC, const char* redC,
+                     const char* resetC);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COCOMM_FANOUT_H */
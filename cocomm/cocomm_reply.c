@@ -0,0 +1,238 @@
+/*
+ * Streaming parser of CANopenNode ASCII command interface replies.
+ *
+ * @file        cocomm_reply.c
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cocomm_reply.h"
+
+/* Value longer than this is followed by "...success" message instead of line end */
+#define REPLY_LONG 1000
+
+enum { RP_HEAD, RP_STATUS, RP_VALUE, RP_ERRTAIL, RP_DONE };
+
+static const char errPattern[] = "\n...ERROR:0x";
+#define ERR_PATTERN_LEN (sizeof(errPattern) - 1)
+
+void
+cocommReply_init(cocommReply_t* rp, FILE* errStream, const char* greenC, const char* redC, const char* resetC) {
+    rp->state = RP_HEAD;
+    rp->errStream = errStream;
+    rp->greenC = greenC;
+    rp->redC = redC;
+    rp->resetC = resetC;
+    rp->tag = NULL;
+    rp->ret = EXIT_SUCCESS;
+    rp->headLen = 0;
+    rp->match = 0;
+    rp->cr = 0;
+    rp->valueLen = 0;
+    rp->outLen = 0;
+    rp->errLen = 0;
+}
+
+int
+cocommReply_done(const cocommReply_t* rp) {
+    return rp->state == RP_DONE;
+}
+
+static void
+flushOut(cocommReply_t* rp) {
+    if (rp->outLen > 0) {
+        fwrite(rp->out, 1, rp->outLen, stdout);
+        rp->valueLen += rp->outLen;
+        rp->outLen = 0;
+    }
+}
+
+static inline void
+putOut(cocommReply_t* rp, char c) {
+    if (rp->outLen >= sizeof(rp->out)) {
+        flushOut(rp);
+    }
+    rp->out[rp->outLen++] = c;
+}
+
+/* value bytes: held back are '\r' (possible end of reply) and beginning of "\n...ERROR:0x" */
+static size_t
+parseValue(cocommReply_t* rp, const char* buf, size_t count) {
+    size_t i = 0;
+
+    while (i < count) {
+        char c = buf[i++];
+
+        if (rp->match > 0) {
+            if (c == errPattern[rp->match]) {
+                if (++rp->match == (int)ERR_PATTERN_LEN) {
+                    /* partial value followed by error */
+                    flushOut(rp);
+                    fflush(stdout);
+                    memcpy(rp->err, &errPattern[1], ERR_PATTERN_LEN - 1);
+                    rp->errLen = ERR_PATTERN_LEN - 1;
+                    rp->state = RP_ERRTAIL;
+                    return i;
+                }
+                continue;
+            }
+            for (int j = 0; j < rp->match; j++) {
+                putOut(rp, errPattern[j]);
+            }
+            rp->match = 0;
+        }
+
+        if (c == '\n') {
+            if (rp->cr) {
+                /* end of reply */
+                rp->cr = 0;
+                flushOut(rp);
+                fflush(stdout);
+                if (rp->valueLen > REPLY_LONG) {
+                    fprintf(rp->errStream, "\n%s...success%s\r\n", rp->greenC, rp->resetC);
+                } else {
+                    fputs("\r\n", rp->errStream);
+                }
+                rp->state = RP_DONE;
+                return i;
+            }
+            rp->match = 1;
+        } else if (c == '\r') {
+            if (rp->cr) {
+                putOut(rp, '\r');
+            }
+            rp->cr = 1;
+        } else {
+            if (rp->cr) {
+                putOut(rp, '\r');
+                rp->cr = 0;
+            }
+            /* fast path for plain data */
+            size_t start = i - 1;
+            while (i < count && buf[i] != '\n' && buf[i] != '\r') {
+                i++;
+            }
+            size_t n = i - start;
+            if (rp->outLen + n > sizeof(rp->out)) {
+                flushOut(rp);
+            }
+            if (n >= sizeof(rp->out)) {
+                fwrite(&buf[start], 1, n, stdout);
+                rp->valueLen += n;
+            } else {
+                memcpy(&rp->out[rp->outLen], &buf[start], n);
+                rp->outLen += n;
+            }
+        }
+    }
+    return i;
+}
+
+/* beginning of the reply is complete: print sequence number and decide type of the reply */
+static size_t
+parseHead(cocommReply_t* rp) {
+    const char* head = rp->head;
+    size_t len = rp->headLen;
+    const char* seqEnd = head[0] == '[' ? memchr(head, ']', len < 15 ? len : 15) : NULL;
+    const char* rest = head;
+
+    if (seqEnd != NULL && (size_t)(seqEnd - head) + 1 < len && seqEnd[1] == ' ') {
+        rest = seqEnd + 2;
+    } else {
+        seqEnd = NULL;
+    }
+    size_t restLen = len - (size_t)(rest - head);
+    int tagLen = seqEnd != NULL ? (int)(seqEnd - head) + 1 : 0;
+    const char* tag = rp->tag != NULL ? rp->tag : head;
+    if (rp->tag != NULL) {
+        tagLen = (int)strlen(rp->tag);
+    }
+
+    if (restLen >= 6 && strncmp(rest, "ERROR:", 6) == 0) {
+        fprintf(rp->errStream, "%s%.*s%s%.*s", rp->redC, tagLen, tag, tagLen > 0 ? " " : "", (int)restLen, rest);
+        rp->ret = EXIT_FAILURE;
+        rp->state = memchr(rest, '\n', restLen) != NULL ? RP_DONE : RP_STATUS;
+        if (rp->state == RP_DONE) {
+            fputs(rp->resetC, rp->errStream);
+        }
+    } else if (restLen == 4 && strncmp(rest, "OK\r\n", 4) == 0) {
+        fprintf(rp->errStream, "%s%.*s%sOK\r\n%s", rp->greenC, tagLen, tag, tagLen > 0 ? " " : "", rp->resetC);
+        rp->state = RP_DONE;
+    } else {
+        if (tagLen > 0) {
+            fprintf(rp->errStream, "%s%.*s%s ", rp->greenC, tagLen, tag, rp->resetC);
+            fflush(rp->errStream);
+        }
+        rp->state = RP_VALUE;
+        parseValue(rp, rest, restLen);
+    }
+    return len;
+}
+
+size_t
+cocommReply_parse(cocommReply_t* rp, const char* buf, size_t count) {
+    size_t i = 0;
+
+    while (i < count && rp->state != RP_DONE) {
+        switch (rp->state) {
+            case RP_HEAD: {
+                /* collect beginning of the reply, until end of line or head buffer is full */
+                size_t space = sizeof(rp->head) - rp->headLen;
+                size_t n = count - i < space ? count - i : space;
+                const char* nl = memchr(&buf[i], '\n', n);
+                if (nl != NULL) {
+                    n = (size_t)(nl - &buf[i]) + 1;
+                }
+                memcpy(&rp->head[rp->headLen], &buf[i], n);
+                rp->headLen += n;
+                i += n;
+                if (nl != NULL || rp->headLen == sizeof(rp->head)) {
+                    parseHead(rp);
+                }
+                break;
+            }
+            case RP_STATUS: {
+                /* rest of the error reply */
+                const char* nl = memchr(&buf[i], '\n', count - i);
+                size_t n = nl != NULL ? (size_t)(nl - &buf[i]) + 1 : count - i;
+                fwrite(&buf[i], 1, n, rp->errStream);
+                i += n;
+                if (nl != NULL) {
+                    fputs(rp->resetC, rp->errStream);
+                    rp->state = RP_DONE;
+                }
+                break;
+            }
+            case RP_VALUE: i += parseValue(rp, &buf[i], count - i); break;
+            case RP_ERRTAIL: {
+                /* error message after partial value, until end of reply */
+                const char* nl = memchr(&buf[i], '\n', count - i);
+                size_t n = nl != NULL ? (size_t)(nl - &buf[i]) + 1 : count - i;
+                size_t copy = n < sizeof(rp->err) - rp->errLen ? n : sizeof(rp->err) - rp->errLen;
+                memcpy(&rp->err[rp->errLen], &buf[i], copy);
+                rp->errLen += copy;
+                i += n;
+                if (nl != NULL) {
+                    fprintf(rp->errStream, "\n%s%.*s%s", rp->redC, (int)rp->errLen, rp->err, rp->resetC);
+                    rp->ret = EXIT_FAILURE;
+                    rp->state = RP_DONE;
+                }
+                break;
+            }
+            default: break;
+        }
+    }
+    return i;
+}
@@ -0,0 +1,77 @@
+/*
+ * Streaming parser of CANopenNode ASCII command interface replies.
+ *
+ * @file        cocomm_reply.h
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#ifndef COCOMM_REPLY_H
+#define COCOMM_REPLY_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Size of buffer for value data, written to stdout in chunks of this size */
+#ifndef COCOMM_REPLY_OUT_SIZE
+#define COCOMM_REPLY_OUT_SIZE 65536
+#endif
+/* Beginning of the reply, which contains sequence number and status */
+#define COCOMM_REPLY_HEAD_SIZE 32
+/* Max size of error message at the end of partial value */
+#define COCOMM_REPLY_ERR_SIZE 100
+
+/*
+ * Reply parser object.
+ *
+ * Parser scans each byte of the reply once. Sequence number and status are printed to errStream (green or red),
+ * value is printed to stdout. Value data are collected and written to stdout in large chunks. Reply ends with "\r\n".
+ * If partial value is followed by "\n...ERROR:0x<abort code>", data are printed to stdout and error to errStream.
+ */
+typedef struct {
+    int state;       /* internal state */
+    FILE* errStream; /* stream for sequence number and status */
+    const char* greenC;
+    const char* redC;
+    const char* resetC;
+    const char* tag; /* if not NULL, printed instead of received sequence number, for example "[5]" */
+    int ret;         /* EXIT_SUCCESS or EXIT_FAILURE, valid when reply is complete */
+    char head[COCOMM_REPLY_HEAD_SIZE];
+    size_t headLen;
+    int match;      /* number of matched characters of "\n...ERROR:0x" */
+    int cr;         /* '\r' is held back */
+    size_t valueLen; /* number of value bytes written to stdout */
+    char out[COCOMM_REPLY_OUT_SIZE];
+    size_t outLen;
+    char err[COCOMM_REPLY_ERR_SIZE];
+    size_t errLen;
+} cocommReply_t;
+
+/* Initialize parser before the reply. Colors may be empty strings. */
+void cocommReply_init(cocommReply_t* rp, FILE* errStream, const char* greenC, const char* redC, const char* resetC);
+
+/* Parse next part of the reply and print it. Return number of bytes consumed, which is less than count, if reply
+ * ended before the end of buf. */
+size_t cocommReply_parse(cocommReply_t* rp, const char* buf, size_t count);
+
+/* Return non-zero, if reply is complete. */
+int cocommReply_done(const cocommReply_t* rp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COCOMM_REPLY_H */
@@ -0,0 +1,664 @@
+/*
+ * Client library for CANopenNode ASCII command interface.
+ *
+ * @file        libcocomm.c
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+#include "libcocomm.h"
+
+#define RX_BUF_SIZE 65536
+#define HEAD_SIZE   24 /* "[<sequence>] " */
+#define TAIL_SIZE   32 /* end of reply, for "\n...ERROR:0x<abort code>" */
+#define IOV_BATCH   64
+#define SOURCE_CHUNK 4096 /* size of chunks of streamed command line */
+
+/* submitted command */
+typedef struct {
+    unsigned long seq;
+    char* command; /* "[<seq>] <command>\n" */
+    size_t commandLen;
+    size_t sentLen; /* bytes of command already sent */
+    cocomm_data_cb_t dataCb;
+    cocomm_done_cb_t doneCb;
+    cocomm_source_cb_t sourceCb; /* command line continues with data from source */
+    void* arg;
+    char* buf; /* collected reply */
+    size_t len;
+    size_t size;
+    char start[8]; /* beginning of reply, for "ERROR:" */
+    size_t startLen;
+    char tail[TAIL_SIZE];
+    size_t tailLen;
+    int complete;
+    int status;
+} request_t;
+
+struct cocomm_conn {
+    int fd;
+    int tcp;
+    char path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+    char host[256];
+    char port[20];
+    unsigned long seq;
+    size_t window;
+    /* ring of submitted commands, in order of submission */
+    request_t* queue;
+    size_t qHead;
+    size_t qCount;
+    size_t qSize;
+    size_t qSent; /* number of commands from qHead, which are sent (or partially sent) */
+    /* receive state */
+    char rx[RX_BUF_SIZE];
+    request_t* cur; /* request receiving reply, NULL at the beginning of the reply */
+    int discard;    /* reply does not match any request */
+    char head[HEAD_SIZE];
+    size_t headLen;
+    int cr; /* last received byte of the reply was '\r' */
+};
+
+static int
+connectSocket(cocomm_conn_t* conn) {
+    int fd = -1;
+
+    if (conn->tcp) {
+        struct addrinfo hints, *res, *rp;
+
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        if (getaddrinfo(conn->host, conn->port, &hints, &res) != 0) {
+            errno = EHOSTUNREACH;
+            return -1;
+        }
+        for (rp = res; rp != NULL; rp = rp->ai_next) {
+            fd = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
+            if (fd == -1) {
+                continue;
+            }
+            if (connect(fd, rp->ai_addr, rp->ai_addrlen) != -1) {
+                break; /* Success */
+            }
+            close(fd);
+            fd = -1;
+        }
+        freeaddrinfo(res);
+    } else {
+        struct sockaddr_un addr_un;
+
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        /* length is checked in cocomm_connect_local(), path is null terminated */
+        memset(&addr_un, 0, sizeof(struct sockaddr_un));
+        addr_un.sun_family = AF_UNIX;
+        memcpy(addr_un.sun_path, conn->path, sizeof(addr_un.sun_path));
+        if (connect(fd, (struct sockaddr*)&addr_un, sizeof(struct sockaddr_un)) == -1) {
+            int err = errno;
+            close(fd);
+            errno = err;
+            fd = -1;
+        }
+    }
+    conn->fd = fd;
+    conn->cur = NULL;
+    conn->discard = 0;
+    conn->headLen = 0;
+    conn->cr = 0;
+    return fd;
+}
+
+static cocomm_conn_t*
+connNew(void) {
+    cocomm_conn_t* conn = calloc(1, sizeof(cocomm_conn_t));
+    if (conn != NULL) {
+        conn->fd = -1;
+        conn->window = 1;
+    }
+    return conn;
+}
+
+cocomm_conn_t*
+cocomm_connect_local(const char* path) {
+    size_t len = strlen(path);
+    cocomm_conn_t* conn;
+
+    if (len >= sizeof(conn->path)) {
+        errno = ENAMETOOLONG;
+        return NULL;
+    }
+    conn = connNew();
+    if (conn == NULL) {
+        return NULL;
+    }
+    memcpy(conn->path, path, len + 1);
+    if (connectSocket(conn) < 0) {
+        int err = errno;
+        free(conn);
+        errno = err;
+        return NULL;
+    }
+    return conn;
+}
+
+cocomm_conn_t*
+cocomm_connect_tcp(const char* host, const char* port) {
+    size_t hostLen = strlen(host);
+    size_t portLen = strlen(port);
+    cocomm_conn_t* conn;
+
+    if (hostLen >= sizeof(conn->host) || portLen >= sizeof(conn->port)) {
+        errno = ENAMETOOLONG;
+        return NULL;
+    }
+    conn = connNew();
+    if (conn == NULL) {
+        return NULL;
+    }
+    conn->tcp = 1;
+    memcpy(conn->host, host, hostLen + 1);
+    memcpy(conn->port, port, portLen + 1);
+    if (connectSocket(conn) < 0) {
+        int err = errno;
+        free(conn);
+        errno = err;
+        return NULL;
+    }
+    return conn;
+}
+
+void
+cocomm_set_window(cocomm_conn_t* conn, size_t window) {
+    conn->window = window > 0 ? window : 1;
+}
+
+int
+cocomm_fd(const cocomm_conn_t* conn) {
+    return conn->fd;
+}
+
+size_t
+cocomm_pending(const cocomm_conn_t* conn) {
+    return conn->qCount;
+}
+
+static request_t*
+reqAt(cocomm_conn_t* conn, size_t i) {
+    return &conn->queue[(conn->qHead + i) % conn->qSize];
+}
+
+/* call callbacks of completed commands at the head of the queue, return number of them */
+static int
+deliverCompleted(cocomm_conn_t* conn) {
+    int count = 0;
+
+    while (conn->qCount > 0 && conn->queue[conn->qHead].complete) {
+        request_t req = conn->queue[conn->qHead];
+        cocomm_result_t result;
+
+        conn->qHead = (conn->qHead + 1) % conn->qSize;
+        conn->qCount--;
+        conn->qSent--;
+
+        result.seq = req.seq;
+        result.status = req.status;
+        result.reply = NULL;
+        result.replyLen = 0;
+        if (req.buf != NULL && req.status != COCOMM_ERR_CONN) {
+            if (req.dataCb != NULL) {
+                req.dataCb(req.arg, req.buf, req.len);
+            } else {
+                result.reply = req.buf;
+                result.replyLen = req.len >= 2 ? req.len - 2 : 0; /* without "\r\n" */
+                result.reply[result.replyLen] = '\0';
+            }
+        }
+        if (req.doneCb != NULL) {
+            req.doneCb(req.arg, &result);
+        }
+        free(req.buf);
+        free(req.command);
+        count++;
+    }
+    return count;
+}
+
+/* connection broken: complete all commands with error */
+static int
+failAll(cocomm_conn_t* conn) {
+    if (conn->fd >= 0) {
+        close(conn->fd);
+        conn->fd = -1;
+    }
+    for (size_t i = 0; i < conn->qCount; i++) {
+        request_t* req = reqAt(conn, i);
+        req->complete = 1;
+        req->status = COCOMM_ERR_CONN;
+    }
+    conn->qSent = conn->qCount;
+    return deliverCompleted(conn);
+}
+
+void
+cocomm_close(cocomm_conn_t* conn) {
+    if (conn == NULL) {
+        return;
+    }
+    failAll(conn);
+    free(conn->queue);
+    free(conn);
+}
+
+static int
+sendAll(int fd, const char* buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, buf, len, MSG_NOSIGNAL); /* blocking */
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/* send command with data from source: command, then chunks from source, then end of line */
+static int
+sendSource(cocomm_conn_t* conn, request_t* req) {
+    char chunk[SOURCE_CHUNK];
+    long n;
+
+    if (sendAll(conn->fd, &req->command[req->sentLen], req->commandLen - req->sentLen) < 0) {
+        return -1;
+    }
+    req->sentLen = req->commandLen;
+    while ((n = req->sourceCb(req->arg, chunk, sizeof(chunk))) > 0) {
+        if (sendAll(conn->fd, chunk, (size_t)n) < 0) {
+            return -1;
+        }
+    }
+    if (sendAll(conn->fd, "\n", 1) < 0) {
+        return -1;
+    }
+    conn->qSent++;
+    return 0;
+}
+
+/* send commands within window, all in one system call if possible */
+static int
+sendPending(cocomm_conn_t* conn) {
+    while (conn->qSent < conn->qCount && conn->qSent < conn->window) {
+        struct iovec iov[IOV_BATCH];
+        struct msghdr msg;
+        int n = 0;
+
+        if (conn->fd < 0 && connectSocket(conn) < 0) {
+            return -1;
+        }
+        if (reqAt(conn, conn->qSent)->sourceCb != NULL) {
+            if (sendSource(conn, reqAt(conn, conn->qSent)) < 0) {
+                return -1;
+            }
+            continue;
+        }
+        for (size_t i = conn->qSent; i < conn->qCount && i < conn->window && n < IOV_BATCH; i++) {
+            request_t* req = reqAt(conn, i);
+            if (req->sourceCb != NULL) {
+                break; /* sent separately */
+            }
+            iov[n].iov_base = &req->command[req->sentLen];
+            iov[n].iov_len = req->commandLen - req->sentLen;
+            n++;
+        }
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = (size_t)n;
+        ssize_t sent = sendmsg(conn->fd, &msg, MSG_NOSIGNAL); /* blocking */
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+
+        /* mark sent commands, last may be sent partially */
+        while (sent > 0) {
+            request_t* req = reqAt(conn, conn->qSent);
+            size_t rest = req->commandLen - req->sentLen;
+            if ((size_t)sent >= rest) {
+                req->sentLen = req->commandLen;
+                conn->qSent++;
+                sent -= (ssize_t)rest;
+            } else {
+                req->sentLen += (size_t)sent;
+                sent = 0;
+            }
+        }
+    }
+    return 0;
+}
+
+static void
+replyData(cocomm_conn_t* conn, const char* data, size_t len) {
+    request_t* req = conn->cur;
+
+    if (req == NULL || len == 0) {
+        return;
+    }
+    if (req->startLen < sizeof(req->start)) {
+        size_t n = len < sizeof(req->start) - req->startLen ? len : sizeof(req->start) - req->startLen;
+        memcpy(&req->start[req->startLen], data, n);
+        req->startLen += n;
+    }
+    if (len >= TAIL_SIZE) {
+        memcpy(req->tail, &data[len - TAIL_SIZE], TAIL_SIZE);
+        req->tailLen = TAIL_SIZE;
+    } else {
+        size_t keep = req->tailLen + len > TAIL_SIZE ? TAIL_SIZE - len : req->tailLen;
+        memmove(req->tail, &req->tail[req->tailLen - keep], keep);
+        memcpy(&req->tail[keep], data, len);
+        req->tailLen = keep + len;
+    }
+
+    if (req->dataCb != NULL && req == &conn->queue[conn->qHead]) {
+        /* stream reply of the first command */
+        req->dataCb(req->arg, data, len);
+        return;
+    }
+    if (req->len + len + 1 > req->size) {
+        size_t size = req->size > 0 ? req->size : 256;
+        while (size < req->len + len + 1) {
+            size *= 2;
+        }
+        char* buf = realloc(req->buf, size);
+        if (buf == NULL) {
+            return; /* data lost, reply is still completed */
+        }
+        req->buf = buf;
+        req->size = size;
+    }
+    memcpy(&req->buf[req->len], data, len);
+    req->len += len;
+}
+
+static void
+replyComplete(cocomm_conn_t* conn) {
+    request_t* req = conn->cur;
+
+    if (req != NULL) {
+        static const char errPattern[] = "\n...ERROR:0x";
+        int err = req->startLen >= 6 && strncmp(req->start, "ERROR:", 6) == 0;
+        for (size_t i = 0; !err && i + sizeof(errPattern) - 1 <= req->tailLen; i++) {
+            err = memcmp(&req->tail[i], errPattern, sizeof(errPattern) - 1) == 0;
+        }
+        req->status = err ? COCOMM_ERR_GATEWAY : COCOMM_OK;
+        req->complete = 1;
+    }
+    conn->cur = NULL;
+    conn->discard = 0;
+    conn->headLen = 0;
+    conn->cr = 0;
+}
+
+/* split received data into replies, find request by sequence number */
+static void
+processRx(cocomm_conn_t* conn, const char* data, size_t len) {
+    size_t i = 0;
+
+    while (i < len) {
+        if (conn->cur == NULL && !conn->discard) {
+            /* collect sequence number */
+            int end = 0;
+            while (i < len && !end) {
+                char c = data[i++];
+                conn->head[conn->headLen++] = c;
+                end = (c == ' ' && conn->headLen >= 2 && conn->head[conn->headLen - 2] == ']') || c == '\n'
+                      || conn->headLen == sizeof(conn->head);
+            }
+            if (!end) {
+                break;
+            }
+
+            char head[HEAD_SIZE];
+            size_t headLen = conn->headLen;
+            size_t tagLen = (conn->head[0] == '[' && conn->head[headLen - 1] == ' ') ? headLen : 0;
+            unsigned long seq = tagLen > 0 ? strtoul(&conn->head[1], NULL, 10) : 0;
+            memcpy(head, conn->head, headLen);
+            conn->headLen = 0;
+
+            for (size_t j = 0; j < conn->qSent; j++) {
+                request_t* req = reqAt(conn, j);
+                if (!req->complete && (req->seq == seq || tagLen == 0)) {
+                    conn->cur = req;
+                    break;
+                }
+            }
+            conn->discard = conn->cur == NULL;
+            if (headLen > tagLen) {
+                /* no sequence number, beginning belongs to the reply */
+                processRx(conn, &head[tagLen], headLen - tagLen);
+            }
+            continue;
+        }
+
+        /* reply ends with "\r\n" */
+        const char* nl = memchr(&data[i], '\n', len - i);
+        size_t n = nl != NULL ? (size_t)(nl - &data[i]) + 1 : len - i;
+        int complete = nl != NULL && ((nl > &data[i] && nl[-1] == '\r') || (nl == &data[i] && conn->cr));
+
+        replyData(conn, &data[i], n);
+        i += n;
+        if (complete) {
+            replyComplete(conn);
+        } else {
+            conn->cr = data[i - 1] == '\r';
+        }
+    }
+}
+
+unsigned long
+cocomm_submit(cocomm_conn_t* conn, const char* command, cocomm_data_cb_t dataCb, cocomm_done_cb_t doneCb,
+              void* arg) {
+    size_t len = strcspn(command, "\r\n");
+    request_t* req;
+
+    if (conn->qCount == conn->qSize) {
+        size_t size = conn->qSize > 0 ? conn->qSize * 2 : 16;
+        request_t* queue = malloc(size * sizeof(request_t));
+        if (queue == NULL) {
+            return 0;
+        }
+        for (size_t i = 0; i < conn->qCount; i++) {
+            queue[i] = *reqAt(conn, i);
+        }
+        /* request receiving a partial reply moves to the new ring, at its position from the head */
+        if (conn->cur != NULL) {
+            conn->cur = &queue[((size_t)(conn->cur - conn->queue) + conn->qSize - conn->qHead) % conn->qSize];
+        }
+        free(conn->queue);
+        conn->queue = queue;
+        conn->qSize = size;
+        conn->qHead = 0;
+    }
+
+    req = &conn->queue[(conn->qHead + conn->qCount) % conn->qSize];
+    memset(req, 0, sizeof(request_t));
+    req->command = malloc(len + 24);
+    if (req->command == NULL) {
+        return 0;
+    }
+    req->seq = ++conn->seq;
+    req->commandLen = (size_t)sprintf(req->command, "[%lu] %.*s\n", req->seq, (int)len, command);
+    req->dataCb = dataCb;
+    req->doneCb = doneCb;
+    req->arg = arg;
+    conn->qCount++;
+
+    return req->seq;
+}
+
+unsigned long
+cocomm_submit_source(cocomm_conn_t* conn, const char* command, cocomm_source_cb_t sourceCb, cocomm_data_cb_t dataCb,
+                     cocomm_done_cb_t doneCb, void* arg) {
+    unsigned long seq = cocomm_submit(conn, command, dataCb, doneCb, arg);
+
+    if (seq != 0) {
+        request_t* req = reqAt(conn, conn->qCount - 1);
+        /* replace end of line with space, data follows */
+        req->command[req->commandLen - 1] = ' ';
+        req->sourceCb = sourceCb;
+    }
+    return seq;
+}
+
+int
+cocomm_submit_batch(cocomm_conn_t* conn, const char* const* commands, int count, cocomm_data_cb_t dataCb,
+                    cocomm_done_cb_t doneCb, void* arg) {
+    int i;
+
+    for (i = 0; i < count; i++) {
+        if (cocomm_submit(conn, commands[i], dataCb, doneCb, arg) == 0) {
+            break;
+        }
+    }
+    return i;
+}
+
+static void
+futureDone(void* arg, const cocomm_result_t* result) {
+    cocomm_future_t* future = (cocomm_future_t*)arg;
+
+    future->status = result->status;
+    future->reply = NULL;
+    future->replyLen = 0;
+    if (result->reply != NULL) {
+        future->reply = malloc(result->replyLen + 1);
+        if (future->reply != NULL) {
+            memcpy(future->reply, result->reply, result->replyLen + 1);
+            future->replyLen = result->replyLen;
+        }
+    }
+    future->done = 1;
+}
+
+unsigned long
+cocomm_submit_future(cocomm_conn_t* conn, const char* command, cocomm_future_t* future) {
+    memset(future, 0, sizeof(cocomm_future_t));
+    return cocomm_submit(conn, command, NULL, futureDone, future);
+}
+
+void
+cocomm_future_free(cocomm_future_t* future) {
+    free(future->reply);
+    future->reply = NULL;
+}
+
+int
+cocomm_poll(cocomm_conn_t* conn, int timeout_ms) {
+    int count = deliverCompleted(conn);
+
+    if (sendPending(conn) < 0) {
+        failAll(conn);
+        return -1;
+    }
+    if (conn->qSent == 0 || count > 0) {
+        return count;
+    }
+
+    struct pollfd pfd = {.fd = conn->fd, .events = POLLIN, .revents = 0};
+    int ret = poll(&pfd, 1, timeout_ms);
+    if (ret < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+    if (ret == 0) {
+        return 0;
+    }
+
+    ssize_t n = read(conn->fd, conn->rx, sizeof(conn->rx));
+    if (n <= 0) {
+        if (n < 0 && (errno == EINTR || errno == EAGAIN)) {
+            return 0;
+        }
+        failAll(conn);
+        return -1;
+    }
+    processRx(conn, conn->rx, (size_t)n);
+
+    /* completed commands make room in the window, send next ones, so external poll loops see them in flight */
+    count = deliverCompleted(conn);
+    if (count > 0 && sendPending(conn) < 0) {
+        failAll(conn);
+        return -1;
+    }
+    return count;
+}
+
+static long
+now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+int
+cocomm_wait(cocomm_conn_t* conn, cocomm_future_t* future, int timeout_ms) {
+    long deadline = now_ms() + timeout_ms;
+
+    while (!future->done) {
+        int tmo = -1;
+        if (timeout_ms >= 0) {
+            tmo = (int)(deadline - now_ms());
+            if (tmo < 0) {
+                return COCOMM_ERR_TIMEOUT;
+            }
+        }
+        if (cocomm_poll(conn, tmo) < 0 && !future->done) {
+            return COCOMM_ERR_CONN;
+        }
+    }
+    return future->status;
+}
+
+int
+cocomm_command(cocomm_conn_t* conn, const char* command, char** reply) {
+    cocomm_future_t future;
+    int status;
+
+    if (cocomm_submit_future(conn, command, &future) == 0) {
+        return COCOMM_ERR_CONN;
+    }
+    status = cocomm_wait(conn, &future, -1);
+    if (reply != NULL) {
+        *reply = future.reply;
+    } else {
+        cocomm_future_free(&future);
+    }
+    return status;
+}
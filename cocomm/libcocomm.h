@@ -0,0 +1,130 @@
+/*
+ * Client library for CANopenNode ASCII command interface.
+ *
+ * @file        libcocomm.h
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#ifndef LIBCOCOMM_H
+#define LIBCOCOMM_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * libcocomm keeps a persistent connection to canopend command interface (local or tcp socket). Commands are
+ * submitted asynchronously: library assigns sequence numbers, sends up to <window> commands at once (with one
+ * writev()) and matches replies by their sequence number. Completion callbacks are called from cocomm_poll() or
+ * cocomm_wait(), always in order of submission. Reply data may be collected by the library or streamed to a data
+ * callback, which is useful for large domain uploads. If connection breaks, all pending commands complete with
+ * COCOMM_ERR_CONN and connection is established again on the next submission.
+ *
+ * Library is not thread safe, one connection should be used by one thread.
+ */
+
+/* Status of completed command */
+#define COCOMM_OK            0  /* gateway replied with value or "OK" */
+#define COCOMM_ERR_GATEWAY   1  /* gateway replied with "ERROR:..." (also after partial value) */
+#define COCOMM_ERR_CONN      -1 /* connection error, command may not be executed */
+#define COCOMM_ERR_TIMEOUT   -2 /* cocomm_wait() timeout, command is still pending */
+
+typedef struct cocomm_conn cocomm_conn_t;
+
+/* Result of the command, passed to completion callback */
+typedef struct {
+    unsigned long seq; /* sequence number, assigned by library */
+    int status;        /* COCOMM_OK, COCOMM_ERR_GATEWAY or COCOMM_ERR_CONN */
+    char* reply;       /* reply without sequence number and without "\r\n", NUL terminated. NULL for streamed
+                          replies and connection errors. Valid only during the callback. */
+    size_t replyLen;
+} cocomm_result_t;
+
+/* Called with parts of the reply (without sequence number, last part ends with "\r\n") */
+typedef void (*cocomm_data_cb_t)(void* arg, const char* data, size_t len);
+/* Called once, when command is completed */
+typedef void (*cocomm_done_cb_t)(void* arg, const cocomm_result_t* result);
+/* Called to get next part of the command line (without "\n"). Return number of bytes written to buf (at most size),
+ * 0 at the end of the command or -1 on error (command line is ended, gateway will reply with error). */
+typedef long (*cocomm_source_cb_t)(void* arg, char* buf, size_t size);
+
+/* Future for commands, which are waited for with cocomm_wait() */
+typedef struct {
+    int done;
+    int status;
+    char* reply; /* reply, allocated, free with cocomm_future_free() */
+    size_t replyLen;
+} cocomm_future_t;
+
+/* Connect to local socket (path) or to tcp host and port. Return NULL on error, errno is set (ENAMETOOLONG, if path
+ * does not fit into sun_path or host or port is too long). */
+cocomm_conn_t* cocomm_connect_local(const char* path);
+cocomm_conn_t* cocomm_connect_tcp(const char* host, const char* port);
+
+/* Complete pending commands with COCOMM_ERR_CONN, close connection and free the object. */
+void cocomm_close(cocomm_conn_t* conn);
+
+/* Max number of commands in flight, default is 1. Larger window pipelines commands. */
+void cocomm_set_window(cocomm_conn_t* conn, size_t window);
+
+/* File descriptor of the connection (for external poll loops), -1 if disconnected */
+int cocomm_fd(const cocomm_conn_t* conn);
+
+/* Number of submitted and not completed commands */
+size_t cocomm_pending(const cocomm_conn_t* conn);
+
+/*
+ * Submit command without sequence number, for example "4 r 0x1017 0 u16". Command must be a single line, trailing
+ * "\n" is optional. dataCb may be NULL, then reply is collected and passed to doneCb in result.reply. Command is
+ * only queued, it is sent within the window by the next cocomm_poll() or cocomm_wait(), together with other queued
+ * commands in one system call. Return sequence number or 0 on error.
+ */
+unsigned long cocomm_submit(cocomm_conn_t* conn, const char* command, cocomm_data_cb_t dataCb, cocomm_done_cb_t doneCb,
+                            void* arg);
+
+/*
+ * Submit command, which continues with data from sourceCb, for example domain data: command "4 w 0x1F50 1 d" and
+ * base64 encoded file from sourceCb. Command line is streamed to the gateway in chunks, when it is sent, so memory use
+ * does not depend on the size of data. Return sequence number or 0 on error.
+ */
+unsigned long cocomm_submit_source(cocomm_conn_t* conn, const char* command, cocomm_source_cb_t sourceCb,
+                                   cocomm_data_cb_t dataCb, cocomm_done_cb_t doneCb, void* arg);
+
+/* Submit count commands, all with the same callbacks, sent with a single system call. Return number submitted. */
+int cocomm_submit_batch(cocomm_conn_t* conn, const char* const* commands, int count, cocomm_data_cb_t dataCb,
+                        cocomm_done_cb_t doneCb, void* arg);
+
+/* Submit command and complete the future. Return sequence number or 0 on error. */
+unsigned long cocomm_submit_future(cocomm_conn_t* conn, const char* command, cocomm_future_t* future);
+
+/* Send pending commands, wait up to timeout_ms (-1 infinite) for replies and call callbacks.
+ * Return number of completed commands or -1 on connection error. */
+int cocomm_poll(cocomm_conn_t* conn, int timeout_ms);
+
+/* Process replies until future is done or timeout_ms (-1 infinite) expires. Return future status or
+ * COCOMM_ERR_TIMEOUT. */
+int cocomm_wait(cocomm_conn_t* conn, cocomm_future_t* future, int timeout_ms);
+
+/* Free reply of the future */
+void cocomm_future_free(cocomm_future_t* future);
+
+/* Execute command synchronously. If reply is not NULL, it is set to allocated reply (free it). Return status. */
+int cocomm_command(cocomm_conn_t* conn, const char* command, char** reply);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBCOCOMM_H */
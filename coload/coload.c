@@ -0,0 +1,572 @@
+/*
+ * Synthetic CAN load generator and simulated CANopen slave nodes for stress testing canopend.
+ *
+ * @file        coload.c
+ *
+ * This file is part of <https://github.com/CANopenNode/CANopenNode>, a CANopen Stack.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+
+/* Max number of streams in the profile */
+#define MAX_STREAMS 64
+/* Max number of frames sent with one sendmmsg() */
+#define MAX_BATCH 256
+/* Max number of SDO requests received with one recvmmsg() */
+#define SLAVE_BATCH 64
+/* Frames, which are due within this time after the earliest one, are sent in the same batch */
+#define DEFAULT_SLACK_US 50
+
+/* kinds of streams */
+typedef enum { ST_SYNC, ST_PDO, ST_HB, ST_EMCY, ST_SDO } streamKind_t;
+
+/* one stream of periodic frames */
+typedef struct {
+    streamKind_t kind;
+    char spec[64];      /* stream as specified, for report */
+    int64_t period_ns;
+    int64_t next_ns;    /* absolute CLOCK_MONOTONIC time of the next frame */
+    canid_t cobId;      /* PDO COB-ID or SDO server node-ID */
+    uint8_t len;        /* PDO length */
+    uint32_t counter;   /* number of generated frames */
+    unsigned long sent; /* number of frames accepted by the socket */
+} stream_t;
+
+/* configuration and state of the generator */
+typedef struct {
+    int fd;
+    stream_t streams[MAX_STREAMS];
+    int streamCount;
+    uint8_t nodeFirst; /* simulated slave nodes, 0 if none */
+    uint8_t nodeLast;
+    int batch;
+    int64_t slack_ns;
+    int64_t duration_ns;
+    unsigned long dropped;  /* frames not accepted by the socket (transmit queue full) */
+    int64_t lateMax_ns;     /* max delay of the wakeup after due time */
+    unsigned long sdoServed; /* SDO requests answered by simulated slaves */
+    unsigned long sdoAborted;
+} coload_t;
+
+static volatile sig_atomic_t endProgram = 0;
+
+static void
+sigHandler(int sig) {
+    (void)sig;
+    endProgram = 1;
+}
+
+static int64_t
+monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void
+printUsage(char* progName) {
+    fprintf(stderr,
+            "Usage: %s <CAN device name> [options]\n"
+            "\n"
+            "Program generates CANopen traffic on CAN device with precise rates, for\n"
+            "stress testing of canopend. Frames are paced by absolute time and sent in\n"
+            "batches. Program may also act as simulated slave nodes, which answer SDO\n"
+            "requests. Statistics are printed at the end.\n"
+            "\n"
+            "Options:\n"
+            "  -S <stream>      Add stream of frames, option may be repeated:\n"
+            "                   'sync:<hz>'                  SYNC (COB-ID 0x80)\n"
+            "                   'pdo:<hz>:<COB-ID>[:<len>]'  PDO with counter, default 8 bytes\n"
+            "                   'hb:<hz>'                    heartbeats of all simulated nodes\n"
+            "                   'emcy:<hz>'                  EMCY of simulated nodes, in turn\n"
+            "                   'sdo:<hz>:<node-ID>'         SDO upload requests of 0x1000,00\n"
+            "  -f <profile>     Read streams from file, one per line. Lines with '#' are\n"
+            "                   comments. Profile makes load reproducible.\n"
+            "  -n <first>-<last> Simulated slave nodes. They send boot-up and answer SDO\n"
+            "                   expedited requests from canopend.\n"
+            "  -d <seconds>     Duration, default until Ctrl+C.\n"
+            "  -b <frames>      Max frames per sendmmsg(), default %d.\n"
+            "  -j <usec>        Frames due within <usec> are batched together, default %d.\n"
+            "\n"
+            "Example: %s vcan0 -n 2-20 -S sync:1000 -S hb:10 -S pdo:2000:0x181 -d 10\n"
+            "\n"
+            "See also: https://github.com/CANopenNode/CANopenLinux\n"
+            "\n",
+            progName, MAX_BATCH, DEFAULT_SLACK_US, progName);
+}
+
+/* Parse stream specification, return 0 on success */
+static int
+addStream(coload_t* ld, const char* spec) {
+    char kind[16];
+    double hz = 0;
+    unsigned long arg = 0, len = 8;
+    stream_t* st;
+
+    if (ld->streamCount >= MAX_STREAMS) {
+        fprintf(stderr, "Too many streams\n");
+        return -1;
+    }
+    st = &ld->streams[ld->streamCount];
+    memset(st, 0, sizeof(stream_t));
+
+    int n = sscanf(spec, "%15[a-z]:%lf:%li:%li", kind, &hz, &arg, &len);
+    if (n < 2 || hz <= 0) {
+        fprintf(stderr, "Wrong stream \"%s\"\n", spec);
+        return -1;
+    }
+    if (strcmp(kind, "sync") == 0) {
+        st->kind = ST_SYNC;
+    } else if (strcmp(kind, "pdo") == 0 && n >= 3 && arg > 0 && arg <= CAN_SFF_MASK && len <= 8) {
+        st->kind = ST_PDO;
+        st->cobId = (canid_t)arg;
+        st->len = (uint8_t)len;
+    } else if (strcmp(kind, "hb") == 0) {
+        st->kind = ST_HB;
+    } else if (strcmp(kind, "emcy") == 0) {
+        st->kind = ST_EMCY;
+    } else if (strcmp(kind, "sdo") == 0 && n >= 3 && arg >= 1 && arg <= 127) {
+        st->kind = ST_SDO;
+        st->cobId = (canid_t)arg;
+    } else {
+        fprintf(stderr, "Wrong stream \"%s\"\n", spec);
+        return -1;
+    }
+    snprintf(st->spec, sizeof(st->spec), "%s", spec);
+    st->spec[strcspn(st->spec, "\r\n")] = '\0';
+    st->period_ns = (int64_t)(1e9 / hz);
+    if (st->period_ns < 1) {
+        st->period_ns = 1;
+    }
+    ld->streamCount++;
+    return 0;
+}
+
+/* Generate frames of the stream, which are due. Heartbeat stream generates one frame per simulated node. */
+static int
+streamFrames(coload_t* ld, stream_t* st, struct can_frame* frames, int max) {
+    int count = 0;
+
+    switch (st->kind) {
+        case ST_SYNC:
+            frames[count].can_id = 0x80;
+            frames[count++].can_dlc = 0;
+            break;
+        case ST_PDO:
+            frames[count].can_id = st->cobId;
+            frames[count].can_dlc = st->len;
+            for (int i = 0; i < st->len; i++) {
+                frames[count].data[i] = (uint8_t)(st->counter >> ((i % 4) * 8));
+            }
+            count++;
+            break;
+        case ST_HB:
+            for (int id = ld->nodeFirst; id > 0 && id <= ld->nodeLast && count < max; id++) {
+                frames[count].can_id = 0x700 + (canid_t)id;
+                frames[count].can_dlc = 1;
+                frames[count++].data[0] = 5; /* operational */
+            }
+            break;
+        case ST_EMCY:
+            if (ld->nodeFirst > 0) {
+                int id = ld->nodeFirst + (int)(st->counter % (uint32_t)(ld->nodeLast - ld->nodeFirst + 1));
+                frames[count].can_id = 0x80 + (canid_t)id;
+                frames[count].can_dlc = 8;
+                memset(frames[count].data, 0, 8);
+                frames[count].data[0] = 0x00; /* error code 0x1000, generic error */
+                frames[count].data[1] = 0x10;
+                frames[count].data[2] = 0x01; /* error register */
+                frames[count].data[4] = (uint8_t)st->counter;
+                count++;
+            }
+            break;
+        case ST_SDO:
+            frames[count].can_id = 0x600 + st->cobId;
+            frames[count].can_dlc = 8;
+            memset(frames[count].data, 0, 8);
+            frames[count].data[0] = 0x40; /* initiate upload 0x1000,00 */
+            frames[count].data[2] = 0x10;
+            count++;
+            break;
+    }
+    st->counter++;
+    return count;
+}
+
+/* Send frames with as few system calls as possible. Frames not accepted because of full queue are dropped. */
+static void
+sendFrames(coload_t* ld, struct can_frame* frames, int count, stream_t** owners) {
+    struct mmsghdr msgs[MAX_BATCH];
+    struct iovec iovs[MAX_BATCH];
+    int done = 0;
+
+    for (int i = 0; i < count; i++) {
+        iovs[i].iov_base = &frames[i];
+        iovs[i].iov_len = sizeof(struct can_frame);
+        memset(&msgs[i], 0, sizeof(msgs[i]));
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    while (done < count) {
+        int n = sendmmsg(ld->fd, &msgs[done], (unsigned)(count - done), 0);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != ENOBUFS && errno != EAGAIN) {
+                perror("CAN sendmmsg");
+                endProgram = 1;
+            }
+            /* frame is lost, continue with next */
+            ld->dropped++;
+            n = 1;
+        } else {
+            for (int i = done; i < done + n; i++) {
+                if (owners[i] != NULL) {
+                    owners[i]->sent++;
+                }
+            }
+        }
+        done += n;
+    }
+}
+
+/* Generator loop: sleep until the earliest due time, then send all frames due within slack in one batch */
+static void
+generate(coload_t* ld) {
+    struct can_frame frames[MAX_BATCH];
+    stream_t* owners[MAX_BATCH];
+    int64_t start = monotonic_ns() + 1000000;
+    int64_t end = ld->duration_ns > 0 ? start + ld->duration_ns : INT64_MAX;
+
+    for (int i = 0; i < ld->streamCount; i++) {
+        ld->streams[i].next_ns = start;
+    }
+
+    while (!endProgram) {
+        int64_t due = INT64_MAX;
+        for (int i = 0; i < ld->streamCount; i++) {
+            if (ld->streams[i].next_ns < due) {
+                due = ld->streams[i].next_ns;
+            }
+        }
+        if (due >= end) {
+            /* nothing more to send, wait for the end (slaves may still be running) */
+            due = end;
+        }
+
+        struct timespec ts = {.tv_sec = (time_t)(due / 1000000000), .tv_nsec = (long)(due % 1000000000)};
+        int err = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+        if (err == EINTR) {
+            continue;
+        }
+        int64_t now = monotonic_ns();
+        if (now >= end) {
+            break;
+        }
+        if (now - due > ld->lateMax_ns) {
+            ld->lateMax_ns = now - due;
+        }
+
+        /* collect frames, which are due, streams may generate more frames, if we are late */
+        int count = 0;
+        int more = 1;
+        while (more && count < ld->batch) {
+            more = 0;
+            for (int i = 0; i < ld->streamCount && count < ld->batch; i++) {
+                stream_t* st = &ld->streams[i];
+                if (st->next_ns <= now + ld->slack_ns) {
+                    int n = streamFrames(ld, st, &frames[count], ld->batch - count);
+                    for (int j = count; j < count + n; j++) {
+                        owners[j] = st;
+                    }
+                    count += n;
+                    st->next_ns += st->period_ns;
+                    more = 1;
+                }
+            }
+        }
+        if (count > 0) {
+            sendFrames(ld, frames, count, owners);
+        }
+    }
+}
+
+/* Simulated slave nodes: answer SDO expedited requests. Upload returns the node-ID and index, download is confirmed,
+ * other requests are aborted. */
+static void*
+slaveThread(void* arg) {
+    coload_t* ld = (coload_t*)arg;
+    struct can_frame rx[SLAVE_BATCH], tx[SLAVE_BATCH];
+    struct mmsghdr rxMsgs[SLAVE_BATCH], txMsgs[SLAVE_BATCH];
+    struct iovec rxIovs[SLAVE_BATCH], txIovs[SLAVE_BATCH];
+
+    for (int i = 0; i < SLAVE_BATCH; i++) {
+        rxIovs[i].iov_base = &rx[i];
+        rxIovs[i].iov_len = sizeof(struct can_frame);
+        txIovs[i].iov_base = &tx[i];
+        txIovs[i].iov_len = sizeof(struct can_frame);
+    }
+
+    while (!endProgram) {
+        memset(rxMsgs, 0, sizeof(rxMsgs));
+        for (int i = 0; i < SLAVE_BATCH; i++) {
+            rxMsgs[i].msg_hdr.msg_iov = &rxIovs[i];
+            rxMsgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int n = recvmmsg(ld->fd, rxMsgs, SLAVE_BATCH, MSG_WAITFORONE, NULL);
+        if (n <= 0) {
+            if (n < 0 && errno != EAGAIN && errno != EINTR) {
+                perror("CAN recvmmsg");
+                break;
+            }
+            continue;
+        }
+
+        int count = 0;
+        for (int i = 0; i < n; i++) {
+            struct can_frame* req = &rx[i];
+            struct can_frame* resp = &tx[count];
+            canid_t id = req->can_id - 0x600;
+
+            if ((req->can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG)) != 0 || id < ld->nodeFirst || id > ld->nodeLast
+                || req->can_dlc != 8) {
+                continue;
+            }
+            resp->can_id = 0x580 + id;
+            resp->can_dlc = 8;
+            memcpy(resp->data, req->data, 4); /* index, subindex */
+            memset(&resp->data[4], 0, 4);
+            switch (req->data[0] & 0xE0) {
+                case 0x40: /* initiate upload, expedited 4 bytes: node-ID and index */
+                    resp->data[0] = 0x43;
+                    resp->data[4] = (uint8_t)id;
+                    resp->data[6] = req->data[1];
+                    resp->data[7] = req->data[2];
+                    ld->sdoServed++;
+                    break;
+                case 0x20: /* initiate download */
+                    if (req->data[0] & 0x02) {
+                        resp->data[0] = 0x60;
+                        ld->sdoServed++;
+                        break;
+                    }
+                    /* fallthrough, segmented transfer is not simulated */
+                default:
+                    resp->data[0] = 0x80;
+                    resp->data[4] = 0x01; /* abort code 0x05040001, command specifier not valid */
+                    resp->data[6] = 0x04;
+                    resp->data[7] = 0x05;
+                    ld->sdoAborted++;
+                    break;
+            }
+            memset(&txMsgs[count], 0, sizeof(txMsgs[count]));
+            txMsgs[count].msg_hdr.msg_iov = &txIovs[count];
+            txMsgs[count].msg_hdr.msg_iovlen = 1;
+            count++;
+        }
+        for (int done = 0; done < count;) {
+            int sent = sendmmsg(ld->fd, &txMsgs[done], (unsigned)(count - done), 0);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                ld->dropped++;
+                sent = 1;
+            }
+            done += sent;
+        }
+    }
+    return NULL;
+}
+
+/* Open CAN socket. If filterSDO, only SDO requests to simulated nodes are received, otherwise nothing. */
+static int
+openSocket(const char* device, coload_t* ld, int filterSDO) {
+    struct sockaddr_can sockAddr;
+    int fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+
+    if (fd < 0) {
+        perror("CAN socket creation failed");
+        return -1;
+    }
+    if (filterSDO) {
+        struct can_filter filter[128];
+        int n = 0;
+        for (int id = ld->nodeFirst; id <= ld->nodeLast; id++) {
+            filter[n].can_id = 0x600 + (canid_t)id;
+            filter[n++].can_mask = CAN_SFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG;
+        }
+        setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FILTER, filter, (socklen_t)(n * sizeof(struct can_filter)));
+        struct timeval tv = {.tv_sec = 0, .tv_usec = 100000};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    } else {
+        setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FILTER, NULL, 0);
+    }
+
+    memset(&sockAddr, 0, sizeof(sockAddr));
+    sockAddr.can_family = AF_CAN;
+    sockAddr.can_ifindex = if_nametoindex(device);
+    if (sockAddr.can_ifindex == 0 || bind(fd, (struct sockaddr*)&sockAddr, sizeof(sockAddr)) < 0) {
+        fprintf(stderr, "CAN Socket binding failed \"%s\": ", device);
+        perror(NULL);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Read profile file, return 0 on success */
+static int
+readProfile(coload_t* ld, const char* path) {
+    FILE* fp = fopen(path, "r");
+    char line[128];
+
+    if (fp == NULL) {
+        perror("Can't open profile");
+        return -1;
+    }
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        char* s = line + strspn(line, " \t");
+        if (s[0] == '#' || s[0] == '\r' || s[0] == '\n' || s[0] == '\0') {
+            continue;
+        }
+        if (addStream(ld, s) < 0) {
+            fclose(fp);
+            return -1;
+        }
+    }
+    fclose(fp);
+    return 0;
+}
+
+int
+main(int argc, char* argv[]) {
+    static coload_t ld;
+    static coload_t slaveLd; /* copy of configuration with own socket and counters */
+    pthread_t slave;
+    int opt;
+    int first = 0, last = 0;
+    double duration = 0;
+
+    if (argc < 2 || strcmp(argv[1], "--help") == 0) {
+        printUsage(argv[0]);
+        exit(EXIT_SUCCESS);
+    }
+    ld.batch = MAX_BATCH;
+    ld.slack_ns = DEFAULT_SLACK_US * 1000;
+
+    while ((opt = getopt(argc, argv, "S:f:n:d:b:j:")) != -1) {
+        switch (opt) {
+            case 'S':
+                if (addStream(&ld, optarg) < 0) {
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'f':
+                if (readProfile(&ld, optarg) < 0) {
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'n':
+                if (sscanf(optarg, "%i-%i", &first, &last) == 1) {
+                    last = first;
+                }
+                break;
+            case 'd': duration = atof(optarg); break;
+            case 'b': ld.batch = atoi(optarg); break;
+            case 'j': ld.slack_ns = atol(optarg) * 1000; break;
+            default: printUsage(argv[0]); exit(EXIT_FAILURE);
+        }
+    }
+    if (optind >= argc || first < 0 || last > 127 || first > last || ld.batch < 1 || ld.batch > MAX_BATCH) {
+        printUsage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    ld.nodeFirst = (uint8_t)first;
+    ld.nodeLast = (uint8_t)last;
+    ld.duration_ns = (int64_t)(duration * 1e9);
+
+    if (signal(SIGINT, sigHandler) == SIG_ERR || signal(SIGTERM, sigHandler) == SIG_ERR) {
+        perror("signal");
+        exit(EXIT_FAILURE);
+    }
+
+    ld.fd = openSocket(argv[optind], &ld, 0);
+    if (ld.fd < 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    /* simulated slaves: boot-up, then SDO server in own thread with own socket */
+    if (ld.nodeFirst > 0) {
+        struct can_frame bootup[128];
+        stream_t* owners[128] = {NULL};
+        int n = 0;
+
+        slaveLd = ld;
+        slaveLd.fd = openSocket(argv[optind], &ld, 1);
+        if (slaveLd.fd < 0) {
+            exit(EXIT_FAILURE);
+        }
+        for (int id = ld.nodeFirst; id <= ld.nodeLast; id++) {
+            bootup[n].can_id = 0x700 + (canid_t)id;
+            bootup[n].can_dlc = 1;
+            bootup[n++].data[0] = 0;
+        }
+        sendFrames(&ld, bootup, n, owners);
+        if (pthread_create(&slave, NULL, slaveThread, &slaveLd) != 0) {
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    int64_t t0 = monotonic_ns();
+    generate(&ld);
+    double elapsed_s = (double)(monotonic_ns() - t0) / 1e9;
+    endProgram = 1;
+    if (ld.nodeFirst > 0) {
+        pthread_join(slave, NULL);
+        close(slaveLd.fd);
+    }
+    close(ld.fd);
+
+    /* report */
+    unsigned long total = 0;
+    printf("%-32s %12s %12s\n", "stream", "frames", "frames/s");
+    for (int i = 0; i < ld.streamCount; i++) {
+        stream_t* st = &ld.streams[i];
+        printf("%-32s %12lu %12.1f\n", st->spec, st->sent, (double)st->sent / elapsed_s);
+        total += st->sent;
+    }
+    printf("%-32s %12lu %12.1f\n", "total", total, (double)total / elapsed_s);
+    printf("%.2f s, %lu frames dropped (transmit queue full), max wakeup delay %lld us\n", elapsed_s,
+           ld.dropped + slaveLd.dropped, (long long)(ld.lateMax_ns / 1000));
+    if (ld.nodeFirst > 0) {
+        printf("simulated nodes %d-%d: %lu SDO requests answered, %lu aborted\n", ld.nodeFirst, ld.nodeLast,
+               slaveLd.sdoServed, slaveLd.sdoAborted);
+    }
+
+    return EXIT_SUCCESS;
+}